@@ -0,0 +1,263 @@
+/*
+	Container operations at key sizes from 10 to 1M entries: find, iteration, values::at, read<Ty>, insert and erase (one by one
+	and as whole sets), over an in-process tree (memory backend) and the same tree written as an offline hive
+
+	Every result is one JSON object per line (ns/op, allocations/op and backend calls/op), meant to be appended to a log and compared:
+		{"bench":"find","source":"memory","n":1000,"ops":1000,"ns_per_op":120.5,"allocs_per_op":2.00,"calls_per_op":1.00}
+
+	g++ -std=c++11 -O2 -I.. containers.cpp -o containers -lpthread
+	./containers [max entries (1000000)] [filter: only the benches whose name contains it]
+*/
+
+#include "regedit_hive.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+// every allocation of the process goes through here
+static std::atomic<unsigned long long> g_allocs(0);
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // free() of the malloc() below
+#endif
+
+void* operator new(size_t n) {
+	g_allocs.fetch_add(1, std::memory_order_relaxed);
+	if(void* p = malloc(n != 0 ? n : 1))
+		return p;
+	throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept {
+	free(p);
+}
+void operator delete(void* p, size_t) noexcept {
+	free(p);
+}
+
+using namespace neo;
+using type = regedit::type;
+
+static const char* g_filter = "";
+
+// Counted : a counting<> backend
+template<class Counted>
+static unsigned long long backend_calls() {
+	typename Counted::counters& c = Counted::stats();
+	return c.open + c.create + c.close + c.query_info + c.enum_key + c.enum_value + c.query_value + c.find + c.set_value + c.delete_value + c.delete_tree;
+}
+
+// fn(i) runs the operation 'i' of up to 'ops' (or 'batch' operations at once), the run stops early once it takes more than 2 seconds
+template<class Counted, class Fn>
+static void run(const char* bench, const char* source, size_t n, size_t ops, Fn fn, size_t batch = 1) {
+	if(strstr(bench, g_filter) == nullptr || ops == 0)
+		return;
+	const std::chrono::steady_clock::duration budget = std::chrono::seconds(2);
+	Counted::stats().reset();
+	unsigned long long allocs = g_allocs.load();
+	size_t sink = 0, done = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now(), now = start;
+	while(done < ops) {
+		for(size_t end = (std::min)(ops, done + 64); done < end; ++done)
+			sink += fn(done);
+		now = std::chrono::steady_clock::now();
+		if(now - start > budget)
+			break;
+	}
+	double ns = std::chrono::duration<double, std::nano>(now - start).count();
+	allocs = g_allocs.load() - allocs;
+	done *= batch;
+	unsigned long long calls = backend_calls<Counted>();
+	printf("{\"bench\":\"%s\",\"source\":\"%s\",\"n\":%zu,\"ops\":%zu,\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f,\"calls_per_op\":%.2f}\n",
+		bench, source, n, done, ns / done, static_cast<double>(allocs) / done, static_cast<double>(calls) / done);
+	fflush(stdout);
+	volatile size_t keep = sink;
+	(void)keep;
+}
+
+static std::string key_name(size_t i) {
+	char buff[32];
+	snprintf(buff, sizeof(buff), "Key_%07zu", i);
+	return buff;
+}
+static std::string value_name(size_t i) {
+	char buff[32];
+	snprintf(buff, sizeof(buff), "Value_%07zu", i);
+	return buff;
+}
+
+// 'n' subkeys and 'n' values (sz and dword alternated), in name order : the memory backend keeps sorted vectors, inserting
+// in a random order would take quadratic time at 1M entries
+static void fill(memory_regedit& reg, size_t n) {
+	for(size_t i = 0; i < n; ++i) {
+		reg.insert(key_name(i));
+		if(i % 2 == 0)
+			reg.values[value_name(i)].write<type::sz>("C:\\Program Files\\Vendor\\Product\\bin\\" + std::to_string(i) + ".dll");
+		else
+			reg.values[value_name(i)].write<type::dword>(static_cast<__regedit_details::DWORD>(i));
+	}
+}
+
+// the lookups of a bench, random existing names
+static std::vector<std::string> sample(size_t n, size_t count, std::string(*name)(size_t)) {
+	std::mt19937 rng(7);
+	std::vector<std::string> out;
+	out.reserve(count);
+	for(size_t i = 0; i < count; ++i)
+		out.push_back(name(rng() % n));
+	return out;
+}
+
+template<class Counted>
+static void read_benches(const basic_regedit<Counted>& reg, const char* source, size_t n) {
+	using regedit = basic_regedit<Counted>;
+	size_t lookups = (std::min)(n, static_cast<size_t>(100000));
+	std::vector<std::string> keys = sample(n, lookups, key_name), vals = sample(n, lookups, value_name);
+
+	run<Counted>("find", source, n, lookups, [&](size_t i) {
+		return static_cast<size_t>(reg.find(keys[i]) != reg.cend());
+	});
+	run<Counted>("find_missing", source, n, lookups, [&](size_t i) {
+		return static_cast<size_t>(reg.find(keys[i] + "_") != reg.cend());
+	});
+
+	typename regedit::const_iterator it = reg.cbegin(), end = reg.cend();
+	run<Counted>("iterate", source, n, n, [&](size_t) {
+		size_t len = it->first.size();
+		++it;
+		return len;
+	});
+	// pathological: end() evaluated on every step asks the backend for the size
+	it = reg.cbegin();
+	run<Counted>("iterate_end_per_iter", source, n, n, [&](size_t) {
+		if(it == reg.cend())
+			return static_cast<size_t>(0);
+		size_t len = it->first.size();
+		++it;
+		return len;
+	});
+	run<Counted>("snapshot_iterate", source, n, 1, [&](size_t) {
+		size_t len = 0;
+		for(const __regedit_details::snapshot_entry& e : reg.snapshot())
+			len += e.length;
+		return len;
+	}, n);
+	typename regedit::values::const_iterator vit = reg.values.cbegin();
+	run<Counted>("values_iterate", source, n, n, [&](size_t) {
+		size_t len = vit->first.size();
+		++vit;
+		return len;
+	});
+	// a value dump: type, size and data of each value
+	vit = reg.values.cbegin();
+	run<Counted>("values_dump", source, n, n, [&](size_t) {
+		size_t len = static_cast<size_t>(vit->second.type()) + vit->second.size() + (vit->second.read() != nullptr);
+		++vit;
+		return len;
+	});
+	run<Counted>("values_query_all", source, n, 1, [&](size_t) {
+		size_t len = 0;
+		for(const __regedit_details::value_info& e : reg.values.query_all())
+			len += static_cast<size_t>(e.ty) + e.size;
+		return len;
+	}, n);
+
+	run<Counted>("values_at", source, n, lookups, [&](size_t i) {
+		return reg.values.at(vals[i]).size();
+	});
+	run<Counted>("read_sz", source, n, lookups, [&](size_t i) {
+		return reg.values.ref(vals[i].c_str()).template read<type::sz>().size();
+	});
+	std::string out;
+	run<Counted>("read_sz_into", source, n, lookups, [&](size_t i) {
+		reg.values.ref(vals[i].c_str()).template read<type::sz>(out);
+		return out.size();
+	});
+	run<Counted>("read_dword", source, n, lookups, [&](size_t i) {
+		return static_cast<size_t>(reg.values.ref(vals[i].c_str()).template read<type::dword>());
+	});
+}
+
+static void write_benches(size_t n) {
+	using counted = basic_regedit<regedit_backend::counting<regedit_backend::memory>>;
+	using Counted = counted::backend_type;
+	std::vector<std::string> names(n), vals(n);
+	for(size_t i = 0; i < n; ++i) {
+		names[i] = key_name(i);
+		vals[i] = value_name(i);
+	}
+
+	regedit_backend::memory::store store;
+	counted reg = counted(store.root())["bench"];
+	run<Counted>("insert", "memory", n, n, [&](size_t i) {
+		return static_cast<size_t>(reg.insert(names[i]).second);
+	});
+	run<Counted>("insert_existing", "memory", n, n, [&](size_t i) {
+		return static_cast<size_t>(reg.insert(names[i]).second);
+	});
+	run<Counted>("write_dword", "memory", n, n, [&](size_t i) {
+		reg.values[vals[i]].write<type::dword>(static_cast<__regedit_details::DWORD>(i));
+		return i;
+	});
+	run<Counted>("values_erase", "memory", n, n, [&](size_t i) {
+		return reg.values.erase(vals[i]);
+	});
+	run<Counted>("erase_range", "memory", n, 1, [&](size_t) {
+		reg.erase(reg.begin(), reg.end());
+		return reg.size();
+	}, n);
+
+	// the same changes as whole sets, names in a random order
+	std::vector<std::string> shuffled = names, shuffled_vals = vals;
+	std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(7));
+	std::shuffle(shuffled_vals.begin(), shuffled_vals.end(), std::mt19937(7));
+	regedit_backend::memory::store bulk_store;
+	counted bulk = counted(bulk_store.root())["bench"];
+	run<Counted>("insert_bulk", "memory", n, 1, [&](size_t) {
+		return bulk.insert_bulk(shuffled.begin(), shuffled.end());
+	}, n);
+	run<Counted>("values_insert_bulk", "memory", n, 1, [&](size_t) {
+		return bulk.values.insert_bulk(shuffled_vals.begin(), shuffled_vals.end());
+	}, n);
+	run<Counted>("values_erase_bulk", "memory", n, 1, [&](size_t) {
+		return bulk.values.erase_bulk(shuffled_vals.begin(), shuffled_vals.end());
+	}, n);
+	run<Counted>("erase_bulk", "memory", n, 1, [&](size_t) {
+		return bulk.erase_bulk(shuffled.begin(), shuffled.end());
+	}, n);
+	bulk.insert_bulk(shuffled.begin(), shuffled.end());
+	run<Counted>("clear", "memory", n, 1, [&](size_t) {
+		bulk.clear();
+		return bulk.size();
+	}, n);
+}
+
+int main(int argc, char* argv[]) {
+	size_t max_n = argc > 1 ? static_cast<size_t>(strtoull(argv[1], nullptr, 10)) : 1000000;
+	if(argc > 2)
+		g_filter = argv[2];
+
+	for(size_t n = 10; n <= max_n; n *= 10) {
+		regedit_backend::memory::store store;
+		memory_regedit tree = memory_regedit(store.root())["bench"];
+		fill(tree, n);
+		read_benches(basic_regedit<regedit_backend::counting<regedit_backend::memory>>(store.root(), "bench"), "memory", n);
+
+		std::string path = "containers_bench.hiv";
+		if(!write_hive(memory_regedit(store.root()), path)) {
+			fprintf(stderr, "can't write %s\n", path.c_str());
+			return 1;
+		}
+		{
+			regedit_backend::hive::file hive(path);
+			read_benches(basic_regedit<regedit_backend::counting<regedit_backend::hive>>(hive.root(), "bench"), "hive", n);
+		}
+		remove(path.c_str());
+
+		write_benches(n);
+	}
+	return 0;
+}
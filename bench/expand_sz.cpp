@@ -0,0 +1,121 @@
+/*
+	expand_sz reads over a Services like tree (an ImagePath per service, a few hundred distinct strings): the previous expansion
+	(copies on every read), read<type::expand_sz>(out) against the process environment and through a memoizing neo::env_expander,
+	plus the '%' scan kernels. ns per value
+
+	g++ -std=c++11 -O2 -I.. expand_sz.cpp -o expand_sz
+	cl /std:c++14 /O2 /EHsc /I.. expand_sz.cpp
+*/
+
+#include "regedit_expand.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+using namespace neo;
+using type = regedit::type;
+
+// the expansion read<type::expand_sz>() did before (non Windows branch), a new string per step
+static std::string old_expand(const std::string& str) {
+	std::string exp;
+	size_t pos = 0, left, right;
+	while((left = str.find('%', pos)) != std::string::npos && (right = str.find('%', left + 1)) != std::string::npos) {
+		exp.append(str, pos, left - pos);
+		const char* var = right - left > 1 ? getenv(str.substr(left + 1, right - left - 1).c_str()) : nullptr;
+		if(var != nullptr) {
+			exp.append(var);
+			pos = right + 1;
+		}
+		else {
+			exp.append(str, left, right - left);
+			pos = right;
+		}
+	}
+	exp.append(str, pos, std::string::npos);
+	return exp;
+}
+
+template<class Fn>
+static void run(const char* what, size_t count, Fn fn) {
+	auto start = std::chrono::steady_clock::now();
+	volatile size_t sink = fn();
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	printf("  %-34s %9.1f ns/value\n", what, ns / count);
+	(void)sink;
+}
+
+int main() {
+	const size_t services = 20000, distinct = 300, rounds = 5;
+	#ifndef _WIN32 // both already set on Windows
+	setenv("SystemRoot", "C:\\Windows", 1);
+	setenv("ProgramFiles", "C:\\Program Files", 1);
+	#endif
+
+	regedit_backend::memory::store store;
+	memory_regedit root = memory_regedit(store.root())["Services"];
+	std::vector<std::string> names;
+	std::mt19937 rng(3);
+	for(size_t i = 0; i < services; ++i) {
+		names.push_back("svc" + std::to_string(i));
+		size_t k = rng() % distinct;
+		std::string path = k % 3 == 0 ? "%SystemRoot%\\System32\\svchost.exe -k group" + std::to_string(k) + " -p"
+			: k % 3 == 1 ? "\"%ProgramFiles%\\Vendor " + std::to_string(k) + "\\bin\\service.exe\" /run"
+			: "%SystemRoot%\\System32\\drivers\\drv" + std::to_string(k) + ".sys";
+		root[names.back()].values["ImagePath"].write<type::expand_sz>(path);
+	}
+	std::vector<memory_regedit> keys;
+	for(const std::string& name : names)
+		keys.push_back(root.at(name));
+
+	printf("%zu services, %zu distinct ImagePaths:\n", services, distinct);
+	run("previous expansion", services * rounds, [&] {
+		size_t acc = 0;
+		std::string raw;
+		for(size_t r = 0; r < rounds; ++r)
+			for(const memory_regedit& k : keys) {
+				k.values.ref("ImagePath").read<type::sz>(raw);
+				acc += old_expand(raw).size();
+			}
+		return acc;
+	});
+	run("read<expand_sz>(out)", services * rounds, [&] {
+		size_t acc = 0;
+		std::string out;
+		for(size_t r = 0; r < rounds; ++r)
+			for(const memory_regedit& k : keys) {
+				k.values.ref("ImagePath").read<type::expand_sz>(out);
+				acc += out.size();
+			}
+		return acc;
+	});
+	env_expander env;
+	run("read<expand_sz>(out, env_expander)", services * rounds, [&] {
+		size_t acc = 0;
+		std::string out;
+		for(size_t r = 0; r < rounds; ++r)
+			for(const memory_regedit& k : keys) {
+				k.values.ref("ImagePath").read<type::expand_sz>(out, env);
+				acc += out.size();
+			}
+		return acc;
+	});
+	printf("  expander: %llu hits, %llu misses\n", env.hits(), env.misses());
+
+	// the '%' scan alone, over long strings without any
+	std::string text(4096, 'x');
+	const size_t scans = 20000;
+	printf("'%%' scan over %zu bytes:\n", text.size());
+	run("_find_char_scalar", scans, [&] {
+		size_t acc = 0;
+		for(size_t i = 0; i < scans; ++i)
+			acc += __regedit_details::_find_char_scalar(text.data() + (i & 7), text.size() - 8, '%') == nullptr;
+		return acc;
+	});
+	run("_find_char (dispatched)", scans, [&] {
+		size_t acc = 0;
+		for(size_t i = 0; i < scans; ++i)
+			acc += __regedit_details::_find_char(text.data() + (i & 7), text.size() - 8, '%') == nullptr;
+		return acc;
+	});
+	return 0;
+}
@@ -0,0 +1,175 @@
+/*
+	Case-insensitive name kernels against the previous byte loop, over a mix of usual registry key names
+	(CLSIDs, device instance ids, CamelCase paths, file extensions, numbered instances)
+
+	g++ -std=c++11 -O2 -I.. name_compare.cpp -o name_compare
+	cl /std:c++14 /O2 /EHsc /I.. name_compare.cpp
+*/
+
+#include "regedit.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+using namespace neo::__regedit_details;
+
+// the tolower loop names::cmp replaced
+static int lcase_cmp_loop(const char* s1, const char* s2) {
+	const char *p1 = s1, *p2 = s2;
+	int result = 0;
+	do {
+		result = tolower(*p1) - tolower(*p2);
+	} while(*p1++ != '\0' && *p2++ != '\0' && result == 0);
+	return (std::min)(1, (std::max)(-1, result));
+}
+static uint64_t fnv_lower(const char* str) {
+	uint64_t h = 14695981039346656037ull;
+	for(; *str != '\0'; ++str)
+		h = (h ^ static_cast<unsigned char>(tolower(static_cast<unsigned char>(*str)))) * 1099511628211ull;
+	return h;
+}
+
+static std::vector<std::string> make_names(size_t count) {
+	static const char* words[] = { "Microsoft", "Windows", "CurrentVersion", "Explorer", "Policies", "Software", "Classes", "Shell", "Services",
+		"Parameters", "Control", "Enum", "Interface", "TypeLib", "Installer", "Products", "Features", "Components", "Run", "Uninstall" };
+	std::mt19937 rng(42);
+	auto hex = [&](size_t n, bool upper) {
+		std::string s;
+		for(size_t i = 0; i < n; ++i)
+			s.push_back((upper ? "0123456789ABCDEF" : "0123456789abcdef")[rng() % 16]);
+		return s;
+	};
+	std::vector<std::string> names;
+	while(names.size() < count) {
+		unsigned kind = rng() % 10;
+		bool upper = rng() % 2 != 0;
+		if(kind < 5) // {8-4-4-4-12}
+			names.push_back("{" + hex(8, upper) + "-" + hex(4, upper) + "-" + hex(4, upper) + "-" + hex(4, upper) + "-" + hex(12, upper) + "}");
+		else if(kind < 7)
+			names.push_back("VEN_" + hex(4, true) + "&DEV_" + hex(4, true) + "&SUBSYS_" + hex(8, true) + "&REV_" + hex(2, true));
+		else if(kind < 9) {
+			std::string s;
+			for(unsigned i = 0, n = 1 + rng() % 3; i < n; ++i)
+				s += words[rng() % (sizeof(words) / sizeof(*words))];
+			names.push_back(s);
+		}
+		else
+			names.push_back(rng() % 2 ? "." + hex(3, false) : hex(4, false));
+	}
+	return names;
+}
+
+template<class Fn>
+static double run(const char* what, size_t ops, Fn fn) {
+	auto start = std::chrono::steady_clock::now();
+	volatile uint64_t sink = fn();
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ops;
+	printf("  %-34s %8.2f ns/op\n", what, ns);
+	(void)sink;
+	return ns;
+}
+
+int main() {
+	const size_t count = 200000, rounds = 20;
+	std::vector<std::string> names = make_names(count);
+	std::vector<std::string> flipped(names); // same names, other case
+	for(std::string& s : flipped)
+		for(char& c : s)
+			if(isalpha(static_cast<unsigned char>(c)))
+				c ^= 0x20;
+
+	#ifdef REGEDIT_AVX2
+	printf("avx2: %s\n", names::_use_avx2() ? "yes" : "no");
+	#endif
+
+	printf("compare (adjacent names):\n");
+	auto cmp_all = [&](int(*fn)(const char*, const char*)) {
+		uint64_t acc = 0;
+		for(size_t r = 0; r < rounds; ++r)
+			for(size_t i = 1; i < count; ++i)
+				acc += fn(names[i - 1].c_str(), names[i].c_str()) + 1;
+		return acc;
+	};
+	double base = run("tolower loop", rounds * count, [&] { return cmp_all(lcase_cmp_loop); });
+	double now = run("names::cmp (known lengths)", rounds * count, [&] {
+		uint64_t acc = 0;
+		for(size_t r = 0; r < rounds; ++r)
+			for(size_t i = 1; i < count; ++i)
+				acc += names::cmp(names[i - 1].data(), names[i - 1].size(), names[i].data(), names[i].size()) + 1;
+		return acc;
+	});
+	printf("  speedup %.2fx\n", base / now);
+
+	printf("equal (same name, other case):\n");
+	base = run("tolower loop", rounds * count, [&] {
+		uint64_t acc = 0;
+		for(size_t r = 0; r < rounds; ++r)
+			for(size_t i = 0; i < count; ++i)
+				acc += lcase_cmp_loop(names[i].c_str(), flipped[i].c_str()) == 0;
+		return acc;
+	});
+	auto eq_all = [&](bool(*fn)(const char*, const char*, size_t)) {
+		uint64_t acc = 0;
+		for(size_t r = 0; r < rounds; ++r)
+			for(size_t i = 0; i < count; ++i)
+				acc += fn(names[i].data(), flipped[i].data(), names[i].size());
+		return acc;
+	};
+	run("eq_scalar (SWAR)", rounds * count, [&] { return eq_all(names::eq_scalar); });
+	#ifdef REGEDIT_SSE2
+	run("eq_sse2", rounds * count, [&] { return eq_all(names::eq_sse2); });
+	#endif
+	#ifdef REGEDIT_AVX2
+	if(names::_use_avx2())
+		run("eq_avx2", rounds * count, [&] { return eq_all(names::eq_avx2); });
+	#endif
+	now = run("names::eq (dispatched)", rounds * count, [&] {
+		uint64_t acc = 0;
+		for(size_t r = 0; r < rounds; ++r)
+			for(size_t i = 0; i < count; ++i)
+				acc += names::eq(names[i].data(), names[i].size(), flipped[i].data(), flipped[i].size());
+		return acc;
+	});
+	printf("  speedup %.2fx\n", base / now);
+
+	printf("hash:\n");
+	base = run("FNV-1a tolower", rounds * count, [&] {
+		uint64_t acc = 0;
+		for(size_t r = 0; r < rounds; ++r)
+			for(size_t i = 0; i < count; ++i)
+				acc += fnv_lower(names[i].c_str());
+		return acc;
+	});
+	auto hash_all = [&](uint64_t(*fn)(const char*, size_t)) {
+		uint64_t acc = 0;
+		for(size_t r = 0; r < rounds; ++r)
+			for(size_t i = 0; i < count; ++i)
+				acc += fn(names[i].data(), names[i].size());
+		return acc;
+	};
+	run("hash_scalar (SWAR)", rounds * count, [&] { return hash_all(names::hash_scalar); });
+	#ifdef REGEDIT_SSE2
+	run("hash_sse2", rounds * count, [&] { return hash_all(names::hash_sse2); });
+	#endif
+	#ifdef REGEDIT_AVX2
+	if(names::_use_avx2())
+		run("hash_avx2", rounds * count, [&] { return hash_all(names::hash_avx2); });
+	#endif
+	now = run("names::hash (dispatched)", rounds * count, [&] { return hash_all(names::hash); });
+	printf("  speedup %.2fx\n", base / now);
+
+	printf("sort %zu names:\n", count);
+	base = run("std::sort + tolower loop", count, [&] {
+		std::vector<std::string> v(names);
+		std::sort(v.begin(), v.end(), [](const std::string& a, const std::string& b) { return lcase_cmp_loop(a.c_str(), b.c_str()) < 0; });
+		return static_cast<uint64_t>(v.front().size());
+	});
+	now = run("std::sort + names::cmp", count, [&] {
+		std::vector<std::string> v(names);
+		std::sort(v.begin(), v.end(), [](const std::string& a, const std::string& b) { return names::cmp(a.data(), a.size(), b.data(), b.size()) < 0; });
+		return static_cast<uint64_t>(v.front().size());
+	});
+	printf("  speedup %.2fx\n", base / now);
+
+	return 0;
+}
@@ -0,0 +1,170 @@
+/*
+	UTF-8 <-> UTF-16LE kernels against the previous per code point loops, over registry like strings in several scripts
+	(ASCII paths, Latin-1 accented text, Cyrillic, CJK, a mix with emojis), throughput in MB/s of UTF-8
+
+	g++ -std=c++11 -O2 -I.. utf_transcode.cpp -o utf_transcode
+	cl /std:c++14 /O2 /EHsc /I.. utf_transcode.cpp
+*/
+
+#include "regedit.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+using namespace neo::__regedit_details;
+
+// the loops utf::to_utf8 / utf::to_utf16 replaced
+static size_t old_to_utf8(const BYTE* src, size_t bytes, char* out) {
+	uint32_t high = 0;
+	size_t len = 0;
+	for(size_t i = 0; i + 1 < bytes; i += 2) {
+		uint32_t cp = src[i] | (src[i + 1] << 8);
+		if(cp >= 0xD800 && cp <= 0xDBFF) {
+			high = cp;
+			continue;
+		}
+		if(cp >= 0xDC00 && cp <= 0xDFFF) {
+			if(high == 0)
+				continue;
+			cp = 0x10000 + ((high - 0xD800) << 10) + (cp - 0xDC00);
+		}
+		high = 0;
+		char tmp[4];
+		size_t n = cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+		switch(n) {
+			case 1: tmp[0] = static_cast<char>(cp); break;
+			case 2: tmp[0] = static_cast<char>(0xC0 | (cp >> 6));  tmp[1] = static_cast<char>(0x80 | (cp & 0x3F)); break;
+			case 3: tmp[0] = static_cast<char>(0xE0 | (cp >> 12)); tmp[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));  tmp[2] = static_cast<char>(0x80 | (cp & 0x3F)); break;
+			case 4: tmp[0] = static_cast<char>(0xF0 | (cp >> 18)); tmp[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F)); tmp[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F)); tmp[3] = static_cast<char>(0x80 | (cp & 0x3F)); break;
+		}
+		memcpy(out + len, tmp, n);
+		len += n;
+	}
+	return len;
+}
+static size_t old_to_utf16(const BYTE* src, size_t len, std::vector<BYTE>& out) {
+	out.clear();
+	for(size_t pos = 0; pos < len; ) {
+		uint32_t cp = utf::next(src, len, pos);
+		if(cp >= 0x10000) {
+			cp -= 0x10000;
+			uint32_t high = 0xD800 + (cp >> 10), low = 0xDC00 + (cp & 0x3FF);
+			out.insert(out.end(), { static_cast<BYTE>(high), static_cast<BYTE>(high >> 8), static_cast<BYTE>(low), static_cast<BYTE>(low >> 8) });
+		}
+		else
+			out.insert(out.end(), { static_cast<BYTE>(cp), static_cast<BYTE>(cp >> 8) });
+	}
+	return out.size();
+}
+
+struct corpus {
+	const char* what;
+	std::vector<std::string> utf8;   // one string per value
+	std::vector<std::vector<BYTE>> utf16;
+	size_t bytes = 0;                // UTF-8 total
+};
+
+static corpus make_corpus(const char* what, const std::vector<std::string>& words, size_t count) {
+	corpus c;
+	c.what = what;
+	std::mt19937 rng(42);
+	while(c.utf8.size() < count) {
+		std::string s;
+		for(unsigned i = 0, n = 2 + rng() % 8; i < n; ++i) {
+			if(i != 0)
+				s += rng() % 3 ? " " : "\\";
+			s += words[rng() % words.size()];
+		}
+		std::vector<BYTE> w;
+		_utf8_to_utf16(reinterpret_cast<const BYTE*>(s.data()), s.size(), w);
+		c.bytes += s.size();
+		c.utf8.push_back(std::move(s));
+		c.utf16.push_back(std::move(w));
+	}
+	return c;
+}
+
+template<class Fn>
+static double run(const char* what, size_t bytes, Fn fn) {
+	auto start = std::chrono::steady_clock::now();
+	volatile size_t sink = fn();
+	double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	double mbs = bytes / sec / 1e6;
+	printf("  %-26s %9.1f MB/s\n", what, mbs);
+	(void)sink;
+	return mbs;
+}
+
+int main() {
+	const size_t count = 100000, rounds = 10;
+	std::vector<corpus> corpora;
+	corpora.push_back(make_corpus("ascii", { "Software", "Microsoft", "Windows", "CurrentVersion", "C:", "Program Files", "%SystemRoot%", "system32",
+		"drivers", "{4D36E972-E325-11CE-BFC1-08002BE10318}", "InstallLocation", "DisplayName" }, count));
+	corpora.push_back(make_corpus("latin-1", { "Paramètres", "Données", "Bibliothèque", "Übersicht", "Einstellungen", "Configuración", "Programme",
+		"Fenêtre", "Système", "Benutzer", "año", "Documents" }, count));
+	corpora.push_back(make_corpus("cyrillic", { "Параметры", "Настройки", "Программы", "Документы", "Система", "Пользователь", "Рабочий", "стол" }, count));
+	corpora.push_back(make_corpus("cjk", { "設定", "ソフトウェア", "プログラム", "ドキュメント", "系统", "用户", "桌面", "控制面板" }, count));
+	corpora.push_back(make_corpus("mixed + emoji", { "Software", "Paramètres", "Настройки", "設定", "\xF0\x9F\x94\x91", "\xF0\x9F\x93\x81", "Files" }, count));
+
+	std::vector<char> narrow;
+	std::vector<BYTE> wide;
+	for(const corpus& c : corpora) {
+		size_t max16 = 0, max8 = 0;
+		for(size_t i = 0; i < count; ++i) {
+			max16 = (std::max)(max16, c.utf16[i].size());
+			max8 = (std::max)(max8, c.utf8[i].size());
+		}
+		narrow.resize(max16 / 2 * 3 + 1);
+		wide.resize(max8 * 2);
+		printf("%s (%zu strings, %.1f MB UTF-8):\n", c.what, count, c.bytes / 1e6);
+
+		printf(" UTF-16 -> UTF-8\n");
+		auto to8 = [&](size_t(*fn)(const BYTE*, size_t, char*, uint32_t&)) {
+			size_t acc = 0;
+			for(size_t r = 0; r < rounds; ++r)
+				for(const std::vector<BYTE>& w : c.utf16) {
+					uint32_t high = 0;
+					acc += fn(w.data(), w.size(), narrow.data(), high);
+				}
+			return acc;
+		};
+		double base = run("previous loop", rounds * c.bytes, [&] {
+			size_t acc = 0;
+			for(size_t r = 0; r < rounds; ++r)
+				for(const std::vector<BYTE>& w : c.utf16)
+					acc += old_to_utf8(w.data(), w.size(), narrow.data());
+			return acc;
+		});
+		run("to_utf8_scalar", rounds * c.bytes, [&] { return to8(utf::to_utf8_scalar); });
+		#ifdef REGEDIT_SSE2
+		run("to_utf8_sse2", rounds * c.bytes, [&] { return to8(utf::to_utf8_sse2); });
+		#endif
+		double now = run("utf::to_utf8 (dispatched)", rounds * c.bytes, [&] { return to8(utf::to_utf8); });
+		printf("  speedup %.2fx\n", now / base);
+
+		printf(" UTF-8 -> UTF-16\n");
+		auto to16 = [&](size_t(*fn)(const BYTE*, size_t, BYTE*)) {
+			size_t acc = 0;
+			for(size_t r = 0; r < rounds; ++r)
+				for(const std::string& s : c.utf8)
+					acc += fn(reinterpret_cast<const BYTE*>(s.data()), s.size(), wide.data());
+			return acc;
+		};
+		base = run("previous loop", rounds * c.bytes, [&] {
+			size_t acc = 0;
+			std::vector<BYTE> out;
+			for(size_t r = 0; r < rounds; ++r)
+				for(const std::string& s : c.utf8)
+					acc += old_to_utf16(reinterpret_cast<const BYTE*>(s.data()), s.size(), out);
+			return acc;
+		});
+		run("to_utf16_scalar", rounds * c.bytes, [&] { return to16(utf::to_utf16_scalar); });
+		#ifdef REGEDIT_SSE2
+		run("to_utf16_sse2", rounds * c.bytes, [&] { return to16(utf::to_utf16_sse2); });
+		#endif
+		now = run("utf::to_utf16 (dispatched)", rounds * c.bytes, [&] { return to16(utf::to_utf16); });
+		printf("  speedup %.2fx\n", now / base);
+	}
+
+	return 0;
+}
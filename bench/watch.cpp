@@ -0,0 +1,88 @@
+/*
+	Change feed over a 50k keys tree (memory backend, 250 keys of 200 subkeys, a value each): a full re-read of the tree (what a poller
+	without change tracking does), change_feed::poll() on the unchanged tree and after a few writes. ns and backend calls per poll
+
+	g++ -std=c++11 -O2 -I.. watch.cpp -o watch -lpthread
+	cl /std:c++14 /O2 /EHsc /I.. watch.cpp
+*/
+
+#include "regedit_watch.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+using namespace neo;
+using type = regedit::type;
+using counted = basic_regedit<regedit_backend::counting<regedit_backend::memory>>;
+using Counted = counted::backend_type;
+
+static unsigned long long backend_calls() {
+	Counted::counters& c = Counted::stats();
+	return c.open + c.create + c.close + c.query_info + c.enum_key + c.enum_value + c.query_value + c.find + c.set_value + c.delete_value + c.delete_tree;
+}
+
+// fn() once per round, 'change' before each one (not timed)
+template<class Change, class Fn>
+static void run(const char* what, size_t rounds, Change change, Fn fn) {
+	double ns = 0;
+	unsigned long long calls = 0;
+	size_t sink = 0;
+	for(size_t r = 0; r < rounds; ++r) {
+		change(r);
+		Counted::stats().reset();
+		auto start = std::chrono::steady_clock::now();
+		sink += fn();
+		ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		calls += backend_calls();
+	}
+	printf("  %-30s %12.1f ns/poll %10.1f calls/poll\n", what, ns / rounds, static_cast<double>(calls) / rounds);
+	volatile size_t keep = sink;
+	(void)keep;
+}
+
+static size_t reread(const counted& key) {
+	size_t n = 0;
+	for(const __regedit_details::value_info& v : key.values.query_all())
+		n += v.size;
+	counted::key_snapshot keys = key.snapshot();
+	for(const __regedit_details::snapshot_entry& e : keys)
+		n += reread(keys.open(e));
+	return n;
+}
+
+int main() {
+	const size_t groups = 250, per_group = 200, rounds = 20;
+	regedit_backend::memory::store store;
+	counted root = counted(store.root())["Config"];
+	for(size_t g = 0; g < groups; ++g) {
+		counted group = root["group" + std::to_string(g)];
+		for(size_t k = 0; k < per_group; ++k)
+			group["key" + std::to_string(k)].values["setting"].write<type::dword>(static_cast<__regedit_details::DWORD>(k));
+	}
+	printf("%zu keys:\n", groups * per_group + groups + 1);
+
+	auto nothing = [](size_t) {};
+	run("full re-read", 3, nothing, [&] {
+		return reread(root);
+	});
+
+	change_feed<Counted> feed(root);
+	run("poll, unchanged", rounds * 50, nothing, [&] {
+		return feed.poll();
+	});
+	std::mt19937 rng(5);
+	run("poll, 1 value changed", rounds, [&](size_t r) {
+		root["group" + std::to_string(rng() % groups) + "\\key" + std::to_string(rng() % per_group)].values["setting"].write<type::dword>(static_cast<__regedit_details::DWORD>(r));
+	}, [&] {
+		return feed.poll();
+	});
+	run("poll, 10 keys added", rounds, [&](size_t r) {
+		for(size_t i = 0; i < 10; ++i)
+			root["group" + std::to_string(rng() % groups) + "\\new" + std::to_string(r * 10 + i)];
+	}, [&] {
+		return feed.poll();
+	});
+	feed.trim(feed.cursor());
+	printf("  last poll: %zu keys checked, %zu read, %zu subtrees skipped\n", feed.stats().keys, feed.stats().read, feed.stats().skipped);
+	return 0;
+}
@@ -19,6 +19,12 @@
 				+ full_resource_descriptor   : https://docs.microsoft.com/en-us/windows-hardware/drivers/ddi/content/wdm/ns-wdm-_cm_full_resource_descriptor
 				+ resoruce_requeriments_list : https://docs.microsoft.com/en-us/windows-hardware/drivers/ddi/content/wdm/ns-wdm-_io_resource_requirements_list
 		- Be careful with what you're going to do, you may make a mess if you edit or delete some keys or values, always make a backup if you want to try 'weird things' : https://support.microsoft.com/en-us/help/322756/how-to-back-up-and-restore-the-registry-in-windows
+		- neo::basic_regedit<Backend> is the generic container, the storage is given by a backend policy :
+				+ regedit_backend::win32  : the live Windows registry (Reg*A functions), only available on Windows
+				+ regedit_backend::memory : an in-process registry with no Win32 calls, available everywhere
+			neo::regedit uses the win32 backend on Windows and the memory backend on any other platform
+		- Defining REGEDIT_INSTRUMENT (before every include of it) counts every public call and the backend calls made by them, and times
+			1 call in REGEDIT_INSTRUMENT_SAMPLE (64 by default), see neo::instrument
 */
 
 
@@ -27,232 +33,3709 @@
 #include <vector>
 #include <memory>
 #include <algorithm>
+#include <deque>
 #include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <atomic>
+#include <stdexcept>
+#ifdef _WIN32
 #include <windows.h>
+#endif
+
+// the string views convert to std::string_view when it's available
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#define REGEDIT_STRING_VIEW
+#include <string_view>
+#endif
+
+// SIMD name kernels, define REGEDIT_NO_SIMD to build only the portable ones
+#if !defined(REGEDIT_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define REGEDIT_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER) || ((defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)))
+#define REGEDIT_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+#endif
+
+// per-call instrumentation, see neo::instrument (nothing of it is compiled without REGEDIT_INSTRUMENT)
+#ifdef REGEDIT_INSTRUMENT
+#include <chrono>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define REGEDIT_RDTSC
+#include <intrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define REGEDIT_RDTSC
+#include <x86intrin.h>
+#endif
+#ifndef REGEDIT_INSTRUMENT_SAMPLE
+#define REGEDIT_INSTRUMENT_SAMPLE 64 // calls per timed one, on average (1 : every call)
+#endif
+#endif
+
+
+
+
+namespace neo {
+
+	#ifdef REGEDIT_INSTRUMENT
+	namespace instrument {
+
+		// public entry points, the backend calls made outside of them count as 'other'
+		enum class op { open, find, at, subscript, insert, erase, read, write, iterate, size, snapshot, other };
+		enum class call { open, create, close, query_info, enum_key, enum_value, query_value, find, set_value, delete_value, delete_tree };
+
+		constexpr size_t op_count   = 12;
+		constexpr size_t call_count = 11;
+		constexpr size_t buckets    = 48; // log2 of the clock ticks
+
+	}
+	#endif
+
+	namespace __regedit_details {
+
+		#ifdef REGEDIT_INSTRUMENT
+		/*
+			Every thread counts on its own block, written with relaxed load + store (a single writer, no locked instructions) and read by
+			instrument::snapshot() from any thread. Nested entry points (operator[] calling insert, ...) count for the outermost one.
+			Every call is counted, 1 in REGEDIT_INSTRUMENT_SAMPLE on average is timed, at random intervals so periodic call patterns don't bias it.
+			reset() never writes the blocks of the threads : it keeps a copy of each as its baseline and bumps an epoch, the 'max' of a block
+			only count once its owner has seen the new epoch (and restarted them)
+		*/
+		namespace trace {
+
+			using instrument::op;
+			using instrument::call;
+
+			struct slot {
+				std::atomic<uint64_t> count, timed, ticks, max; // 'ticks', 'max' and 'hist' are the ones of the 'timed' calls
+				std::atomic<uint64_t> calls[instrument::call_count];
+				std::atomic<uint64_t> hist[instrument::buckets];
+			};
+			struct block {
+				slot ops[instrument::op_count];
+				std::atomic<unsigned> epoch; // of the 'max'
+			};
+
+			inline uint64_t now() {
+				#ifdef REGEDIT_RDTSC
+				return __rdtsc();
+				#else
+				return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+				#endif
+			}
+			inline size_t bucket(uint64_t ticks) {
+				size_t b = 0;
+				#if defined(__GNUC__) || defined(__clang__)
+				b = ticks != 0 ? static_cast<size_t>(63 - __builtin_clzll(ticks)) : 0;
+				#else
+				while(ticks >>= 1)
+					++b;
+				#endif
+				return b < instrument::buckets ? b : instrument::buckets - 1;
+			}
+			inline void bump(std::atomic<uint64_t>& c, uint64_t n = 1) {
+				c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+			}
+
+			struct live_block {
+				block* counts;               // written by its thread only
+				std::unique_ptr<block> base; // 'counts' at the last reset(), subtracted by snapshot()
+			};
+			struct registry {
+				std::mutex mtx;
+				std::vector<live_block> live;
+				block retired; // counts of the threads already ended, since the last reset()
+				std::atomic<unsigned> epoch{ 0 }; // bumped by reset()
+				uint64_t start_ticks = now();
+				std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+			};
+			// never destroyed, threads can end after the static destructors
+			inline registry& reg() {
+				static registry* r = new registry();
+				return *r;
+			}
+
+			// the counts, not the 'max'
+			inline void merge(block& dst, const block& src, bool sub = false) {
+				for(size_t o = 0; o < instrument::op_count; ++o) {
+					slot& d = dst.ops[o];
+					const slot& s = src.ops[o];
+					auto add = [sub](std::atomic<uint64_t>& a, const std::atomic<uint64_t>& b) {
+						uint64_t v = b.load(std::memory_order_relaxed);
+						a.store(sub ? a.load(std::memory_order_relaxed) - v : a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+					};
+					add(d.count, s.count);
+					add(d.timed, s.timed);
+					add(d.ticks, s.ticks);
+					for(size_t c = 0; c < instrument::call_count; ++c)
+						add(d.calls[c], s.calls[c]);
+					for(size_t b = 0; b < instrument::buckets; ++b)
+						add(d.hist[b], s.hist[b]);
+				}
+			}
+			inline void merge_max(block& dst, const block& src) {
+				for(size_t o = 0; o < instrument::op_count; ++o)
+					if(src.ops[o].max.load(std::memory_order_relaxed) > dst.ops[o].max.load(std::memory_order_relaxed))
+						dst.ops[o].max.store(src.ops[o].max.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			}
+
+			struct thread_state {
+				block* b;
+				unsigned depth = 0;
+				op cur = op::other;
+				bool timing = false;
+				uint64_t start = 0;
+				uint32_t countdown = 1; // calls until the next timed one
+				uint32_t rng;
+				thread_state() : b(new block()) {
+					rng = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(b) >> 4) | 1;
+					registry& r = reg();
+					std::lock_guard<std::mutex> lock(r.mtx);
+					b->epoch.store(r.epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+					r.live.push_back(live_block{ b, std::unique_ptr<block>(new block()) });
+				}
+				~thread_state() {
+					registry& r = reg();
+					std::lock_guard<std::mutex> lock(r.mtx);
+					std::vector<live_block>::iterator it = std::find_if(r.live.begin(), r.live.end(), [this](const live_block& l) { return l.counts == b; });
+					merge(r.retired, *b);
+					merge(r.retired, *it->base, true);
+					if(b->epoch.load(std::memory_order_relaxed) == r.epoch.load(std::memory_order_relaxed))
+						merge_max(r.retired, *b);
+					r.live.erase(it);
+					delete b;
+				}
+				// true once every [1, 2 * REGEDIT_INSTRUMENT_SAMPLE - 1] calls (xorshift32)
+				bool sample() {
+					if(--countdown != 0)
+						return false;
+					rng ^= rng << 13;
+					rng ^= rng >> 17;
+					rng ^= rng << 5;
+					countdown = 1 + rng % (2 * REGEDIT_INSTRUMENT_SAMPLE - 1);
+					return true;
+				}
+			};
+			inline thread_state& make_state() {
+				thread_local thread_state st;
+				return st;
+			}
+			// a plain pointer, its thread_local access needs no init guard call
+			inline thread_state& state() {
+				static thread_local thread_state* st = nullptr;
+				if(st == nullptr)
+					st = &make_state();
+				return *st;
+			}
+
+			inline void count(call c) {
+				thread_state& st = state();
+				bump(st.b->ops[static_cast<size_t>(st.cur)].calls[static_cast<size_t>(c)]);
+			}
+
+			class scope {
+
+				private:
+
+					thread_state& _st;
+
+				public:
+
+					scope(op o) : _st(state()) {
+						if(_st.depth++ == 0) {
+							_st.cur = o;
+							_st.timing = _st.sample();
+							if(_st.timing)
+								_st.start = now();
+						}
+					}
+					~scope() {
+						if(--_st.depth != 0)
+							return;
+						slot& s = _st.b->ops[static_cast<size_t>(_st.cur)];
+						bump(s.count);
+						if(_st.timing) {
+							uint64_t t = now() - _st.start;
+							block& b = *_st.b;
+							unsigned epoch = reg().epoch.load(std::memory_order_relaxed);
+							if(b.epoch.load(std::memory_order_relaxed) != epoch) { // reset() since the last timed call
+								for(slot& m : b.ops)
+									m.max.store(0, std::memory_order_relaxed);
+								b.epoch.store(epoch, std::memory_order_release);
+							}
+							bump(s.timed);
+							bump(s.ticks, t);
+							if(t > s.max.load(std::memory_order_relaxed))
+								s.max.store(t, std::memory_order_relaxed);
+							bump(s.hist[bucket(t)]);
+						}
+						_st.cur = op::other;
+					}
+					scope(const scope&) = delete;
+					scope& operator=(const scope&) = delete;
+
+			};
+
+		}
+		#define REGEDIT_TRACE(what) ::neo::__regedit_details::trace::scope _regedit_trace(::neo::instrument::op::what)
+		#else
+		#define REGEDIT_TRACE(what)
+		#endif
+
+		#ifdef _WIN32
+		using ::BYTE;
+		using ::DWORD;
+		using ::DWORD64;
+		#else
+		typedef uint8_t  BYTE;
+		typedef uint32_t DWORD;
+		typedef uint64_t DWORD64;
+		#endif
+
+		namespace status { // same values than the Win32 error codes
+			constexpr long success           = 0;
+			constexpr long file_not_found    = 2;
+			constexpr long access_denied     = 5;
+			constexpr long invalid_handle    = 6;
+			constexpr long invalid_parameter = 87;
+			constexpr long more_data         = 234;
+			constexpr long no_more_items     = 259;
+			constexpr long key_deleted       = 1018;
+		}
+
+		/*
+			Case-insensitive name kernels, ASCII letters are folded to upper case and the rest of bytes compared as unsigned (the registry
+			order for ASCII names, so '_' sorts after the letters). Portable SWAR versions, SSE2 when the target has it, and AVX2 for the
+			blocks of 32 bytes when the CPU supports it (runtime check)
+		*/
+		namespace names {
+
+			constexpr uint64_t _k_mul = 0x9E3779B97F4A7C15ull;
+
+			inline unsigned char _fold(unsigned char c) {
+				return c >= 'a' && c <= 'z' ? static_cast<unsigned char>(c - 0x20) : c;
+			}
+			// 8 bytes at once, only the bytes in 'a'..'z' change
+			inline uint64_t _fold8(uint64_t w) {
+				const uint64_t high = 0x8080808080808080ull;
+				uint64_t low7 = w & ~high;
+				uint64_t ge_a = low7 + 0x1F1F1F1F1F1F1F1Full; // high bit set for >= 'a'
+				uint64_t gt_z = low7 + 0x0505050505050505ull; // high bit set for > 'z'
+				return w ^ ((ge_a & ~gt_z & ~w & high) >> 2);
+			}
+			inline uint64_t _load8(const char* p, size_t n) { // zero padded
+				uint64_t w = 0;
+				memcpy(&w, p, n < 8 ? n : 8);
+				return w;
+			}
+			inline uint64_t _mix(uint64_t acc, uint64_t w) {
+				acc = (acc ^ w) * _k_mul;
+				return acc ^ (acc >> 29);
+			}
+			inline uint64_t _finish(uint64_t a0, uint64_t a1, size_t n) {
+				uint64_t h = _mix(_mix(static_cast<uint64_t>(n) * _k_mul, a0), a1);
+				return h ^ (h >> 32);
+			}
+			inline int _tail_cmp(const char* s1, const char* s2, size_t n) {
+				for(size_t i = 0; i < n; ++i) {
+					unsigned char c1 = _fold(static_cast<unsigned char>(s1[i])), c2 = _fold(static_cast<unsigned char>(s2[i]));
+					if(c1 != c2)
+						return c1 < c2 ? -1 : 1;
+				}
+				return 0;
+			}
+			inline int _len_cmp(size_t n1, size_t n2) {
+				return n1 < n2 ? -1 : n1 > n2 ? 1 : 0;
+			}
+
+			// portable versions, also the reference for the SIMD ones
+
+			inline int cmp_scalar(const char* s1, size_t n1, const char* s2, size_t n2) {
+				size_t n = (std::min)(n1, n2), i = 0;
+				for(; i + 8 <= n; i += 8)
+					if(_fold8(_load8(s1 + i, 8)) != _fold8(_load8(s2 + i, 8)))
+						break;
+				int ret = _tail_cmp(s1 + i, s2 + i, n - i);
+				return ret != 0 ? ret : _len_cmp(n1, n2);
+			}
+			inline bool eq_scalar(const char* s1, const char* s2, size_t n) {
+				size_t i = 0;
+				for(; i + 8 <= n; i += 8)
+					if(_fold8(_load8(s1 + i, 8)) != _fold8(_load8(s2 + i, 8)))
+						return false;
+				return _fold8(_load8(s1 + i, n - i)) == _fold8(_load8(s2 + i, n - i));
+			}
+			// words of 8 bytes alternate between two accumulators, the SIMD versions produce the same values
+			inline uint64_t hash_scalar(const char* s, size_t n) {
+				uint64_t acc[2] = { 0, _k_mul };
+				size_t i = 0, k = 0;
+				for(; i + 8 <= n; i += 8, ++k)
+					acc[k & 1] = _mix(acc[k & 1], _fold8(_load8(s + i, 8)));
+				if(i < n)
+					acc[k & 1] = _mix(acc[k & 1], _fold8(_load8(s + i, n - i)));
+				return _finish(acc[0], acc[1], n);
+			}
+
+			#ifdef REGEDIT_SSE2
+			inline int _ctz(uint32_t v) {
+				#ifdef _MSC_VER
+				unsigned long pos;
+				_BitScanForward(&pos, v);
+				return static_cast<int>(pos);
+				#else
+				return __builtin_ctz(v);
+				#endif
+			}
+			inline __m128i _fold16(__m128i v) {
+				__m128i lower = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('z' + 1)));
+				return _mm_sub_epi8(v, _mm_and_si128(lower, _mm_set1_epi8(0x20)));
+			}
+			inline __m128i _load16(const char* p) {
+				return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			}
+
+			inline int cmp_sse2(const char* s1, size_t n1, const char* s2, size_t n2) {
+				size_t n = (std::min)(n1, n2), i = 0;
+				for(; i + 16 <= n; i += 16) {
+					uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_fold16(_load16(s1 + i)), _fold16(_load16(s2 + i)))));
+					if(mask != 0xFFFF) {
+						i += _ctz(~mask);
+						return _fold(static_cast<unsigned char>(s1[i])) < _fold(static_cast<unsigned char>(s2[i])) ? -1 : 1;
+					}
+				}
+				int ret = _tail_cmp(s1 + i, s2 + i, n - i);
+				return ret != 0 ? ret : _len_cmp(n1, n2);
+			}
+			inline bool eq_sse2(const char* s1, const char* s2, size_t n) {
+				size_t i = 0;
+				for(; i + 16 <= n; i += 16)
+					if(_mm_movemask_epi8(_mm_cmpeq_epi8(_fold16(_load16(s1 + i)), _fold16(_load16(s2 + i)))) != 0xFFFF)
+						return false;
+				return eq_scalar(s1 + i, s2 + i, n - i);
+			}
+			inline uint64_t hash_sse2(const char* s, size_t n) {
+				uint64_t acc[2] = { 0, _k_mul };
+				size_t i = 0;
+				alignas(16) uint64_t w[2];
+				for(; i + 16 <= n; i += 16) { // two words, one for each accumulator
+					_mm_store_si128(reinterpret_cast<__m128i*>(w), _fold16(_load16(s + i)));
+					acc[0] = _mix(acc[0], w[0]);
+					acc[1] = _mix(acc[1], w[1]);
+				}
+				if(i + 8 <= n) {
+					acc[0] = _mix(acc[0], _fold8(_load8(s + i, 8)));
+					i += 8;
+					if(i < n)
+						acc[1] = _mix(acc[1], _fold8(_load8(s + i, n - i)));
+				}
+				else if(i < n)
+					acc[0] = _mix(acc[0], _fold8(_load8(s + i, n - i)));
+				return _finish(acc[0], acc[1], n);
+			}
+			#endif
+
+			#ifdef REGEDIT_AVX2
+			#ifdef _MSC_VER
+			#define REGEDIT_TARGET_AVX2
+			#else
+			#define REGEDIT_TARGET_AVX2 __attribute__((target("avx2")))
+			#endif
+			REGEDIT_TARGET_AVX2 inline __m256i _fold32(__m256i v) {
+				__m256i lower = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), v));
+				return _mm256_sub_epi8(v, _mm256_and_si256(lower, _mm256_set1_epi8(0x20)));
+			}
+			REGEDIT_TARGET_AVX2 inline __m256i _load32(const char* p) {
+				return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+			}
+
+			// the 32 byte blocks, the rest goes through the SSE2 versions
+			REGEDIT_TARGET_AVX2 inline int cmp_avx2(const char* s1, size_t n1, const char* s2, size_t n2) {
+				size_t n = (std::min)(n1, n2), i = 0;
+				for(; i + 32 <= n; i += 32) {
+					uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_fold32(_load32(s1 + i)), _fold32(_load32(s2 + i)))));
+					if(mask != 0xFFFFFFFFu) {
+						i += _ctz(~mask);
+						return _fold(static_cast<unsigned char>(s1[i])) < _fold(static_cast<unsigned char>(s2[i])) ? -1 : 1;
+					}
+				}
+				return cmp_sse2(s1 + i, n1 - i, s2 + i, n2 - i);
+			}
+			REGEDIT_TARGET_AVX2 inline bool eq_avx2(const char* s1, const char* s2, size_t n) {
+				size_t i = 0;
+				for(; i + 32 <= n; i += 32)
+					if(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_fold32(_load32(s1 + i)), _fold32(_load32(s2 + i))))) != 0xFFFFFFFFu)
+						return false;
+				return eq_sse2(s1 + i, s2 + i, n - i);
+			}
+			REGEDIT_TARGET_AVX2 inline uint64_t hash_avx2(const char* s, size_t n) {
+				uint64_t acc[2] = { 0, _k_mul };
+				size_t i = 0;
+				alignas(32) uint64_t w[4];
+				for(; i + 32 <= n; i += 32) {
+					_mm256_store_si256(reinterpret_cast<__m256i*>(w), _fold32(_load32(s + i)));
+					acc[0] = _mix(acc[0], w[0]);
+					acc[1] = _mix(acc[1], w[1]);
+					acc[0] = _mix(acc[0], w[2]);
+					acc[1] = _mix(acc[1], w[3]);
+				}
+				for(size_t k = 0; i < n; i += 8, ++k) // even number of words so far, the parity starts again at acc[0]
+					acc[k & 1] = _mix(acc[k & 1], _fold8(_load8(s + i, n - i)));
+				return _finish(acc[0], acc[1], n);
+			}
+
+			inline bool _cpu_avx2() {
+				#ifdef _MSC_VER
+				int info[4];
+				__cpuid(info, 0);
+				if(info[0] < 7)
+					return false;
+				__cpuid(info, 1);
+				if((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6) // OSXSAVE, and the OS saving the YMM registers
+					return false;
+				__cpuidex(info, 7, 0);
+				return (info[1] & (1 << 5)) != 0;
+				#else
+				return __builtin_cpu_supports("avx2") != 0;
+				#endif
+			}
+			inline bool _use_avx2() {
+				static const bool avx2 = _cpu_avx2();
+				return avx2;
+			}
+			#endif
+
+			// dispatched versions, the AVX2 ones are only worth for the longer names
+
+			inline int cmp(const char* s1, size_t n1, const char* s2, size_t n2) {
+				#if defined(REGEDIT_AVX2)
+				if(n1 >= 32 && n2 >= 32 && _use_avx2())
+					return cmp_avx2(s1, n1, s2, n2);
+				#endif
+				#if defined(REGEDIT_SSE2)
+				return cmp_sse2(s1, n1, s2, n2);
+				#else
+				return cmp_scalar(s1, n1, s2, n2);
+				#endif
+			}
+			inline bool eq(const char* s1, size_t n1, const char* s2, size_t n2) {
+				if(n1 != n2)
+					return false;
+				#if defined(REGEDIT_AVX2)
+				if(n1 >= 32 && _use_avx2())
+					return eq_avx2(s1, s2, n1);
+				#endif
+				#if defined(REGEDIT_SSE2)
+				return eq_sse2(s1, s2, n1);
+				#else
+				return eq_scalar(s1, s2, n1);
+				#endif
+			}
+			inline uint64_t hash(const char* s, size_t n) {
+				#if defined(REGEDIT_AVX2)
+				if(n >= 32 && _use_avx2())
+					return hash_avx2(s, n);
+				#endif
+				#if defined(REGEDIT_SSE2)
+				return hash_sse2(s, n);
+				#else
+				return hash_scalar(s, n);
+				#endif
+			}
+
+		}
+
+		/*
+			UTF-8 <-> UTF-16LE transcoding over byte buffers (UTF-16 data is unaligned and little endian on every backend). The SSE2 kernels
+			take 8 UTF-16 chars at once while they're all ASCII or all 2 byte sequences, and 16 UTF-8 bytes at once while they're ASCII,
+			any other block goes through the scalar kernels. Unpaired surrogates are dropped, invalid UTF-8 sequences are taken as Latin-1
+		*/
+		namespace utf {
+
+			// next code point of an UTF-8 string
+			inline uint32_t next(const BYTE* src, size_t len, size_t& pos) {
+				uint32_t c = src[pos];
+				size_t n = c >= 0xF0 && c < 0xF8 ? 3 : c >= 0xE0 && c < 0xF0 ? 2 : c >= 0xC0 && c < 0xE0 ? 1 : 0;
+				if(n == 0 || pos + n >= len) {
+					++pos;
+					return c;
+				}
+				uint32_t cp = c & (0x3F >> n);
+				for(size_t i = 1; i <= n; ++i) {
+					if((src[pos + i] & 0xC0) != 0x80) {
+						++pos;
+						return c;
+					}
+					cp = (cp << 6) | (src[pos + i] & 0x3F);
+				}
+				pos += n + 1;
+				return cp;
+			}
+			// a code point as UTF-8 (4 bytes at most) and as UTF-16LE (2 or 4 bytes), out = nullptr just counts
+			inline size_t put8(uint32_t cp, char* out) {
+				size_t n = cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+				if(out != nullptr) {
+					switch(n) {
+						case 1: out[0] = static_cast<char>(cp); break;
+						case 2: out[0] = static_cast<char>(0xC0 | (cp >> 6));  out[1] = static_cast<char>(0x80 | (cp & 0x3F)); break;
+						case 3: out[0] = static_cast<char>(0xE0 | (cp >> 12)); out[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));  out[2] = static_cast<char>(0x80 | (cp & 0x3F)); break;
+						case 4: out[0] = static_cast<char>(0xF0 | (cp >> 18)); out[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F)); out[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F)); out[3] = static_cast<char>(0x80 | (cp & 0x3F)); break;
+					}
+				}
+				return n;
+			}
+			inline size_t put16(uint32_t cp, BYTE* out) {
+				if(cp < 0x10000) {
+					if(out != nullptr) {
+						out[0] = static_cast<BYTE>(cp);
+						out[1] = static_cast<BYTE>(cp >> 8);
+					}
+					return 2;
+				}
+				cp -= 0x10000;
+				if(out != nullptr) {
+					uint32_t high = 0xD800 + (cp >> 10), low = 0xDC00 + (cp & 0x3FF);
+					out[0] = static_cast<BYTE>(high);
+					out[1] = static_cast<BYTE>(high >> 8);
+					out[2] = static_cast<BYTE>(low);
+					out[3] = static_cast<BYTE>(low >> 8);
+				}
+				return 4;
+			}
+
+			// UTF-16LE to UTF-8, 'high' keeps a high surrogate split from its pair by the end of a chunk, out = nullptr just counts.
+			// Writes bytes / 2 * 3 + 1 bytes at most
+			inline size_t to_utf8_scalar(const BYTE* src, size_t bytes, char* out, uint32_t& high) {
+				uint32_t pending = high; // a local, the stores through 'out' could alias it
+				size_t len = 0;
+				for(size_t i = 0; i + 1 < bytes; i += 2) {
+					uint32_t cp = src[i] | (src[i + 1] << 8);
+					if(cp < 0x80) {
+						pending = 0;
+						if(out != nullptr)
+							out[len] = static_cast<char>(cp);
+						++len;
+						continue;
+					}
+					if(cp >= 0xD800 && cp <= 0xDBFF) {
+						pending = cp;
+						continue;
+					}
+					if(cp >= 0xDC00 && cp <= 0xDFFF) {
+						if(pending == 0)
+							continue;
+						cp = 0x10000 + ((pending - 0xD800) << 10) + (cp - 0xDC00);
+					}
+					pending = 0;
+					len += put8(cp, out != nullptr ? out + len : nullptr);
+				}
+				high = pending;
+				return len;
+			}
+			// UTF-8 to UTF-16LE, out = nullptr just counts. Writes len * 2 bytes at most
+			inline size_t to_utf16_scalar(const BYTE* src, size_t len, BYTE* out) {
+				size_t bytes = 0;
+				for(size_t pos = 0; pos < len; ) {
+					uint32_t cp = src[pos] < 0x80 ? src[pos++] : next(src, len, pos);
+					bytes += put16(cp, out != nullptr ? out + bytes : nullptr);
+				}
+				return bytes;
+			}
+
+			#ifdef REGEDIT_SSE2
+			// chars taken by the scalar kernels after a block that isn't ASCII, text with other scripts rarely gives a full ASCII block again soon
+			constexpr size_t _scalar_run = 64;
+
+			inline size_t to_utf8_sse2(const BYTE* src, size_t bytes, char* out, uint32_t& high) {
+				const __m128i zero = _mm_setzero_si128();
+				size_t len = 0, i = 0;
+				while(i + 1 < bytes) {
+					for(; i + 16 <= bytes; i += 16) {
+						__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+						int ascii = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xFF80))), zero));
+						if(ascii == 0xFFFF) {
+							if(out != nullptr)
+								_mm_storel_epi64(reinterpret_cast<__m128i*>(out + len), _mm_packus_epi16(v, v));
+							len += 8;
+						}
+						else if(ascii == 0 && _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(static_cast<short>(0xF800))), zero)) == 0xFFFF) {
+							// 0x80 - 0x7FF, each char gives 110xxxxx 10xxxxxx
+							if(out != nullptr) {
+								__m128i lead = _mm_or_si128(_mm_srli_epi16(v, 6), _mm_set1_epi16(0xC0));
+								__m128i cont = _mm_slli_epi16(_mm_or_si128(_mm_and_si128(v, _mm_set1_epi16(0x3F)), _mm_set1_epi16(0x80)), 8);
+								_mm_storeu_si128(reinterpret_cast<__m128i*>(out + len), _mm_or_si128(lead, cont));
+							}
+							len += 16;
+						}
+						else
+							break;
+						high = 0; // no low surrogate in the block, a pending high one is dropped
+					}
+					size_t n = (std::min)(bytes - i, _scalar_run * 2);
+					len += to_utf8_scalar(src + i, n, out != nullptr ? out + len : nullptr, high);
+					i += n;
+				}
+				return len;
+			}
+			inline size_t to_utf16_sse2(const BYTE* src, size_t len, BYTE* out) {
+				const __m128i zero = _mm_setzero_si128();
+				size_t bytes = 0, pos = 0;
+				while(pos < len) {
+					for(; pos + 16 <= len; pos += 16) {
+						__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + pos));
+						if(_mm_movemask_epi8(v) != 0)
+							break;
+						if(out != nullptr) {
+							_mm_storeu_si128(reinterpret_cast<__m128i*>(out + bytes), _mm_unpacklo_epi8(v, zero));
+							_mm_storeu_si128(reinterpret_cast<__m128i*>(out + bytes + 16), _mm_unpackhi_epi8(v, zero));
+						}
+						bytes += 32;
+					}
+					// the last sequence can go past the run
+					for(size_t end = (std::min)(pos + _scalar_run, len); pos < end; ) {
+						uint32_t cp = src[pos] < 0x80 ? src[pos++] : next(src, len, pos);
+						bytes += put16(cp, out != nullptr ? out + bytes : nullptr);
+					}
+				}
+				return bytes;
+			}
+			#endif
+
+			inline size_t to_utf8(const BYTE* src, size_t bytes, char* out, uint32_t& high) {
+				#if defined(REGEDIT_SSE2)
+				return to_utf8_sse2(src, bytes, out, high);
+				#else
+				return to_utf8_scalar(src, bytes, out, high);
+				#endif
+			}
+			inline size_t to_utf16(const BYTE* src, size_t len, BYTE* out) {
+				#if defined(REGEDIT_SSE2)
+				return to_utf16_sse2(src, len, out);
+				#else
+				return to_utf16_scalar(src, len, out);
+				#endif
+			}
+
+			// a wchar_t string (UTF-16 on Windows, UTF-32 elsewhere) appended as UTF-8
+			inline void from_wide(const wchar_t* src, size_t count, std::string& out) {
+				size_t base = out.size();
+				if(sizeof(wchar_t) == 2) {
+					uint32_t high = 0;
+					out.resize(base + count * 3 + 1);
+					out.resize(base + to_utf8(reinterpret_cast<const BYTE*>(src), count * 2, &out[base], high));
+					return;
+				}
+				char tmp[4];
+				for(size_t i = 0; i < count; ++i) {
+					uint32_t cp = static_cast<uint32_t>(src[i]);
+					if(cp < 0x110000 && (cp < 0xD800 || cp > 0xDFFF))
+						out.append(tmp, put8(cp, tmp));
+				}
+			}
+			// an UTF-8 string appended as a wchar_t one
+			inline void to_wide(const char* src, size_t len, std::wstring& out) {
+				size_t base = out.size();
+				if(sizeof(wchar_t) == 2) {
+					out.resize(base + len); // never more UTF-16 chars than UTF-8 bytes
+					out.resize(base + to_utf16(reinterpret_cast<const BYTE*>(src), len, reinterpret_cast<BYTE*>(&out[base])) / 2);
+					return;
+				}
+				for(size_t pos = 0; pos < len; )
+					out.push_back(static_cast<wchar_t>(next(reinterpret_cast<const BYTE*>(src), len, pos)));
+			}
+
+		}
+
+		// UTF-16LE to UTF-8, fed by chunks (big data segments may split a surrogate pair), out = nullptr just counts
+		struct _utf16_to_utf8 {
+			uint32_t high = 0;
+			size_t feed(const BYTE* src, size_t bytes, char* out) {
+				return utf::to_utf8(src, bytes, out, high);
+			}
+		};
+		inline uint32_t _utf8_next(const BYTE* src, size_t len, size_t& pos) {
+			return utf::next(src, len, pos);
+		}
+		// appends the UTF-16LE form of an UTF-8 string
+		inline void _utf8_to_utf16(const BYTE* src, size_t len, std::vector<BYTE>& out) {
+			size_t base = out.size();
+			out.resize(base + len * 2);
+			out.resize(base + utf::to_utf16(src, len, out.data() + base));
+		}
+
+		// optional backend functions
+		template<class Backend, class = void> struct _has_find_key : std::false_type {};
+		template<class Backend> struct _has_find_key<Backend, decltype(void(Backend::find_key(typename Backend::handle(), "", nullptr)))> : std::true_type {};
+		template<class Backend, class = void> struct _has_find_value : std::false_type {};
+		template<class Backend> struct _has_find_value<Backend, decltype(void(Backend::find_value(typename Backend::handle(), "", nullptr)))> : std::true_type {};
+		template<class Backend, class = void> struct _has_query_stamp : std::false_type {};
+		template<class Backend> struct _has_query_stamp<Backend, decltype(void(Backend::query_stamp(typename Backend::handle(), nullptr, nullptr, nullptr)))> : std::true_type {};
+		template<class Backend, class = void> struct _has_enum_data : std::false_type {};
+		template<class Backend> struct _has_enum_data<Backend, decltype(void(Backend::enum_data(typename Backend::handle(), 0, nullptr, nullptr, nullptr, nullptr, nullptr)))> : std::true_type {};
+		template<class Backend, class = void> struct _has_query_key_info : std::false_type {};
+		template<class Backend> struct _has_query_key_info<Backend, decltype(void(Backend::query_key_info(typename Backend::handle(), nullptr)))> : std::true_type {};
+		template<class Backend, class = void> struct _has_create_keys : std::false_type {};
+		template<class Backend> struct _has_create_keys<Backend, decltype(void(Backend::create_keys(typename Backend::handle(), nullptr, 0, nullptr)))> : std::true_type {};
+		template<class Backend, class = void> struct _has_create_values : std::false_type {};
+		template<class Backend> struct _has_create_values<Backend, decltype(void(Backend::create_values(typename Backend::handle(), nullptr, 0, nullptr)))> : std::true_type {};
+		template<class Backend, class = void> struct _has_delete_keys : std::false_type {};
+		template<class Backend> struct _has_delete_keys<Backend, decltype(void(Backend::delete_keys(typename Backend::handle(), nullptr, 0, nullptr)))> : std::true_type {};
+		template<class Backend, class = void> struct _has_delete_values : std::false_type {};
+		template<class Backend> struct _has_delete_values<Backend, decltype(void(Backend::delete_values(typename Backend::handle(), nullptr, 0, nullptr)))> : std::true_type {};
+		template<class Backend, class = void> struct _has_query_change_stamp : std::false_type {};
+		template<class Backend> struct _has_query_change_stamp<Backend, decltype(void(Backend::query_change_stamp(typename Backend::handle(), nullptr, nullptr)))> : std::true_type {};
+
+		constexpr DWORD key_name_size = 255 * 3 + 1; // 255 UTF-16 chars, 3 UTF-8 bytes each at most, plus the null
+		constexpr DWORD value_name_size = 16383 * 3 + 1;
+		constexpr DWORD index_min_size = 64; // keys with less subkeys (or values) are searched over the enumeration
+
+		// what RegQueryInfoKey tells about a key, the lengths are UTF-8 bytes without the null (upper bounds, 0 when the backend doesn't know them)
+		struct key_info {
+			DWORD subkeys = 0;
+			DWORD values = 0;
+			DWORD max_key_name = 0;
+			DWORD max_value_name = 0;
+			DWORD max_value_data = 0;
+			DWORD64 stamp = 0; // same than query_stamp(), 0 when the backend has none
+		};
+
+		// without query_key_info(), the counts (and the stamp) with unknown lengths
+		template<class Backend>
+		long _query_counts(typename Backend::handle hk, key_info* info, std::true_type) {
+			return Backend::query_stamp(hk, &info->stamp, &info->subkeys, &info->values);
+		}
+		template<class Backend>
+		long _query_counts(typename Backend::handle hk, key_info* info, std::false_type) {
+			return Backend::query_info(hk, &info->subkeys, &info->values);
+		}
+		template<class Backend>
+		long _query_key_info(typename Backend::handle hk, key_info* info, std::true_type) {
+			return Backend::query_key_info(hk, info);
+		}
+		template<class Backend>
+		long _query_key_info(typename Backend::handle hk, key_info* info, std::false_type) {
+			*info = key_info();
+			return _query_counts<Backend>(hk, info, _has_query_stamp<Backend>());
+		}
+
+		// without query_change_stamp(), the key_info stamp is taken as the last write time of the key, and the subtree one is unknown (0)
+		template<class Backend>
+		long _query_change_stamp(typename Backend::handle hk, DWORD64* key, DWORD64* tree, std::true_type) {
+			return Backend::query_change_stamp(hk, key, tree);
+		}
+		template<class Backend>
+		long _query_change_stamp(typename Backend::handle hk, DWORD64* key, DWORD64* tree, std::false_type) {
+			key_info info;
+			long ret = _query_key_info<Backend>(hk, &info, _has_query_key_info<Backend>());
+			*key = _has_query_key_info<Backend>::value ? info.stamp : 0; // a query_stamp() one doesn't see the data changes
+			*tree = 0;
+			return ret;
+		}
+
+		// batched changes, one call per name when the backend has no batched version : a bad handle stops them, any other
+		// failure is returned once all the names went through (a missing name is not one when deleting)
+		inline bool _bulk_stop(long ret) {
+			return ret == status::invalid_handle || ret == status::key_deleted;
+		}
+		template<class Backend>
+		long _create_keys(typename Backend::handle hk, const char* const* names, DWORD count, DWORD* created, std::true_type) {
+			return Backend::create_keys(hk, names, count, created);
+		}
+		template<class Backend>
+		long _create_keys(typename Backend::handle hk, const char* const* names, DWORD count, DWORD* created, std::false_type) {
+			long err = status::success;
+			*created = 0;
+			for(DWORD i = 0; i < count; ++i) {
+				typename Backend::handle sub = typename Backend::handle();
+				bool crt = false;
+				long ret = Backend::create(hk, names[i], false, &sub, &crt);
+				if(_bulk_stop(ret))
+					return ret;
+				if(ret == status::success) {
+					Backend::close(sub);
+					*created += crt ? 1 : 0;
+				}
+				else if(err == status::success)
+					err = ret;
+			}
+			return err;
+		}
+		template<class Backend>
+		long _create_values(typename Backend::handle hk, const char* const* names, DWORD count, DWORD* created, std::true_type) {
+			return Backend::create_values(hk, names, count, created);
+		}
+		template<class Backend>
+		long _create_values(typename Backend::handle hk, const char* const* names, DWORD count, DWORD* created, std::false_type) {
+			long err = status::success;
+			*created = 0;
+			for(DWORD i = 0; i < count; ++i) {
+				long ret = Backend::query_value(hk, names[i], nullptr, nullptr, nullptr);
+				if(ret == status::file_not_found && (ret = Backend::set_value(hk, names[i], 0, nullptr, 0)) == status::success)
+					++*created;
+				if(_bulk_stop(ret))
+					return ret;
+				if(ret != status::success && err == status::success)
+					err = ret;
+			}
+			return err;
+		}
+		template<class Backend>
+		long _delete_keys(typename Backend::handle hk, const char* const* names, DWORD count, DWORD* deleted, std::true_type) {
+			return Backend::delete_keys(hk, names, count, deleted);
+		}
+		template<class Backend>
+		long _delete_keys(typename Backend::handle hk, const char* const* names, DWORD count, DWORD* deleted, std::false_type) {
+			long err = status::success;
+			*deleted = 0;
+			for(DWORD i = 0; i < count; ++i) {
+				if(*names[i] == '\0') // the key itself
+					continue;
+				long ret = Backend::delete_tree(hk, names[i]);
+				if(_bulk_stop(ret))
+					return ret;
+				if(ret == status::success)
+					++*deleted;
+				else if(ret != status::file_not_found && err == status::success)
+					err = ret;
+			}
+			return err;
+		}
+		template<class Backend>
+		long _delete_values(typename Backend::handle hk, const char* const* names, DWORD count, DWORD* deleted, std::true_type) {
+			return Backend::delete_values(hk, names, count, deleted);
+		}
+		template<class Backend>
+		long _delete_values(typename Backend::handle hk, const char* const* names, DWORD count, DWORD* deleted, std::false_type) {
+			long err = status::success;
+			*deleted = 0;
+			for(DWORD i = 0; i < count; ++i) {
+				long ret = Backend::delete_value(hk, names[i]);
+				if(_bulk_stop(ret))
+					return ret;
+				if(ret == status::success)
+					++*deleted;
+				else if(ret != status::file_not_found && err == status::success)
+					err = ret;
+			}
+			return err;
+		}
+
+		// the names given to a batched change, as the C strings the backends take
+		class _name_list {
+
+			private:
+
+				std::vector<std::string> _strs;
+				std::vector<const char*> _ptrs;
+
+			public:
+
+				_name_list() {}
+				template<class InputIterator>
+				_name_list(InputIterator left, InputIterator right) {
+					for(; left != right; ++left)
+						_strs.push_back(*left);
+				}
+
+				void push_back(std::string str) {
+					_strs.push_back(std::move(str));
+				}
+				const char* const* data() {
+					if(_ptrs.size() != _strs.size()) {
+						_ptrs.clear();
+						for(const std::string& str : _strs)
+							_ptrs.push_back(str.c_str());
+					}
+					return _ptrs.data();
+				}
+				DWORD size() const {
+					return static_cast<DWORD>(_strs.size());
+				}
+
+		};
+
+
+		// case-insensitive name -> enumeration position, open addressing over a flat table
+		class name_index {
+
+			private:
+
+				struct _slot {
+					uint32_t hash;
+					DWORD pos; // position + 1, 0 for an empty slot
+				};
+
+				std::vector<char> _names;
+				std::vector<size_t> _offs; // by position
+				std::vector<_slot> _slots;
+				DWORD64 _stamp = 0;
+
+				size_t _length(DWORD pos) const {
+					return (pos + 1 < _offs.size() ? _offs[pos + 1] : _names.size()) - _offs[pos] - 1;
+				}
+
+			public:
+
+				DWORD64 stamp() const {
+					return _stamp;
+				}
+				DWORD size() const {
+					return static_cast<DWORD>(_offs.size());
+				}
+
+				// fn(pos, name, &len) -> status, same contract than Backend::enum_key/enum_value, name_size is the expected longest name (grown if needed)
+				template<class EnumFn>
+				bool build(DWORD64 stamp, DWORD count, DWORD name_size, EnumFn fn) {
+					_stamp = stamp;
+					_names.clear();
+					_offs.clear();
+					_offs.reserve(count);
+					_names.reserve(static_cast<size_t>(count) * 16);
+					std::vector<char> buff((std::max)(name_size, static_cast<DWORD>(256)));
+					long ret;
+					for(DWORD pos = 0; ; ) {
+						DWORD len = static_cast<DWORD>(buff.size());
+						ret = fn(pos, buff.data(), &len);
+						if(ret == status::more_data && buff.size() < (1u << 20)) {
+							buff.resize(buff.size() * 4);
+							continue;
+						}
+						if(ret != status::success)
+							break;
+						_offs.push_back(_names.size());
+						_names.insert(_names.end(), buff.data(), buff.data() + len + 1);
+						++pos;
+					}
+					if(ret != status::no_more_items)
+						return false;
+
+					size_t cap = 16;
+					while(cap < _offs.size() * 2)
+						cap <<= 1;
+					_slots.assign(cap, _slot{ 0, 0 });
+					for(DWORD pos = 0; pos < _offs.size(); ++pos) {
+						uint64_t h = names::hash(&_names[_offs[pos]], _length(pos));
+						size_t i = static_cast<size_t>(h) & (cap - 1);
+						while(_slots[i].pos != 0)
+							i = (i + 1) & (cap - 1);
+						_slots[i] = _slot{ static_cast<uint32_t>(h >> 32), pos + 1 };
+					}
+					return true;
+				}
+
+				// size() if not found
+				DWORD find(const char* name) const {
+					if(_slots.empty())
+						return size();
+					size_t len = strlen(name);
+					uint64_t h = names::hash(name, len);
+					size_t mask = _slots.size() - 1;
+					for(size_t i = static_cast<size_t>(h) & mask; _slots[i].pos != 0; i = (i + 1) & mask) {
+						const _slot& sl = _slots[i];
+						if(sl.hash == static_cast<uint32_t>(h >> 32) && names::eq(&_names[_offs[sl.pos - 1]], _length(sl.pos - 1), name, len))
+							return sl.pos - 1;
+					}
+					return size();
+				}
+
+		};
+
+		// refcounted owner of a backend handle, copies share the same open handle instead of reopening it
+		template<class Backend>
+		class shared_handle {
+
+			private:
+
+				using handle = typename Backend::handle;
+
+				struct _index {
+					std::unique_ptr<name_index> idx;
+					DWORD64 seen_stamp = 0;
+					DWORD seen_count = 0;
+					bool seen = false;
+				};
+				struct _block {
+					handle hk;
+					bool write;
+					std::atomic<long> refs;
+					std::atomic<unsigned long> gen{0}; // bumped when a subkey or value is added or removed through the handle
+					std::mutex mtx; // guards the indexes and the key info
+					_index index[2]; // subkeys, values
+					key_info info;
+					unsigned long info_gen = 0;
+					bool has_info = false;
+					_block(handle h, bool w) : hk(h), write(w), refs(1) {}
+				};
+
+				_block* _b = nullptr;
+
+				bool _refresh(key_info* out, unsigned long gen) const {
+					key_info fresh;
+					if(_query_key_info<Backend>(_b->hk, &fresh, _has_query_key_info<Backend>()) != status::success)
+						return false;
+					std::lock_guard<std::mutex> lock(_b->mtx);
+					_b->info = fresh;
+					_b->info_gen = gen; // a touch() meanwhile leaves it stale, queried again on the next call
+					_b->has_info = true;
+					*out = fresh;
+					return true;
+				}
+
+				void _release() {
+					if(_b != nullptr && _b->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+						Backend::close(_b->hk);
+						delete _b;
+					}
+					_b = nullptr;
+				}
+
+			public:
+
+				shared_handle() {}
+				shared_handle(const shared_handle& other) : _b(other._b) {
+					if(_b != nullptr)
+						_b->refs.fetch_add(1, std::memory_order_relaxed);
+				}
+				shared_handle(shared_handle&& other) : _b(other._b) {
+					other._b = nullptr;
+				}
+				~shared_handle() {
+					_release();
+				}
+
+				shared_handle& operator=(const shared_handle& other) {
+					shared_handle(other).swap(*this);
+					return *this;
+				}
+				shared_handle& operator=(shared_handle&& other) {
+					shared_handle(std::move(other)).swap(*this);
+					return *this;
+				}
+
+				// takes the ownership of an already opened handle
+				static shared_handle adopt(handle hk, bool write_permision) {
+					shared_handle tmp;
+					if(hk != handle())
+						tmp._b = new _block(hk, write_permision);
+					return tmp;
+				}
+				// empty on failure
+				static shared_handle open(handle parent, const char* key, bool write_permision) {
+					handle hk = handle();
+					if(Backend::open(parent, key, write_permision, &hk) != status::success)
+						return shared_handle();
+					return adopt(hk, write_permision);
+				}
+
+				handle get() const {
+					return _b != nullptr ? _b->hk : handle();
+				}
+				operator handle() const {
+					return get();
+				}
+
+				bool is_open() const {
+					return _b != nullptr;
+				}
+				bool write() const {
+					return _b != nullptr && _b->write;
+				}
+				long use_count() const {
+					return _b != nullptr ? _b->refs.load(std::memory_order_relaxed) : 0;
+				}
+
+				void reset() {
+					_release();
+				}
+				void swap(shared_handle& other) {
+					std::swap(_b, other._b);
+				}
+
+				/*
+					Counts and name / data lengths of the key, queried once and kept until a subkey or value is added or removed through
+					this handle (touch()), changes made elsewhere (other handles, other processes) need a touch() too. find() checks the
+					live stamp of the keys it indexes and refreshes them
+				*/
+				bool info(key_info* out) const {
+					if(_b == nullptr)
+						return false;
+					_block* b = _b;
+					unsigned long gen = b->gen.load(std::memory_order_acquire);
+					{
+						std::lock_guard<std::mutex> lock(b->mtx);
+						if(b->has_info && b->info_gen == gen) {
+							*out = b->info;
+							return true;
+						}
+					}
+					return _refresh(out, gen);
+				}
+				void touch() const {
+					if(_b != nullptr)
+						_b->gen.fetch_add(1, std::memory_order_acq_rel);
+				}
+
+				/*
+					Hashed lookup for large keys, false if the index can't be used (backend without query_stamp(), small key, ...)
+					The index is built on a lookup once the key stamp is seen unchanged twice (so insert loops don't rebuild it every time),
+					and dropped when the live stamp or count of the key changes : its positions are only used against the current ones
+				*/
+				bool find(bool values, const char* name, DWORD* pos) const {
+					return find(values, name, pos, _has_query_stamp<Backend>());
+				}
+				bool find(bool, const char*, DWORD*, std::false_type) const {
+					return false;
+				}
+				bool find(bool values, const char* name, DWORD* pos, std::true_type) const {
+					key_info ki;
+					if(!info(&ki) || (values ? ki.values : ki.subkeys) < index_min_size)
+						return false;
+					key_info live; // one stamp query per lookup, only on the keys large enough to be indexed
+					if(Backend::query_stamp(_b->hk, &live.stamp, &live.subkeys, &live.values) != status::success)
+						return false;
+					if(live.stamp != ki.stamp || live.subkeys != ki.subkeys || live.values != ki.values) { // changed through another handle
+						if(!_refresh(&ki, _b->gen.load(std::memory_order_acquire)))
+							return false;
+					}
+					DWORD64 stamp = live.stamp;
+					DWORD count = values ? live.values : live.subkeys;
+					if(count < index_min_size || ki.stamp != stamp || (values ? ki.values : ki.subkeys) != count)
+						return false;
+
+					std::lock_guard<std::mutex> lock(_b->mtx);
+					_index& ix = _b->index[values ? 1 : 0];
+					if(ix.idx == nullptr || ix.idx->stamp() != stamp || ix.idx->size() != count) {
+						ix.idx.reset();
+						if(!ix.seen || ix.seen_stamp != stamp || ix.seen_count != count) {
+							ix.seen = true;
+							ix.seen_stamp = stamp;
+							ix.seen_count = count;
+							return false;
+						}
+						handle hk = _b->hk;
+						std::unique_ptr<name_index> idx(new name_index());
+						bool built = values ?
+							idx->build(stamp, count, ki.max_value_name + 1, [hk](DWORD p, char* buff, DWORD* len) { return Backend::enum_value(hk, p, buff, len); }) :
+							idx->build(stamp, count, ki.max_key_name + 1, [hk](DWORD p, char* buff, DWORD* len) { return Backend::enum_key(hk, p, buff, len); });
+						if(!built || idx->size() != count)
+							return false;
+						ix.idx = std::move(idx);
+					}
+					*pos = ix.idx->find(name);
+					return true;
+				}
+				// for the changes the stamp can miss (e.g. a delete and an insert within the same Win32 last write time tick)
+				void invalidate() const {
+					if(_b == nullptr)
+						return;
+					touch();
+					std::lock_guard<std::mutex> lock(_b->mtx);
+					for(_index& ix : _b->index)
+						ix = _index();
+				}
+
+				bool operator==(const shared_handle& other) const {
+					return get() == other.get();
+				}
+				bool operator!=(const shared_handle& other) const {
+					return !(*this == other);
+				}
+
+		};
+
+		template<class Backend, class ValType, class CmpIter, class IterChild, class GenFn>
+		class iter {
+
+			protected:
+
+				shared_handle<Backend> _hkey;
+				DWORD _pos = 0;
+
+				iter(const shared_handle<Backend>& hkey, DWORD pos) : _hkey(hkey), _pos(pos) {}
+
+			public:
+
+				using iterator_category = std::input_iterator_tag; // operator* returns by value, +=, -, [] and the comparisons are extras
+				using value_type        = std::pair<const std::string, ValType>;
+				using difference_type   = ptrdiff_t;
+				using reference         = value_type; // objects are created on the fly
+
+				// keeps the generated object alive for the duration of operator->
+				struct pointer {
+					value_type v;
+					value_type* operator->() { return &v; }
+				};
+
+				iter() {}
+				iter(const iter&) = default;
+				iter(iter&&) = default;
+
+				IterChild& operator=(const iter& other) {
+					_hkey = other._hkey;
+					_pos = other._pos;
+					return static_cast<IterChild&>(*this);
+				}
+				IterChild& operator=(iter&& other) {
+					std::swap(_hkey, other._hkey);
+					std::swap(_pos, other._pos);
+					return static_cast<IterChild&>(*this);
+				}
+
+				bool operator==(const IterChild& other) const {
+					return _pos == other._pos && _hkey == other._hkey;
+				}
+				bool operator!=(const IterChild& other) const {
+					return !(*this == other);
+				}
+				bool operator==(const CmpIter& other) const {
+					return _pos == other._pos && _hkey == other._hkey;
+				}
+				bool operator!=(const CmpIter& other) const {
+					return !(*this == other);
+				}
+
+				bool operator<(const iter& other) const {
+					return _pos < other._pos;
+				}
+				bool operator>(const iter& other) const {
+					return other < *this;
+				}
+				bool operator<=(const iter& other) const {
+					return !(other < *this);
+				}
+				bool operator>=(const iter& other) const {
+					return !(*this < other);
+				}
+
+				IterChild& operator++() {
+					++_pos;
+					return static_cast<IterChild&>(*this);
+				}
+				IterChild operator++(int) {
+					iter tmp(*this);
+					++(*this);
+					return static_cast<IterChild&>(tmp);
+				}
+
+				IterChild& operator--() {
+					--_pos;
+					return static_cast<IterChild&>(*this);
+				}
+				IterChild operator--(int) {
+					iter tmp(*this);
+					--(*this);
+					return static_cast<IterChild&>(tmp);
+				}
+
+				IterChild& operator+=(difference_type n) {
+					_pos = static_cast<DWORD>(static_cast<difference_type>(_pos) + n);
+					return static_cast<IterChild&>(*this);
+				}
+				IterChild& operator-=(difference_type n) {
+					return *this += -n;
+				}
+				IterChild operator+(difference_type n) const {
+					IterChild tmp(static_cast<const IterChild&>(*this));
+					return tmp += n;
+				}
+				friend IterChild operator+(difference_type n, const IterChild& it) {
+					return it + n;
+				}
+				IterChild operator-(difference_type n) const {
+					IterChild tmp(static_cast<const IterChild&>(*this));
+					return tmp -= n;
+				}
+				difference_type operator-(const iter& other) const {
+					return static_cast<difference_type>(_pos) - static_cast<difference_type>(other._pos);
+				}
+
+				reference operator*() const {
+					REGEDIT_TRACE(iterate);
+					return GenFn()(_hkey, _pos);
+				}
+				reference operator[](difference_type n) const {
+					REGEDIT_TRACE(iterate);
+					return GenFn()(_hkey, static_cast<DWORD>(static_cast<difference_type>(_pos) + n));
+				}
+
+				pointer operator->() const {
+					REGEDIT_TRACE(iterate);
+					return pointer{GenFn()(_hkey, _pos)};
+				}
+
+		};
+
+		enum class type : DWORD { // REG_* values
+			none                       = 0,
+			sz                         = 1,
+			expand_sz                  = 2,
+			binary                     = 3,
+			dword                      = 4,
+			dword_little_endian        = 4,
+			dword_big_endian           = 5,
+			link                       = 6,
+			multi_sz                   = 7,
+			resource_list              = 8,
+			full_resource_descriptor   = 9,
+			resource_requirements_list = 10,
+			qword                      = 11,
+			qword_little_endian        = 11
+		};
+
+		// first 'c' of s[0, n), nullptr if there's none : 8 bytes at once (SWAR), 16 with SSE2
+		inline const char* _find_char_scalar(const char* s, size_t n, char c) {
+			const uint64_t low = 0x0101010101010101ull, high = 0x8080808080808080ull, key = low * static_cast<unsigned char>(c);
+			size_t i = 0;
+			for(; i + 8 <= n; i += 8) {
+				uint64_t w = names::_load8(s + i, 8) ^ key; // zero bytes where 'c' is
+				if(((w - low) & ~w & high) != 0)
+					break;
+			}
+			for(; i < n; ++i)
+				if(s[i] == c)
+					return s + i;
+			return nullptr;
+		}
+		#ifdef REGEDIT_SSE2
+		inline const char* _find_char_sse2(const char* s, size_t n, char c) {
+			const __m128i key = _mm_set1_epi8(c);
+			size_t i = 0;
+			for(; i + 16 <= n; i += 16) {
+				uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(names::_load16(s + i), key)));
+				if(mask != 0)
+					return s + i + names::_ctz(mask);
+			}
+			return _find_char_scalar(s + i, n - i, c);
+		}
+		#endif
+		inline const char* _find_char(const char* s, size_t n, char c) {
+			#if defined(REGEDIT_SSE2)
+			return _find_char_sse2(s, n, c);
+			#else
+			return _find_char_scalar(s, n, c);
+			#endif
+		}
+
+		// same rules than ExpandEnvironmentStrings over any variable source, the expansion is appended to 'out'. lookup(name, len, out)
+		// appends the variable and returns true if it's defined, an unknown %variable% is left untouched and its closing '%' can open the next one
+		template<class Lookup>
+		void _expand_vars(const char* str, size_t len, std::string& out, Lookup&& lookup) {
+			const char* end = str + len;
+			for(const char* left; (left = _find_char(str, static_cast<size_t>(end - str), '%')) != nullptr; ) {
+				const char* right = _find_char(left + 1, static_cast<size_t>(end - left - 1), '%');
+				if(right == nullptr)
+					break;
+				out.append(str, left);
+				if(right - left > 1 && lookup(left + 1, static_cast<size_t>(right - left - 1), out))
+					str = right + 1;
+				else {
+					out.append(left, right);
+					str = right;
+				}
+			}
+			out.append(str, end);
+		}
+
+		// replaces the %variables% of 'str' from the process environment, through per-thread buffers (no allocations once they're big enough)
+		inline void _expand_env(std::string& str) {
+			if(_find_char(str.data(), str.size(), '%') == nullptr)
+				return;
+			#ifdef _WIN32
+			static thread_local std::wstring wide, exp;
+			wide.clear();
+			utf::to_wide(str.c_str(), strlen(str.c_str()), wide);
+			if(exp.size() < 256)
+				exp.resize(256);
+			DWORD len = ExpandEnvironmentStringsW(wide.c_str(), &exp[0], static_cast<DWORD>(exp.size()));
+			if(len > exp.size()) { // only called again when it doesn't fit
+				exp.resize(len);
+				len = ExpandEnvironmentStringsW(wide.c_str(), &exp[0], static_cast<DWORD>(exp.size()));
+			}
+			if(len == 0 || len > exp.size())
+				return;
+			str.clear();
+			utf::from_wide(exp.c_str(), len - 1, str);
+			#else
+			static thread_local std::string exp, var;
+			exp.clear();
+			_expand_vars(str.data(), str.size(), exp, [](const char* name, size_t len, std::string& out) {
+				var.assign(name, len);
+				const char* val = getenv(var.c_str());
+				if(val == nullptr)
+					return false;
+				out.append(val);
+				return true;
+			});
+			str.swap(exp);
+			#endif
+		}
+
+		struct snapshot_entry {
+			const char* name = nullptr; // null terminated, owned by the snapshot
+			size_t length = 0;
+			type ty = type::none;       // values only, and only when requested
+			DWORD size = 0;             // same
+		};
+
+		// names fetched in a single enumeration pass into one contiguous buffer, entries are views into it
+		template<class Backend>
+		class snapshot {
+
+			protected:
+
+				shared_handle<Backend> _hkey; // shared with the key it was taken from
+				bool _write = true;
+				std::vector<char> _names;
+				std::vector<snapshot_entry> _entries;
+
+				snapshot() {}
+				snapshot(const snapshot& other) {
+					*this = other;
+				}
+				snapshot(snapshot&& other) {
+					swap(other);
+				}
+
+				snapshot& operator=(const snapshot& other) {
+					_hkey = other._hkey;
+					_write = other._write;
+					_names = other._names;
+					_entries = other._entries;
+					_relocate();
+					return *this;
+				}
+				snapshot& operator=(snapshot&& other) {
+					swap(other);
+					return *this;
+				}
+
+				// fn(handle, pos, name, &len, &entry) -> status, same contract than Backend::enum_key/enum_value
+				template<class EnumFn>
+				void _fill(const shared_handle<Backend>& hk, bool write_permision, DWORD count, size_t buff_size, EnumFn fn) {
+					_hkey = hk;
+					_write = write_permision;
+					_entries.reserve(count);
+					_names.reserve(static_cast<size_t>(count) * 16);
+					std::vector<char> buff(buff_size);
+					for(DWORD pos = 0; ; ) {
+						snapshot_entry e;
+						DWORD len = static_cast<DWORD>(buff.size());
+						long ret = fn(_hkey, pos, buff.data(), &len, &e);
+						if(ret == status::more_data && buff.size() < (1u << 20)) { // names converted to UTF-8 can be longer than the Win32 limit
+							buff.resize(buff.size() * 4);
+							continue;
+						}
+						if(ret != status::success)
+							break;
+						e.length = len;
+						_names.insert(_names.end(), buff.data(), buff.data() + len + 1);
+						_entries.push_back(e);
+						++pos;
+					}
+					_relocate();
+				}
+
+				// names are stored back to back, so the views can be rebuilt from the lengths
+				void _relocate() {
+					const char* p = _names.data();
+					for(snapshot_entry& e : _entries) {
+						e.name = p;
+						p += e.length + 1;
+					}
+				}
+
+			public:
+
+				using entry                  = snapshot_entry;
+				using value_type             = snapshot_entry;
+				using size_type              = size_t;
+				using iterator               = typename std::vector<snapshot_entry>::const_iterator;
+				using const_iterator         = iterator;
+				using reverse_iterator       = std::reverse_iterator<iterator>;
+				using const_reverse_iterator = reverse_iterator;
+
+				// Iterators:
+
+				iterator begin() const {
+					return _entries.begin();
+				}
+				iterator cbegin() const {
+					return _entries.begin();
+				}
+				iterator end() const {
+					return _entries.end();
+				}
+				iterator cend() const {
+					return _entries.end();
+				}
+				reverse_iterator rbegin() const {
+					return _entries.rbegin();
+				}
+				reverse_iterator rend() const {
+					return _entries.rend();
+				}
+
+				// Element Access:
+
+				const entry& operator[](size_t pos) const {
+					return _entries[pos];
+				}
+				const entry& at(size_t pos) const {
+					if(pos >= _entries.size())
+						throw std::out_of_range("neo::regedit::snapshot::at(): position out of range");
+					return _entries[pos];
+				}
+
+				// Capacity:
+
+				bool empty() const {
+					return _entries.empty();
+				}
+				size_t size() const {
+					return _entries.size();
+				}
+
+				// Operations:
+
+				iterator find(const std::string& name) const {
+					return std::find_if(_entries.begin(), _entries.end(), [&](const snapshot_entry& e) { return names::eq(e.name, e.length, name.data(), name.size()); });
+				}
+
+				bool is_open() const {
+					return _hkey.is_open();
+				}
+
+				void swap(snapshot& other) {
+					std::swap(_hkey, other._hkey);
+					std::swap(_write, other._write);
+					_names.swap(other._names); // the buffers are moved, the views stay valid
+					_entries.swap(other._entries);
+				}
+
+		};
+
+		namespace read_overload { // GCC needs all this instead just a simple 'auto' return
+
+			template<type T>
+			using _return_t =
+				typename std::conditional<T == type::none,                       void*,
+				typename std::conditional<T == type::sz,                         std::string,
+				typename std::conditional<T == type::expand_sz,                  std::string,
+				typename std::conditional<T == type::binary,                     std::unique_ptr<BYTE[]>,
+				typename std::conditional<T == type::dword,                      DWORD,
+				typename std::conditional<T == type::dword_big_endian,           DWORD,
+				typename std::conditional<T == type::link,                       std::wstring,
+				typename std::conditional<T == type::multi_sz,                   std::vector<std::string>,
+				typename std::conditional<T == type::resource_list,              std::unique_ptr<BYTE[]>,
+				typename std::conditional<T == type::full_resource_descriptor,   std::unique_ptr<BYTE[]>,
+				typename std::conditional<T == type::resource_requirements_list, std::unique_ptr<BYTE[]>,
+				typename std::conditional<T == type::qword,                      DWORD64,
+				std::nullptr_t>::type>::type>::type>::type>::type>::type>::type>::type>::type>::type>::type>::type;
+
+			// storage filled by the reads into a caller object, binary types go to a reusable vector
+			template<type T>
+			using _into_t = typename std::conditional<std::is_same<_return_t<T>, std::unique_ptr<BYTE[]>>::value, std::vector<BYTE>, _return_t<T>>::type;
+
+			// inline storage, the heap is only used for the values bigger than it
+			class _buffer {
+
+				private:
+
+					BYTE _inline[512];
+					std::unique_ptr<BYTE[]> _heap;
+					DWORD _cap = sizeof(_inline);
+
+				public:
+
+					BYTE* data() {
+						return _heap != nullptr ? _heap.get() : _inline;
+					}
+					DWORD capacity() const {
+						return _cap;
+					}
+					BYTE* reserve(DWORD len) {
+						if(len > _cap) {
+							_heap.reset(new BYTE[len]);
+							_cap = len;
+						}
+						return data();
+					}
+
+			};
+
+			// one query when the value fits on the given storage, resize(len) -> BYTE* is only called if it doesn't (or the value grew meanwhile)
+			template<class Backend, class Resize>
+			long _query(typename Backend::handle hk, const char* name, DWORD* ty, BYTE* data, DWORD cap, DWORD* len, Resize resize) {
+				if(data == nullptr)
+					data = resize(cap = 16);
+				for(;;) {
+					*len = cap;
+					long ret = Backend::query_value(hk, name, ty, data, len);
+					if(ret != status::more_data)
+						return ret;
+					data = resize(cap = *len);
+				}
+			}
+			template<class Backend>
+			long _query(typename Backend::handle hk, const char* name, DWORD* ty, _buffer& buff, DWORD* len) {
+				return _query<Backend>(hk, name, ty, buff.data(), buff.capacity(), len, [&](DWORD n) { return buff.reserve(n); });
+			}
+
+			// reuses the string storage, the value ends at its first null (the stored terminator is optional)
+			template<class Backend>
+			bool _read_sz(typename Backend::handle hk, const char* name, std::string& out) {
+				DWORD len = 0;
+				out.resize(out.capacity());
+				long ret = _query<Backend>(hk, name, nullptr, reinterpret_cast<BYTE*>(&out[0]), static_cast<DWORD>(out.size()), &len, [&](DWORD n) {
+					out.resize(n);
+					return reinterpret_cast<BYTE*>(&out[0]);
+				});
+				if(ret != status::success) {
+					out.clear();
+					return false;
+				}
+				out.resize(std::find(out.begin(), out.begin() + len, '\0') - out.begin());
+				return true;
+			}
+			template<class Backend>
+			bool _read_bin(typename Backend::handle hk, const char* name, std::vector<BYTE>& out) {
+				DWORD len = 0;
+				out.resize((std::max)(out.capacity(), static_cast<size_t>(16)));
+				long ret = _query<Backend>(hk, name, nullptr, out.data(), static_cast<DWORD>(out.size()), &len, [&](DWORD n) {
+					out.resize(n);
+					return out.data();
+				});
+				out.resize(ret == status::success ? len : 0);
+				return ret == status::success;
+			}
+			// smaller values are zero extended, bigger ones truncated
+			template<class Backend, class T>
+			bool _read_pod(typename Backend::handle hk, const char* name, T& out) {
+				_buffer buff;
+				DWORD len = 0;
+				out = T();
+				if(_query<Backend>(hk, name, nullptr, buff, &len) != status::success)
+					return false;
+				memcpy(&out, buff.data(), (std::min)(static_cast<size_t>(len), sizeof(T)));
+				return true;
+			}
+
+			template<class Backend>
+			std::unique_ptr<BYTE[]> read(typename Backend::handle hk, const char* name) {
+				_buffer buff;
+				DWORD len = 0;
+				if(_query<Backend>(hk, name, nullptr, buff, &len) != status::success)
+					len = 0;
+				std::unique_ptr<BYTE[]> ptr(new BYTE[len]);
+				memcpy(ptr.get(), buff.data(), len);
+				return ptr;
+			}
+
+			template<type T> struct _reader; // a function template can't be partially specialized by the backend
+			template<type T, class Backend> _return_t<T> read(typename Backend::handle hk, const char* name) {
+				return _reader<T>::template read<Backend>(hk, name);
+			}
+			template<type T, class Backend> bool read(typename Backend::handle hk, const char* name, _into_t<T>& out) {
+				return _reader<T>::template read<Backend>(hk, name, out);
+			}
+
+			template<> struct _reader<type::none> {
+				template<class Backend> static _return_t<type::none>                       /* void*                    */ read(typename Backend::handle, const char*) {
+					return static_cast<void*>(nullptr);
+				}
+				template<class Backend> static bool read(typename Backend::handle hk, const char* name, void*& out) {
+					out = nullptr;
+					return Backend::query_value(hk, name, NULL, NULL, NULL) == status::success;
+				}
+			};
+			template<> struct _reader<type::sz> {
+				template<class Backend> static _return_t<type::sz>                         /* std::string              */ read(typename Backend::handle hk, const char* name) {
+					std::string str;
+					_read_sz<Backend>(hk, name, str);
+					return str;
+				}
+				template<class Backend> static bool read(typename Backend::handle hk, const char* name, std::string& out) {
+					return _read_sz<Backend>(hk, name, out);
+				}
+			};
+			template<> struct _reader<type::expand_sz> {
+				template<class Backend> static _return_t<type::expand_sz>                  /* std::string              */ read(typename Backend::handle hk, const char* name) {
+					std::string str = read_overload::read<type::sz, Backend>(hk, name);
+					_expand_env(str);
+					return str;
+				}
+				template<class Backend> static bool read(typename Backend::handle hk, const char* name, std::string& out) {
+					if(!_read_sz<Backend>(hk, name, out))
+						return false;
+					_expand_env(out);
+					return true;
+				}
+			};
+			template<> struct _reader<type::binary> {
+				template<class Backend> static _return_t<type::binary>                     /* std::unique_ptr<BYTE[]>  */ read(typename Backend::handle hk, const char* name) {
+					return read_overload::read<Backend>(hk, name);
+				}
+				template<class Backend> static bool read(typename Backend::handle hk, const char* name, std::vector<BYTE>& out) {
+					return _read_bin<Backend>(hk, name, out);
+				}
+			};
+			template<> struct _reader<type::dword> {
+				template<class Backend> static _return_t<type::dword>                      /* DWORD                    */ read(typename Backend::handle hk, const char* name) {
+					DWORD val = 0;
+					_read_pod<Backend>(hk, name, val);
+					return val;
+				}
+				template<class Backend> static bool read(typename Backend::handle hk, const char* name, DWORD& out) {
+					return _read_pod<Backend>(hk, name, out);
+				}
+			};
+			template<> struct _reader<type::dword_big_endian> {
+				template<class Backend> static _return_t<type::dword_big_endian>           /* DWORD                    */ read(typename Backend::handle hk, const char* name) {
+					return read_overload::read<type::dword, Backend>(hk, name);
+					//std::unique_ptr<BYTE> pt = read<type::binary>();
+					//return DWORD((pt.get()[0] << 24) | (pt.get()[1] << 16) | (pt.get()[2] << 16) | (pt.get()[3] << 0));
+				}
+				template<class Backend> static bool read(typename Backend::handle hk, const char* name, DWORD& out) {
+					return _read_pod<Backend>(hk, name, out);
+				}
+			};
+			template<> struct _reader<type::link> {
+				template<class Backend> static _return_t<type::link>                       /* std::wstring             */ read(typename Backend::handle hk, const char* name) {
+					std::wstring str;
+					read<Backend>(hk, name, str);
+					return str;
+				}
+				template<class Backend> static bool read(typename Backend::handle hk, const char* name, std::wstring& out) {
+					_buffer buff;
+					DWORD len = 0;
+					if(_query<Backend>(hk, name, nullptr, buff, &len) != status::success) {
+						out.clear();
+						return false;
+					}
+					out.resize(len / sizeof(wchar_t));
+					if(!out.empty())
+						memcpy(&out[0], buff.data(), out.size() * sizeof(wchar_t));
+					out.resize(std::find(out.begin(), out.end(), L'\0') - out.begin());
+					return true;
+				}
+				// the target as UTF-8
+				template<class Backend> static bool read(typename Backend::handle hk, const char* name, std::string& out) {
+					std::wstring wide;
+					out.clear();
+					if(!read<Backend>(hk, name, wide))
+						return false;
+					utf::from_wide(wide.data(), wide.size(), out);
+					return true;
+				}
+			};
+			template<> struct _reader<type::multi_sz> {
+				template<class Backend> static _return_t<type::multi_sz>                   /* std::vector<std::string> */ read(typename Backend::handle hk, const char* name) {
+					std::vector<std::string> vec;
+					read<Backend>(hk, name, vec);
+					return vec;
+				}
+				// the strings already in 'out' are reused
+				template<class Backend> static bool read(typename Backend::handle hk, const char* name, std::vector<std::string>& out) {
+					_buffer buff;
+					DWORD len = 0;
+					size_t count = 0;
+					bool ok = _query<Backend>(hk, name, nullptr, buff, &len) == status::success;
+					const char* str = reinterpret_cast<const char*>(buff.data());
+					for(size_t off = 0; ok && off < len && str[off] != '\0'; ++count) {
+						size_t size = std::find(str + off, str + len, '\0') - (str + off);
+						if(count < out.size())
+							out[count].assign(str + off, size);
+						else
+							out.emplace_back(str + off, size);
+						off += size + 1;
+					}
+					out.resize(count);
+					return ok;
+				}
+			};
+			template<> struct _reader<type::resource_list> {
+				template<class Backend> static _return_t<type::resource_list>              /* std::unique_ptr<BYTE[]>  */ read(typename Backend::handle hk, const char* name) {
+					return read_overload::read<Backend>(hk, name);
+				}
+				template<class Backend> static bool read(typename Backend::handle hk, const char* name, std::vector<BYTE>& out) {
+					return _read_bin<Backend>(hk, name, out);
+				}
+			};
+			template<> struct _reader<type::full_resource_descriptor> {
+				template<class Backend> static _return_t<type::full_resource_descriptor>   /* std::unique_ptr<BYTE[]>  */ read(typename Backend::handle hk, const char* name) {
+					return read_overload::read<Backend>(hk, name);
+				}
+				template<class Backend> static bool read(typename Backend::handle hk, const char* name, std::vector<BYTE>& out) {
+					return _read_bin<Backend>(hk, name, out);
+				}
+			};
+			template<> struct _reader<type::resource_requirements_list> {
+				template<class Backend> static _return_t<type::resource_requirements_list> /* std::unique_ptr<BYTE[]>  */ read(typename Backend::handle hk, const char* name) {
+					return read_overload::read<Backend>(hk, name);
+				}
+				template<class Backend> static bool read(typename Backend::handle hk, const char* name, std::vector<BYTE>& out) {
+					return _read_bin<Backend>(hk, name, out);
+				}
+			};
+			template<> struct _reader<type::qword> {
+				template<class Backend> static _return_t<type::qword>                      /* DWORD64                  */ read(typename Backend::handle hk, const char* name) {
+					DWORD64 val = 0;
+					_read_pod<Backend>(hk, name, val);
+					return val;
+				}
+				template<class Backend> static bool read(typename Backend::handle hk, const char* name, DWORD64& out) {
+					return _read_pod<Backend>(hk, name, out);
+				}
+			};
+		}
+
+		// non-owning piece of a string value
+		class str_view {
+
+			private:
+
+				const char* _data = "";
+				size_t _size = 0;
+
+			public:
+
+				using const_iterator = const char*;
+
+				str_view() {}
+				str_view(const char* str, size_t len) : _data(str), _size(len) {}
+				str_view(const char* str) : _data(str), _size(strlen(str)) {}
+				str_view(const std::string& str) : _data(str.data()), _size(str.size()) {}
+
+				const char* data() const {
+					return _data;
+				}
+				size_t size() const {
+					return _size;
+				}
+				size_t length() const {
+					return _size;
+				}
+				bool empty() const {
+					return _size == 0;
+				}
+				const char* begin() const {
+					return _data;
+				}
+				const char* end() const {
+					return _data + _size;
+				}
+				char operator[](size_t pos) const {
+					return _data[pos];
+				}
+
+				std::string str() const {
+					return std::string(_data, _size);
+				}
+				#ifdef REGEDIT_STRING_VIEW
+				operator std::string_view() const {
+					return std::string_view(_data, _size);
+				}
+				#endif
+
+				friend bool operator==(const str_view& lhs, const str_view& rhs) {
+					return lhs._size == rhs._size && memcmp(lhs._data, rhs._data, lhs._size) == 0;
+				}
+				friend bool operator!=(const str_view& lhs, const str_view& rhs) {
+					return !(lhs == rhs);
+				}
+
+		};
+
+		// value data kept on a single buffer reused by the next reads, always null terminated
+		class _text_buffer {
+
+			protected:
+
+				std::unique_ptr<char[]> _buff;
+				DWORD _cap = 0;
+				size_t _len = 0;
+				char _none[2] = {}; // data of a view never read
+
+				char* _text() {
+					return _buff != nullptr ? _buff.get() : _none;
+				}
+				const char* _text() const {
+					return _buff != nullptr ? _buff.get() : _none;
+				}
+
+				template<class Backend>
+				bool _fill(typename Backend::handle hk, const char* name) {
+					DWORD len = 0;
+					long ret = read_overload::_query<Backend>(hk, name, nullptr, reinterpret_cast<BYTE*>(_buff.get()), _cap, &len, [this](DWORD n) {
+						_buff.reset(new char[static_cast<size_t>(n) + 2]);
+						_cap = n;
+						return reinterpret_cast<BYTE*>(_buff.get());
+					});
+					_len = ret == status::success ? len : 0;
+					if(_buff != nullptr)
+						_buff[_len] = _buff[_len + 1] = '\0'; // the stored terminators are optional
+					return ret == status::success;
+				}
+
+			public:
+
+				_text_buffer() {}
+				_text_buffer(_text_buffer&& other) {
+					swap(other);
+				}
+				_text_buffer& operator=(_text_buffer&& other) {
+					swap(other);
+					return *this;
+				}
+
+				void swap(_text_buffer& other) {
+					_buff.swap(other._buff);
+					std::swap(_cap, other._cap);
+					std::swap(_len, other._len);
+				}
+
+		};
+
+		// sz / expand_sz value owning its buffer, it can be parsed (and modified) in place
+		class sz_view : public _text_buffer {
+
+			public:
+
+				using iterator       = char*;
+				using const_iterator = const char*;
+
+				char* data() {
+					return _text();
+				}
+				const char* data() const {
+					return _text();
+				}
+				const char* c_str() const {
+					return data();
+				}
+				size_t size() const {
+					return _len;
+				}
+				size_t length() const {
+					return _len;
+				}
+				bool empty() const {
+					return _len == 0;
+				}
+				char* begin() {
+					return data();
+				}
+				char* end() {
+					return data() + _len;
+				}
+				const char* begin() const {
+					return data();
+				}
+				const char* end() const {
+					return data() + _len;
+				}
+				char& operator[](size_t pos) {
+					return data()[pos];
+				}
+				char operator[](size_t pos) const {
+					return data()[pos];
+				}
+
+				str_view view() const {
+					return str_view(data(), _len);
+				}
+				operator str_view() const {
+					return view();
+				}
+				std::string str() const {
+					return std::string(data(), _len);
+				}
+
+				// the string ends at its first null, 'expand' replaces the %variables% as read<type::expand_sz>() does
+				template<class Backend>
+				bool read(typename Backend::handle hk, const char* name, bool expand = false) {
+					bool ok = _fill<Backend>(hk, name);
+					_len = strlen(_text());
+					if(ok && expand && memchr(data(), '%', _len) != nullptr) {
+						std::string exp(data(), _len);
+						_expand_env(exp);
+						if(exp.size() > _cap) {
+							_buff.reset(new char[exp.size() + 2]);
+							_cap = static_cast<DWORD>(exp.size());
+						}
+						memcpy(_buff.get(), exp.c_str(), exp.size() + 1);
+						_len = exp.size();
+					}
+					return ok;
+				}
+
+		};
+
+		// multi_sz value owning its buffer, the strings are found while iterating (up to the first empty one)
+		class multi_sz_view : public _text_buffer {
+
+			public:
+
+				class const_iterator {
+
+					private:
+
+						const char* _p = nullptr;
+						const char* _end = nullptr;
+						str_view _cur;
+
+						void _take() {
+							if(_p < _end && *_p != '\0')
+								_cur = str_view(_p, strlen(_p));
+							else
+								_p = _end;
+						}
+
+					public:
+
+						using iterator_category = std::forward_iterator_tag;
+						using value_type        = str_view;
+						using difference_type   = std::ptrdiff_t;
+						using pointer           = const str_view*;
+						using reference         = const str_view&;
+
+						const_iterator() {}
+						const_iterator(const char* p, const char* end) : _p(p), _end(end) {
+							_take();
+						}
+
+						reference operator*() const {
+							return _cur;
+						}
+						pointer operator->() const {
+							return &_cur;
+						}
+						const_iterator& operator++() {
+							_p += _cur.size() + 1;
+							_take();
+							return *this;
+						}
+						const_iterator operator++(int) {
+							const_iterator tmp = *this;
+							++*this;
+							return tmp;
+						}
+
+						bool operator==(const const_iterator& other) const {
+							return _p == other._p;
+						}
+						bool operator!=(const const_iterator& other) const {
+							return _p != other._p;
+						}
+
+				};
+				using iterator = const_iterator;
+
+				const_iterator begin() const {
+					return const_iterator(_text(), _text() + _len);
+				}
+				const_iterator end() const {
+					return const_iterator(_text() + _len, _text() + _len);
+				}
+				bool empty() const {
+					return begin() == end();
+				}
+				// counts the strings, O(n)
+				size_t size() const {
+					return static_cast<size_t>(std::distance(begin(), end()));
+				}
+				str_view front() const {
+					return *begin();
+				}
+
+				template<class Backend>
+				bool read(typename Backend::handle hk, const char* name) {
+					return _fill<Backend>(hk, name);
+				}
+
+		};
+
+		template<type T>
+		using _view_t = typename std::conditional<T == type::multi_sz, multi_sz_view, sz_view>::type;
+
+		template<class Backend>
+		bool _read_view(typename Backend::handle hk, const char* name, sz_view& out, bool expand) {
+			return out.read<Backend>(hk, name, expand);
+		}
+		template<class Backend>
+		bool _read_view(typename Backend::handle hk, const char* name, multi_sz_view& out, bool) {
+			return out.read<Backend>(hk, name);
+		}
+
+		// one call when the backend enumerates the data too and it fits on the buffer, enum + query otherwise
+		template<class Backend>
+		long _enum_data(typename Backend::handle hk, DWORD pos, char* name, DWORD name_cap, DWORD* ty, read_overload::_buffer& buff, DWORD* len, std::false_type) {
+			DWORD nlen = name_cap, size = 0;
+			long ret = Backend::enum_value(hk, pos, name, &nlen, ty, &size);
+			if(ret != status::success)
+				return ret;
+			buff.reserve(size);
+			return read_overload::_query<Backend>(hk, name, ty, buff, len);
+		}
+		template<class Backend>
+		long _enum_data(typename Backend::handle hk, DWORD pos, char* name, DWORD name_cap, DWORD* ty, read_overload::_buffer& buff, DWORD* len, std::true_type) {
+			DWORD nlen = name_cap;
+			*len = buff.capacity();
+			long ret = Backend::enum_data(hk, pos, name, &nlen, ty, buff.data(), len);
+			if(ret != status::more_data)
+				return ret;
+			return _enum_data<Backend>(hk, pos, name, name_cap, ty, buff, len, std::false_type());
+		}
+
+		// a value of a value_table, the name and the data are views into the buffers of the table
+		struct value_info {
+			const char* name = nullptr; // null terminated
+			size_t length = 0;
+			type ty = type::none;
+			const BYTE* data = nullptr; // 8 bytes aligned, followed by two nulls not counted on the size
+			DWORD size = 0;
+
+			// sz / expand_sz data up to its first null, not expanded
+			str_view str() const {
+				const char* p = reinterpret_cast<const char*>(data);
+				return str_view(p, strlen(p));
+			}
+			// dword, dword_big_endian (byte swapped) and qword data, 0 for any other type
+			DWORD64 number() const {
+				if(ty == type::qword && size >= sizeof(DWORD64)) {
+					DWORD64 v;
+					memcpy(&v, data, sizeof(v));
+					return v;
+				}
+				if((ty == type::dword || ty == type::dword_big_endian) && size >= sizeof(DWORD)) {
+					DWORD v;
+					memcpy(&v, data, sizeof(v));
+					return ty == type::dword ? v : ((v >> 24) | ((v >> 8) & 0xFF00) | ((v << 8) & 0xFF0000) | (v << 24));
+				}
+				return 0;
+			}
+		};
+
+		// names, types and data of all the values of a key taken in a single enumeration pass (one backend call per value with enum_data()),
+		// the names and the data of every value go back to back on two buffers
+		template<class Backend>
+		class value_table {
+
+			protected:
+
+				shared_handle<Backend> _hkey; // shared with the key it was taken from
+				bool _write = true;
+				std::vector<char> _names;
+				std::vector<BYTE> _data;
+				std::vector<value_info> _entries;
+
+				value_table() {}
+				value_table(const value_table& other) {
+					*this = other;
+				}
+				value_table(value_table&& other) {
+					swap(other);
+				}
+
+				value_table& operator=(const value_table& other) {
+					_hkey = other._hkey;
+					_write = other._write;
+					_names = other._names;
+					_data = other._data;
+					_entries = other._entries;
+					_relocate();
+					return *this;
+				}
+				value_table& operator=(value_table&& other) {
+					swap(other);
+					return *this;
+				}
+
+				static size_t _align8(size_t n) {
+					return (n + 7) & ~static_cast<size_t>(7);
+				}
+
+				void _fill(const shared_handle<Backend>& hk, bool write_permision, const key_info& info) {
+					_hkey = hk;
+					_write = write_permision;
+					_entries.reserve(info.values);
+					std::vector<char> name(info.max_value_name != 0 ? info.max_value_name + 1 : value_name_size);
+					read_overload::_buffer buff;
+					buff.reserve(info.max_value_data);
+					for(DWORD pos = 0; ; ) {
+						value_info e;
+						DWORD ty = 0, len = 0;
+						long ret = _enum_data<Backend>(_hkey, pos, name.data(), static_cast<DWORD>(name.size()), &ty, buff, &len, _has_enum_data<Backend>());
+						if(ret == status::more_data && name.size() < value_name_size) { // a name longer than the key info said, changed meanwhile
+							name.resize(value_name_size);
+							continue;
+						}
+						if(ret != status::success)
+							break;
+						e.length = strlen(name.data());
+						e.ty = static_cast<type>(ty);
+						e.size = len;
+						_names.insert(_names.end(), name.data(), name.data() + e.length + 1);
+						_data.resize(_align8(_data.size()));
+						_data.insert(_data.end(), buff.data(), buff.data() + len);
+						_data.insert(_data.end(), 2, 0);
+						_entries.push_back(e);
+						++pos;
+					}
+					_relocate();
+				}
+
+				// both buffers are filled in order, so the views can be rebuilt from the lengths and sizes
+				void _relocate() {
+					const char* p = _names.data();
+					size_t off = 0;
+					for(value_info& e : _entries) {
+						e.name = p;
+						p += e.length + 1;
+						off = _align8(off);
+						e.data = _data.data() + off;
+						off += e.size + 2;
+					}
+				}
+
+			public:
+
+				using entry                  = value_info;
+				using value_type             = value_info;
+				using size_type              = size_t;
+				using iterator               = typename std::vector<value_info>::const_iterator;
+				using const_iterator         = iterator;
+				using reverse_iterator       = std::reverse_iterator<iterator>;
+				using const_reverse_iterator = reverse_iterator;
+
+				// Iterators:
+
+				iterator begin() const {
+					return _entries.begin();
+				}
+				iterator cbegin() const {
+					return _entries.begin();
+				}
+				iterator end() const {
+					return _entries.end();
+				}
+				iterator cend() const {
+					return _entries.end();
+				}
+				reverse_iterator rbegin() const {
+					return _entries.rbegin();
+				}
+				reverse_iterator rend() const {
+					return _entries.rend();
+				}
+
+				// Element Access:
+
+				const entry& operator[](size_t pos) const {
+					return _entries[pos];
+				}
+				const entry& at(size_t pos) const {
+					if(pos >= _entries.size())
+						throw std::out_of_range("neo::regedit::value_table::at(): position out of range");
+					return _entries[pos];
+				}
+
+				// Capacity:
+
+				bool empty() const {
+					return _entries.empty();
+				}
+				size_t size() const {
+					return _entries.size();
+				}
+				// bytes taken by the data of all the values
+				size_t data_size() const {
+					return _data.size();
+				}
+
+				// Operations:
+
+				iterator find(const std::string& name) const {
+					return std::find_if(_entries.begin(), _entries.end(), [&](const value_info& e) { return names::eq(e.name, e.length, name.data(), name.size()); });
+				}
+
+				bool is_open() const {
+					return _hkey.is_open();
+				}
+
+				void swap(value_table& other) {
+					std::swap(_hkey, other._hkey);
+					std::swap(_write, other._write);
+					_names.swap(other._names); // the buffers are moved, the views stay valid
+					_data.swap(other._data);
+					_entries.swap(other._entries);
+				}
+
+		};
+
+	}
+
+	/*
+		Backend policy, a class with a 'handle' type (value-initialized handle means closed), a 'hkey' struct with the predefined root handles
+		and the next static functions, all of them returning a Win32-like status code (__regedit_details::status) :
+			+ open(handle parent, const char* key, bool write, handle* out)
+			+ create(handle parent, const char* key, bool write, handle* out, bool* created)
+			+ close(handle hk)                                                                 -> void
+			+ query_info(handle hk, DWORD* subkeys, DWORD* values)
+			+ enum_key(handle hk, DWORD pos, char* name, DWORD* len)
+			+ enum_value(handle hk, DWORD pos, char* name, DWORD* len, DWORD* type, DWORD* size)  -> type and size can be nullptr
+			+ query_value(handle hk, const char* name, DWORD* type, BYTE* data, DWORD* len)
+			+ set_value(handle hk, const char* name, DWORD type, const BYTE* data, DWORD len)
+			+ set_value_unicode(handle hk, const char* name, DWORD type, const BYTE* data, DWORD len)
+			+ delete_value(handle hk, const char* name)
+			+ delete_tree(handle hk, const char* key)
+		All of them follows the same rules than their Reg*A counterparts (sizes, ERROR_MORE_DATA, ERROR_NO_MORE_ITEMS, "" key to duplicate a handle, ...),
+		with the names and the sz / expand_sz / multi_sz data in UTF-8 instead of the ANSI code page
+		Optionally, a backend with a direct lookup can provide the next ones, used by find() instead of a binary search over the enumeration :
+			+ find_key(handle hk, const char* name, DWORD* pos)                                -> enumeration position of the subkey
+			+ find_value(handle hk, const char* name, DWORD* pos)                              -> enumeration position of the value
+		And a backend able to tell when a key changes can provide the next one, enabling the hashed name index for large keys :
+			+ query_stamp(handle hk, DWORD64* stamp, DWORD* subkeys, DWORD* values)            -> stamp changes when the subkeys or values of the key change
+		And a backend knowing the longest names and data of a key can provide the next one, used to size the enumeration buffers :
+			+ query_key_info(handle hk, __regedit_details::key_info* info)                      -> counts, stamp and UTF-8 upper bounds of the name and data lengths
+		And a backend able to enumerate a value with its data in one call (as RegEnumValueA does) can provide the next one, used by copy_tree() :
+			+ enum_data(handle hk, DWORD pos, char* name, DWORD* len, DWORD* type, BYTE* data, DWORD* size) -> size is the data capacity on input
+		And a backend able to change many names of a key at once can provide the next ones, used by insert_bulk(), erase_bulk() and clear() :
+			+ create_keys(handle hk, const char* const* names, DWORD count, DWORD* created)     -> created : subkeys that didn't exist
+			+ create_values(handle hk, const char* const* names, DWORD count, DWORD* created)   -> missing values are added as type::none without data
+			+ delete_keys(handle hk, const char* const* names, DWORD count, DWORD* deleted)     -> same than delete_tree() on each one, missing ones are skipped
+			+ delete_values(handle hk, const char* const* names, DWORD count, DWORD* deleted)   -> missing ones are skipped
+		And a backend stamping every change can provide the next one, used by neo::change_feed to skip the unchanged subtrees (without it,
+		the query_key_info() stamp is taken as the last write time of the key) :
+			+ query_change_stamp(handle hk, DWORD64* key, DWORD64* tree)                       -> key : last change of its subkeys, values or data,
+			                                                                                      tree : last change in its whole subtree, 0 if unknown
+	*/
+	namespace regedit_backend {
+
+		#ifdef _WIN32
+		/*
+			Live registry through the Reg*W functions. The names and the sz / expand_sz / multi_sz data are given and taken as UTF-8, as on the
+			other backends, converted through a per-thread buffer (one registry call per operation, same than the Reg*A ones)
+		*/
+		struct win32 {
+
+			private:
+
+				using DWORD   = __regedit_details::DWORD;
+				using DWORD64 = __regedit_details::DWORD64;
+				using BYTE    = __regedit_details::BYTE;
+
+				template<class = void>
+				struct _hkey {
+					static const HKEY classes_root;
+					static const HKEY current_config;
+					static const HKEY current_user;
+					static const HKEY local_machine;
+					static const HKEY users;
+				};
+
+				// an UTF-8 string as the null terminated UTF-16 one the *W calls take, nullptr stays nullptr
+				class _wide {
+
+					private:
+
+						wchar_t _inline[256];
+						std::unique_ptr<wchar_t[]> _heap;
+						const wchar_t* _str = nullptr;
+
+					public:
+
+						explicit _wide(const char* str) {
+							if(str == nullptr)
+								return;
+							size_t len = strlen(str);
+							wchar_t* out = _inline;
+							if(len >= sizeof(_inline) / sizeof(wchar_t)) {
+								_heap.reset(new wchar_t[len + 1]); // never more UTF-16 chars than UTF-8 bytes
+								out = _heap.get();
+							}
+							out[__regedit_details::utf::to_utf16(reinterpret_cast<const BYTE*>(str), len, reinterpret_cast<BYTE*>(out)) / 2] = L'\0';
+							_str = out;
+						}
+						_wide(const _wide&) = delete;
+						_wide& operator=(const _wide&) = delete;
+
+						operator const wchar_t*() const {
+							return _str;
+						}
+
+				};
+
+				struct _scratch {
+					std::vector<wchar_t> name = std::vector<wchar_t>(16384); // value names limit, key names take 255
+					std::vector<BYTE> data = std::vector<BYTE>(512);         // UTF-16 data of the string values
+				};
+				static _scratch& _tls() {
+					static thread_local _scratch buff;
+					return buff;
+				}
+
+				static bool _is_string(DWORD ty) {
+					return ty == REG_SZ || ty == REG_EXPAND_SZ || ty == REG_MULTI_SZ;
+				}
+
+				// the name given by a *W enumeration with the *A rules: 'len' is the capacity on input, the length without the null on output
+				static long _name_out(const wchar_t* src, DWORD count, char* name, DWORD* len) {
+					const BYTE* wide = reinterpret_cast<const BYTE*>(src);
+					uint32_t high = 0;
+					if(*len > count * 3) { // fits for sure, a single pass
+						size_t n = __regedit_details::utf::to_utf8(wide, count * 2, name, high);
+						name[n] = '\0';
+						*len = static_cast<DWORD>(n);
+						return ERROR_SUCCESS;
+					}
+					size_t n = __regedit_details::utf::to_utf8(wide, count * 2, nullptr, high);
+					if(n >= *len)
+						return ERROR_MORE_DATA;
+					high = 0;
+					__regedit_details::utf::to_utf8(wide, count * 2, name, high);
+					name[n] = '\0';
+					*len = static_cast<DWORD>(n);
+					return ERROR_SUCCESS;
+				}
+				// UTF-16 string data given as UTF-8 with the *A rules: 'data' can be nullptr to get the size, 'len' gets the needed size
+				static long _data_out(const BYTE* wide, DWORD bytes, BYTE* data, DWORD* len) {
+					uint32_t high = 0;
+					if(data != nullptr && *len >= bytes / 2 * 3) {
+						*len = static_cast<DWORD>(__regedit_details::utf::to_utf8(wide, bytes, reinterpret_cast<char*>(data), high));
+						return ERROR_SUCCESS;
+					}
+					DWORD need = static_cast<DWORD>(__regedit_details::utf::to_utf8(wide, bytes, nullptr, high));
+					if(data == nullptr || *len < need) {
+						*len = need;
+						return data == nullptr ? ERROR_SUCCESS : ERROR_MORE_DATA;
+					}
+					high = 0;
+					*len = static_cast<DWORD>(__regedit_details::utf::to_utf8(wide, bytes, reinterpret_cast<char*>(data), high));
+					return ERROR_SUCCESS;
+				}
+				// the raw data on 'buff', grown while it doesn't fit (never empty, a null data pointer would just give the size)
+				template<class Query>
+				static LONG _read_wide(std::vector<BYTE>& buff, DWORD* size, Query query) {
+					for(;;) {
+						if(buff.size() < (std::max)(*size, static_cast<DWORD>(1)))
+							buff.resize((std::max)(*size, static_cast<DWORD>(1)));
+						*size = static_cast<DWORD>(buff.size());
+						LONG ret = query(buff.data(), size);
+						if(ret != ERROR_MORE_DATA)
+							return ret;
+					}
+				}
+
+				static LONG _delete_tree(HKEY hk, LPCWSTR pcwstr) {
+					#ifdef _MSC_VER
+					return RegDeleteTreeW(hk, pcwstr);
+					#else
+					typedef LONG(WINAPI *_DLLRegDeleteTreeW)(HKEY, LPCWSTR);
+					static _DLLRegDeleteTreeW rgtwfn = (_DLLRegDeleteTreeW)GetProcAddress(GetModuleHandleA("Advapi32.dll"), "RegDeleteTreeW");
+					return rgtwfn(hk, pcwstr);
+					#endif
+				}
+
+			public:
+
+				using handle = HKEY;
+				using hkey   = _hkey<>;
+
+				static long open(handle parent, const char* key, bool write, handle* out) {
+					return RegOpenKeyExW(parent, _wide(key), 0, write ? (KEY_READ | KEY_WRITE) : (KEY_READ), out);
+				}
+				static long create(handle parent, const char* key, bool write, handle* out, bool* created) {
+					DWORD disp = 0;
+					LONG ret = RegCreateKeyExW(parent, _wide(key), 0, NULL, REG_OPTION_NON_VOLATILE, write ? (KEY_READ | KEY_WRITE) : (KEY_READ), NULL, out, &disp);
+					if(created != nullptr)
+						*created = disp == REG_CREATED_NEW_KEY;
+					return ret;
+				}
+				static void close(handle hk) {
+					RegCloseKey(hk);
+				}
+
+				static long query_info(handle hk, DWORD* subkeys, DWORD* values) {
+					return RegQueryInfoKeyW(hk, NULL, NULL, NULL, subkeys, NULL, NULL, values, NULL, NULL, NULL, NULL);
+				}
+				static long query_stamp(handle hk, DWORD64* stamp, DWORD* subkeys, DWORD* values) { // last write time
+					FILETIME ft = {};
+					LONG ret = RegQueryInfoKeyW(hk, NULL, NULL, NULL, subkeys, NULL, NULL, values, NULL, NULL, NULL, &ft);
+					if(stamp != nullptr)
+						*stamp = (static_cast<DWORD64>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+					return ret;
+				}
+				// UTF-16 lengths turned into UTF-8 upper bounds
+				static long query_key_info(handle hk, __regedit_details::key_info* info) {
+					FILETIME ft = {};
+					DWORD keys = 0, key_len = 0, vals = 0, val_len = 0, data = 0;
+					LONG ret = RegQueryInfoKeyW(hk, NULL, NULL, NULL, &keys, &key_len, NULL, &vals, &val_len, &data, NULL, &ft);
+					if(ret != ERROR_SUCCESS)
+						return ret;
+					info->subkeys = keys;
+					info->values = vals;
+					info->max_key_name = key_len * 3;
+					info->max_value_name = val_len * 3;
+					info->max_value_data = data / 2 * 3 + 1; // for strings, the other types keep their size
+					info->stamp = (static_cast<DWORD64>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+					return ret;
+				}
+				static long enum_key(handle hk, DWORD pos, char* name, DWORD* len) {
+					wchar_t wname[256];
+					DWORD wlen = 256;
+					LONG ret = RegEnumKeyExW(hk, pos, wname, &wlen, NULL, NULL, NULL, NULL);
+					return ret != ERROR_SUCCESS ? ret : _name_out(wname, wlen, name, len);
+				}
+				// string sizes are the UTF-8 ones, so the data of the string values is read too
+				static long enum_value(handle hk, DWORD pos, char* name, DWORD* len, DWORD* ty = nullptr, DWORD* size = nullptr) {
+					_scratch& buff = _tls();
+					DWORD wlen = 0, vty = 0, wsize = 0;
+					LONG ret = _read_wide(buff.data, &wsize, [&](BYTE* data, DWORD* bytes) {
+						wlen = static_cast<DWORD>(buff.name.size());
+						return RegEnumValueW(hk, pos, buff.name.data(), &wlen, NULL, &vty, size != nullptr ? data : NULL, size != nullptr ? bytes : NULL);
+					});
+					if(ret != ERROR_SUCCESS)
+						return ret;
+					if(ty != nullptr)
+						*ty = vty;
+					if(size != nullptr) {
+						*size = wsize;
+						if(_is_string(vty))
+							_data_out(buff.data.data(), wsize, nullptr, size);
+					}
+					return _name_out(buff.name.data(), wlen, name, len);
+				}
+				static long enum_data(handle hk, DWORD pos, char* name, DWORD* len, DWORD* ty, BYTE* data, DWORD* size) {
+					_scratch& buff = _tls();
+					DWORD wlen = static_cast<DWORD>(buff.name.size()), vty = 0, wsize = *size;
+					LONG ret = RegEnumValueW(hk, pos, buff.name.data(), &wlen, NULL, &vty, data, &wsize);
+					if(ret != ERROR_SUCCESS && (ret != ERROR_MORE_DATA || !_is_string(vty))) {
+						*size = wsize;
+						return ret;
+					}
+					if(ret == ERROR_SUCCESS && !_is_string(vty)) {
+						*size = wsize;
+						if(ty != nullptr)
+							*ty = vty;
+						return _name_out(buff.name.data(), wlen, name, len);
+					}
+					if(ret == ERROR_SUCCESS && data != nullptr)
+						buff.data.assign(data, data + wsize);
+					else if((ret = _read_wide(buff.data, &wsize, [&](BYTE* wide, DWORD* bytes) {
+						wlen = static_cast<DWORD>(buff.name.size());
+						return RegEnumValueW(hk, pos, buff.name.data(), &wlen, NULL, &vty, wide, bytes);
+					})) != ERROR_SUCCESS)
+						return ret;
+					if(ty != nullptr)
+						*ty = vty;
+					if((ret = _name_out(buff.name.data(), wlen, name, len)) != ERROR_SUCCESS)
+						return ret;
+					return _data_out(buff.data.data(), wsize, data, size);
+				}
+
+				static long query_value(handle hk, const char* name, DWORD* ty, BYTE* data, DWORD* len) {
+					_wide wname(name);
+					DWORD vty = 0, size = data != nullptr && len != nullptr ? *len : 0;
+					LONG ret = RegQueryValueExW(hk, wname, NULL, &vty, data, len != nullptr ? &size : NULL);
+					if(ty != nullptr)
+						*ty = vty;
+					if((ret != ERROR_SUCCESS && ret != ERROR_MORE_DATA) || len == nullptr || !_is_string(vty)) {
+						if(len != nullptr)
+							*len = size;
+						return ret;
+					}
+					_scratch& buff = _tls();
+					if(ret == ERROR_SUCCESS && data != nullptr)
+						buff.data.assign(data, data + size);
+					else if((ret = _read_wide(buff.data, &size, [&](BYTE* wide, DWORD* bytes) { return RegQueryValueExW(hk, wname, NULL, &vty, wide, bytes); })) != ERROR_SUCCESS)
+						return ret;
+					return _data_out(buff.data.data(), size, data, len);
+				}
+				static long set_value(handle hk, const char* name, DWORD ty, const BYTE* data, DWORD len) {
+					if(data == nullptr || !_is_string(ty))
+						return RegSetValueExW(hk, _wide(name), 0, ty, data, len);
+					_scratch& buff = _tls();
+					if(buff.data.size() < static_cast<size_t>(len) * 2)
+						buff.data.resize(static_cast<size_t>(len) * 2);
+					DWORD bytes = static_cast<DWORD>(__regedit_details::utf::to_utf16(data, len, buff.data.data()));
+					return RegSetValueExW(hk, _wide(name), 0, ty, buff.data.data(), bytes);
+				}
+				static long set_value_unicode(handle hk, const char* name, DWORD ty, const BYTE* data, DWORD len) {
+					return RegSetValueExW(hk, _wide(name), 0, ty, data, len);
+				}
+				static long delete_value(handle hk, const char* name) {
+					return RegDeleteValueW(hk, _wide(name));
+				}
+				static long delete_tree(handle hk, const char* key) {
+					if(key == nullptr || *key == '\0') // clears the key but keeps it
+						return _delete_tree(hk, NULL);
+					return _delete_tree(hk, _wide(key));
+				}
+
+		};
+
+		template<class T> const HKEY win32::_hkey<T>::classes_root   = HKEY_CLASSES_ROOT;
+		template<class T> const HKEY win32::_hkey<T>::current_config = HKEY_CURRENT_CONFIG;
+		template<class T> const HKEY win32::_hkey<T>::current_user   = HKEY_CURRENT_USER;
+		template<class T> const HKEY win32::_hkey<T>::local_machine  = HKEY_LOCAL_MACHINE;
+		template<class T> const HKEY win32::_hkey<T>::users          = HKEY_USERS;
+		#endif
+
+		/*
+			In-process registry, every key keeps its subkeys and values on sorted flat vectors (same case-insensitive order used by the container searches),
+			the predefined hkey roots are process-wide, use a memory::store to get an independent tree.
+			Notes:
+				- Write permissions are not enforced
+				- Handles to deleted keys stay valid until closed, any operation on them returns status::key_deleted
+				- A store must outlive all the handles opened on it
+		*/
+		class memory {
+
+			private:
+
+				using DWORD   = __regedit_details::DWORD;
+				using DWORD64 = __regedit_details::DWORD64;
+				using BYTE    = __regedit_details::BYTE;
+
+				struct _node;
+
+				struct _subkey {
+					std::string name;
+					std::unique_ptr<_node> node;
+				};
+				struct _value {
+					std::string name;
+					DWORD type;
+					std::vector<BYTE> data;
+				};
+
+			public:
+
+				class store;
+
+			private:
+
+				struct _node {
+					store* owner;
+					_node* parent;
+					std::vector<_subkey> keys;
+					std::vector<_value> vals;
+					long refs = 0;
+					DWORD64 gen = 0; // bumped when a subkey or value is added or removed
+					DWORD64 changed = 0, tree_changed = 0; // store clock of the last change of the key (data included) and of its subtree
+					DWORD max_key = 0, max_value = 0, max_data = 0; // longest ones ever added, upper bounds for query_key_info()
+					bool deleted = false;
+					_node(store* st, _node* up = nullptr) : owner(st), parent(up) {}
+				};
+
+			public:
+
+				using handle = _node*;
+
+				class store {
+
+					private:
+
+						std::mutex _mtx;
+						DWORD64 _clock = 0; // change stamps, see query_change_stamp()
+						_node _root;
+
+						friend memory;
+
+					public:
+
+						store() : _root(this) {}
+						store(const store&) = delete;
+						store& operator=(const store&) = delete;
 
+						handle root() {
+							return &_root;
+						}
+
+				};
+
+			private:
+
+				template<class = void>
+				struct _hkey {
+					static const handle classes_root;
+					static const handle current_config;
+					static const handle current_user;
+					static const handle local_machine;
+					static const handle users;
+				};
+
+				static handle _predefined(size_t pos) {
+					static store hives[5];
+					return hives[pos].root();
+				}
+
+				// the length of 'name' is taken once, not on every probe
+				template<class Vec>
+				static typename Vec::iterator _lower(Vec& vec, const char* name, size_t len) {
+					return std::lower_bound(vec.begin(), vec.end(), name, [len](const typename Vec::value_type& elem, const char* str) {
+						return __regedit_details::names::cmp(elem.name.data(), elem.name.size(), str, len) < 0;
+					});
+				}
+				template<class Vec>
+				static typename Vec::iterator _find(Vec& vec, const char* name) {
+					size_t len = strlen(name);
+					typename Vec::iterator it = _lower(vec, name, len);
+					return it != vec.end() && __regedit_details::names::eq(it->name.data(), it->name.size(), name, len) ? it : vec.end();
+				}
+
+				// a change on 'hk' (subkeys, values or data) : a new clock tick on it and on the subtree stamp of its ancestors
+				static void _touch(_node* hk) {
+					DWORD64 now = ++hk->owner->_clock;
+					hk->changed = now;
+					for(_node* n = hk; n != nullptr; n = n->parent)
+						n->tree_changed = now;
+				}
+				// a new subkey gets its own tick, a key deleted and created again doesn't look unchanged
+				static _node* _new_node(_node* parent) {
+					_node* node = new _node(parent->owner, parent);
+					node->changed = node->tree_changed = ++parent->owner->_clock;
+					return node;
+				}
+
+				// follows a '\' separated path, creating the missing keys if 'created' is given
+				static long _walk(_node* hk, const char* key, _node** out, bool* created) {
+					std::string seg;
+					for(const char* p = key != nullptr ? key : ""; ; ++p) {
+						if(*p != '\\' && *p != '\0') {
+							seg.push_back(*p);
+							continue;
+						}
+						if(!seg.empty()) {
+							if(seg.size() > 255 && __regedit_details::utf::to_utf16(reinterpret_cast<const BYTE*>(seg.data()), seg.size(), nullptr) > 255 * 2) // 255 UTF-16 chars
+								return __regedit_details::status::invalid_parameter;
+							std::vector<_subkey>::iterator it = _lower(hk->keys, seg.c_str(), seg.size());
+							if(it != hk->keys.end() && __regedit_details::names::eq(it->name.data(), it->name.size(), seg.data(), seg.size()))
+								hk = it->node.get();
+							else if(created != nullptr) {
+								std::unique_ptr<_node> node(_new_node(hk));
+								_node* child = node.get();
+								hk->max_key = (std::max)(hk->max_key, static_cast<DWORD>(seg.size()));
+								hk->keys.insert(it, _subkey{ std::move(seg), std::move(node) });
+								++hk->gen;
+								_touch(hk);
+								hk = child;
+								*created = true;
+							}
+							else
+								return __regedit_details::status::file_not_found;
+							seg.clear();
+						}
+						if(*p == '\0')
+							break;
+					}
+					*out = hk;
+					return __regedit_details::status::success;
+				}
+				// detaches a whole subtree, the keys still referenced by some handle are released on their last close()
+				static void _orphan(_node* hk) {
+					for(_subkey& sk : hk->keys)
+						_orphan(sk.node.release());
+					hk->keys.clear();
+					hk->vals.clear();
+					hk->parent = nullptr;
+					hk->deleted = true;
+					if(hk->refs == 0)
+						delete hk;
+				}
+				static long _check(handle hk) {
+					if(hk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					return hk->deleted ? __regedit_details::status::key_deleted : __regedit_details::status::success;
+				}
+				static long _enum(const std::string& str, char* name, DWORD* len) {
+					if(*len <= str.size())
+						return __regedit_details::status::more_data;
+					memcpy(name, str.c_str(), str.size() + 1);
+					*len = static_cast<DWORD>(str.size());
+					return __regedit_details::status::success;
+				}
+				// removes the subkey at the end of a '\' separated path (without trailing '\')
+				static long _delete_path(_node* hk, const std::string& path) {
+					size_t sep = path.rfind('\\');
+					_node* parent = hk;
+					long ret = __regedit_details::status::success;
+					if(sep != std::string::npos && (ret = _walk(hk, path.substr(0, sep).c_str(), &parent, nullptr)) != __regedit_details::status::success)
+						return ret;
+					std::vector<_subkey>::iterator it = _find(parent->keys, path.c_str() + (sep != std::string::npos ? sep + 1 : 0));
+					if(it == parent->keys.end())
+						return __regedit_details::status::file_not_found;
+					_orphan(it->node.release());
+					parent->keys.erase(it);
+					++parent->gen;
+					_touch(parent);
+					return ret;
+				}
+				// 'names' with their lengths, sorted
+				static std::vector<__regedit_details::str_view> _sorted(const std::vector<const char*>& names) {
+					std::vector<__regedit_details::str_view> out(names.begin(), names.end());
+					std::sort(out.begin(), out.end(), [](const __regedit_details::str_view& l, const __regedit_details::str_view& r) {
+						return __regedit_details::names::cmp(l.data(), l.size(), r.data(), r.size()) < 0;
+					});
+					return out;
+				}
+				template<class Elem>
+				static int _cmp(const Elem& elem, const __regedit_details::str_view& name) {
+					return __regedit_details::names::cmp(elem.name.data(), elem.name.size(), name.data(), name.size());
+				}
+				// sorts 'names' and merges the ones not in 'vec' yet (built by make(name)) in a single pass, returns how many were added
+				template<class Vec, class Make>
+				static DWORD _merge(_node* hk, Vec& vec, const std::vector<const char*>& names, Make make) {
+					using elem = typename Vec::value_type;
+					std::vector<__regedit_details::str_view> sorted = _sorted(names);
+					size_t mid = vec.size(), pos = 0;
+					for(size_t i = 0; i < sorted.size(); ++i) {
+						if(i != 0 && __regedit_details::names::eq(sorted[i - 1].data(), sorted[i - 1].size(), sorted[i].data(), sorted[i].size()))
+							continue;
+						int cmp = 1;
+						while(pos < mid && (cmp = _cmp(vec[pos], sorted[i])) < 0)
+							++pos;
+						if(pos == mid || cmp != 0)
+							vec.push_back(make(sorted[i].data()));
+					}
+					if(vec.size() == mid)
+						return 0;
+					std::inplace_merge(vec.begin(), vec.begin() + mid, vec.end(), [](const elem& l, const elem& r) {
+						return __regedit_details::names::cmp(l.name.data(), l.name.size(), r.name.data(), r.name.size()) < 0;
+					});
+					++hk->gen;
+					_touch(hk);
+					return static_cast<DWORD>(vec.size() - mid);
+				}
+				// sorts 'names' and marks the entries of 'vec' found among them
+				template<class Vec>
+				static void _mark(Vec& vec, const std::vector<const char*>& names, std::vector<bool>& drop) {
+					size_t pos = 0;
+					for(const __regedit_details::str_view& name : _sorted(names)) {
+						int cmp = 1;
+						while(pos < vec.size() && (cmp = _cmp(vec[pos], name)) < 0)
+							++pos;
+						if(pos == vec.size())
+							break;
+						if(cmp == 0)
+							drop[pos] = true;
+					}
+				}
+				static void _drop(_subkey& sk) {
+					_orphan(sk.node.release());
+				}
+				static void _drop(_value&) {}
+				// erases the marked entries in one pass (orphaning the subkeys), returns how many were
+				template<class Vec>
+				static DWORD _compact(_node* hk, Vec& vec, const std::vector<bool>& drop) {
+					size_t out = 0;
+					for(size_t i = 0; i < vec.size(); ++i) {
+						if(drop[i])
+							_drop(vec[i]);
+						else if(out++ != i)
+							vec[out - 1] = std::move(vec[i]);
+					}
+					DWORD deleted = static_cast<DWORD>(vec.size() - out);
+					if(deleted != 0) {
+						vec.erase(vec.begin() + out, vec.end());
+						++hk->gen;
+						_touch(hk);
+					}
+					return deleted;
+				}
+
+			public:
+
+				using hkey = _hkey<>;
+
+				static long open(handle parent, const char* key, bool /*write*/, handle* out) {
+					if(parent == nullptr)
+						return __regedit_details::status::invalid_handle;
+					std::lock_guard<std::mutex> lock(parent->owner->_mtx);
+					long ret = _check(parent);
+					if(ret == __regedit_details::status::success && (ret = _walk(parent, key, out, nullptr)) == __regedit_details::status::success)
+						++(*out)->refs;
+					return ret;
+				}
+				static long create(handle parent, const char* key, bool /*write*/, handle* out, bool* created) {
+					if(parent == nullptr)
+						return __regedit_details::status::invalid_handle;
+					std::lock_guard<std::mutex> lock(parent->owner->_mtx);
+					bool crt = false;
+					long ret = _check(parent);
+					if(ret == __regedit_details::status::success && (ret = _walk(parent, key, out, &crt)) == __regedit_details::status::success)
+						++(*out)->refs;
+					if(created != nullptr)
+						*created = crt;
+					return ret;
+				}
+				static void close(handle hk) {
+					if(hk == nullptr)
+						return;
+					std::lock_guard<std::mutex> lock(hk->owner->_mtx);
+					if(--hk->refs == 0 && hk->deleted)
+						delete hk;
+				}
+
+				static long query_info(handle hk, DWORD* subkeys, DWORD* values) {
+					if(hk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					std::lock_guard<std::mutex> lock(hk->owner->_mtx);
+					long ret = _check(hk);
+					if(ret == __regedit_details::status::success) {
+						if(subkeys != nullptr)
+							*subkeys = static_cast<DWORD>(hk->keys.size());
+						if(values != nullptr)
+							*values = static_cast<DWORD>(hk->vals.size());
+					}
+					return ret;
+				}
+				static long query_stamp(handle hk, DWORD64* stamp, DWORD* subkeys, DWORD* values) {
+					if(hk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					std::lock_guard<std::mutex> lock(hk->owner->_mtx);
+					long ret = _check(hk);
+					if(ret == __regedit_details::status::success) {
+						if(stamp != nullptr)
+							*stamp = hk->gen;
+						if(subkeys != nullptr)
+							*subkeys = static_cast<DWORD>(hk->keys.size());
+						if(values != nullptr)
+							*values = static_cast<DWORD>(hk->vals.size());
+					}
+					return ret;
+				}
+				static long query_key_info(handle hk, __regedit_details::key_info* info) {
+					if(hk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					std::lock_guard<std::mutex> lock(hk->owner->_mtx);
+					long ret = _check(hk);
+					if(ret != __regedit_details::status::success)
+						return ret;
+					info->subkeys = static_cast<DWORD>(hk->keys.size());
+					info->values = static_cast<DWORD>(hk->vals.size());
+					info->max_key_name = hk->max_key;
+					info->max_value_name = hk->max_value;
+					info->max_value_data = hk->max_data;
+					info->stamp = hk->gen;
+					return ret;
+				}
+				static long query_change_stamp(handle hk, DWORD64* key, DWORD64* tree) {
+					if(hk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					std::lock_guard<std::mutex> lock(hk->owner->_mtx);
+					long ret = _check(hk);
+					if(ret == __regedit_details::status::success) {
+						*key = hk->changed;
+						*tree = hk->tree_changed;
+					}
+					return ret;
+				}
+				static long enum_key(handle hk, DWORD pos, char* name, DWORD* len) {
+					if(hk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					std::lock_guard<std::mutex> lock(hk->owner->_mtx);
+					long ret = _check(hk);
+					if(ret != __regedit_details::status::success)
+						return ret;
+					return pos < hk->keys.size() ? _enum(hk->keys[pos].name, name, len) : __regedit_details::status::no_more_items;
+				}
+				static long enum_value(handle hk, DWORD pos, char* name, DWORD* len, DWORD* ty = nullptr, DWORD* size = nullptr) {
+					if(hk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					std::lock_guard<std::mutex> lock(hk->owner->_mtx);
+					long ret = _check(hk);
+					if(ret != __regedit_details::status::success)
+						return ret;
+					if(pos >= hk->vals.size())
+						return __regedit_details::status::no_more_items;
+					if(ty != nullptr)
+						*ty = hk->vals[pos].type;
+					if(size != nullptr)
+						*size = static_cast<DWORD>(hk->vals[pos].data.size());
+					return _enum(hk->vals[pos].name, name, len);
+				}
+				static long enum_data(handle hk, DWORD pos, char* name, DWORD* len, DWORD* ty, BYTE* data, DWORD* size) {
+					if(hk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					std::lock_guard<std::mutex> lock(hk->owner->_mtx);
+					long ret = _check(hk);
+					if(ret != __regedit_details::status::success)
+						return ret;
+					if(pos >= hk->vals.size())
+						return __regedit_details::status::no_more_items;
+					const _value& val = hk->vals[pos];
+					if((ret = _enum(val.name, name, len)) != __regedit_details::status::success)
+						return ret;
+					if(ty != nullptr)
+						*ty = val.type;
+					if(size == nullptr)
+						return data == nullptr ? __regedit_details::status::success : __regedit_details::status::invalid_parameter;
+					DWORD cap = *size;
+					*size = static_cast<DWORD>(val.data.size());
+					if(data == nullptr || val.data.empty())
+						return __regedit_details::status::success;
+					if(cap < *size)
+						return __regedit_details::status::more_data;
+					memcpy(data, val.data.data(), val.data.size());
+					return __regedit_details::status::success;
+				}
+
+				static long query_value(handle hk, const char* name, DWORD* ty, BYTE* data, DWORD* len) {
+					if(hk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					std::lock_guard<std::mutex> lock(hk->owner->_mtx);
+					long ret = _check(hk);
+					if(ret != __regedit_details::status::success)
+						return ret;
+					std::vector<_value>::iterator it = _find(hk->vals, name != nullptr ? name : "");
+					if(it == hk->vals.end())
+						return __regedit_details::status::file_not_found;
+					DWORD size = static_cast<DWORD>(it->data.size());
+					if(ty != nullptr)
+						*ty = it->type;
+					if(data != nullptr) {
+						if(len == nullptr)
+							return __regedit_details::status::invalid_parameter;
+						if(*len < size) {
+							*len = size;
+							return __regedit_details::status::more_data;
+						}
+						if(size != 0)
+							memcpy(data, it->data.data(), size);
+					}
+					if(len != nullptr)
+						*len = size;
+					return __regedit_details::status::success;
+				}
+				static long set_value(handle hk, const char* name, DWORD ty, const BYTE* data, DWORD len) {
+					if(hk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					std::lock_guard<std::mutex> lock(hk->owner->_mtx);
+					long ret = _check(hk);
+					if(ret != __regedit_details::status::success)
+						return ret;
+					if(name == nullptr)
+						name = "";
+					size_t nlen = strlen(name);
+					if(nlen > 16383)
+						return __regedit_details::status::invalid_parameter;
+					std::vector<_value>::iterator it = _lower(hk->vals, name, nlen);
+					if(it == hk->vals.end() || !__regedit_details::names::eq(it->name.data(), it->name.size(), name, nlen)) {
+						it = hk->vals.insert(it, _value{ name, ty, {} });
+						hk->max_value = (std::max)(hk->max_value, static_cast<DWORD>(it->name.size()));
+						++hk->gen;
+					}
+					it->type = ty;
+					it->data.assign(data, data + (data != nullptr ? len : 0));
+					hk->max_data = (std::max)(hk->max_data, static_cast<DWORD>(it->data.size()));
+					_touch(hk);
+					return __regedit_details::status::success;
+				}
+				static long set_value_unicode(handle hk, const char* name, DWORD ty, const BYTE* data, DWORD len) {
+					using __regedit_details::type;
+					if(data == nullptr || (ty != static_cast<DWORD>(type::sz) && ty != static_cast<DWORD>(type::expand_sz) && ty != static_cast<DWORD>(type::multi_sz)))
+						return set_value(hk, name, ty, data, len);
+					// string types are stored as UTF-8, as query_value() gives them
+					std::string narrow;
+					__regedit_details::utf::from_wide(reinterpret_cast<const wchar_t*>(data), len / sizeof(wchar_t), narrow);
+					return set_value(hk, name, ty, reinterpret_cast<const BYTE*>(narrow.data()), static_cast<DWORD>(narrow.size()));
+				}
+				static long delete_value(handle hk, const char* name) {
+					if(hk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					std::lock_guard<std::mutex> lock(hk->owner->_mtx);
+					long ret = _check(hk);
+					if(ret != __regedit_details::status::success)
+						return ret;
+					std::vector<_value>::iterator it = _find(hk->vals, name != nullptr ? name : "");
+					if(it == hk->vals.end())
+						return __regedit_details::status::file_not_found;
+					hk->vals.erase(it);
+					++hk->gen;
+					_touch(hk);
+					return __regedit_details::status::success;
+				}
+				static long delete_tree(handle hk, const char* key) {
+					if(hk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					std::lock_guard<std::mutex> lock(hk->owner->_mtx);
+					long ret = _check(hk);
+					if(ret != __regedit_details::status::success)
+						return ret;
+					std::string path = key != nullptr ? key : "";
+					while(!path.empty() && path.back() == '\\')
+						path.pop_back();
+					if(path.empty()) { // same than RegDeleteTree with NULL, clears the key but keeps it
+						for(_subkey& sk : hk->keys)
+							_orphan(sk.node.release());
+						hk->keys.clear();
+						hk->vals.clear();
+						hk->max_key = hk->max_value = hk->max_data = 0;
+						++hk->gen;
+						_touch(hk);
+						return ret;
+					}
+					return _delete_path(hk, path);
+				}
+
+				// batched versions of create(), set_value(), delete_tree() and delete_value() : one lock, and one merge or
+				// one compaction of the sorted vectors, instead of an insertion or erasure in the middle per name
+				static long create_keys(handle hk, const char* const* names, DWORD count, DWORD* created) {
+					*created = 0;
+					if(hk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					std::lock_guard<std::mutex> lock(hk->owner->_mtx);
+					long ret = _check(hk);
+					if(ret != __regedit_details::status::success)
+						return ret;
+					std::vector<const char*> flat, paths;
+					flat.reserve(count);
+					for(DWORD i = 0; i < count; ++i) {
+						const char* name = names[i] != nullptr ? names[i] : "";
+						size_t len = strlen(name);
+						if(strchr(name, '\\') != nullptr)
+							paths.push_back(name);
+						else if(len > 255 && __regedit_details::utf::to_utf16(reinterpret_cast<const BYTE*>(name), len, nullptr) > 255 * 2)
+							ret = __regedit_details::status::invalid_parameter;
+						else if(len != 0)
+							flat.push_back(name);
+					}
+					*created = _merge(hk, hk->keys, flat, [hk](const char* name) {
+						_subkey sk{ name, std::unique_ptr<_node>(_new_node(hk)) };
+						hk->max_key = (std::max)(hk->max_key, static_cast<DWORD>(sk.name.size()));
+						return sk;
+					});
+					for(const char* path : paths) { // nested ones, through the tree
+						_node* out = nullptr;
+						bool crt = false;
+						long err = _walk(hk, path, &out, &crt);
+						if(err != __regedit_details::status::success)
+							ret = ret != __regedit_details::status::success ? ret : err;
+						else if(crt)
+							++*created;
+					}
+					return ret;
+				}
+				static long create_values(handle hk, const char* const* names, DWORD count, DWORD* created) {
+					*created = 0;
+					if(hk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					std::lock_guard<std::mutex> lock(hk->owner->_mtx);
+					long ret = _check(hk);
+					if(ret != __regedit_details::status::success)
+						return ret;
+					std::vector<const char*> flat;
+					flat.reserve(count);
+					for(DWORD i = 0; i < count; ++i) {
+						const char* name = names[i] != nullptr ? names[i] : "";
+						if(strlen(name) > 16383)
+							ret = __regedit_details::status::invalid_parameter;
+						else
+							flat.push_back(name);
+					}
+					*created = _merge(hk, hk->vals, flat, [hk](const char* name) {
+						_value val{ name, static_cast<DWORD>(__regedit_details::type::none), {} };
+						hk->max_value = (std::max)(hk->max_value, static_cast<DWORD>(val.name.size()));
+						return val;
+					});
+					return ret;
+				}
+				static long delete_keys(handle hk, const char* const* names, DWORD count, DWORD* deleted) {
+					*deleted = 0;
+					if(hk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					std::lock_guard<std::mutex> lock(hk->owner->_mtx);
+					long ret = _check(hk);
+					if(ret != __regedit_details::status::success)
+						return ret;
+					std::vector<bool> drop(hk->keys.size());
+					std::vector<const char*> flat, paths;
+					flat.reserve(count);
+					for(DWORD i = 0; i < count; ++i) {
+						const char* name = names[i] != nullptr ? names[i] : "";
+						if(strchr(name, '\\') != nullptr)
+							paths.push_back(name);
+						else if(*name != '\0')
+							flat.push_back(name);
+					}
+					_mark(hk->keys, flat, drop);
+					*deleted = _compact(hk, hk->keys, drop);
+					for(const char* path : paths) {
+						std::string key = path;
+						while(!key.empty() && key.back() == '\\')
+							key.pop_back();
+						long err = key.empty() ? __regedit_details::status::success : _delete_path(hk, key);
+						if(err == __regedit_details::status::success)
+							*deleted += key.empty() ? 0 : 1;
+						else if(err != __regedit_details::status::file_not_found)
+							ret = ret != __regedit_details::status::success ? ret : err;
+					}
+					return ret;
+				}
+				static long delete_values(handle hk, const char* const* names, DWORD count, DWORD* deleted) {
+					*deleted = 0;
+					if(hk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					std::lock_guard<std::mutex> lock(hk->owner->_mtx);
+					long ret = _check(hk);
+					if(ret != __regedit_details::status::success)
+						return ret;
+					std::vector<bool> drop(hk->vals.size());
+					std::vector<const char*> flat;
+					flat.reserve(count);
+					for(DWORD i = 0; i < count; ++i)
+						flat.push_back(names[i] != nullptr ? names[i] : "");
+					_mark(hk->vals, flat, drop);
+					*deleted = _compact(hk, hk->vals, drop);
+					return ret;
+				}
 
+		};
 
+		template<class T> const memory::handle memory::_hkey<T>::classes_root   = memory::_predefined(0);
+		template<class T> const memory::handle memory::_hkey<T>::current_config = memory::_predefined(1);
+		template<class T> const memory::handle memory::_hkey<T>::current_user   = memory::_predefined(2);
+		template<class T> const memory::handle memory::_hkey<T>::local_machine  = memory::_predefined(3);
+		template<class T> const memory::handle memory::_hkey<T>::users          = memory::_predefined(4);
 
-namespace neo {
+		/*
+			Forwards everything to another backend counting the calls, meant for tests and benchmarks (e.g. basic_regedit<counting<memory>>)
+			The counters are per adapted backend and process-wide
+		*/
+		template<class Backend>
+		struct counting {
 
-	namespace __regedit_details {
+			private:
 
-		template<class ValType, class CmpIter, class IterChild, class GenFn>
-		class iter {
+				using DWORD   = __regedit_details::DWORD;
+				using DWORD64 = __regedit_details::DWORD64;
+				using BYTE    = __regedit_details::BYTE;
 
-			protected:
+				static void _inc(std::atomic<unsigned long long>& counter) {
+					counter.fetch_add(1, std::memory_order_relaxed);
+				}
 
-				HKEY _hkey = NULL;
-				DWORD _pos = 0;
+			public:
 
-				iter(HKEY hkey, DWORD pos) : _hkey(hkey), _pos(pos) {}
+				using handle = typename Backend::handle;
+				using hkey   = typename Backend::hkey;
 
-			public:
+				struct counters {
+					std::atomic<unsigned long long> open{0}, create{0}, close{0};
+					std::atomic<unsigned long long> query_info{0}, enum_key{0}, enum_value{0}, query_value{0}, find{0};
+					std::atomic<unsigned long long> set_value{0}, delete_value{0}, delete_tree{0};
 
-				using iterator_category = std::bidirectional_iterator_tag; // random_access_iterator_tag
-				using value_type        = std::pair<const std::string, ValType>;
-				using difference_type   = ptrdiff_t;
-				using pointer           = std::unique_ptr<value_type>;
-				using reference         = value_type; // objects are created on the fly
+					// handles opened and not closed yet
+					long long open_handles() const {
+						return static_cast<long long>(open + create) - static_cast<long long>(close);
+					}
+					void reset() {
+						for(std::atomic<unsigned long long>* c : { &open, &create, &close, &query_info, &enum_key, &enum_value, &query_value, &find, &set_value, &delete_value, &delete_tree })
+							c->store(0, std::memory_order_relaxed);
+					}
+				};
 
-				iter() {}
-				iter(const iter&) = default;
-				iter(iter&&) = default;
+				static counters& stats() {
+					static counters cnt;
+					return cnt;
+				}
 
-				IterChild& operator=(const iter& other) {
-					_hkey = other._hkey;
-					_pos = other._pos;
-					return static_cast<IterChild&>(*this);
+				static long open(handle parent, const char* key, bool write, handle* out) {
+					long ret = Backend::open(parent, key, write, out);
+					if(ret == __regedit_details::status::success)
+						_inc(stats().open);
+					return ret;
 				}
-				IterChild& operator=(iter&& other) {
-					std::swap(_hkey, other._hkey);
-					std::swap(_pos, other._pos);
-					return static_cast<IterChild&>(*this);
+				static long create(handle parent, const char* key, bool write, handle* out, bool* created) {
+					long ret = Backend::create(parent, key, write, out, created);
+					if(ret == __regedit_details::status::success)
+						_inc(stats().create);
+					return ret;
+				}
+				static void close(handle hk) {
+					_inc(stats().close);
+					Backend::close(hk);
 				}
 
-				bool operator==(const IterChild& other) const {
-					return _pos == other._pos && _hkey == other._hkey;
+				static long query_info(handle hk, DWORD* subkeys, DWORD* values) {
+					_inc(stats().query_info);
+					return Backend::query_info(hk, subkeys, values);
 				}
-				bool operator!=(const IterChild& other) const {
-					return !(*this == other);
+				template<class B = Backend>
+				static auto query_stamp(handle hk, DWORD64* stamp, DWORD* subkeys, DWORD* values) -> decltype(B::query_stamp(hk, stamp, subkeys, values)) {
+					_inc(stats().query_info);
+					return B::query_stamp(hk, stamp, subkeys, values);
 				}
-				bool operator==(const CmpIter& other) const {
-					return _pos == other._pos && _hkey == other._hkey;
+				template<class B = Backend>
+				static auto query_key_info(handle hk, __regedit_details::key_info* info) -> decltype(B::query_key_info(hk, info)) {
+					_inc(stats().query_info);
+					return B::query_key_info(hk, info);
 				}
-				bool operator!=(const CmpIter& other) const {
-					return !(*this == other);
+				template<class B = Backend>
+				static auto query_change_stamp(handle hk, DWORD64* key, DWORD64* tree) -> decltype(B::query_change_stamp(hk, key, tree)) {
+					_inc(stats().query_info);
+					return B::query_change_stamp(hk, key, tree);
+				}
+				static long enum_key(handle hk, DWORD pos, char* name, DWORD* len) {
+					_inc(stats().enum_key);
+					return Backend::enum_key(hk, pos, name, len);
+				}
+				static long enum_value(handle hk, DWORD pos, char* name, DWORD* len, DWORD* ty = nullptr, DWORD* size = nullptr) {
+					_inc(stats().enum_value);
+					return Backend::enum_value(hk, pos, name, len, ty, size);
+				}
+				template<class B = Backend>
+				static auto enum_data(handle hk, DWORD pos, char* name, DWORD* len, DWORD* ty, BYTE* data, DWORD* size) -> decltype(B::enum_data(hk, pos, name, len, ty, data, size)) {
+					_inc(stats().enum_value);
+					return B::enum_data(hk, pos, name, len, ty, data, size);
+				}
+				// only available when the adapted backend has them
+				template<class B = Backend>
+				static auto find_key(handle hk, const char* name, DWORD* pos) -> decltype(B::find_key(hk, name, pos)) {
+					_inc(stats().find);
+					return B::find_key(hk, name, pos);
+				}
+				template<class B = Backend>
+				static auto find_value(handle hk, const char* name, DWORD* pos) -> decltype(B::find_value(hk, name, pos)) {
+					_inc(stats().find);
+					return B::find_value(hk, name, pos);
 				}
 
-				IterChild& operator++() {
-					++_pos;
-					return static_cast<IterChild&>(*this);
+				static long query_value(handle hk, const char* name, DWORD* ty, BYTE* data, DWORD* len) {
+					_inc(stats().query_value);
+					return Backend::query_value(hk, name, ty, data, len);
 				}
-				IterChild operator++(int) {
-					iter tmp(*this);
-					++(*this);
-					return static_cast<IterChild&>(tmp);
+				static long set_value(handle hk, const char* name, DWORD ty, const BYTE* data, DWORD len) {
+					_inc(stats().set_value);
+					return Backend::set_value(hk, name, ty, data, len);
+				}
+				static long set_value_unicode(handle hk, const char* name, DWORD ty, const BYTE* data, DWORD len) {
+					_inc(stats().set_value);
+					return Backend::set_value_unicode(hk, name, ty, data, len);
+				}
+				static long delete_value(handle hk, const char* name) {
+					_inc(stats().delete_value);
+					return Backend::delete_value(hk, name);
+				}
+				static long delete_tree(handle hk, const char* key) {
+					_inc(stats().delete_tree);
+					return Backend::delete_tree(hk, key);
+				}
+				template<class B = Backend>
+				static auto create_keys(handle hk, const char* const* names, DWORD count, DWORD* created) -> decltype(B::create_keys(hk, names, count, created)) {
+					_inc(stats().create);
+					return B::create_keys(hk, names, count, created);
+				}
+				template<class B = Backend>
+				static auto create_values(handle hk, const char* const* names, DWORD count, DWORD* created) -> decltype(B::create_values(hk, names, count, created)) {
+					_inc(stats().set_value);
+					return B::create_values(hk, names, count, created);
+				}
+				template<class B = Backend>
+				static auto delete_keys(handle hk, const char* const* names, DWORD count, DWORD* deleted) -> decltype(B::delete_keys(hk, names, count, deleted)) {
+					_inc(stats().delete_tree);
+					return B::delete_keys(hk, names, count, deleted);
+				}
+				template<class B = Backend>
+				static auto delete_values(handle hk, const char* const* names, DWORD count, DWORD* deleted) -> decltype(B::delete_values(hk, names, count, deleted)) {
+					_inc(stats().delete_value);
+					return B::delete_values(hk, names, count, deleted);
 				}
 
-				IterChild& operator--() {
-					--_pos;
-					return static_cast<IterChild&>(*this);
+		};
+
+		#ifdef REGEDIT_INSTRUMENT
+		/*
+			Forwards everything to another backend counting the calls for the neo::basic_regedit entry point running on the thread,
+			the neo::regedit, neo::memory_regedit and neo::hive_regedit aliases use it when REGEDIT_INSTRUMENT is defined
+		*/
+		template<class Backend>
+		struct traced {
+
+			private:
+
+				using DWORD   = __regedit_details::DWORD;
+				using DWORD64 = __regedit_details::DWORD64;
+				using BYTE    = __regedit_details::BYTE;
+				using call    = instrument::call;
+
+			public:
+
+				using handle = typename Backend::handle;
+				using hkey   = typename Backend::hkey;
+
+				static long open(handle parent, const char* key, bool write, handle* out) {
+					__regedit_details::trace::count(call::open);
+					return Backend::open(parent, key, write, out);
 				}
-				IterChild operator--(int) {
-					iter tmp(*this);
-					--(*this);
-					return static_cast<IterChild&>(tmp);
+				static long create(handle parent, const char* key, bool write, handle* out, bool* created) {
+					__regedit_details::trace::count(call::create);
+					return Backend::create(parent, key, write, out, created);
+				}
+				static void close(handle hk) {
+					__regedit_details::trace::count(call::close);
+					Backend::close(hk);
 				}
 
-				reference operator*() {
-					return GenFn()(_hkey, _pos);
+				static long query_info(handle hk, DWORD* subkeys, DWORD* values) {
+					__regedit_details::trace::count(call::query_info);
+					return Backend::query_info(hk, subkeys, values);
+				}
+				template<class B = Backend>
+				static auto query_stamp(handle hk, DWORD64* stamp, DWORD* subkeys, DWORD* values) -> decltype(B::query_stamp(hk, stamp, subkeys, values)) {
+					__regedit_details::trace::count(call::query_info);
+					return B::query_stamp(hk, stamp, subkeys, values);
+				}
+				template<class B = Backend>
+				static auto query_key_info(handle hk, __regedit_details::key_info* info) -> decltype(B::query_key_info(hk, info)) {
+					__regedit_details::trace::count(call::query_info);
+					return B::query_key_info(hk, info);
 				}
-				const reference operator*() const {
-					return const_cast<iter&>(*this).operator*();
+				template<class B = Backend>
+				static auto query_change_stamp(handle hk, DWORD64* key, DWORD64* tree) -> decltype(B::query_change_stamp(hk, key, tree)) {
+					__regedit_details::trace::count(call::query_info);
+					return B::query_change_stamp(hk, key, tree);
+				}
+				static long enum_key(handle hk, DWORD pos, char* name, DWORD* len) {
+					__regedit_details::trace::count(call::enum_key);
+					return Backend::enum_key(hk, pos, name, len);
+				}
+				static long enum_value(handle hk, DWORD pos, char* name, DWORD* len, DWORD* ty = nullptr, DWORD* size = nullptr) {
+					__regedit_details::trace::count(call::enum_value);
+					return Backend::enum_value(hk, pos, name, len, ty, size);
+				}
+				template<class B = Backend>
+				static auto enum_data(handle hk, DWORD pos, char* name, DWORD* len, DWORD* ty, BYTE* data, DWORD* size) -> decltype(B::enum_data(hk, pos, name, len, ty, data, size)) {
+					__regedit_details::trace::count(call::enum_value);
+					return B::enum_data(hk, pos, name, len, ty, data, size);
+				}
+				template<class B = Backend>
+				static auto find_key(handle hk, const char* name, DWORD* pos) -> decltype(B::find_key(hk, name, pos)) {
+					__regedit_details::trace::count(call::find);
+					return B::find_key(hk, name, pos);
+				}
+				template<class B = Backend>
+				static auto find_value(handle hk, const char* name, DWORD* pos) -> decltype(B::find_value(hk, name, pos)) {
+					__regedit_details::trace::count(call::find);
+					return B::find_value(hk, name, pos);
 				}
 
-				pointer operator->() {
-					return pointer(new reference(GenFn()(_hkey, _pos)));
+				static long query_value(handle hk, const char* name, DWORD* ty, BYTE* data, DWORD* len) {
+					__regedit_details::trace::count(call::query_value);
+					return Backend::query_value(hk, name, ty, data, len);
+				}
+				static long set_value(handle hk, const char* name, DWORD ty, const BYTE* data, DWORD len) {
+					__regedit_details::trace::count(call::set_value);
+					return Backend::set_value(hk, name, ty, data, len);
+				}
+				static long set_value_unicode(handle hk, const char* name, DWORD ty, const BYTE* data, DWORD len) {
+					__regedit_details::trace::count(call::set_value);
+					return Backend::set_value_unicode(hk, name, ty, data, len);
+				}
+				static long delete_value(handle hk, const char* name) {
+					__regedit_details::trace::count(call::delete_value);
+					return Backend::delete_value(hk, name);
 				}
-				const pointer operator->() const {
-					return const_cast<iter&>(*this).operator->();
+				static long delete_tree(handle hk, const char* key) {
+					__regedit_details::trace::count(call::delete_tree);
+					return Backend::delete_tree(hk, key);
+				}
+				template<class B = Backend>
+				static auto create_keys(handle hk, const char* const* names, DWORD count, DWORD* created) -> decltype(B::create_keys(hk, names, count, created)) {
+					__regedit_details::trace::count(call::create);
+					return B::create_keys(hk, names, count, created);
+				}
+				template<class B = Backend>
+				static auto create_values(handle hk, const char* const* names, DWORD count, DWORD* created) -> decltype(B::create_values(hk, names, count, created)) {
+					__regedit_details::trace::count(call::set_value);
+					return B::create_values(hk, names, count, created);
+				}
+				template<class B = Backend>
+				static auto delete_keys(handle hk, const char* const* names, DWORD count, DWORD* deleted) -> decltype(B::delete_keys(hk, names, count, deleted)) {
+					__regedit_details::trace::count(call::delete_tree);
+					return B::delete_keys(hk, names, count, deleted);
+				}
+				template<class B = Backend>
+				static auto delete_values(handle hk, const char* const* names, DWORD count, DWORD* deleted) -> decltype(B::delete_values(hk, names, count, deleted)) {
+					__regedit_details::trace::count(call::delete_value);
+					return B::delete_values(hk, names, count, deleted);
 				}
 
 		};
 
-		enum class type : DWORD {
-			none                       = REG_NONE,
-			sz                         = REG_SZ,
-			expand_sz                  = REG_EXPAND_SZ,
-			binary                     = REG_BINARY,
-			dword                      = REG_DWORD,
-			dword_little_endian        = REG_DWORD_LITTLE_ENDIAN,
-			dword_big_endian           = REG_DWORD_BIG_ENDIAN,
-			link                       = REG_LINK,
-			multi_sz                   = REG_MULTI_SZ,
-			resource_list              = REG_RESOURCE_LIST,
-			full_resource_descriptor   = REG_FULL_RESOURCE_DESCRIPTOR,
-			resource_requirements_list = REG_RESOURCE_REQUIREMENTS_LIST,
-			qword                      = REG_QWORD,
-			qword_little_endian        = REG_QWORD_LITTLE_ENDIAN
-		};
+		template<class Backend>
+		using _default = traced<Backend>;
+		#else
+		template<class Backend>
+		using _default = Backend;
+		#endif
 
-		namespace read_overload { // GCC needs all this instead just a simple 'auto' return
+	}
 
-			template<type T>
-			using _return_t =
-				typename std::conditional<T == type::none,                       void*,
-				typename std::conditional<T == type::sz,                         std::string,
-				typename std::conditional<T == type::expand_sz,                  std::string,
-				typename std::conditional<T == type::binary,                     std::unique_ptr<BYTE>,
-				typename std::conditional<T == type::dword,                      DWORD,
-				typename std::conditional<T == type::dword_big_endian,           DWORD,
-				typename std::conditional<T == type::link,                       std::wstring,
-				typename std::conditional<T == type::multi_sz,                   std::vector<std::string>,
-				typename std::conditional<T == type::resource_list,              std::unique_ptr<BYTE>,
-				typename std::conditional<T == type::full_resource_descriptor,   std::unique_ptr<BYTE>,
-				typename std::conditional<T == type::resource_requirements_list, std::unique_ptr<BYTE>,
-				typename std::conditional<T == type::qword,                      DWORD64,
-				std::nullptr_t>::type>::type>::type>::type>::type>::type>::type>::type>::type>::type>::type>::type;
+	#ifdef REGEDIT_INSTRUMENT
+	namespace instrument {
 
-			std::unique_ptr<BYTE> read(HKEY hk, const std::string& name) {
-				DWORD ty = 0, len = 0;
-				RegQueryValueExA(hk, name.c_str(), NULL, NULL, NULL, &len);
-				std::unique_ptr<BYTE> ptr(new BYTE[len]);
-				RegQueryValueExA(hk, name.c_str(), NULL, &ty, ptr.get(), &len);
-				return std::move(ptr);
-			}
+		struct op_stats {
+			uint64_t count = 0;                  // finished calls
+			uint64_t timed = 0;                  // the ones timed (1 in REGEDIT_INSTRUMENT_SAMPLE), max_ns and histogram are theirs
+			double total_ns = 0;                 // estimated : mean of the timed calls * count
+			double max_ns = 0;
+			uint64_t calls[call_count] = {};     // backend calls made by them, indexed by neo::instrument::call
+			uint64_t histogram[buckets] = {};    // latencies, histogram[i] counts the timed calls in [bucket_ns(i), bucket_ns(i + 1))
+			double tick_ns = 1;                  // clock tick length the histogram is measured in
 
-			template<type T> _return_t<T> read(HKEY hk, const std::string& name);
-			template<> _return_t<type::none>                       /* void*                    */ read<type::none>(HKEY hk, const std::string& name) {
-				return static_cast<void*>(nullptr);
-			}
-			template<> _return_t<type::sz>                         /* std::string              */ read<type::sz>(HKEY hk, const std::string& name) {
-				return std::string(reinterpret_cast<const char*>(read(hk, name).get()));
+			double bucket_ns(size_t i) const {
+				return i == 0 ? 0 : static_cast<double>(uint64_t(1) << i) * tick_ns;
 			}
-			template<> _return_t<type::expand_sz>                  /* std::string              */ read<type::expand_sz>(HKEY hk, const std::string& name) {
-				std::string str = read<type::sz>(hk, name);
-				DWORD size = ExpandEnvironmentStringsA(str.c_str(), NULL, 0);
-				std::unique_ptr<char> exp(new char[size]);
-				ExpandEnvironmentStringsA(str.c_str(), exp.get(), size);
-				return std::string(exp.get());
+			uint64_t backend_calls() const {
+				uint64_t n = 0;
+				for(uint64_t c : calls)
+					n += c;
+				return n;
 			}
-			template<> _return_t<type::binary>                     /* std::unique_ptr<BYTE>    */ read<type::binary>(HKEY hk, const std::string& name) {
-				return read(hk, name);
+			uint64_t backend_calls(call c) const {
+				return calls[static_cast<size_t>(c)];
 			}
-			template<> _return_t<type::dword>                      /* DWORD                    */ read<type::dword>(HKEY hk, const std::string& name) {
-				return *reinterpret_cast<DWORD*>(read(hk, name).get());
+			double mean_ns() const {
+				return count != 0 ? total_ns / static_cast<double>(count) : 0;
 			}
-			template<> _return_t<type::dword_big_endian>           /* DWORD                    */ read<type::dword_big_endian>(HKEY hk, const std::string& name) {
-				return read<type::dword>(hk, name);
-				//std::unique_ptr<BYTE> pt = read<type::binary>();
-				//return DWORD((pt.get()[0] << 24) | (pt.get()[1] << 16) | (pt.get()[2] << 16) | (pt.get()[3] << 0));
+			// upper bound of the bucket holding the 'p' quantile (0.5, 0.99, ...)
+			double percentile_ns(double p) const {
+				if(timed == 0)
+					return 0;
+				uint64_t target = (std::min)(timed - 1, static_cast<uint64_t>(p * static_cast<double>(timed))), seen = 0;
+				for(size_t i = 0; i < buckets; ++i)
+					if((seen += histogram[i]) > target)
+						return (std::min)(bucket_ns(i + 1), max_ns);
+				return max_ns;
 			}
-			template<> _return_t<type::link>                       /* std::wstring             */ read<type::link>(HKEY hk, const std::string& name) {
-				return std::wstring(reinterpret_cast<const wchar_t*>(read(hk, name).get()));
+		};
+
+		struct report {
+			op_stats ops[op_count];
+			const op_stats& operator[](op o) const {
+				return ops[static_cast<size_t>(o)];
 			}
-			template<> _return_t<type::multi_sz>                   /* std::vector<std::string> */ read<type::multi_sz>(HKEY hk, const std::string& name) {
-				DWORD ty = 0, len = 0, off = 0;
-				RegQueryValueExA(hk, name.c_str(), NULL, NULL, NULL, &len);
-				std::unique_ptr<BYTE> ptr(new BYTE[len]);
-				RegQueryValueExA(hk, name.c_str(), NULL, &ty, ptr.get(), &len);
+		};
 
-				std::vector<std::string> vec;
-				while(off < len && *reinterpret_cast<const char*>(ptr.get() + off) != '\0') {
-					vec.push_back(reinterpret_cast<const char*>(ptr.get() + off));
-					off += vec.back().size() + 1;
+		inline const char* to_string(op o) {
+			static const char* names[op_count] = { "open", "find", "at", "subscript", "insert", "erase", "read", "write", "iterate", "size", "snapshot", "other" };
+			return names[static_cast<size_t>(o)];
+		}
+		inline const char* to_string(call c) {
+			static const char* names[call_count] = { "open", "create", "close", "query_info", "enum_key", "enum_value", "query_value", "find", "set_value", "delete_value", "delete_tree" };
+			return names[static_cast<size_t>(c)];
+		}
+
+		// counts of every thread since the start or the last reset(), can be called at any time from any thread
+		inline report snapshot() {
+			using namespace __regedit_details::trace;
+			registry& r = reg();
+			std::unique_ptr<block> total(new block());
+			{
+				std::lock_guard<std::mutex> lock(r.mtx);
+				merge(*total, r.retired);
+				merge_max(*total, r.retired);
+				unsigned epoch = r.epoch.load(std::memory_order_relaxed);
+				for(const live_block& l : r.live) {
+					merge(*total, *l.counts);
+					merge(*total, *l.base, true);
+					if(l.counts->epoch.load(std::memory_order_acquire) == epoch)
+						merge_max(*total, *l.counts);
 				}
-				return std::move(vec);
-			}
-			template<> _return_t<type::resource_list>              /* std::unique_ptr<BYTE>    */ read<type::resource_list>(HKEY hk, const std::string& name) {
-				return read(hk, name);
 			}
-			template<> _return_t<type::full_resource_descriptor>   /* std::unique_ptr<BYTE>    */ read<type::full_resource_descriptor>(HKEY hk, const std::string& name) {
-				return read(hk, name);
-			}
-			template<> _return_t<type::resource_requirements_list> /* std::unique_ptr<BYTE>    */ read<type::resource_requirements_list>(HKEY hk, const std::string& name) {
-				return read(hk, name);
-			}
-			template<> _return_t<type::qword>                      /* DWORD64                  */ read<type::qword>(HKEY hk, const std::string& name) {
-				return *reinterpret_cast<DWORD64*>(read(hk, name).get());
+			// clock ticks to ns, measured over the whole run (at least 10ms)
+			double tick_ns = 1;
+			#ifdef REGEDIT_RDTSC
+			std::chrono::steady_clock::time_point until = r.start_time + std::chrono::milliseconds(10);
+			while(std::chrono::steady_clock::now() < until)
+				;
+			tick_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - r.start_time).count() / static_cast<double>(now() - r.start_ticks);
+			#endif
+			report ret;
+			for(size_t o = 0; o < op_count; ++o) {
+				const slot& s = total->ops[o];
+				op_stats& d = ret.ops[o];
+				d.count = s.count.load(std::memory_order_relaxed);
+				d.timed = s.timed.load(std::memory_order_relaxed);
+				if(d.timed != 0)
+					d.total_ns = static_cast<double>(s.ticks.load(std::memory_order_relaxed)) * tick_ns * static_cast<double>(d.count) / static_cast<double>(d.timed);
+				d.max_ns = static_cast<double>(s.max.load(std::memory_order_relaxed)) * tick_ns;
+				d.tick_ns = tick_ns;
+				for(size_t c = 0; c < call_count; ++c)
+					d.calls[c] = s.calls[c].load(std::memory_order_relaxed);
+				for(size_t b = 0; b < buckets; ++b)
+					d.histogram[b] = s.hist[b].load(std::memory_order_relaxed);
 			}
+			return ret;
 		}
 
-		inline int _lcase_cmp(const char* s1, const char* s2) {
-			#ifdef _MSC_VER
-			return _stricmp(s1, s2);
-			#else // GCC having some linker problems even with strcasecmp (at least at my end)
-			const char *p1 = s1, *p2 = s2;
-			int result = 0;
-			do {
-				result = tolower(*p1) - tolower(*p2);
-			} while(*p1++ != '\0' && *p2++ != '\0' && result == 0);
-			return (std::min)(1, (std::max)(-1, result));
-			#endif
+		// the next snapshot() counts from here, the max latencies restart too
+		inline void reset() {
+			using namespace __regedit_details::trace;
+			registry& r = reg();
+			std::lock_guard<std::mutex> lock(r.mtx);
+			merge(r.retired, r.retired, true);
+			for(size_t o = 0; o < op_count; ++o)
+				r.retired.ops[o].max.store(0, std::memory_order_relaxed);
+			for(live_block& l : r.live) { // the threads restart their 'max' on their next timed call
+				l.base.reset(new block());
+				merge(*l.base, *l.counts);
+			}
+			r.epoch.fetch_add(1, std::memory_order_relaxed);
 		}
 
 	}
+	#endif
 
-	class regedit {
+	template<class Backend>
+	class basic_regedit {
 
 		private:
 
-			HKEY _hkey = NULL;
-			DWORD _mode = KEY_READ | KEY_WRITE;
+			using DWORD   = __regedit_details::DWORD;
+			using DWORD64 = __regedit_details::DWORD64;
+			using BYTE    = __regedit_details::BYTE;
+			using handle  = typename Backend::handle;
+			using shared  = __regedit_details::shared_handle<Backend>;
 
-			// O(log2 n) search, returns end position if fails
+			shared _hkey;
+			bool _write = true;
+
+			// O(1) through the name index on large keys, O(log2 n) search otherwise, returns end position if fails
 			DWORD _find_pos(const char* str) const {
+				DWORD pos = 0;
+				if(_hkey.find(false, str, &pos))
+					return pos;
+				return _find_pos(str, __regedit_details::_has_find_key<Backend>());
+			}
+			DWORD _find_pos(const char* str, std::true_type) const {
+				DWORD pos = 0;
+				return Backend::find_key(_hkey, str, &pos) == __regedit_details::status::success ? pos : static_cast<DWORD>(size());
+			}
+			DWORD _find_pos(const char* str, std::false_type) const {
 				DWORD left = 0, right = 0, endp = 0;
-				if(RegQueryInfoKeyA(_hkey, NULL, NULL, NULL, &endp, NULL, NULL, NULL, NULL, NULL, NULL, NULL) != ERROR_SUCCESS)
+				__regedit_details::key_info ki;
+				if(!_hkey.info(&ki))
 					return 0;
 
-				right = endp;
+				right = endp = ki.subkeys;
 				if(left != right) {
-					char buff[255];
+					char buff[__regedit_details::key_name_size];
+					size_t len = strlen(str);
 					while(left <= right) {
-						DWORD blen = 255, pos = (left + right) >> 1;
-						if(RegEnumKeyExA(_hkey, pos, buff, &blen, NULL, NULL, NULL, NULL) != ERROR_SUCCESS)
+						DWORD blen = __regedit_details::key_name_size, pos = (left + right) >> 1;
+						if(Backend::enum_key(_hkey, pos, buff, &blen) != __regedit_details::status::success)
 							return endp;
-						int cmp = __regedit_details::_lcase_cmp(str, buff);
+						int cmp = __regedit_details::names::cmp(str, len, buff, blen);
 						if(cmp > 0)
 							left = pos + 1;
 						else if(cmp < 0)
@@ -265,28 +3748,37 @@ namespace neo {
 				return endp;
 			}
 			std::string _pos_str(size_t pos) const {
-				char buff[255];
-				DWORD blen = 255;
-				return RegEnumKeyExA(_hkey, static_cast<DWORD>(pos), buff, &blen, NULL, NULL, NULL, NULL) == ERROR_SUCCESS ? buff : "";
+				char buff[__regedit_details::key_name_size];
+				DWORD blen = __regedit_details::key_name_size;
+				return Backend::enum_key(_hkey, static_cast<DWORD>(pos), buff, &blen) == __regedit_details::status::success ? buff : "";
+			}
+			size_t _erase_names(const char* const* names, DWORD count) {
+				DWORD deleted = 0;
+				long ret = __regedit_details::_delete_keys<Backend>(_hkey, names, count, &deleted, __regedit_details::_has_delete_keys<Backend>());
+				if(deleted != 0)
+					_hkey.invalidate();
+				if(ret != __regedit_details::status::success)
+					throw std::logic_error("neo::regedit::erase(): trying to delete subkeys from an unvalid key");
+				return deleted;
+			}
+
+			// takes the ownership of an already opened handle
+			static basic_regedit _adopt(handle hk, bool write_permision) {
+				basic_regedit tmp;
+				tmp._hkey = shared::adopt(hk, write_permision);
+				tmp._write = write_permision;
+				return tmp;
 			}
 
 			struct _gen_fn {
-				std::pair<std::string, regedit> operator()(HKEY hk, DWORD pos) const {
-					char buff[255];
-					DWORD blen = 255;
-					RegEnumKeyExA(hk, pos, buff, &blen, NULL, NULL, NULL, NULL);
-					return { buff, regedit(hk, buff) };
+				std::pair<std::string, basic_regedit> operator()(const shared& hk, DWORD pos) const {
+					char buff[__regedit_details::key_name_size];
+					DWORD blen = __regedit_details::key_name_size;
+					Backend::enum_key(hk, pos, buff, &blen);
+					return { buff, basic_regedit(hk, buff, hk.write()) };
 				}
 			};
 
-			#ifndef _MSC_VER
-			static LONG RegDeleteTreeA(HKEY hk, LPCSTR pcstr) {
-				typedef LONG(*_DLLRegDeleteTreeA)(HKEY, LPCSTR);
-				static _DLLRegDeleteTreeA rgtafn = (_DLLRegDeleteTreeA)GetProcAddress(GetModuleHandleA("Advapi32.dll"), "RegDeleteTreeA");
-				return rgtafn(hk, pcstr);
-			}
-			#endif
-
 		public:
 
 			// https://docs.microsoft.com/es-es/windows/desktop/SysInfo/registry-functions
@@ -296,18 +3788,18 @@ namespace neo {
 			class iterator;
 			class const_iterator;
 
-			class iterator : public __regedit_details::iter<regedit, const_iterator, iterator, _gen_fn> {
+			class iterator : public __regedit_details::iter<Backend, basic_regedit, const_iterator, iterator, _gen_fn> {
 				public:
-					using __regedit_details::iter<regedit, const_iterator, iterator, _gen_fn>::iter;
-					friend regedit;
-					friend __regedit_details::iter<const regedit, iterator, const_iterator, _gen_fn>;
+					using __regedit_details::iter<Backend, basic_regedit, const_iterator, iterator, _gen_fn>::iter;
+					friend basic_regedit;
+					friend __regedit_details::iter<Backend, const basic_regedit, iterator, const_iterator, _gen_fn>;
 			};
-			class const_iterator : public __regedit_details::iter<const regedit, iterator, const_iterator, _gen_fn> {
+			class const_iterator : public __regedit_details::iter<Backend, const basic_regedit, iterator, const_iterator, _gen_fn> {
 				public:
-					using __regedit_details::iter<const regedit, iterator, const_iterator, _gen_fn>::iter;
-					const_iterator(const iterator& other) : __regedit_details::iter<const regedit, iterator, const_iterator, _gen_fn>::iter(other._hkey, other._pos) {}
-					const_iterator(iterator&& other) : __regedit_details::iter<const regedit, iterator, const_iterator, _gen_fn>::iter(other._hkey, other._pos) {}
-					using __regedit_details::iter<const regedit, iterator, const_iterator, _gen_fn>::operator=;
+					using __regedit_details::iter<Backend, const basic_regedit, iterator, const_iterator, _gen_fn>::iter;
+					const_iterator(const iterator& other) : __regedit_details::iter<Backend, const basic_regedit, iterator, const_iterator, _gen_fn>::iter(other._hkey, other._pos) {}
+					const_iterator(iterator&& other) : __regedit_details::iter<Backend, const basic_regedit, iterator, const_iterator, _gen_fn>::iter(other._hkey, other._pos) {}
+					using __regedit_details::iter<Backend, const basic_regedit, iterator, const_iterator, _gen_fn>::operator=;
 					const_iterator& operator=(const iterator& other) {
 						*this = static_cast<const const_iterator&>(other);
 						return *this;
@@ -316,81 +3808,147 @@ namespace neo {
 						*this = static_cast<const_iterator&&>(std::forward<iterator>(other));
 						return *this;
 					}
-					friend regedit;
-					friend __regedit_details::iter<regedit, const_iterator, iterator, _gen_fn>;
+					friend basic_regedit;
+					friend __regedit_details::iter<Backend, basic_regedit, const_iterator, iterator, _gen_fn>;
 			};
 			using reverse_iterator       = std::reverse_iterator<iterator>;
 			using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
-			struct hkey {
-				static const HKEY classes_root;
-				static const HKEY current_config;
-				static const HKEY current_user;
-				static const HKEY local_machine;
-				static const HKEY users;
+			using backend_type = Backend;
+			using handle_type  = handle;
+			using hkey         = typename Backend::hkey;
+			using type         = __regedit_details::type;
+
+			using key_info      = __regedit_details::key_info;
+			using value_info    = __regedit_details::value_info;
+			using str_view      = __regedit_details::str_view;
+			using sz_view       = __regedit_details::sz_view;
+			using multi_sz_view = __regedit_details::multi_sz_view;
+
+			// subkey names taken in one pass, iterating doesn't touch the backend anymore
+			class key_snapshot : public __regedit_details::snapshot<Backend> {
+				private:
+					friend basic_regedit;
+				public:
+					key_snapshot() {}
+					basic_regedit open(const __regedit_details::snapshot_entry& e) const {
+						return basic_regedit(this->_hkey, e.name, this->_write);
+					}
+					basic_regedit open(size_t pos) const {
+						return open(this->at(pos));
+					}
 			};
-			using type = __regedit_details::type;
+
+			class value_ref;
 
 			class value {
 
 				private:
 
-					HKEY _hkey = NULL;
+					shared _hkey;
 					std::string _name;
-					DWORD _mode = KEY_READ | KEY_WRITE;
+					bool _write = true;
+
+					// the shared handle can be a read only one, a writable handle is only opened when writing
+					handle _writable() {
+						if(_write && !_hkey.write()) {
+							shared hk = shared::open(_hkey, "", true);
+							if(hk.is_open())
+								_hkey = std::move(hk);
+						}
+						return _hkey;
+					}
 
 				public:
 
 					value() {}
-					value(HKEY hk, const char* name = "", bool write_permision = true) : _name(name) {
-						_mode = write_permision == true ? (KEY_READ | KEY_WRITE) : (KEY_READ);
-						RegOpenKeyExA(hk, "", 0, _mode, &_hkey);
-					}
-					value(const value& other) {
-						*this = other;
-					}
+					value(handle hk, const char* name = "", bool write_permision = true) : _hkey(shared::open(hk, "", write_permision)), _name(name), _write(write_permision) {}
+					value(const shared& hk, const char* name, bool write_permision = true) : _hkey(hk), _name(name), _write(write_permision) {}
+					value(const value_ref& ref) : _hkey(*ref._hkey), _name(ref._name), _write(ref._write) {}
+					value(const value&) = default;
 					value(value&& other) {
-						*this = std::forward<value>(other);
+						swap(other);
 					}
 
-					value& operator=(const value& other) {
-						RegOpenKeyExA(other._hkey, "", 0, other._mode, &_hkey);
-						_name = other._name;
-						_mode = other._mode;
-						return *this;
-					}
+					value& operator=(const value&) = default;
 					value& operator=(value&& other) {
 						swap(other);
 						return *this;
 					}
 
-					~value() {
-						if(_hkey != NULL)
-							RegCloseKey(_hkey);
-					}
-
-					std::unique_ptr<BYTE> read() const {
-						return __regedit_details::read_overload::read(_hkey, _name);
+					std::unique_ptr<BYTE[]> read() const {
+						REGEDIT_TRACE(read);
+						return __regedit_details::read_overload::read<Backend>(_hkey, _name.c_str());
 					}
 					template<type Ty>
 					__regedit_details::read_overload::_return_t<Ty> read() const {
-						return __regedit_details::read_overload::read<Ty>(_hkey, _name);
+						REGEDIT_TRACE(read);
+						return __regedit_details::read_overload::read<Ty, Backend>(_hkey, _name.c_str());
+					}
+					// reuses the storage of 'out' (binary types read into a std::vector<BYTE>), no allocations once it's big enough
+					template<type Ty>
+					bool read(__regedit_details::read_overload::_into_t<Ty>& out) const {
+						REGEDIT_TRACE(read);
+						return __regedit_details::read_overload::read<Ty, Backend>(_hkey, _name.c_str(), out);
+					}
+					// link targets as UTF-8
+					template<type Ty, typename = typename std::enable_if<Ty == type::link>::type>
+					bool read(std::string& out) const {
+						REGEDIT_TRACE(read);
+						return __regedit_details::read_overload::_reader<Ty>::template read<Backend>(_hkey, _name.c_str(), out);
+					}
+					// expanded by 'env' (a neo::env_expander, see regedit_expand.hpp) instead of the process environment
+					template<type Ty, class Expander, typename = typename std::enable_if<Ty == type::expand_sz>::type>
+					bool read(std::string& out, Expander& env) const {
+						REGEDIT_TRACE(read);
+						if(!__regedit_details::read_overload::read<type::sz, Backend>(_hkey, _name.c_str(), out))
+							return false;
+						env.expand(out);
+						return true;
+					}
+					// the string data on one owning buffer, parsed in place: no copies per string, 'out' is reused by the next reads
+					template<type Ty, typename = typename std::enable_if<Ty == type::sz || Ty == type::expand_sz || Ty == type::multi_sz>::type>
+					bool view(__regedit_details::_view_t<Ty>& out) const {
+						REGEDIT_TRACE(read);
+						return __regedit_details::_read_view<Backend>(_hkey, _name.c_str(), out, Ty == type::expand_sz);
+					}
+					template<type Ty, typename = typename std::enable_if<Ty == type::sz || Ty == type::expand_sz || Ty == type::multi_sz>::type>
+					__regedit_details::_view_t<Ty> view() const {
+						__regedit_details::_view_t<Ty> out;
+						view<Ty>(out);
+						return out;
+					}
+					// same than RegQueryValueEx, 'bytes' gets the needed size if the value doesn't fit
+					bool read(void* data, DWORD* bytes, basic_regedit::type* ty = nullptr) const {
+						REGEDIT_TRACE(read);
+						DWORD vty = 0;
+						bool ret = Backend::query_value(_hkey, _name.c_str(), &vty, reinterpret_cast<BYTE*>(data), bytes) == __regedit_details::status::success;
+						if(ty != nullptr)
+							*ty = static_cast<basic_regedit::type>(vty);
+						return ret;
 					}
 
 					void write(const void* data, type ty, DWORD bytes) {
-						RegSetValueExA(_hkey, _name.c_str(), 0, static_cast<DWORD>(ty), reinterpret_cast<const LPBYTE>(const_cast<void*>(data)), bytes);
+						REGEDIT_TRACE(write);
+						Backend::set_value(_writable(), _name.c_str(), static_cast<DWORD>(ty), reinterpret_cast<const BYTE*>(data), bytes);
 					}
 					void write_unicode(const void* data, type ty, DWORD bytes) {
-						RegSetValueExW(_hkey, std::wstring(_name.begin(), _name.end()).c_str(), 0, static_cast<DWORD>(ty), reinterpret_cast<const LPBYTE>(const_cast<void*>(data)), bytes);
+						REGEDIT_TRACE(write);
+						Backend::set_value_unicode(_writable(), _name.c_str(), static_cast<DWORD>(ty), reinterpret_cast<const BYTE*>(data), bytes);
 					}
 
 					template<type Ty, typename = typename std::enable_if<Ty == type::none>::type>
 					void write() {
 						write(nullptr, Ty, 0);
 					}
-					template<type Ty, typename = typename std::enable_if<Ty == type::sz || Ty == type::expand_sz>::type>
+					// UTF-8, link targets are stored as wchar_t strings
+					template<type Ty, typename = typename std::enable_if<Ty == type::sz || Ty == type::expand_sz || Ty == type::link>::type>
 					void write(const std::string& val) {
-						write(val.c_str(), Ty, val.size() + 1);
+						if(Ty != type::link)
+							return write(val.c_str(), Ty, static_cast<DWORD>(val.size() + 1));
+						std::wstring wide;
+						__regedit_details::utf::to_wide(val.c_str(), val.size(), wide);
+						write<Ty>(wide);
 					}
 					template<type Ty, typename = typename std::enable_if<Ty == type::binary>::type>
 					void write(const uint8_t* val, size_t bytes) {
@@ -402,7 +3960,7 @@ namespace neo {
 					}
 					template<type Ty, typename = typename std::enable_if<Ty == type::sz || Ty == type::expand_sz || Ty == type::link>::type>
 					void write(const std::wstring& val) {
-						write_unicode(val.c_str(), Ty, val.size() * 2 + 2);
+						write_unicode(val.c_str(), Ty, static_cast<DWORD>((val.size() + 1) * sizeof(wchar_t)));
 					}
 					template<type Ty, class InputIterator, typename = typename std::enable_if<Ty == type::multi_sz>::type>
 					typename std::enable_if<std::is_convertible<decltype(*InputIterator()), std::string>::value, void>::type  write(InputIterator left, InputIterator right) {
@@ -413,7 +3971,7 @@ namespace neo {
 							vec.push_back('\0');
 						}
 						vec.push_back('\0');
-						write(vec.data(), Ty, vec.size());
+						write(vec.data(), Ty, static_cast<DWORD>(vec.size()));
 					}
 					template<type Ty, class InputIterator, typename = typename std::enable_if<Ty == type::multi_sz>::type>
 					typename std::enable_if<std::is_convertible<decltype(*InputIterator()), std::wstring>::value, void>::type write(InputIterator left, InputIterator right) {
@@ -424,7 +3982,7 @@ namespace neo {
 							vec.push_back(L'\0');
 						}
 						vec.push_back(L'\0');
-						write_unicode(vec.data(), Ty, vec.size() * 2);
+						write_unicode(vec.data(), Ty, static_cast<DWORD>(vec.size() * sizeof(wchar_t)));
 					}
 					template<type Ty, typename = typename std::enable_if<Ty == type::resource_list || Ty == type::full_resource_descriptor || Ty == type::resource_requirements_list>::type>
 					void write(const void* val, size_t bytes) {
@@ -435,21 +3993,105 @@ namespace neo {
 						write(&val, Ty, sizeof(DWORD64));
 					}
 
-					regedit::type type() const {
+					basic_regedit::type type() const {
+						REGEDIT_TRACE(read);
 						DWORD ty = 0;
-						RegQueryValueExA(_hkey, _name.c_str(), NULL, &ty, NULL, NULL);
-						return static_cast<regedit::type>(ty);
+						Backend::query_value(_hkey, _name.c_str(), &ty, NULL, NULL);
+						return static_cast<basic_regedit::type>(ty);
 					}
 
 					size_t size() const {
+						REGEDIT_TRACE(read);
 						DWORD len = 0;
-						return static_cast<size_t>(RegQueryValueExA(_hkey, _name.c_str(), NULL, NULL, NULL, &len) == ERROR_SUCCESS ? len : 0);
+						return static_cast<size_t>(Backend::query_value(_hkey, _name.c_str(), NULL, NULL, &len) == __regedit_details::status::success ? len : 0);
 					}
 
 					void swap(value& other) {
-						std::swap(_hkey, other._hkey);
+						_hkey.swap(other._hkey);
 						std::swap(_name, other._name);
-						std::swap(_mode, other._mode);
+						std::swap(_write, other._write);
+					}
+
+			};
+
+			// non-owning view of a value, valid while the key (or snapshot) it was taken from and the name are alive
+			class value_ref {
+
+				private:
+
+					const shared* _hkey = nullptr;
+					const char* _name = "";
+					bool _write = true; // of the key, for the value objects made from it
+
+					friend value;
+
+				public:
+
+					value_ref() {}
+					value_ref(const shared& hk, const char* name, bool write_permision) : _hkey(&hk), _name(name), _write(write_permision) {}
+
+					const char* name() const {
+						return _name;
+					}
+
+					std::unique_ptr<BYTE[]> read() const {
+						REGEDIT_TRACE(read);
+						return __regedit_details::read_overload::read<Backend>(*_hkey, _name);
+					}
+					template<type Ty>
+					__regedit_details::read_overload::_return_t<Ty> read() const {
+						REGEDIT_TRACE(read);
+						return __regedit_details::read_overload::read<Ty, Backend>(*_hkey, _name);
+					}
+					template<type Ty>
+					bool read(__regedit_details::read_overload::_into_t<Ty>& out) const {
+						REGEDIT_TRACE(read);
+						return __regedit_details::read_overload::read<Ty, Backend>(*_hkey, _name, out);
+					}
+					template<type Ty, typename = typename std::enable_if<Ty == type::link>::type>
+					bool read(std::string& out) const {
+						REGEDIT_TRACE(read);
+						return __regedit_details::read_overload::_reader<Ty>::template read<Backend>(*_hkey, _name, out);
+					}
+					template<type Ty, class Expander, typename = typename std::enable_if<Ty == type::expand_sz>::type>
+					bool read(std::string& out, Expander& env) const {
+						REGEDIT_TRACE(read);
+						if(!__regedit_details::read_overload::read<type::sz, Backend>(*_hkey, _name, out))
+							return false;
+						env.expand(out);
+						return true;
+					}
+					template<type Ty, typename = typename std::enable_if<Ty == type::sz || Ty == type::expand_sz || Ty == type::multi_sz>::type>
+					bool view(__regedit_details::_view_t<Ty>& out) const {
+						REGEDIT_TRACE(read);
+						return __regedit_details::_read_view<Backend>(*_hkey, _name, out, Ty == type::expand_sz);
+					}
+					template<type Ty, typename = typename std::enable_if<Ty == type::sz || Ty == type::expand_sz || Ty == type::multi_sz>::type>
+					__regedit_details::_view_t<Ty> view() const {
+						__regedit_details::_view_t<Ty> out;
+						view<Ty>(out);
+						return out;
+					}
+					bool read(void* data, DWORD* bytes, basic_regedit::type* ty = nullptr) const {
+						REGEDIT_TRACE(read);
+						DWORD vty = 0;
+						bool ret = Backend::query_value(*_hkey, _name, &vty, reinterpret_cast<BYTE*>(data), bytes) == __regedit_details::status::success;
+						if(ty != nullptr)
+							*ty = static_cast<basic_regedit::type>(vty);
+						return ret;
+					}
+
+					basic_regedit::type type() const {
+						REGEDIT_TRACE(read);
+						DWORD ty = 0;
+						Backend::query_value(*_hkey, _name, &ty, NULL, NULL);
+						return static_cast<basic_regedit::type>(ty);
+					}
+
+					size_t size() const {
+						REGEDIT_TRACE(read);
+						DWORD len = 0;
+						return static_cast<size_t>(Backend::query_value(*_hkey, _name, NULL, NULL, &len) == __regedit_details::status::success ? len : 0);
 					}
 
 			};
@@ -458,22 +4100,36 @@ namespace neo {
 
 				private:
 
-					HKEY& _hkey;
+					shared& _hkey;
+					const bool& _write; // of the key, given to the snapshots
 
-					// O(log2 n) search, returns end position if fails
+					// O(1) through the name index on large keys, O(log2 n) search otherwise, returns end position if fails
 					DWORD _find_pos(const char* str) const {
+						DWORD pos = 0;
+						if(_hkey.find(true, str, &pos))
+							return pos;
+						return _find_pos(str, __regedit_details::_has_find_value<Backend>());
+					}
+					DWORD _find_pos(const char* str, std::true_type) const {
+						DWORD pos = 0;
+						return Backend::find_value(_hkey, str, &pos) == __regedit_details::status::success ? pos : static_cast<DWORD>(size());
+					}
+					DWORD _find_pos(const char* str, std::false_type) const {
 						DWORD left = 0, right = 0, endp = 0;
-						if(RegQueryInfoKeyA(_hkey, NULL, NULL, NULL, NULL, NULL, NULL, &endp, NULL, NULL, NULL, NULL) != ERROR_SUCCESS)
+						__regedit_details::key_info ki;
+						if(!_hkey.info(&ki))
 							return 0;
 
-						right = endp;
+						right = endp = ki.values;
 						if(left != right) {
-							char buff[16384];
+							__regedit_details::read_overload::_buffer buff;
+							buff.reserve(ki.max_value_name + 1);
+							size_t len = strlen(str);
 							while(left <= right) {
-								DWORD blen = 16384, pos = (left + right) >> 1;
-								if(RegEnumValueA(_hkey, pos, buff, &blen, NULL, NULL, NULL, NULL) != ERROR_SUCCESS)
+								DWORD pos = (left + right) >> 1, blen = 0;
+								if(_enum_name(_hkey, pos, buff, &blen) != __regedit_details::status::success)
 									return endp;
-								int cmp = __regedit_details::_lcase_cmp(str, buff);
+								int cmp = __regedit_details::names::cmp(str, len, reinterpret_cast<const char*>(buff.data()), blen);
 								if(cmp > 0)
 									left = pos + 1;
 								else if(cmp < 0)
@@ -485,24 +4141,47 @@ namespace neo {
 
 						return endp;
 					}
+					// the name buffer is sized from the key info, and grown to the Win32 limit if a name doesn't fit anyway (changes made elsewhere)
+					static long _enum_name(const shared& hk, DWORD pos, __regedit_details::read_overload::_buffer& buff, DWORD* out = nullptr) {
+						DWORD len = buff.capacity();
+						long ret = Backend::enum_value(hk, pos, reinterpret_cast<char*>(buff.data()), &len);
+						if(ret == __regedit_details::status::more_data) {
+							len = __regedit_details::value_name_size;
+							ret = Backend::enum_value(hk, pos, reinterpret_cast<char*>(buff.reserve(len)), &len);
+						}
+						if(out != nullptr)
+							*out = len;
+						return ret;
+					}
+					// the inline storage of the buffer fits the usual names, the longer ones take a second call
+					static const char* _name_at(const shared& hk, DWORD pos, __regedit_details::read_overload::_buffer& buff) {
+						return _enum_name(hk, pos, buff) == __regedit_details::status::success ? reinterpret_cast<const char*>(buff.data()) : "";
+					}
 					std::string _pos_str(size_t pos) const {
-						char buff[16384];
-						DWORD blen = 16384;
-						return RegEnumValueA(_hkey, static_cast<DWORD>(pos), buff, &blen, NULL, NULL, NULL, NULL) == ERROR_SUCCESS ? buff : "";
+						__regedit_details::read_overload::_buffer buff;
+						return _name_at(_hkey, static_cast<DWORD>(pos), buff);
+					}
+					size_t _erase_names(const char* const* names, DWORD count) {
+						DWORD deleted = 0;
+						long ret = __regedit_details::_delete_values<Backend>(_hkey, names, count, &deleted, __regedit_details::_has_delete_values<Backend>());
+						if(deleted != 0)
+							_hkey.invalidate();
+						if(ret != __regedit_details::status::success)
+							throw std::logic_error("neo::regedit::values::erase(): trying to delete values from an unvalid key");
+						return deleted;
 					}
 
 					struct _gen_fn {
-						std::pair<std::string, value> operator()(HKEY hk, DWORD pos) const {
-							char buff[16383];
-							DWORD blen = 16383;
-							RegEnumValueA(hk, pos, buff, &blen, NULL, NULL, NULL, NULL);
-							return {buff, value(hk, buff)};
+						std::pair<std::string, value> operator()(const shared& hk, DWORD pos) const {
+							__regedit_details::read_overload::_buffer buff;
+							const char* name = _name_at(hk, pos, buff);
+							return {name, value(hk, name, hk.write())}; // the handle of the key was opened with its permissions
 						}
 					};
 
-					values(HKEY& hkey) : _hkey(hkey) {}
+					values(shared& hkey, const bool& write) : _hkey(hkey), _write(write) {}
 
-					friend regedit;
+					friend basic_regedit;
 
 				public:
 
@@ -517,18 +4196,18 @@ namespace neo {
 					class iterator;
 					class const_iterator;
 
-					class iterator : public __regedit_details::iter<value, const_iterator, iterator, _gen_fn> {
+					class iterator : public __regedit_details::iter<Backend, value, const_iterator, iterator, _gen_fn> {
 						public:
-							using __regedit_details::iter<value, const_iterator, iterator, _gen_fn>::iter;
+							using __regedit_details::iter<Backend, value, const_iterator, iterator, _gen_fn>::iter;
 							friend values;
-							friend __regedit_details::iter<const value, iterator, const_iterator, _gen_fn>;
+							friend __regedit_details::iter<Backend, const value, iterator, const_iterator, _gen_fn>;
 					};
-					class const_iterator : public __regedit_details::iter<const value, iterator, const_iterator, _gen_fn> {
+					class const_iterator : public __regedit_details::iter<Backend, const value, iterator, const_iterator, _gen_fn> {
 						public:
-							using __regedit_details::iter<const value, iterator, const_iterator, _gen_fn>::iter;
-							const_iterator(const iterator& other) : __regedit_details::iter<const value, iterator, const_iterator, _gen_fn>::iter(other._hkey, other._pos) {}
-							const_iterator(iterator&& other) : __regedit_details::iter<const value, iterator, const_iterator, _gen_fn>::iter(other._hkey, other._pos) {}
-							using __regedit_details::iter<const value, iterator, const_iterator, _gen_fn>::operator=;
+							using __regedit_details::iter<Backend, const value, iterator, const_iterator, _gen_fn>::iter;
+							const_iterator(const iterator& other) : __regedit_details::iter<Backend, const value, iterator, const_iterator, _gen_fn>::iter(other._hkey, other._pos) {}
+							const_iterator(iterator&& other) : __regedit_details::iter<Backend, const value, iterator, const_iterator, _gen_fn>::iter(other._hkey, other._pos) {}
+							using __regedit_details::iter<Backend, const value, iterator, const_iterator, _gen_fn>::operator=;
 							const_iterator& operator=(const iterator& other) {
 								*this = static_cast<const const_iterator&>(other);
 								return *this;
@@ -538,11 +4217,45 @@ namespace neo {
 								return *this;
 							}
 							friend values;
-							friend __regedit_details::iter<value, const_iterator, iterator, _gen_fn>;
+							friend __regedit_details::iter<Backend, value, const_iterator, iterator, _gen_fn>;
 					};
 					using reverse_iterator		 = std::reverse_iterator<iterator>;
 					using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
+					// value names, and optionally types and sizes, taken in one pass
+					class value_snapshot : public __regedit_details::snapshot<Backend> {
+						private:
+							friend values;
+						public:
+							value_snapshot() {}
+							value open(const __regedit_details::snapshot_entry& e) const {
+								return value(this->_hkey, e.name, this->_write);
+							}
+							value open(size_t pos) const {
+								return open(this->at(pos));
+							}
+							value_ref ref(const __regedit_details::snapshot_entry& e) const {
+								return value_ref(this->_hkey, e.name, this->_write);
+							}
+					};
+
+					// names, types, sizes and data of all the values, see query_all()
+					class value_table : public __regedit_details::value_table<Backend> {
+						private:
+							friend values;
+						public:
+							value_table() {}
+							value open(const __regedit_details::value_info& e) const {
+								return value(this->_hkey, e.name, this->_write);
+							}
+							value open(size_t pos) const {
+								return open(this->at(pos));
+							}
+							value_ref ref(const __regedit_details::value_info& e) const {
+								return value_ref(this->_hkey, e.name, this->_write);
+							}
+					};
+
 					// Iterators:
 
 					iterator begin() {
@@ -588,52 +4301,62 @@ namespace neo {
 					// Element Access:
 
 					value at(const std::string& val) {
-						if(RegQueryValueExA(_hkey, val.c_str(), NULL, NULL, NULL, NULL) != ERROR_SUCCESS)
+						REGEDIT_TRACE(at);
+						if(Backend::query_value(_hkey, val.c_str(), NULL, NULL, NULL) != __regedit_details::status::success)
 							throw std::out_of_range("neo::regedit::values::at(): value doesn't exists");
-						return value(_hkey, val.c_str());
+						return value(_hkey, val.c_str(), _write);
 					}
 					const value at(const std::string& val) const {
+						REGEDIT_TRACE(at);
 						return const_cast<values&>(*this).at(val);
 					}
 					value operator[](const std::string& val) {
+						REGEDIT_TRACE(subscript);
 						try {
 							return at(val);
 						}
 						catch(...) {
-							RegSetValueExA(_hkey, val.c_str(), 0, REG_NONE, NULL, 0);
-							return value(_hkey, val.c_str());
+							Backend::set_value(_hkey, val.c_str(), static_cast<DWORD>(type::none), NULL, 0);
+							_hkey.touch();
+							return value(_hkey, val.c_str(), _write);
 						}
 					}
 					const value operator[](const std::string& val) const {
+						REGEDIT_TRACE(subscript);
 						return const_cast<values&>(*this).operator[](val);
 					}
 
 					std::pair<std::string, value> at(size_t pos) {
+						REGEDIT_TRACE(at);
 						std::string val = _pos_str(pos);
-						if(RegQueryValueExA(_hkey, val.c_str(), NULL, NULL, NULL, NULL) != ERROR_SUCCESS)
+						if(Backend::query_value(_hkey, val.c_str(), NULL, NULL, NULL) != __regedit_details::status::success)
 							throw std::out_of_range("neo::regedit::values::at(): value doesn't exists");
 						std::pair<std::string, value> ret;
-						ret.second = value(_hkey, val.c_str());
+						ret.second = value(_hkey, val.c_str(), _write);
 						ret.first = std::move(val);
 						return std::move(ret);
 					}
 					const std::pair<std::string, value> at(size_t pos) const {
+						REGEDIT_TRACE(at);
 						return const_cast<values&>(*this).at(pos);
 					}
 					std::pair<std::string, value> operator[](size_t pos) {
+						REGEDIT_TRACE(subscript);
 						try {
 							return at(pos);
 						}
 						catch(...) {
 							std::string val = _pos_str(pos);
-							RegSetValueExA(_hkey, val.c_str(), 0, REG_NONE, NULL, 0);
+							Backend::set_value(_hkey, val.c_str(), static_cast<DWORD>(type::none), NULL, 0);
+							_hkey.touch();
 							std::pair<std::string, value> ret;
-							ret.second = value(_hkey, val.c_str());
+							ret.second = value(_hkey, val.c_str(), _write);
 							ret.first = std::move(val);
 							return std::move(ret);
 						}
 					}
 					const std::pair<std::string, value> operator[](size_t pos) const {
+						REGEDIT_TRACE(subscript);
 						return const_cast<values&>(*this).operator[](pos);
 					}
 
@@ -643,36 +4366,59 @@ namespace neo {
 						return !size();
 					}
 					size_t size() const {
-						DWORD size;
-						return static_cast<size_t>(RegQueryInfoKeyA(_hkey, NULL, NULL, NULL, NULL, NULL, NULL, &size, NULL, NULL, NULL, NULL) == ERROR_SUCCESS ? size : 0);
+						REGEDIT_TRACE(size);
+						__regedit_details::key_info ki;
+						return _hkey.info(&ki) ? ki.values : 0;
 					}
 
 					// Modifiers:
 
 					std::pair<iterator, bool> insert(const std::string& val) {
+						REGEDIT_TRACE(insert);
 						iterator it = find(val);
 						if(it != end())
 							return { it, false };
-						RegSetValueExA(_hkey, val.c_str(), 0, REG_NONE, NULL, 0);
+						Backend::set_value(_hkey, val.c_str(), static_cast<DWORD>(type::none), NULL, 0);
+						_hkey.touch();
 						return { find(val), true };
 					}
 					template<class InputIterator, typename = typename std::enable_if<std::is_convertible<decltype(*InputIterator()), std::string>::value>::type>
 					iterator insert(InputIterator left, InputIterator right) {
+						REGEDIT_TRACE(insert);
 						iterator it = end();
 						while(left != right)
-							it = insert(*left++).first; 
+							it = insert(*left++).first;
 						return it;
 					}
 					void insert(std::initializer_list<std::string> il) {
 						insert(il.begin(), il.end());
 					}
+					// adds the missing values (as type::none) without looking up each one, in a single call when the backend can, returns how many were added
+					template<class InputIterator, typename = typename std::enable_if<std::is_convertible<decltype(*InputIterator()), std::string>::value>::type>
+					size_t insert_bulk(InputIterator left, InputIterator right) {
+						REGEDIT_TRACE(insert);
+						__regedit_details::_name_list names(left, right);
+						DWORD created = 0;
+						long ret = __regedit_details::_create_values<Backend>(_hkey, names.data(), names.size(), &created, __regedit_details::_has_create_values<Backend>());
+						if(created != 0)
+							_hkey.touch();
+						if(ret != __regedit_details::status::success)
+							throw std::logic_error("neo::regedit::values::insert_bulk(): trying to insert values to an unvalid key");
+						return created;
+					}
+					size_t insert_bulk(std::initializer_list<std::string> il) {
+						return insert_bulk(il.begin(), il.end());
+					}
 
 					iterator erase(const_iterator pos) {
-						if(RegDeleteValueA(_hkey, pos->first.c_str()) != ERROR_SUCCESS)
+						REGEDIT_TRACE(erase);
+						if(Backend::delete_value(_hkey, pos->first.c_str()) != __regedit_details::status::success)
 							throw std::logic_error("neo::regedit::values::erase(): trying to delete a value from an unvalid key");
+						_hkey.invalidate();
 						return iterator(_hkey, (std::min)(pos._pos, static_cast<DWORD>(size())));
 					}
 					size_t erase(const std::string& val) {
+						REGEDIT_TRACE(erase);
 						const_iterator it = find(val);
 						if(it == cend())
 							return 0;
@@ -680,14 +4426,41 @@ namespace neo {
 						return 1;
 					}
 					iterator erase(const_iterator left, const_iterator right) {
-						iterator it = end();
-						while(left != right)
-							it = erase(--right);
-						return it;
+						REGEDIT_TRACE(erase);
+						DWORD pos = left._pos;
+						__regedit_details::_name_list names;
+						for(; left != right; ++left)
+							names.push_back(left->first);
+						if(names.size() == 0)
+							return end();
+						_erase_names(names.data(), names.size());
+						return iterator(_hkey, (std::min)(pos, static_cast<DWORD>(size())));
+					}
+					// deletes the given values in a single call when the backend can, the missing ones are skipped, returns how many were deleted
+					template<class InputIterator, typename = typename std::enable_if<std::is_convertible<decltype(*InputIterator()), std::string>::value>::type>
+					size_t erase_bulk(InputIterator left, InputIterator right) {
+						REGEDIT_TRACE(erase);
+						__regedit_details::_name_list names(left, right);
+						return _erase_names(names.data(), names.size());
+					}
+					size_t erase_bulk(std::initializer_list<std::string> il) {
+						return erase_bulk(il.begin(), il.end());
 					}
 
+					// the value names are enumerated once, then deleted by a single delete_values() when the backend has it, one call per name otherwise
 					void clear() {
-						erase(begin(), end());
+						REGEDIT_TRACE(erase);
+						__regedit_details::key_info ki;
+						_hkey.touch();
+						if(!_hkey.info(&ki) || ki.values == 0)
+							return;
+						// only the values seen, not delete_tree("") : subkeys created meanwhile stay
+						value_snapshot snap = snapshot();
+						std::vector<const char*> names;
+						names.reserve(snap.size());
+						for(const __regedit_details::snapshot_entry& e : snap)
+							names.push_back(e.name);
+						_erase_names(names.data(), static_cast<DWORD>(names.size()));
 					}
 
 					std::pair<iterator, bool> emplace(const std::string& val) {
@@ -697,39 +4470,69 @@ namespace neo {
 					// Operations:
 
 					iterator find(const std::string& val) {
+						REGEDIT_TRACE(find);
 						return iterator(_hkey, _find_pos(val.c_str()));
 					}
 					const_iterator find(const std::string& val) const {
+						REGEDIT_TRACE(find);
 						return const_cast<values&>(*this).find(val);
 					}
 
+					value_ref ref(const char* val) const {
+						return value_ref(_hkey, val, _write);
+					}
+
+					value_snapshot snapshot(bool with_info = false) const {
+						REGEDIT_TRACE(snapshot);
+						value_snapshot snap;
+						__regedit_details::key_info ki;
+						if(!_hkey.info(&ki))
+							return snap;
+						snap._fill(_hkey, _write, ki.values, (std::max)(ki.max_value_name + 1, static_cast<DWORD>(256)), [with_info](handle hk, DWORD pos, char* name, DWORD* len, __regedit_details::snapshot_entry* e) {
+							DWORD ty = 0;
+							long ret = Backend::enum_value(hk, pos, name, len, with_info ? &ty : nullptr, with_info ? &e->size : nullptr);
+							e->ty = static_cast<type>(ty);
+							return ret;
+						});
+						return snap;
+					}
+					// every value with its type and data in one pass, one backend call per value instead of the type() / size() / read() ones
+					value_table query_all() const {
+						REGEDIT_TRACE(snapshot);
+						value_table table;
+						__regedit_details::key_info ki;
+						if(_hkey.info(&ki))
+							table._fill(_hkey, _write, ki);
+						return table;
+					}
+
 			} values;
 
 			// Constructors:
 
-			regedit() : values(_hkey) {}
-			regedit(const regedit& other) : values(_hkey) {
+			basic_regedit() : values(_hkey, _write) {}
+			basic_regedit(const basic_regedit& other) : values(_hkey, _write) {
 				*this = other;
 			}
-			regedit(regedit&& other) : values(_hkey) {
-				*this = std::forward<regedit>(other);
+			basic_regedit(basic_regedit&& other) : values(_hkey, _write) {
+				*this = std::forward<basic_regedit>(other);
 			}
 
-			regedit(HKEY hkey, const std::string& key = "", bool write_permision = true) : values(_hkey) {
+			basic_regedit(handle hkey, const std::string& key = "", bool write_permision = true) : values(_hkey, _write) {
 				open(hkey, key, write_permision);
 			}
 
-			regedit& operator=(const regedit& other) {
-				RegOpenKeyExA(other._hkey, "", 0, other._mode, &_hkey); // generate a new handle to same key to avoid closing twice the same handle
-				_mode = other._mode;
+			basic_regedit& operator=(const basic_regedit& other) {
+				_hkey = other._hkey; // both share the same open handle
+				_write = other._write;
 				return *this;
 			};
-			regedit& operator=(regedit&& other) {
+			basic_regedit& operator=(basic_regedit&& other) {
 				swap(other);
 				return *this;
 			};
 
-			~regedit() {
+			~basic_regedit() {
 				close();
 			}
 
@@ -777,46 +4580,58 @@ namespace neo {
 
 			// Element Access:
 
-			regedit at(const std::string& key) {
-				regedit tmp(_hkey, key);
+			basic_regedit at(const std::string& key) {
+				REGEDIT_TRACE(at);
+				basic_regedit tmp(_hkey, key);
 				if(!tmp.is_open())
 					throw std::out_of_range("neo::regedit::at() key doesn't exists");
 				return std::move(tmp);
 			}
-			const regedit at(const std::string& key) const {
-				return const_cast<regedit&>(*this).at(key);
+			const basic_regedit at(const std::string& key) const {
+				REGEDIT_TRACE(at);
+				return const_cast<basic_regedit&>(*this).at(key);
 			}
-			regedit operator[](const std::string& key) {
-				HKEY hk;
-				DWORD disp;
-				if(RegCreateKeyExA(_hkey, key.c_str(), 0, NULL, REG_OPTION_NON_VOLATILE, _mode, NULL, &hk, &disp) != ERROR_SUCCESS)
+			basic_regedit operator[](const std::string& key) {
+				REGEDIT_TRACE(subscript);
+				handle hk;
+				bool created = false;
+				if(Backend::create(_hkey, key.c_str(), _write, &hk, &created) != __regedit_details::status::success)
 					throw std::logic_error("neo::regedit::operator[](): trying to open or create a subkey to an unvalid key");
-				return regedit(hk);
+				if(created)
+					_hkey.touch();
+				return _adopt(hk, _write);
 			}
-			const regedit operator[](const std::string& key) const {
-				return const_cast<regedit&>(*this).operator[](key);
+			const basic_regedit operator[](const std::string& key) const {
+				REGEDIT_TRACE(subscript);
+				return const_cast<basic_regedit&>(*this).operator[](key);
 			}
 
-			std::pair<std::string, regedit> at(size_t pos) {
+			std::pair<std::string, basic_regedit> at(size_t pos) {
+				REGEDIT_TRACE(at);
 				std::string key = _pos_str(pos);
-				regedit tmp(_hkey, key);
+				basic_regedit tmp(_hkey, key);
 				if(!tmp.is_open())
 					throw std::out_of_range("neo::regedit::at() key doesn't exists");
 				return { std::move(key), std::move(tmp) };
 			}
-			const std::pair<std::string, regedit> at(size_t pos) const {
-				return const_cast<regedit&>(*this).at(pos);
+			const std::pair<std::string, basic_regedit> at(size_t pos) const {
+				REGEDIT_TRACE(at);
+				return const_cast<basic_regedit&>(*this).at(pos);
 			}
-			std::pair<std::string, regedit> operator[](size_t pos) {
-				HKEY hk;
-				DWORD disp;
+			std::pair<std::string, basic_regedit> operator[](size_t pos) {
+				REGEDIT_TRACE(subscript);
+				handle hk;
+				bool created = false;
 				std::string key = _pos_str(pos);
-				if(RegCreateKeyExA(_hkey, key.c_str(), 0, NULL, REG_OPTION_NON_VOLATILE, _mode, NULL, &hk, &disp) != ERROR_SUCCESS)
+				if(Backend::create(_hkey, key.c_str(), _write, &hk, &created) != __regedit_details::status::success)
 					throw std::logic_error("neo::regedit::operator[](): trying to open or create a subkey to an unvalid key");
-				return { std::move(key), regedit(hk) };
+				if(created)
+					_hkey.touch();
+				return { std::move(key), _adopt(hk, _write) };
 			}
-			const std::pair<std::string, regedit> operator[](size_t pos) const {
-				return const_cast<regedit&>(*this).operator[](pos);
+			const std::pair<std::string, basic_regedit> operator[](size_t pos) const {
+				REGEDIT_TRACE(subscript);
+				return const_cast<basic_regedit&>(*this).operator[](pos);
 			}
 
 			// Capacity:
@@ -825,45 +4640,84 @@ namespace neo {
 				return !size();
 			}
 			size_t size() const {
-				DWORD size;
-				return static_cast<size_t>(RegQueryInfoKeyA(_hkey, NULL, NULL, NULL, &size, NULL, NULL, NULL, NULL, NULL, NULL, NULL) == ERROR_SUCCESS ? size : 0);
+				REGEDIT_TRACE(size);
+				__regedit_details::key_info ki;
+				return _hkey.info(&ki) ? ki.subkeys : 0;
+			}
+
+			// Key info:
+
+			// counts and longest names / data of the key, queried once and kept until a subkey or value is added or removed through this container
+			// (or any copy of it), the data length isn't updated by the writes
+			key_info info() const {
+				__regedit_details::key_info ki;
+				_hkey.info(&ki);
+				return ki;
+			}
+			// drops the kept key info, needed to see the changes made through other handles or processes
+			void refresh() const {
+				_hkey.touch();
 			}
 
 			// Modifiers:
 
-			bool open(HKEY hkey, const std::string& key = "", bool write_permision = true) {
-				_mode = write_permision == true ? (KEY_READ | KEY_WRITE) : (KEY_READ);
-				return RegOpenKeyExA(hkey, key.c_str(), 0, _mode, &_hkey) == ERROR_SUCCESS;
+			bool open(handle hkey, const std::string& key = "", bool write_permision = true) {
+				REGEDIT_TRACE(open);
+				_write = write_permision;
+				_hkey = shared::open(hkey, key.c_str(), _write);
+				return _hkey.is_open();
 			}
 
 			void close() {
-				if(_hkey != NULL)
-					RegCloseKey(_hkey);
-				_hkey = NULL;
+				_hkey.reset();
 			}
 
 			std::pair<iterator, bool> insert(const std::string& key) {
-				HKEY hk;
-				DWORD disp;
-				if(RegCreateKeyExA(_hkey, key.c_str(), 0, NULL, REG_OPTION_NON_VOLATILE, _mode, NULL, &hk, &disp) != ERROR_SUCCESS)
+				REGEDIT_TRACE(insert);
+				handle hk;
+				bool created = false;
+				if(Backend::create(_hkey, key.c_str(), _write, &hk, &created) != __regedit_details::status::success)
 					throw std::logic_error("neo::regedit::insert(): trying to insert a subkey to an unvalid key");
-				return { find(key), (disp == REG_CREATED_NEW_KEY) };
+				Backend::close(hk);
+				if(created)
+					_hkey.touch();
+				return { find(key), created };
 			}
 			template<class InputIterator, typename = typename std::enable_if<std::is_convertible<decltype(*InputIterator()), std::string>::value>::type>
 			void insert(InputIterator left, InputIterator right) {
+				REGEDIT_TRACE(insert);
 				while(left != right)
 					insert(*left++);
 			}
 			void insert(std::initializer_list<std::string> il) {
 				insert(il.begin(), il.end());
 			}
+			// creates the missing subkeys without looking up each one, in a single call when the backend can, returns how many were created
+			template<class InputIterator, typename = typename std::enable_if<std::is_convertible<decltype(*InputIterator()), std::string>::value>::type>
+			size_t insert_bulk(InputIterator left, InputIterator right) {
+				REGEDIT_TRACE(insert);
+				__regedit_details::_name_list names(left, right);
+				DWORD created = 0;
+				long ret = __regedit_details::_create_keys<Backend>(_hkey, names.data(), names.size(), &created, __regedit_details::_has_create_keys<Backend>());
+				if(created != 0)
+					_hkey.touch();
+				if(ret != __regedit_details::status::success)
+					throw std::logic_error("neo::regedit::insert_bulk(): trying to insert subkeys to an unvalid key");
+				return created;
+			}
+			size_t insert_bulk(std::initializer_list<std::string> il) {
+				return insert_bulk(il.begin(), il.end());
+			}
 
 			iterator erase(const_iterator pos) {
-				if(RegDeleteTreeA(_hkey, pos->first.c_str()) != ERROR_SUCCESS)
+				REGEDIT_TRACE(erase);
+				if(Backend::delete_tree(_hkey, pos->first.c_str()) != __regedit_details::status::success)
 					throw std::logic_error("neo::regedit::erase(): trying to delete a subkey from an unvalid key");
+				_hkey.invalidate();
 				return iterator(_hkey, pos._pos == 0 ? 0 : pos._pos - 1);
 			}
 			size_t erase(const std::string& key) {
+				REGEDIT_TRACE(erase);
 				const_iterator it = find(key);
 				if(it == cend())
 					return 0;
@@ -871,19 +4725,47 @@ namespace neo {
 				return 1;
 			}
 			iterator erase(const_iterator left, const_iterator right) {
-				iterator it = end();
-				while(left != right)
-					it = erase(--right);
-				return it;
+				REGEDIT_TRACE(erase);
+				DWORD pos = left._pos;
+				__regedit_details::_name_list names;
+				for(; left != right; ++left)
+					names.push_back(left->first);
+				if(names.size() == 0)
+					return end();
+				_erase_names(names.data(), names.size());
+				return iterator(_hkey, pos == 0 ? 0 : pos - 1);
+			}
+			// deletes the given subkeys (and their subtrees) in a single call when the backend can, the missing ones are skipped,
+			// returns how many were deleted
+			template<class InputIterator, typename = typename std::enable_if<std::is_convertible<decltype(*InputIterator()), std::string>::value>::type>
+			size_t erase_bulk(InputIterator left, InputIterator right) {
+				REGEDIT_TRACE(erase);
+				__regedit_details::_name_list names(left, right);
+				return _erase_names(names.data(), names.size());
+			}
+			size_t erase_bulk(std::initializer_list<std::string> il) {
+				return erase_bulk(il.begin(), il.end());
 			}
 
-			void swap(regedit& other) {
-				std::swap(_hkey, other._hkey);
-				std::swap(_mode, other._mode);
+			void swap(basic_regedit& other) {
+				_hkey.swap(other._hkey);
+				std::swap(_write, other._write);
 			}
 
+			// the subkey names are enumerated once, then their trees deleted by a single delete_keys() when the backend has it, one delete_tree() per name otherwise
 			void clear() {
-				erase(begin(), end());
+				REGEDIT_TRACE(erase);
+				__regedit_details::key_info ki;
+				_hkey.touch();
+				if(!_hkey.info(&ki) || ki.subkeys == 0)
+					return;
+				// only the subkeys seen, not delete_tree("") : values written meanwhile stay
+				key_snapshot snap = snapshot();
+				std::vector<const char*> names;
+				names.reserve(snap.size());
+				for(const __regedit_details::snapshot_entry& e : snap)
+					names.push_back(e.name);
+				_erase_names(names.data(), static_cast<DWORD>(names.size()));
 			}
 
 			std::pair<iterator, bool> emplace(const std::string& key) {
@@ -893,14 +4775,32 @@ namespace neo {
 			// Operations:
 
 			iterator find(const std::string& key) {
+				REGEDIT_TRACE(find);
 				return iterator(_hkey, _find_pos(key.c_str()));
 			}
 			const_iterator find(const std::string& key) const {
-				return const_cast<regedit&>(*this).find(key);
+				REGEDIT_TRACE(find);
+				return const_cast<basic_regedit&>(*this).find(key);
+			}
+
+			key_snapshot snapshot() const {
+				REGEDIT_TRACE(snapshot);
+				key_snapshot snap;
+				__regedit_details::key_info ki;
+				if(!_hkey.info(&ki))
+					return snap;
+				snap._fill(_hkey, _write, ki.subkeys, (std::max)(ki.max_key_name + 1, static_cast<DWORD>(256)), [](handle hk, DWORD pos, char* name, DWORD* len, __regedit_details::snapshot_entry*) {
+					return Backend::enum_key(hk, pos, name, len);
+				});
+				return snap;
 			}
 
 			bool is_open() const {
-				return _hkey != NULL;
+				return _hkey.is_open();
+			}
+
+			handle_type native_handle() const {
+				return _hkey.get();
 			}
 
 			static const char* type_to_string(type ty) {
@@ -923,11 +4823,101 @@ namespace neo {
 
 	};
 
-	const HKEY regedit::hkey::classes_root   = HKEY_CLASSES_ROOT;
-	const HKEY regedit::hkey::current_config = HKEY_CURRENT_CONFIG;
-	const HKEY regedit::hkey::current_user   = HKEY_CURRENT_USER;
-	const HKEY regedit::hkey::local_machine  = HKEY_LOCAL_MACHINE;
-	const HKEY regedit::hkey::users          = HKEY_USERS;
+	namespace __regedit_details {
+
+		// breadth first, the subkeys of a key are created together and the values go through a single reused buffer
+		template<class Src, class Dst>
+		bool copy_tree(typename Src::handle src, typename Dst::handle dst) {
+			struct _pair {
+				typename Src::handle s;
+				typename Dst::handle d;
+			};
+			std::deque<_pair> queue;
+			std::vector<char> name(16384 * 3 + 1); // UTF-8 names from hives can take more than 16383 bytes
+			read_overload::_buffer data;
+			bool ok = true;
+
+			auto release = [](const _pair& p) {
+				Src::close(p.s);
+				Dst::close(p.d);
+			};
+			_pair cur = { src, dst };
+			bool root = true;
+			try {
+				for(;;) {
+					DWORD keys = 0, vals = 0;
+					if(Src::query_info(cur.s, &keys, &vals) != status::success)
+						ok = false;
+					else {
+						for(DWORD pos = 0; pos < vals; ++pos) {
+							DWORD ty = 0, len = 0;
+							if(_enum_data<Src>(cur.s, pos, name.data(), static_cast<DWORD>(name.size()), &ty, data, &len, _has_enum_data<Src>()) != status::success
+							|| Dst::set_value(cur.d, name.data(), ty, data.data(), len) != status::success)
+								ok = false;
+						}
+						for(DWORD pos = 0; pos < keys; ++pos) {
+							char kname[key_name_size];
+							DWORD klen = key_name_size;
+							_pair child;
+							if(Src::enum_key(cur.s, pos, kname, &klen) != status::success || Src::open(cur.s, kname, false, &child.s) != status::success) {
+								ok = false;
+								continue;
+							}
+							if(Dst::create(cur.d, kname, true, &child.d, nullptr) != status::success) {
+								Src::close(child.s);
+								ok = false;
+								continue;
+							}
+							queue.push_back(child);
+						}
+					}
+					if(!root)
+						release(cur);
+					root = false;
+					if(queue.empty())
+						break;
+					cur = queue.front();
+					queue.pop_front();
+				}
+			}
+			catch(...) {
+				if(!root)
+					release(cur);
+				for(const _pair& p : queue)
+					release(p);
+				throw;
+			}
+			return ok;
+		}
+
+	}
+
+	// copies the values and subkeys of 'src' into 'dst', merged with what 'dst' already has (same name values are overwritten),
+	// between any two backends, returns false if something couldn't be read or written. 'dst' can't be inside 'src'
+	template<class Src, class Dst>
+	bool copy_tree(const basic_regedit<Src>& src, const basic_regedit<Dst>& dst) {
+		if(!src.is_open() || !dst.is_open())
+			return false;
+		bool ok = __regedit_details::copy_tree<Src, Dst>(src.native_handle(), dst.native_handle());
+		dst.refresh();
+		return ok;
+	}
+
+	// copy_tree() into the subkey 'key' of 'parent' (created if it doesn't exists), returns the copy
+	template<class Src, class Dst>
+	basic_regedit<Dst> clone(const basic_regedit<Src>& src, const basic_regedit<Dst>& parent, const std::string& key) {
+		basic_regedit<Dst> dst = parent[key];
+		if(!copy_tree(src, dst))
+			throw std::logic_error("neo::clone(): the subtree couldn't be fully copied");
+		return dst;
+	}
+
+	#ifdef _WIN32
+	using regedit = basic_regedit<regedit_backend::_default<regedit_backend::win32>>;
+	#else
+	using regedit = basic_regedit<regedit_backend::_default<regedit_backend::memory>>;
+	#endif
+	using memory_regedit = basic_regedit<regedit_backend::_default<regedit_backend::memory>>;
 
 
 }
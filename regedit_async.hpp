@@ -0,0 +1,463 @@
+#pragma once
+
+#ifndef __NEO_REGEDIT_ASYNC_HPP__
+#define __NEO_REGEDIT_ASYNC_HPP__
+
+
+/*
+	Header name: regedit_async.hpp
+	Author: neo3587
+
+	Notes:
+		- neo::async_regedit runs the registry calls (open, create, read, write, delete tree) on the workers of a neo::async_executor,
+			keys are given by their path relative to the root key and opened on the worker, works with any backend
+		- Every operation returns a neo::async_op : get() / wait() as a future, then() for a callback (called from the worker that
+			completes it), and co_await when compiled as C++20 with coroutines (resumed on that worker too)
+		- The executor has a fixed number of workers and a bounded queue, posting into a full queue blocks the caller until there's room
+			(the workers themselves never block on it)
+		- Concurrent reads of the same value (same key, name and type) share a single call and result
+		- The writes to one key (write, erase_value, insert, erase, run) are done in submission order, one at a time, the reads submitted
+			after them see their result. Keys are told apart by their path, a write to "a\b" isn't ordered against erase("a")
+		- Reads of missing keys or values fail with std::out_of_range, writes into a key that can't be created with std::logic_error
+*/
+
+
+
+#include "regedit.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <thread>
+
+#if defined(__has_include)
+	#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+		#include <coroutine>
+		#define REGEDIT_COROUTINES
+	#endif
+#endif
+
+
+
+namespace neo {
+
+	class async_executor {
+
+		private:
+
+			std::mutex _mtx;
+			std::condition_variable _work, _room;
+			std::deque<std::function<void()>> _tasks;
+			size_t _capacity;
+			bool _stop = false;
+			std::vector<std::thread> _pool;
+
+			// the executor whose worker runs on this thread, if any
+			static async_executor*& _current() {
+				static thread_local async_executor* ex = nullptr;
+				return ex;
+			}
+
+			void _run() {
+				_current() = this;
+				for(;;) {
+					std::function<void()> task;
+					{
+						std::unique_lock<std::mutex> lock(_mtx);
+						_work.wait(lock, [this] { return _stop || !_tasks.empty(); });
+						if(_tasks.empty())
+							return;
+						task = std::move(_tasks.front());
+						_tasks.pop_front();
+					}
+					_room.notify_one();
+					task();
+				}
+			}
+
+		public:
+
+			// 'threads' workers (0 : one per hardware thread), up to 'capacity' tasks waiting
+			explicit async_executor(size_t threads = 0, size_t capacity = 1024) : _capacity((std::max)(capacity, static_cast<size_t>(1))) {
+				threads = threads != 0 ? threads : (std::max)(1u, std::thread::hardware_concurrency());
+				for(size_t i = 0; i < threads; ++i)
+					_pool.emplace_back(&async_executor::_run, this);
+			}
+			async_executor(const async_executor&) = delete;
+			async_executor& operator=(const async_executor&) = delete;
+
+			// the pending tasks are run before the workers end
+			~async_executor() {
+				{
+					std::lock_guard<std::mutex> lock(_mtx);
+					_stop = true;
+				}
+				_work.notify_all();
+				for(std::thread& th : _pool)
+					th.join();
+			}
+
+			void post(std::function<void()> task) {
+				{
+					std::unique_lock<std::mutex> lock(_mtx);
+					if(_current() != this)
+						_room.wait(lock, [this] { return _tasks.size() < _capacity; });
+					_tasks.push_back(std::move(task));
+				}
+				_work.notify_one();
+			}
+
+			size_t threads() const {
+				return _pool.size();
+			}
+
+	};
+
+	namespace __regedit_details {
+
+		struct _async_base {
+			std::mutex mtx;
+			std::condition_variable cv;
+			bool done = false;
+			std::exception_ptr error;
+			std::vector<std::function<void()>> next;
+
+			void wait() {
+				std::unique_lock<std::mutex> lock(mtx);
+				cv.wait(lock, [this] { return done; });
+			}
+			// false if it's already done, 'fn' isn't kept then
+			bool then(std::function<void()>&& fn) {
+				std::lock_guard<std::mutex> lock(mtx);
+				if(done)
+					return false;
+				next.push_back(std::move(fn));
+				return true;
+			}
+			void finish() {
+				std::vector<std::function<void()>> fns;
+				{
+					std::lock_guard<std::mutex> lock(mtx);
+					done = true;
+					fns.swap(next);
+				}
+				cv.notify_all();
+				for(std::function<void()>& fn : fns)
+					fn();
+			}
+		};
+
+		template<class T>
+		struct _async_state : _async_base {
+			T value{};
+
+			template<class Fn>
+			void set(Fn&& fn) {
+				try {
+					value = fn();
+				}
+				catch(...) {
+					error = std::current_exception();
+				}
+			}
+		};
+
+		// case folded key path, the strand and read coalescing identifier of a key
+		inline std::string _async_key(const std::string& path) {
+			std::string out(path.size(), '\0');
+			for(size_t i = 0; i < path.size(); ++i)
+				out[i] = static_cast<char>(names::_fold(static_cast<unsigned char>(path[i])));
+			while(!out.empty() && out.back() == '\\')
+				out.pop_back();
+			return out;
+		}
+
+		template<type Ty>
+		void _async_bytes(const DWORD& val, std::vector<BYTE>& out) {
+			out.assign(reinterpret_cast<const BYTE*>(&val), reinterpret_cast<const BYTE*>(&val) + sizeof(DWORD));
+		}
+		template<type Ty>
+		void _async_bytes(const DWORD64& val, std::vector<BYTE>& out) {
+			out.assign(reinterpret_cast<const BYTE*>(&val), reinterpret_cast<const BYTE*>(&val) + sizeof(DWORD64));
+		}
+		template<type Ty>
+		void _async_bytes(const std::string& val, std::vector<BYTE>& out) {
+			out.assign(val.c_str(), val.c_str() + val.size() + 1);
+		}
+		template<type Ty>
+		void _async_bytes(const std::vector<std::string>& val, std::vector<BYTE>& out) {
+			out.clear();
+			for(const std::string& s : val)
+				out.insert(out.end(), s.c_str(), s.c_str() + s.size() + 1);
+			out.push_back('\0');
+		}
+		template<type Ty>
+		void _async_bytes(const std::vector<BYTE>& val, std::vector<BYTE>& out) {
+			out = val;
+		}
+
+	}
+
+	template<class T>
+	class async_op {
+
+		private:
+
+			template<class Backend> friend class async_regedit;
+
+			std::shared_ptr<__regedit_details::_async_state<T>> _state;
+
+			async_op(const std::shared_ptr<__regedit_details::_async_state<T>>& state) : _state(state) {}
+
+		public:
+
+			async_op() {}
+
+			bool valid() const {
+				return static_cast<bool>(_state);
+			}
+			bool ready() const {
+				std::lock_guard<std::mutex> lock(_state->mtx);
+				return _state->done;
+			}
+			void wait() const {
+				_state->wait();
+			}
+			template<class Rep, class Period>
+			bool wait_for(const std::chrono::duration<Rep, Period>& time) const {
+				std::unique_lock<std::mutex> lock(_state->mtx);
+				return _state->cv.wait_for(lock, time, [this] { return _state->done; });
+			}
+			// waits for the result, rethrows the error of the operation if it failed
+			const T& get() const {
+				_state->wait();
+				if(_state->error)
+					std::rethrow_exception(_state->error);
+				return _state->value;
+			}
+
+			// fn(std::exception_ptr error, const T& result), right away if it's already done
+			template<class Fn>
+			void then(Fn fn) const {
+				std::shared_ptr<__regedit_details::_async_state<T>> state = _state;
+				std::function<void()> call = [state, fn]() mutable {
+					fn(state->error, state->value);
+				};
+				if(!_state->then(std::move(call)))
+					fn(_state->error, _state->value);
+			}
+
+			#if defined(REGEDIT_COROUTINES)
+			bool await_ready() const {
+				return ready();
+			}
+			bool await_suspend(std::coroutine_handle<> h) const {
+				return _state->then([h] { h.resume(); });
+			}
+			T await_resume() const {
+				return get();
+			}
+			#endif
+
+	};
+
+	template<class Backend>
+	class async_regedit {
+
+		private:
+
+			using DWORD   = __regedit_details::DWORD;
+			using BYTE    = __regedit_details::BYTE;
+			using type    = __regedit_details::type;
+			using regedit = basic_regedit<Backend>;
+
+			struct _strand {
+				std::deque<std::function<void()>> tasks;
+			};
+			struct _shared {
+				regedit root;
+				async_executor& ex;
+				std::mutex mtx;
+				std::map<std::string, _strand> strands;                               // keys with ordered tasks pending or running
+				std::map<std::string, std::shared_ptr<__regedit_details::_async_base>> reads; // "key\nname\ntype" -> read in flight
+
+				_shared(const regedit& r, async_executor& e) : root(r), ex(e) {}
+			};
+
+			std::shared_ptr<_shared> _s;
+
+			// runs the front task of the strand, then posts the next one, if any
+			static void _drain(const std::shared_ptr<_shared>& s, const std::string& key) {
+				std::function<void()> task;
+				{
+					std::lock_guard<std::mutex> lock(s->mtx);
+					task = std::move(s->strands[key].tasks.front());
+				}
+				task();
+				bool more;
+				{
+					std::lock_guard<std::mutex> lock(s->mtx);
+					typename std::map<std::string, _strand>::iterator it = s->strands.find(key);
+					it->second.tasks.pop_front();
+					more = !it->second.tasks.empty();
+					if(!more)
+						s->strands.erase(it);
+				}
+				if(more)
+					s->ex.post([s, key] { _drain(s, key); });
+			}
+
+			// appends 'task' to the strand of 'key', 's->mtx' locked, true if the strand has to be started
+			static bool _enqueue(_shared& s, const std::string& key, std::function<void()>&& task) {
+				std::deque<std::function<void()>>& tasks = s.strands[key].tasks;
+				tasks.push_back(std::move(task));
+				return tasks.size() == 1;
+			}
+
+			// an ordered operation over 'path', the reads in flight on that key can't be joined anymore
+			template<class T, class Fn>
+			async_op<T> _ordered(const std::string& path, Fn fn) {
+				std::shared_ptr<__regedit_details::_async_state<T>> state = std::make_shared<__regedit_details::_async_state<T>>();
+				std::shared_ptr<_shared> s = _s;
+				std::string key = __regedit_details::_async_key(path);
+				bool start;
+				{
+					std::lock_guard<std::mutex> lock(s->mtx);
+					std::string prefix = key + '\n';
+					for(typename std::map<std::string, std::shared_ptr<__regedit_details::_async_base>>::iterator it = s->reads.lower_bound(prefix);
+						it != s->reads.end() && it->first.compare(0, prefix.size(), prefix) == 0; )
+						it = s->reads.erase(it);
+					start = _enqueue(*s, key, [s, state, path, fn]() mutable {
+						state->set([&] { return fn(s->root, path); });
+						state->finish();
+					});
+				}
+				if(start)
+					s->ex.post([s, key] { _drain(s, key); });
+				return async_op<T>(state);
+			}
+
+			static regedit _create(regedit& root, const std::string& path) {
+				return path.empty() ? root : root[path];
+			}
+
+		public:
+
+			async_regedit() {}
+			// 'root' is shared with the caller, writes need it opened with write permission
+			async_regedit(const regedit& root, async_executor& ex) : _s(std::make_shared<_shared>(root, ex)) {}
+
+			// reads the value 'name' of the key 'path' (relative to the root) as 'Ty', joins the same read if it's already in flight
+			template<type Ty>
+			async_op<__regedit_details::read_overload::_into_t<Ty>> read(const std::string& path, const std::string& name) {
+				using T = __regedit_details::read_overload::_into_t<Ty>;
+				std::shared_ptr<_shared> s = _s;
+				std::string key = __regedit_details::_async_key(path);
+				std::string id = key + '\n' + __regedit_details::_async_key(name) + '\n' + std::to_string(static_cast<DWORD>(Ty));
+				std::shared_ptr<__regedit_details::_async_state<T>> state;
+				std::function<void()> direct;
+				{
+					std::lock_guard<std::mutex> lock(s->mtx);
+					typename std::map<std::string, std::shared_ptr<__regedit_details::_async_base>>::iterator it = s->reads.find(id);
+					if(it != s->reads.end())
+						return async_op<T>(std::static_pointer_cast<__regedit_details::_async_state<T>>(it->second));
+					state = std::make_shared<__regedit_details::_async_state<T>>();
+					s->reads.emplace(id, state);
+					std::function<void()> task = [s, state, path, name, id] {
+						state->set([&] {
+							regedit k(s->root.native_handle(), path, false);
+							T out;
+							if(!k.is_open() || !__regedit_details::read_overload::read<Ty, Backend>(k.native_handle(), name.c_str(), out))
+								throw std::out_of_range("neo::async_regedit::read(): value doesn't exists");
+							return out;
+						});
+						{
+							std::lock_guard<std::mutex> lock(s->mtx);
+							typename std::map<std::string, std::shared_ptr<__regedit_details::_async_base>>::iterator it = s->reads.find(id);
+							if(it != s->reads.end() && it->second == state)
+								s->reads.erase(it);
+						}
+						state->finish();
+					};
+					// behind the pending writes of the key, if any
+					if(s->strands.count(key) != 0)
+						_enqueue(*s, key, std::move(task));
+					else
+						direct = std::move(task);
+				}
+				if(direct)
+					s->ex.post(std::move(direct));
+				return async_op<T>(state);
+			}
+
+			// creates the key if needed
+			template<type Ty>
+			async_op<bool> write(const std::string& path, const std::string& name, const __regedit_details::read_overload::_into_t<Ty>& val) {
+				static_assert(Ty == type::sz || Ty == type::expand_sz || Ty == type::multi_sz || Ty == type::binary || Ty == type::dword || Ty == type::dword_big_endian || Ty == type::qword,
+					"neo::async_regedit::write(): only sz, expand_sz, multi_sz, binary, dword, dword_big_endian and qword values");
+				std::vector<BYTE> data;
+				__regedit_details::_async_bytes<Ty>(val, data);
+				return write(path, name, Ty, std::move(data));
+			}
+			async_op<bool> write(const std::string& path, const std::string& name, type ty, std::vector<BYTE> data) {
+				return _ordered<bool>(path, [name, ty, data](regedit& root, const std::string& path) {
+					regedit k = _create(root, path);
+					bool ok = Backend::set_value(k.native_handle(), name.c_str(), static_cast<DWORD>(ty), data.data(), static_cast<DWORD>(data.size())) == __regedit_details::status::success;
+					k.refresh();
+					return ok;
+				});
+			}
+			async_op<bool> erase_value(const std::string& path, const std::string& name) {
+				return _ordered<bool>(path, [name](regedit& root, const std::string& path) {
+					regedit k(root.native_handle(), path);
+					bool ok = k.is_open() && Backend::delete_value(k.native_handle(), name.c_str()) == __regedit_details::status::success;
+					if(path.empty())
+						root.refresh();
+					return ok;
+				});
+			}
+			// same than operator[], the key is created if it doesn't exists
+			async_op<bool> insert(const std::string& path) {
+				return _ordered<bool>(path, [](regedit& root, const std::string& path) {
+					return _create(root, path).is_open();
+				});
+			}
+			// deletes the key and its whole subtree, false if it doesn't exists
+			async_op<bool> erase(const std::string& path) {
+				return _ordered<bool>(path, [](regedit& root, const std::string& path) {
+					bool ok = Backend::delete_tree(root.native_handle(), path.c_str()) == __regedit_details::status::success;
+					root.refresh();
+					return ok;
+				});
+			}
+			// fn(neo::basic_regedit<Backend>& key) on a worker, ordered with the writes of the key (created if needed)
+			template<class Fn>
+			auto run(const std::string& path, Fn fn) -> async_op<typename std::decay<decltype(fn(std::declval<regedit&>()))>::type> {
+				using R = typename std::decay<decltype(fn(std::declval<regedit&>()))>::type;
+				static_assert(!std::is_void<R>::value, "neo::async_regedit::run(): the function has to return a value");
+				return _ordered<R>(path, [fn](regedit& root, const std::string& path) mutable {
+					regedit k = _create(root, path);
+					return fn(k);
+				});
+			}
+
+			const regedit& root() const {
+				return _s->root;
+			}
+			async_executor& executor() const {
+				return _s->ex;
+			}
+
+	};
+
+	template<class Backend>
+	async_regedit<Backend> make_async(const basic_regedit<Backend>& root, async_executor& ex) {
+		return async_regedit<Backend>(root, ex);
+	}
+
+}
+
+
+
+#endif
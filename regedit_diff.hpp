@@ -0,0 +1,472 @@
+#pragma once
+
+#ifndef __NEO_REGEDIT_DIFF_HPP__
+#define __NEO_REGEDIT_DIFF_HPP__
+
+
+/*
+	Header name: regedit_diff.hpp
+	Author: neo3587
+
+	Notes:
+		- neo::diff() compares two trees and gives the keys and values added, removed and changed from 'a' to 'b', works with any pair of
+			backends (live registry, memory trees, offline hives)
+		- The output is already a minimal patch : a removed key is one entry for its whole subtree, an added key is followed by its values
+			and its subkeys. apply_diff() applies it over a tree, write_patch() writes it as a .reg file
+		- neo::tree_hashes keeps a content hash per key (its values and its whole subtree, case insensitive names, the key name itself
+			excluded), built in one pass and persisted with save() / load(). Given the hashes of both trees, diff() skips the subtrees
+			with the same hash without opening them
+		- The hashes are only valid while the tree doesn't change, meant for offline hives, saved snapshots or a baseline machine
+*/
+
+
+
+#include "regedit_reg.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <unordered_map>
+
+
+
+namespace neo {
+
+	struct diff_entry {
+		enum class kind { added_key, removed_key, added_value, removed_value, changed_value };
+		kind what = kind::added_key;
+		std::string path; // of the key, relative to the compared roots, '\' separated, empty for the roots
+		std::string name; // values only, "" for the default value
+		__regedit_details::type ty = __regedit_details::type::none;     // added / changed values
+		std::vector<__regedit_details::BYTE> data;
+		__regedit_details::type old_ty = __regedit_details::type::none; // removed / changed values
+		std::vector<__regedit_details::BYTE> old_data;
+	};
+
+	struct diff_stats {
+		size_t keys = 0;    // compared keys
+		size_t skipped = 0; // subtrees skipped by their hash
+		size_t entries = 0;
+	};
+
+	namespace __regedit_details {
+
+		template<class A, class B, class Fn> class differ;
+
+		inline uint64_t _data_hash(DWORD ty, const BYTE* data, size_t len) {
+			uint64_t acc = names::_mix(names::_k_mul, ty);
+			const char* p = reinterpret_cast<const char*>(data);
+			for(size_t i = 0; i < len; i += 8)
+				acc = names::_mix(acc, names::_load8(p + i, len - i));
+			return names::_finish(acc, ty, len);
+		}
+
+		// folded path of the child 'name' of 'path'
+		inline void _diff_child(std::string& path, const char* name, size_t len) {
+			if(!path.empty())
+				path.push_back('\\');
+			for(size_t i = 0; i < len; ++i)
+				path.push_back(static_cast<char>(names::_fold(static_cast<unsigned char>(name[i]))));
+		}
+
+		// snapshot entries in registry order (case insensitive)
+		template<class Snapshot>
+		std::vector<const snapshot_entry*> _diff_sorted(const Snapshot& snap) {
+			std::vector<const snapshot_entry*> out;
+			out.reserve(snap.size());
+			for(const snapshot_entry& e : snap)
+				out.push_back(&e);
+			std::sort(out.begin(), out.end(), [](const snapshot_entry* x, const snapshot_entry* y) {
+				return names::cmp(x->name, x->length, y->name, y->length) < 0;
+			});
+			return out;
+		}
+
+	}
+
+	class tree_hashes {
+
+		private:
+
+			template<class A, class B, class Fn> friend class __regedit_details::differ;
+
+			using DWORD = __regedit_details::DWORD;
+			using BYTE  = __regedit_details::BYTE;
+
+			std::unordered_map<std::string, uint64_t> _hashes; // folded path -> subtree hash
+
+			static uint32_t _magic() {
+				return 0x48545252; // "RRTH"
+			}
+
+			bool _at(const std::string& folded, uint64_t& out) const {
+				std::unordered_map<std::string, uint64_t>::const_iterator it = _hashes.find(folded);
+				if(it == _hashes.end())
+					return false;
+				out = it->second;
+				return true;
+			}
+
+			template<class Backend>
+			uint64_t _build(const basic_regedit<Backend>& key, std::string& path, __regedit_details::read_overload::_buffer& buff) {
+				namespace nm = __regedit_details::names;
+				typename basic_regedit<Backend>::values::value_snapshot vals = key.values.snapshot();
+				uint64_t vh = 0, kh = 0;
+				for(const __regedit_details::snapshot_entry& e : vals) {
+					DWORD ty = 0, len = 0;
+					if(__regedit_details::read_overload::_query<Backend>(key.native_handle(), e.name, &ty, buff, &len) == __regedit_details::status::success)
+						vh += nm::_mix(nm::hash(e.name, e.length), __regedit_details::_data_hash(ty, buff.data(), len)); // a sum, the enumeration order doesn't matter
+				}
+				typename basic_regedit<Backend>::key_snapshot keys = key.snapshot();
+				size_t base = path.size();
+				for(const __regedit_details::snapshot_entry& e : keys) {
+					basic_regedit<Backend> sub = keys.open(e);
+					if(!sub.is_open())
+						continue;
+					__regedit_details::_diff_child(path, e.name, e.length);
+					kh += nm::_mix(nm::hash(e.name, e.length) ^ nm::_k_mul, _build(sub, path, buff));
+					path.resize(base);
+				}
+				uint64_t h = nm::_finish(vh, kh, vals.size() * 31 + keys.size());
+				_hashes[path] = h;
+				return h;
+			}
+
+		public:
+
+			tree_hashes() {}
+
+			// hashes 'root' and every key below it, returns the hash of the root
+			template<class Backend>
+			uint64_t build(const basic_regedit<Backend>& root) {
+				_hashes.clear();
+				if(!root.is_open())
+					return 0;
+				std::string path;
+				__regedit_details::read_overload::_buffer buff;
+				return _build(root, path, buff);
+			}
+
+			// hash of the subtree at 'path' (relative to the root the hashes were built from)
+			bool find(const std::string& path, uint64_t& out) const {
+				std::string folded;
+				__regedit_details::_diff_child(folded, path.data(), path.size());
+				while(!folded.empty() && folded.back() == '\\')
+					folded.pop_back();
+				return _at(folded, out);
+			}
+
+			size_t size() const {
+				return _hashes.size();
+			}
+			bool empty() const {
+				return _hashes.empty();
+			}
+			void clear() {
+				_hashes.clear();
+			}
+
+			// binary file : magic, count, then length / path / hash per key (little endian)
+			bool save(const std::string& file) const {
+				std::FILE* f = std::fopen(file.c_str(), "wb");
+				if(f == nullptr)
+					return false;
+				uint32_t magic = _magic();
+				uint64_t count = _hashes.size();
+				bool ok = std::fwrite(&magic, sizeof(magic), 1, f) == 1 && std::fwrite(&count, sizeof(count), 1, f) == 1;
+				for(std::unordered_map<std::string, uint64_t>::const_iterator it = _hashes.begin(); ok && it != _hashes.end(); ++it) {
+					uint32_t len = static_cast<uint32_t>(it->first.size());
+					ok = std::fwrite(&len, sizeof(len), 1, f) == 1 && std::fwrite(it->first.data(), 1, len, f) == len && std::fwrite(&it->second, sizeof(it->second), 1, f) == 1;
+				}
+				return std::fclose(f) == 0 && ok;
+			}
+			bool load(const std::string& file) {
+				_hashes.clear();
+				std::FILE* f = std::fopen(file.c_str(), "rb");
+				if(f == nullptr)
+					return false;
+				uint32_t magic = 0;
+				uint64_t count = 0;
+				bool ok = std::fread(&magic, sizeof(magic), 1, f) == 1 && magic == _magic() && std::fread(&count, sizeof(count), 1, f) == 1;
+				std::string path;
+				for(uint64_t i = 0; ok && i < count; ++i) {
+					uint32_t len = 0;
+					uint64_t h = 0;
+					ok = std::fread(&len, sizeof(len), 1, f) == 1 && len <= (1u << 20);
+					if(ok) {
+						path.resize(len);
+						ok = (len == 0 || std::fread(&path[0], 1, len, f) == len) && std::fread(&h, sizeof(h), 1, f) == 1;
+					}
+					if(ok)
+						_hashes[path] = h;
+				}
+				std::fclose(f);
+				if(!ok)
+					_hashes.clear();
+				return ok;
+			}
+
+	};
+
+	namespace __regedit_details {
+
+		template<class A, class B, class Fn>
+		class differ {
+
+			private:
+
+				using entry = snapshot_entry;
+
+				Fn& _fn;
+				const tree_hashes* _ha;
+				const tree_hashes* _hb;
+				std::string _path, _folded;
+				read_overload::_buffer _buff;
+				bool _stop = false;
+
+				bool _emit(const diff_entry& e, std::true_type) {
+					_fn(e);
+					return true;
+				}
+				bool _emit(const diff_entry& e, std::false_type) {
+					return static_cast<bool>(_fn(e));
+				}
+				void _emit(diff_entry& e) {
+					++stats.entries;
+					if(!_emit(e, std::is_void<decltype(_fn(std::declval<const diff_entry&>()))>()))
+						_stop = true;
+				}
+
+				template<class Backend>
+				bool _read(const basic_regedit<Backend>& key, const char* name, type& ty, std::vector<BYTE>& out) {
+					DWORD vty = 0, len = 0;
+					if(read_overload::_query<Backend>(key.native_handle(), name, &vty, _buff, &len) != status::success)
+						return false;
+					ty = static_cast<type>(vty);
+					out.assign(_buff.data(), _buff.data() + len);
+					return true;
+				}
+
+				bool _same_hash() const {
+					uint64_t x = 0, y = 0;
+					return _ha != nullptr && _hb != nullptr && _ha->_at(_folded, x) && _hb->_at(_folded, y) && x == y;
+				}
+
+				void _enter(const entry& e, size_t& base, size_t& fbase) {
+					base = _path.size();
+					fbase = _folded.size();
+					if(!_path.empty())
+						_path.push_back('\\');
+					_path.append(e.name, e.length);
+					_diff_child(_folded, e.name, e.length);
+				}
+				void _leave(size_t base, size_t fbase) {
+					_path.resize(base);
+					_folded.resize(fbase);
+				}
+
+				// the whole subtree of 'b' as added
+				void _added(const basic_regedit<B>& b) {
+					diff_entry k;
+					k.what = diff_entry::kind::added_key;
+					k.path = _path;
+					_emit(k);
+					typename basic_regedit<B>::values::value_snapshot vals = b.values.snapshot();
+					for(const entry& e : vals) {
+						if(_stop)
+							return;
+						diff_entry v;
+						v.what = diff_entry::kind::added_value;
+						v.path = _path;
+						v.name.assign(e.name, e.length);
+						if(_read(b, e.name, v.ty, v.data))
+							_emit(v);
+					}
+					typename basic_regedit<B>::key_snapshot keys = b.snapshot();
+					for(const entry& e : keys) {
+						if(_stop)
+							return;
+						basic_regedit<B> sub = keys.open(e);
+						if(!sub.is_open())
+							continue;
+						size_t base, fbase;
+						_enter(e, base, fbase);
+						_added(sub);
+						_leave(base, fbase);
+					}
+				}
+
+				void _values(const basic_regedit<A>& a, const basic_regedit<B>& b) {
+					typename basic_regedit<A>::values::value_snapshot sa = a.values.snapshot(true);
+					typename basic_regedit<B>::values::value_snapshot sb = b.values.snapshot(true);
+					std::vector<const entry*> va = _diff_sorted(sa), vb = _diff_sorted(sb);
+					size_t i = 0, j = 0;
+					while((i < va.size() || j < vb.size()) && !_stop) {
+						int c = i == va.size() ? 1 : j == vb.size() ? -1 : names::cmp(va[i]->name, va[i]->length, vb[j]->name, vb[j]->length);
+						diff_entry v;
+						v.path = _path;
+						if(c < 0) {
+							v.what = diff_entry::kind::removed_value;
+							v.name.assign(va[i]->name, va[i]->length);
+							if(_read(a, va[i]->name, v.old_ty, v.old_data))
+								_emit(v);
+							++i;
+							continue;
+						}
+						if(c > 0) {
+							v.what = diff_entry::kind::added_value;
+							v.name.assign(vb[j]->name, vb[j]->length);
+							if(_read(b, vb[j]->name, v.ty, v.data))
+								_emit(v);
+							++j;
+							continue;
+						}
+						if(_read(a, va[i]->name, v.old_ty, v.old_data) && _read(b, vb[j]->name, v.ty, v.data) && (v.ty != v.old_ty || v.data != v.old_data)) {
+							v.what = diff_entry::kind::changed_value;
+							v.name.assign(vb[j]->name, vb[j]->length);
+							_emit(v);
+						}
+						++i;
+						++j;
+					}
+				}
+
+				void _key(const basic_regedit<A>& a, const basic_regedit<B>& b) {
+					++stats.keys;
+					_values(a, b);
+					typename basic_regedit<A>::key_snapshot sa = a.snapshot();
+					typename basic_regedit<B>::key_snapshot sb = b.snapshot();
+					std::vector<const entry*> ka = _diff_sorted(sa), kb = _diff_sorted(sb);
+					size_t i = 0, j = 0;
+					while((i < ka.size() || j < kb.size()) && !_stop) {
+						int c = i == ka.size() ? 1 : j == kb.size() ? -1 : names::cmp(ka[i]->name, ka[i]->length, kb[j]->name, kb[j]->length);
+						size_t base, fbase;
+						_enter(c <= 0 ? *ka[i] : *kb[j], base, fbase);
+						if(c < 0) {
+							diff_entry k;
+							k.what = diff_entry::kind::removed_key;
+							k.path = _path;
+							_emit(k);
+							++i;
+						}
+						else if(c > 0) {
+							basic_regedit<B> sub = sb.open(*kb[j]);
+							if(sub.is_open())
+								_added(sub);
+							++j;
+						}
+						else {
+							if(_same_hash())
+								++stats.skipped;
+							else {
+								basic_regedit<A> suba = sa.open(*ka[i]);
+								basic_regedit<B> subb = sb.open(*kb[j]);
+								if(suba.is_open() && subb.is_open())
+									_key(suba, subb);
+							}
+							++i;
+							++j;
+						}
+						_leave(base, fbase);
+					}
+				}
+
+			public:
+
+				diff_stats stats;
+
+				differ(Fn& fn, const tree_hashes* ha, const tree_hashes* hb) : _fn(fn), _ha(ha), _hb(hb) {}
+
+				diff_stats run(const basic_regedit<A>& a, const basic_regedit<B>& b) {
+					if(!a.is_open() || !b.is_open())
+						return stats;
+					if(_same_hash())
+						++stats.skipped;
+					else
+						_key(a, b);
+					return stats;
+				}
+
+		};
+
+	}
+
+	// fn(const neo::diff_entry&) for every difference from 'a' to 'b' (returning false ends the diff), 'ha' / 'hb' : hashes built from 'a' / 'b'
+	template<class A, class B, class Fn, typename = decltype(std::declval<Fn&>()(std::declval<const diff_entry&>()))>
+	diff_stats diff(const basic_regedit<A>& a, const basic_regedit<B>& b, Fn fn, const tree_hashes* ha = nullptr, const tree_hashes* hb = nullptr) {
+		__regedit_details::differ<A, B, Fn> d(fn, ha, hb);
+		return d.run(a, b);
+	}
+	template<class A, class B>
+	std::vector<diff_entry> diff(const basic_regedit<A>& a, const basic_regedit<B>& b, const tree_hashes* ha = nullptr, const tree_hashes* hb = nullptr) {
+		std::vector<diff_entry> out;
+		diff(a, b, [&out](const diff_entry& e) {
+			out.push_back(e);
+		}, ha, hb);
+		return out;
+	}
+
+	// turns 'dst' (a copy of 'a') into 'b'
+	template<class Backend>
+	bool apply_diff(const std::vector<diff_entry>& entries, const basic_regedit<Backend>& dst) {
+		namespace status = __regedit_details::status;
+		if(!dst.is_open())
+			return false;
+		typename Backend::handle cur = typename Backend::handle();
+		const std::string* cur_path = nullptr;
+		bool ok = true;
+		for(const diff_entry& e : entries) {
+			if(e.what == diff_entry::kind::removed_key) {
+				long ret = Backend::delete_tree(dst.native_handle(), e.path.c_str());
+				ok = ok && (ret == status::success || ret == status::file_not_found);
+				continue;
+			}
+			if(cur_path == nullptr || *cur_path != e.path) {
+				if(cur != typename Backend::handle())
+					Backend::close(cur);
+				cur = typename Backend::handle();
+				cur_path = &e.path;
+				if(Backend::create(dst.native_handle(), e.path.c_str(), true, &cur, nullptr) != status::success) {
+					cur = typename Backend::handle();
+					ok = false;
+				}
+			}
+			if(cur == typename Backend::handle())
+				continue;
+			if(e.what == diff_entry::kind::added_value || e.what == diff_entry::kind::changed_value)
+				ok = Backend::set_value(cur, e.name.c_str(), static_cast<__regedit_details::DWORD>(e.ty), e.data.data(), static_cast<__regedit_details::DWORD>(e.data.size())) == status::success && ok;
+			else if(e.what == diff_entry::kind::removed_value) {
+				long ret = Backend::delete_value(cur, e.name.c_str());
+				ok = ok && (ret == status::success || ret == status::file_not_found);
+			}
+		}
+		if(cur != typename Backend::handle())
+			Backend::close(cur);
+		dst.refresh();
+		return ok;
+	}
+
+	// the entries as .reg sections under 'root_path' (HKEY_LOCAL_MACHINE\..., the path of 'a' / 'b' when the file gets imported)
+	inline bool write_patch(reg_writer& writer, const std::vector<diff_entry>& entries, const std::string& root_path) {
+		bool ok = true;
+		reg_entry r;
+		for(const diff_entry& e : entries) {
+			r.path = e.path.empty() ? root_path : root_path + '\\' + e.path;
+			r.name = e.name;
+			r.ty = e.ty;
+			r.data = e.data;
+			switch(e.what) {
+				case diff_entry::kind::added_key:     r.what = reg_entry::kind::key;          break;
+				case diff_entry::kind::removed_key:   r.what = reg_entry::kind::delete_key;   break;
+				case diff_entry::kind::added_value:
+				case diff_entry::kind::changed_value: r.what = reg_entry::kind::value;        break;
+				case diff_entry::kind::removed_value: r.what = reg_entry::kind::delete_value; break;
+			}
+			ok = writer.write(r) && ok;
+		}
+		return ok;
+	}
+
+}
+
+
+
+#endif
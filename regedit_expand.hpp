@@ -0,0 +1,268 @@
+#pragma once
+
+#ifndef __NEO_REGEDIT_EXPAND_HPP__
+#define __NEO_REGEDIT_EXPAND_HPP__
+
+
+/*
+	Header name: regedit_expand.hpp
+	Author: neo3587
+
+	Notes:
+		- neo::env_vars is a set of variables for the expand_sz expansion : the process environment, a map of its own, or the sz / expand_sz
+			values of a registry key (a user profile's Environment key, from any backend, offline hives too), optionally falling back on another set
+		- Variable names are case insensitive as on Windows (getenv() is case sensitive elsewhere, so is the process environment there), the
+			%variables% follow the ExpandEnvironmentStrings rules : unknown ones are left untouched
+		- neo::env_expander expands against an env_vars and memoizes the results keyed on the raw string and a generation, bulk dumps
+			expanding the same strings again and again (service ImagePaths, ...) take a single hash lookup per string. set() / erase()
+			through it start a new generation, refresh() too : needed once the process environment or the loaded key change elsewhere
+		- env_expander is thread safe, value::read<type::expand_sz>(out, expander) reads a value through it instead of the process environment
+*/
+
+
+
+#include "regedit.hpp"
+#include <unordered_map>
+
+
+
+namespace neo {
+
+	namespace __regedit_details {
+
+		struct _env_hash {
+			size_t operator()(const std::string& str) const {
+				return static_cast<size_t>(names::hash(str.data(), str.size()));
+			}
+		};
+		struct _env_eq {
+			bool operator()(const std::string& l, const std::string& r) const {
+				return names::eq(l.data(), l.size(), r.data(), r.size());
+			}
+		};
+
+	}
+
+	class env_vars {
+
+		private:
+
+			using _map = std::unordered_map<std::string, std::string, __regedit_details::_env_hash, __regedit_details::_env_eq>;
+
+			_map _vars;
+			bool _process = false;
+			std::shared_ptr<const env_vars> _fallback;
+
+			static bool _lookup_process(const char* name, size_t len, std::string& out) {
+				#ifdef _WIN32
+				std::wstring wname, val(256, L'\0');
+				__regedit_details::utf::to_wide(name, len, wname);
+				SetLastError(ERROR_SUCCESS);
+				DWORD n = GetEnvironmentVariableW(wname.c_str(), &val[0], static_cast<DWORD>(val.size()));
+				if(n > val.size()) {
+					val.resize(n);
+					n = GetEnvironmentVariableW(wname.c_str(), &val[0], static_cast<DWORD>(val.size()));
+				}
+				if((n == 0 && GetLastError() == ERROR_ENVVAR_NOT_FOUND) || n > val.size())
+					return false;
+				__regedit_details::utf::from_wide(val.c_str(), n, out);
+				return true;
+				#else
+				const char* val = getenv(std::string(name, len).c_str());
+				if(val == nullptr)
+					return false;
+				out.append(val);
+				return true;
+				#endif
+			}
+
+		public:
+
+			// Constructors:
+
+			env_vars() {}
+			env_vars(std::initializer_list<std::pair<const std::string, std::string>> il) : _vars(il.begin(), il.end()) {}
+			template<class InputIterator>
+			env_vars(InputIterator left, InputIterator right) : _vars(left, right) {}
+
+			// the process environment, looked up on each expansion (the own variables set() on it take precedence)
+			static env_vars process() {
+				env_vars vars;
+				vars._process = true;
+				return vars;
+			}
+			// the sz and expand_sz values of 'key', the expand_sz ones expanded against the sz ones and 'fallback' (kept as the fallback of the set)
+			template<class Backend>
+			static env_vars from_key(const basic_regedit<Backend>& key, const env_vars& fallback = process()) {
+				using __regedit_details::type;
+				env_vars vars;
+				vars._fallback = std::make_shared<const env_vars>(fallback);
+				auto table = key.values.query_all();
+				for(const __regedit_details::value_info& e : table)
+					if(e.ty == type::sz)
+						vars._vars[e.name] = e.str().str();
+				for(const __regedit_details::value_info& e : table) {
+					if(e.ty != type::expand_sz)
+						continue;
+					std::string exp;
+					__regedit_details::str_view raw = e.str();
+					__regedit_details::_expand_vars(raw.data(), raw.size(), exp, [&vars](const char* name, size_t len, std::string& out) {
+						return vars.lookup(name, len, out);
+					});
+					vars._vars[e.name] = std::move(exp);
+				}
+				return vars;
+			}
+
+			// Modifiers:
+
+			void set(const std::string& name, const std::string& val) {
+				_vars[name] = val;
+			}
+			bool erase(const std::string& name) {
+				return _vars.erase(name) != 0;
+			}
+			// the variables not found on this set are looked up on 'vars'
+			void fallback(const env_vars& vars) {
+				_fallback = std::make_shared<const env_vars>(vars);
+			}
+
+			// Lookup:
+
+			// appends the variable to 'out' if it's defined
+			bool lookup(const char* name, size_t len, std::string& out) const {
+				if(!_vars.empty()) {
+					_map::const_iterator it = _vars.find(std::string(name, len));
+					if(it != _vars.end()) {
+						out.append(it->second);
+						return true;
+					}
+				}
+				if(_process && _lookup_process(name, len, out))
+					return true;
+				return _fallback != nullptr && _fallback->lookup(name, len, out);
+			}
+			bool contains(const std::string& name) const {
+				std::string tmp;
+				return lookup(name.data(), name.size(), tmp);
+			}
+			// own variables, the process environment and the fallback excluded
+			size_t size() const {
+				return _vars.size();
+			}
+
+	};
+
+	class env_expander {
+
+		private:
+
+			struct _memo {
+				unsigned long gen;
+				std::string out;
+			};
+
+			env_vars _vars;
+			mutable std::mutex _mtx;
+			std::unordered_map<std::string, _memo> _cache;
+			std::string _key; // scratch of expand(str, len, out)
+			unsigned long _gen = 0;
+			size_t _max_cached;
+			unsigned long long _hits = 0, _misses = 0;
+
+			// 'out' gets the expansion of 'raw', under the lock
+			void _expand(const std::string& raw, std::string& out) {
+				std::unordered_map<std::string, _memo>::iterator it = _cache.find(raw);
+				if(it != _cache.end() && it->second.gen == _gen) {
+					++_hits;
+					out.assign(it->second.out);
+					return;
+				}
+				++_misses;
+				std::string exp;
+				__regedit_details::_expand_vars(raw.data(), raw.size(), exp, [this](const char* name, size_t len, std::string& dst) {
+					return _vars.lookup(name, len, dst);
+				});
+				if(it != _cache.end())
+					it->second = _memo{ _gen, exp };
+				else {
+					if(_cache.size() >= _max_cached) // the strings of an older generation go with the rest
+						_cache.clear();
+					_cache.emplace(raw, _memo{ _gen, exp });
+				}
+				out.swap(exp);
+			}
+
+		public:
+
+			// Constructors:
+
+			explicit env_expander(env_vars vars = env_vars::process(), size_t max_cached = 65536) : _vars(std::move(vars)), _max_cached((std::max)(max_cached, static_cast<size_t>(1))) {}
+			env_expander(const env_expander&) = delete;
+			env_expander& operator=(const env_expander&) = delete;
+
+			// Expansion:
+
+			// 'str' is replaced by its expansion, no lock is taken when it has no '%'
+			void expand(std::string& str) {
+				if(__regedit_details::_find_char(str.data(), str.size(), '%') == nullptr)
+					return;
+				std::lock_guard<std::mutex> lock(_mtx);
+				_expand(str, str);
+			}
+			// str[0, len) expanded into 'out' (e.g. the data of a snapshot or query_all() entry)
+			void expand(const char* str, size_t len, std::string& out) {
+				if(__regedit_details::_find_char(str, len, '%') == nullptr) {
+					out.assign(str, len);
+					return;
+				}
+				std::lock_guard<std::mutex> lock(_mtx);
+				_key.assign(str, len);
+				_expand(_key, out);
+			}
+
+			// Modifiers:
+
+			void set(const std::string& name, const std::string& val) {
+				std::lock_guard<std::mutex> lock(_mtx);
+				_vars.set(name, val);
+				++_gen;
+			}
+			bool erase(const std::string& name) {
+				std::lock_guard<std::mutex> lock(_mtx);
+				++_gen;
+				return _vars.erase(name);
+			}
+			// the memoized expansions are taken as outdated, after the variables changed elsewhere (process environment, ...)
+			void refresh() {
+				std::lock_guard<std::mutex> lock(_mtx);
+				++_gen;
+			}
+
+			// Observers:
+
+			unsigned long generation() const {
+				std::lock_guard<std::mutex> lock(_mtx);
+				return _gen;
+			}
+			size_t cached() const {
+				std::lock_guard<std::mutex> lock(_mtx);
+				return _cache.size();
+			}
+			// expansions given from the cache and computed
+			unsigned long long hits() const {
+				std::lock_guard<std::mutex> lock(_mtx);
+				return _hits;
+			}
+			unsigned long long misses() const {
+				std::lock_guard<std::mutex> lock(_mtx);
+				return _misses;
+			}
+
+	};
+
+}
+
+
+
+#endif
@@ -0,0 +1,1555 @@
+
+#pragma once
+
+#ifndef __NEO_REGEDIT_HIVE_HPP__
+#define __NEO_REGEDIT_HIVE_HPP__
+
+
+/*
+	Header name: regedit_hive.hpp
+	Author: neo3587
+
+	Notes:
+		- Offline registry hive files (regf format : NTUSER.DAT, SOFTWARE, SYSTEM, ...) for neo::basic_regedit, works on any platform
+		- The hive is memory mapped and the nk / vk / lf / lh / li / ri / db cells are walked in place, nothing is loaded nor copied
+			besides what is returned to the caller, regedit_backend::hive::key_name() / value_name() / value_view() give direct views into the mapping
+		- The value lists of a key aren't sorted : keys with many values get a hashed name index on their first lookup, kept by the file
+		- Read only, every write operation returns status::access_denied (the container throws the same way than with a read-only key)
+		- Dirty hives are read as they are, the transaction logs (.LOG1 / .LOG2) are not replayed
+		- Key names, value names and sz / expand_sz / multi_sz data are returned as UTF-8, link and the remaining types are returned raw
+		- neo::hive_writer / write_hive() serialize any neo::basic_regedit tree as a hive, compact_hive() rewrites a hive with its cells packed in DFS order
+		- Format reference : https://github.com/msuhanov/regf/blob/master/Windows%20registry%20file%20format%20specification.md
+*/
+
+
+
+#include "regedit.hpp"
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <unordered_map>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+
+
+namespace neo {
+
+	namespace __regedit_details {
+
+		namespace regf {
+
+			constexpr uint32_t base_block_size = 0x1000;
+			constexpr uint32_t no_cell         = 0xFFFFFFFF;
+			constexpr uint32_t big_data_size   = 16344; // max data bytes per cell, bigger values are split through a db cell (hive version 1.4+)
+
+			// nk (key node) layout
+			constexpr size_t nk_flags         = 0x02;
+			constexpr size_t nk_last_write    = 0x04;
+			constexpr size_t nk_parent        = 0x10;
+			constexpr size_t nk_subkeys       = 0x14;
+			constexpr size_t nk_subkeys_list  = 0x1C;
+			constexpr size_t nk_values        = 0x24;
+			constexpr size_t nk_values_list   = 0x28;
+			constexpr size_t nk_security      = 0x2C;
+			constexpr size_t nk_class         = 0x30;
+			constexpr size_t nk_max_subkey    = 0x34;
+			constexpr size_t nk_max_class     = 0x38;
+			constexpr size_t nk_max_value     = 0x3C;
+			constexpr size_t nk_max_data      = 0x40;
+			constexpr size_t nk_name_len      = 0x48;
+			constexpr size_t nk_class_len     = 0x4A;
+			constexpr size_t nk_name          = 0x4C;
+			constexpr uint16_t nk_root_flag   = 0x0004;
+			constexpr uint16_t nk_comp_name   = 0x0020;
+
+			// vk (key value) layout
+			constexpr size_t vk_name_len      = 0x02;
+			constexpr size_t vk_data_size     = 0x04;
+			constexpr size_t vk_data          = 0x08;
+			constexpr size_t vk_type          = 0x0C;
+			constexpr size_t vk_flags         = 0x10;
+			constexpr size_t vk_name          = 0x14;
+			constexpr uint16_t vk_comp_name   = 0x0001;
+			constexpr uint32_t vk_data_inline = 0x80000000;
+
+			inline uint16_t _le16(const BYTE* p) {
+				return static_cast<uint16_t>(p[0] | (p[1] << 8));
+			}
+			inline uint32_t _le32(const BYTE* p) {
+				return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+			}
+			inline bool _sig(const BYTE* p, const char* sig) {
+				return p[0] == static_cast<BYTE>(sig[0]) && p[1] == static_cast<BYTE>(sig[1]);
+			}
+
+			// Latin-1 (compressed names) to UTF-8, out = nullptr just counts
+			inline size_t _latin1_to_utf8(const BYTE* src, size_t bytes, char* out) {
+				size_t len = 0;
+				for(size_t i = 0; i < bytes; ++i) {
+					if(src[i] < 0x80) {
+						if(out != nullptr)
+							out[len] = static_cast<char>(src[i]);
+						++len;
+					}
+					else {
+						if(out != nullptr) {
+							out[len] = static_cast<char>(0xC0 | (src[i] >> 6));
+							out[len + 1] = static_cast<char>(0x80 | (src[i] & 0x3F));
+						}
+						len += 2;
+					}
+				}
+				return len;
+			}
+
+			inline void _put16(BYTE* p, uint16_t v) {
+				p[0] = static_cast<BYTE>(v);
+				p[1] = static_cast<BYTE>(v >> 8);
+			}
+			inline void _put32(BYTE* p, uint32_t v) {
+				for(int i = 0; i < 4; ++i)
+					p[i] = static_cast<BYTE>(v >> (i * 8));
+			}
+			inline void _put64(BYTE* p, uint64_t v) {
+				for(int i = 0; i < 8; ++i)
+					p[i] = static_cast<BYTE>(v >> (i * 8));
+			}
+
+			// key or value name as stored on the hive, Latin-1 if comp, UTF-16LE otherwise
+			struct _name {
+				std::vector<BYTE> bytes;
+				bool comp = true;
+
+				size_t units() const {
+					return comp ? bytes.size() : bytes.size() / 2;
+				}
+				uint16_t unit(size_t pos) const {
+					return comp ? bytes[pos] : _le16(bytes.data() + pos * 2);
+				}
+				size_t utf16_bytes() const {
+					return units() * 2;
+				}
+
+				void assign_utf8(const char* str, size_t len) {
+					const BYTE* src = reinterpret_cast<const BYTE*>(str);
+					comp = true;
+					for(size_t pos = 0; pos < len && comp; )
+						comp = _utf8_next(src, len, pos) < 0x100;
+					bytes.clear();
+					if(!comp)
+						_utf8_to_utf16(src, len, bytes);
+					else
+						for(size_t pos = 0; pos < len; )
+							bytes.push_back(static_cast<BYTE>(_utf8_next(src, len, pos)));
+				}
+				void assign_raw(const BYTE* data, size_t size, bool compressed) {
+					bytes.assign(data, data + size);
+					comp = compressed;
+				}
+			};
+
+			/*
+				Registry upcase (RtlUpcaseUnicodeChar) for the lh hashes, the subkey list order and the name lookups : Unicode simple uppercase
+				of the BMP scripts with case, without the mappings into ASCII (dotless i, long s, ...) that the registry doesn't do either
+			*/
+			struct _case_range {
+				uint16_t first, last;
+				int16_t delta;
+				uint8_t stride; // 2 : every other code unit starting at 'first'
+			};
+			struct _upcase_table {
+				uint16_t map[0x10000];
+				_upcase_table() {
+					static const _case_range ranges[] = {
+						{ 0x0061, 0x007A,    -32, 1 }, { 0x00E0, 0x00F6,    -32, 1 }, { 0x00F8, 0x00FE,    -32, 1 }, { 0x00FF, 0x00FF,    121, 1 },
+						{ 0x0101, 0x012F,     -1, 2 }, { 0x0133, 0x0137,     -1, 2 }, { 0x013A, 0x0148,     -1, 2 }, { 0x014B, 0x0177,     -1, 2 },
+						{ 0x017A, 0x017E,     -1, 2 }, { 0x0180, 0x0180,    195, 1 }, { 0x0183, 0x0185,     -1, 2 }, { 0x0188, 0x0188,     -1, 1 },
+						{ 0x018C, 0x018C,     -1, 1 }, { 0x0192, 0x0192,     -1, 1 }, { 0x0195, 0x0195,     97, 1 }, { 0x0199, 0x0199,     -1, 1 },
+						{ 0x019A, 0x019A,    163, 1 }, { 0x019E, 0x019E,    130, 1 }, { 0x01A1, 0x01A5,     -1, 2 }, { 0x01A8, 0x01A8,     -1, 1 },
+						{ 0x01AD, 0x01AD,     -1, 1 }, { 0x01B0, 0x01B0,     -1, 1 }, { 0x01B4, 0x01B6,     -1, 2 }, { 0x01B9, 0x01B9,     -1, 1 },
+						{ 0x01BD, 0x01BD,     -1, 1 }, { 0x01BF, 0x01BF,     56, 1 }, { 0x01C5, 0x01C5,     -1, 1 }, { 0x01C6, 0x01C6,     -2, 1 },
+						{ 0x01C8, 0x01C8,     -1, 1 }, { 0x01C9, 0x01C9,     -2, 1 }, { 0x01CB, 0x01CB,     -1, 1 }, { 0x01CC, 0x01CC,     -2, 1 },
+						{ 0x01CE, 0x01DC,     -1, 2 }, { 0x01DD, 0x01DD,    -79, 1 }, { 0x01DF, 0x01EF,     -1, 2 }, { 0x01F2, 0x01F2,     -1, 1 },
+						{ 0x01F3, 0x01F3,     -2, 1 }, { 0x01F5, 0x01F5,     -1, 1 }, { 0x01F9, 0x021F,     -1, 2 }, { 0x0223, 0x0233,     -1, 2 },
+						{ 0x023C, 0x023C,     -1, 1 }, { 0x0242, 0x0242,     -1, 1 }, { 0x0247, 0x024F,     -1, 2 }, { 0x0253, 0x0253,   -210, 1 },
+						{ 0x0254, 0x0254,   -206, 1 }, { 0x0256, 0x0257,   -205, 1 }, { 0x0259, 0x0259,   -202, 1 }, { 0x025B, 0x025B,   -203, 1 },
+						{ 0x0260, 0x0260,   -205, 1 }, { 0x0263, 0x0263,   -207, 1 }, { 0x0268, 0x0268,   -209, 1 }, { 0x0269, 0x0269,   -211, 1 },
+						{ 0x026F, 0x026F,   -211, 1 }, { 0x0272, 0x0272,   -213, 1 }, { 0x0275, 0x0275,   -214, 1 }, { 0x0280, 0x0280,   -218, 1 },
+						{ 0x0283, 0x0283,   -218, 1 }, { 0x0288, 0x0288,   -218, 1 }, { 0x0289, 0x0289,    -69, 1 }, { 0x028A, 0x028B,   -217, 1 },
+						{ 0x028C, 0x028C,    -71, 1 }, { 0x0292, 0x0292,   -219, 1 }, { 0x03AC, 0x03AC,    -38, 1 }, { 0x03AD, 0x03AF,    -37, 1 },
+						{ 0x03B1, 0x03C1,    -32, 1 }, { 0x03C2, 0x03C2,    -31, 1 }, { 0x03C3, 0x03CB,    -32, 1 }, { 0x03CC, 0x03CC,    -64, 1 },
+						{ 0x03CD, 0x03CE,    -63, 1 }, { 0x03D9, 0x03EF,     -1, 2 }, { 0x03F2, 0x03F2,      7, 1 }, { 0x03F8, 0x03F8,     -1, 1 },
+						{ 0x03FB, 0x03FB,     -1, 1 }, { 0x0430, 0x044F,    -32, 1 }, { 0x0450, 0x045F,    -80, 1 }, { 0x0461, 0x0481,     -1, 2 },
+						{ 0x048B, 0x04BF,     -1, 2 }, { 0x04C2, 0x04CE,     -1, 2 }, { 0x04CF, 0x04CF,    -15, 1 }, { 0x04D1, 0x052F,     -1, 2 },
+						{ 0x0561, 0x0586,    -48, 1 }, { 0x1E01, 0x1E95,     -1, 2 }, { 0x1EA1, 0x1EFF,     -1, 2 }, { 0x1F00, 0x1F07,      8, 1 },
+						{ 0x1F10, 0x1F15,      8, 1 }, { 0x1F20, 0x1F27,      8, 1 }, { 0x1F30, 0x1F37,      8, 1 }, { 0x1F40, 0x1F45,      8, 1 },
+						{ 0x1F51, 0x1F57,      8, 2 }, { 0x1F60, 0x1F67,      8, 1 }, { 0x1F70, 0x1F71,     74, 1 }, { 0x1F72, 0x1F75,     86, 1 },
+						{ 0x1F76, 0x1F77,    100, 1 }, { 0x1F78, 0x1F79,    128, 1 }, { 0x1F7A, 0x1F7B,    112, 1 }, { 0x1F7C, 0x1F7D,    126, 1 },
+						{ 0x1F80, 0x1F87,      8, 1 }, { 0x1F90, 0x1F97,      8, 1 }, { 0x1FA0, 0x1FA7,      8, 1 }, { 0x1FB0, 0x1FB1,      8, 1 },
+						{ 0x1FB3, 0x1FB3,      9, 1 }, { 0x1FC3, 0x1FC3,      9, 1 }, { 0x1FD0, 0x1FD1,      8, 1 }, { 0x1FE0, 0x1FE1,      8, 1 },
+						{ 0x1FE5, 0x1FE5,      7, 1 }, { 0x1FF3, 0x1FF3,      9, 1 }, { 0x214E, 0x214E,    -28, 1 }, { 0x2170, 0x217F,    -16, 1 },
+						{ 0x2184, 0x2184,     -1, 1 }, { 0x24D0, 0x24E9,    -26, 1 }, { 0x2C30, 0x2C5E,    -48, 1 }, { 0x2C61, 0x2C61,     -1, 1 },
+						{ 0x2C65, 0x2C65, -10795, 1 }, { 0x2C66, 0x2C66, -10792, 1 }, { 0x2C68, 0x2C6C,     -1, 2 }, { 0x2C73, 0x2C73,     -1, 1 },
+						{ 0x2C76, 0x2C76,     -1, 1 }, { 0x2C81, 0x2CE3,     -1, 2 }, { 0x2D00, 0x2D25,  -7264, 1 }, { 0xA641, 0xA66D,     -1, 2 },
+						{ 0xA681, 0xA697,     -1, 2 }, { 0xA723, 0xA72F,     -1, 2 }, { 0xA733, 0xA76F,     -1, 2 }, { 0xA77A, 0xA77C,     -1, 2 },
+						{ 0xA77F, 0xA787,     -1, 2 }, { 0xA78C, 0xA78C,     -1, 1 }, { 0xFF41, 0xFF5A,    -32, 1 }
+					};
+					for(uint32_t c = 0; c < 0x10000; ++c)
+						map[c] = static_cast<uint16_t>(c);
+					for(const _case_range& r : ranges)
+						for(uint32_t c = r.first; c <= r.last; c += r.stride)
+							map[c] = static_cast<uint16_t>(static_cast<int32_t>(c) + r.delta);
+				}
+			};
+			inline uint16_t _upcase16(uint16_t c) {
+				if(c < 0x80)
+					return c >= 'a' && c <= 'z' ? static_cast<uint16_t>(c - 0x20) : c;
+				static const _upcase_table table;
+				return table.map[c];
+			}
+			inline uint32_t _lh_hash(const _name& name) {
+				uint32_t hash = 0;
+				for(size_t i = 0; i < name.units(); ++i)
+					hash = hash * 37 + _upcase16(name.unit(i));
+				return hash;
+			}
+			inline bool _lh_less(const _name& n1, const _name& n2) {
+				size_t len = (std::min)(n1.units(), n2.units());
+				for(size_t i = 0; i < len; ++i) {
+					uint16_t c1 = _upcase16(n1.unit(i)), c2 = _upcase16(n2.unit(i));
+					if(c1 != c2)
+						return c1 < c2;
+				}
+				return n1.units() < n2.units();
+			}
+
+		}
+
+	}
+
+	class hive_writer;
+
+	namespace regedit_backend {
+
+		class hive {
+
+			private:
+
+				using DWORD = __regedit_details::DWORD;
+				using BYTE  = __regedit_details::BYTE;
+
+			public:
+
+				class file;
+
+				struct handle {
+					const file* owner = nullptr;
+					uint32_t cell = __regedit_details::regf::no_cell;
+					bool operator==(const handle& other) const {
+						return owner == other.owner && cell == other.cell;
+					}
+					bool operator!=(const handle& other) const {
+						return !(*this == other);
+					}
+				};
+				struct hkey {}; // no predefined roots, use file::root()
+
+				// raw name stored on a nk / vk cell, Latin-1 when !wide, UTF-16LE otherwise (size in bytes)
+				struct name_ref {
+					const BYTE* data = nullptr;
+					size_t size = 0;
+					bool wide = false;
+				};
+
+				class file {
+
+					private:
+
+						const BYTE* _base = nullptr;
+						size_t _size = 0;
+						uint32_t _root = __regedit_details::regf::no_cell;
+						bool _mapped = false;
+						#ifdef _WIN32
+						HANDLE _file = INVALID_HANDLE_VALUE;
+						HANDLE _map = NULL;
+						#endif
+
+						struct _value_index {
+							__regedit_details::name_index idx;
+							bool ascii = true; // every name is ASCII, a miss is final for an ASCII name
+							bool built = false; // false : a name couldn't be read, kept so the build isn't retried on every lookup
+						};
+						mutable std::mutex _mtx;
+						mutable std::unordered_map<uint32_t, std::unique_ptr<_value_index>> _indexes; // nk cell -> index of its values
+
+						bool _load() {
+							using namespace __regedit_details::regf;
+							if(_size < base_block_size + 0x20 || memcmp(_base, "regf", 4) != 0 || memcmp(_base + base_block_size, "hbin", 4) != 0) {
+								close();
+								return false;
+							}
+							_root = _le32(_base + 0x24);
+							const BYTE* nk = cell(_root, nk_name);
+							if(nk == nullptr || !_sig(nk, "nk")) {
+								close();
+								return false;
+							}
+							return true;
+						}
+
+						friend hive;
+
+					public:
+
+						file() {}
+						file(const std::string& path) {
+							open(path);
+						}
+						file(const void* data, size_t size) {
+							open(data, size);
+						}
+						file(const file&) = delete;
+						file& operator=(const file&) = delete;
+
+						~file() {
+							close();
+						}
+
+						// maps a hive file
+						bool open(const std::string& path) {
+							close();
+							#ifdef _WIN32
+							_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+							if(_file == INVALID_HANDLE_VALUE)
+								return false;
+							LARGE_INTEGER size;
+							if(!GetFileSizeEx(_file, &size) || size.QuadPart == 0 || (_map = CreateFileMappingA(_file, NULL, PAGE_READONLY, 0, 0, NULL)) == NULL) {
+								close();
+								return false;
+							}
+							_base = static_cast<const BYTE*>(MapViewOfFile(_map, FILE_MAP_READ, 0, 0, 0));
+							_size = static_cast<size_t>(size.QuadPart);
+							#else
+							int fd = ::open(path.c_str(), O_RDONLY);
+							if(fd < 0)
+								return false;
+							struct stat st;
+							void* ptr = MAP_FAILED;
+							if(fstat(fd, &st) == 0 && st.st_size > 0)
+								ptr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+							::close(fd);
+							_base = ptr != MAP_FAILED ? static_cast<const BYTE*>(ptr) : nullptr;
+							_size = ptr != MAP_FAILED ? static_cast<size_t>(st.st_size) : 0;
+							#endif
+							_mapped = true;
+							if(_base == nullptr) {
+								close();
+								return false;
+							}
+							return _load();
+						}
+						// uses an already loaded hive image, it must outlive the file
+						bool open(const void* data, size_t size) {
+							close();
+							_base = static_cast<const BYTE*>(data);
+							_size = size;
+							return _base != nullptr && _load();
+						}
+
+						void close() {
+							if(_mapped && _base != nullptr) {
+								#ifdef _WIN32
+								UnmapViewOfFile(_base);
+								#else
+								munmap(const_cast<BYTE*>(_base), _size);
+								#endif
+							}
+							#ifdef _WIN32
+							if(_map != NULL)
+								CloseHandle(_map);
+							if(_file != INVALID_HANDLE_VALUE)
+								CloseHandle(_file);
+							_map = NULL;
+							_file = INVALID_HANDLE_VALUE;
+							#endif
+							_base = nullptr;
+							_size = 0;
+							_root = __regedit_details::regf::no_cell;
+							_mapped = false;
+							_indexes.clear();
+						}
+
+						bool is_open() const {
+							return _base != nullptr;
+						}
+
+						handle root() const {
+							handle hk;
+							if(is_open()) {
+								hk.owner = this;
+								hk.cell = _root;
+							}
+							return hk;
+						}
+
+						const BYTE* data() const {
+							return _base;
+						}
+						size_t size() const {
+							return _size;
+						}
+
+						// cell contents with at least 'bytes' available, nullptr if out of bounds
+						const BYTE* cell(uint32_t off, size_t bytes) const {
+							using namespace __regedit_details::regf;
+							if(off == no_cell || static_cast<size_t>(off) + base_block_size + 4 > _size)
+								return nullptr;
+							const BYTE* ptr = _base + base_block_size + off;
+							int32_t len = static_cast<int32_t>(_le32(ptr));
+							size_t abs = static_cast<size_t>(len < 0 ? -static_cast<int64_t>(len) : len);
+							if(abs < bytes + 4 || static_cast<size_t>(ptr - _base) + abs > _size)
+								return nullptr;
+							return ptr + 4;
+						}
+
+				};
+
+			private:
+
+				friend hive_writer;
+
+				// usable bytes of an already bounds checked cell
+				static size_t _cell_size(const BYTE* cell) {
+					int32_t len = static_cast<int32_t>(__regedit_details::regf::_le32(cell - 4));
+					return static_cast<size_t>(len < 0 ? -static_cast<int64_t>(len) : len) - 4;
+				}
+
+				static const BYTE* _nk(handle hk, size_t bytes = __regedit_details::regf::nk_name) {
+					if(hk.owner == nullptr)
+						return nullptr;
+					const BYTE* nk = hk.owner->cell(hk.cell, bytes);
+					return nk != nullptr && __regedit_details::regf::_sig(nk, "nk") ? nk : nullptr;
+				}
+
+				// subkey cell at the given position of a lf / lh / li / ri list
+				static uint32_t _list_at(const file* f, uint32_t list, DWORD pos, bool leaf) {
+					using namespace __regedit_details::regf;
+					const BYTE* lst = f->cell(list, 4);
+					if(lst == nullptr)
+						return no_cell;
+					uint16_t count = _le16(lst + 2);
+					if(_sig(lst, "lf") || _sig(lst, "lh")) {
+						return pos < count && (lst = f->cell(list, 4 + count * 8)) != nullptr ? _le32(lst + 4 + pos * 8) : no_cell;
+					}
+					if(_sig(lst, "li")) {
+						return pos < count && (lst = f->cell(list, 4 + count * 4)) != nullptr ? _le32(lst + 4 + pos * 4) : no_cell;
+					}
+					if(_sig(lst, "ri") && !leaf && (lst = f->cell(list, 4 + count * 4)) != nullptr) {
+						for(uint16_t i = 0; i < count; ++i) {
+							uint32_t sub = _le32(lst + 4 + i * 4);
+							const BYTE* sublst = f->cell(sub, 4);
+							if(sublst == nullptr)
+								return no_cell;
+							DWORD subcount = _le16(sublst + 2);
+							if(pos < subcount)
+								return _list_at(f, sub, pos, true);
+							pos -= subcount;
+						}
+					}
+					return no_cell;
+				}
+				static uint32_t _subkey_at(handle hk, DWORD pos) {
+					using namespace __regedit_details::regf;
+					const BYTE* nk = _nk(hk);
+					if(nk == nullptr || pos >= _le32(nk + nk_subkeys))
+						return no_cell;
+					return _list_at(hk.owner, _le32(nk + nk_subkeys_list), pos, false);
+				}
+				// the nk count, clamped to what its value list cell holds (a corrupted count would size the buffers of every caller)
+				static DWORD _value_count(const file* f, const BYTE* nk) {
+					using namespace __regedit_details::regf;
+					DWORD count = _le32(nk + nk_values);
+					const BYTE* lst = count != 0 ? f->cell(_le32(nk + nk_values_list), 4) : nullptr;
+					return lst != nullptr ? static_cast<DWORD>((std::min)(static_cast<size_t>(count), _cell_size(lst) / 4)) : 0;
+				}
+				static const BYTE* _vk_at(handle hk, DWORD pos) {
+					using namespace __regedit_details::regf;
+					const BYTE* nk = _nk(hk);
+					if(nk == nullptr)
+						return nullptr;
+					DWORD count = _value_count(hk.owner, nk);
+					const BYTE* lst = pos < count ? hk.owner->cell(_le32(nk + nk_values_list), count * 4) : nullptr;
+					const BYTE* vk = lst != nullptr ? hk.owner->cell(_le32(lst + pos * 4), vk_name) : nullptr;
+					return vk != nullptr && _sig(vk, "vk") ? vk : nullptr;
+				}
+
+				static name_ref _key_name(const file* f, uint32_t cell) {
+					using namespace __regedit_details::regf;
+					name_ref ref;
+					const BYTE* nk = f->cell(cell, nk_name);
+					if(nk == nullptr || !_sig(nk, "nk"))
+						return ref;
+					uint16_t len = _le16(nk + nk_name_len);
+					if(f->cell(cell, nk_name + len) == nullptr)
+						return ref;
+					ref.data = nk + nk_name;
+					ref.size = len;
+					ref.wide = (_le16(nk + nk_flags) & nk_comp_name) == 0;
+					return ref;
+				}
+				static name_ref _value_name(const BYTE* vk) {
+					using namespace __regedit_details::regf;
+					name_ref ref;
+					uint16_t len = _le16(vk + vk_name_len);
+					if(_cell_size(vk) < vk_name + len)
+						return ref;
+					ref.data = vk + vk_name;
+					ref.size = len;
+					ref.wide = (_le16(vk + vk_flags) & vk_comp_name) == 0;
+					return ref;
+				}
+
+				static size_t _utf8(name_ref ref, char* out) {
+					if(ref.wide)
+						return __regedit_details::_utf16_to_utf8().feed(ref.data, ref.size, out);
+					return __regedit_details::regf::_latin1_to_utf8(ref.data, ref.size, out);
+				}
+				static long _copy_name(name_ref ref, char* name, DWORD* len) {
+					size_t size = _utf8(ref, nullptr);
+					if(*len <= size)
+						return __regedit_details::status::more_data;
+					_utf8(ref, name);
+					name[size] = '\0';
+					*len = static_cast<DWORD>(size);
+					return __regedit_details::status::success;
+				}
+				// same order used by the hive subkey lists, upcased UTF-16 code units, 'str' is UTF-8
+				static int _upcase_cmp(name_ref ref, const char* str) {
+					using namespace __regedit_details::regf;
+					const BYTE* src = reinterpret_cast<const BYTE*>(str);
+					size_t len = strlen(str), pos = 0, units = ref.wide ? ref.size / 2 : ref.size;
+					uint16_t low = 0; // pending low surrogate of 'str'
+					for(size_t i = 0; ; ++i) {
+						bool end1 = i >= units, end2 = low == 0 && pos >= len;
+						if(end1 || end2)
+							return end1 && end2 ? 0 : end1 ? -1 : 1;
+						uint16_t c1 = ref.wide ? _le16(ref.data + i * 2) : ref.data[i], c2 = low;
+						if(low != 0)
+							low = 0;
+						else {
+							uint32_t cp = __regedit_details::_utf8_next(src, len, pos);
+							if(cp >= 0x10000) {
+								cp -= 0x10000;
+								c2 = static_cast<uint16_t>(0xD800 + (cp >> 10));
+								low = static_cast<uint16_t>(0xDC00 + (cp & 0x3FF));
+							}
+							else
+								c2 = static_cast<uint16_t>(cp);
+						}
+						c1 = _upcase16(c1);
+						c2 = _upcase16(c2);
+						if(c1 != c2)
+							return c1 < c2 ? -1 : 1;
+					}
+				}
+				static bool _equal(name_ref ref, const char* str) {
+					return _upcase_cmp(ref, str) == 0;
+				}
+				static bool _ascii(const char* str) {
+					for(; *str != '\0'; ++str)
+						if(static_cast<unsigned char>(*str) >= 0x80)
+							return false;
+					return true;
+				}
+
+				static long _find_key(handle hk, const char* name, uint32_t* cell, DWORD* pos) {
+					using namespace __regedit_details::regf;
+					const BYTE* nk = _nk(hk);
+					if(nk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					DWORD count = _le32(nk + nk_subkeys);
+					DWORD left = 0, right = count;
+					while(left < right) { // binary search over the (sorted) subkey lists
+						DWORD mid = left + ((right - left) >> 1);
+						uint32_t sub = _subkey_at(hk, mid);
+						name_ref ref = _key_name(hk.owner, sub);
+						if(ref.data == nullptr)
+							break;
+						int cmp = _upcase_cmp(ref, name);
+						if(cmp < 0)
+							left = mid + 1;
+						else if(cmp > 0)
+							right = mid;
+						else {
+							*cell = sub;
+							*pos = mid;
+							return __regedit_details::status::success;
+						}
+					}
+					if(_ascii(name)) // the ASCII order is the same everywhere, anything else could have been sorted with another upcase table
+						return __regedit_details::status::file_not_found;
+					for(DWORD i = 0; i < count; ++i) {
+						uint32_t sub = _subkey_at(hk, i);
+						if(_equal(_key_name(hk.owner, sub), name)) {
+							*cell = sub;
+							*pos = i;
+							return __regedit_details::status::success;
+						}
+					}
+					return __regedit_details::status::file_not_found;
+				}
+				// built once per key and kept until the file is closed, nullptr if a name can't be read (remembered too)
+				static const file::_value_index* _values_index(handle hk, DWORD count) {
+					std::lock_guard<std::mutex> lock(hk.owner->_mtx);
+					std::unique_ptr<file::_value_index>& ix = hk.owner->_indexes[hk.cell];
+					if(ix != nullptr)
+						return ix->built ? ix.get() : nullptr;
+					ix.reset(new file::_value_index());
+					std::unique_ptr<file::_value_index> fresh(new file::_value_index());
+					for(DWORD i = 0; i < count && fresh->ascii; ++i) {
+						const BYTE* vk = _vk_at(hk, i);
+						name_ref ref = vk != nullptr ? _value_name(vk) : name_ref();
+						fresh->ascii = !ref.wide && std::find_if(ref.data, ref.data + ref.size, [](BYTE c) { return c >= 0x80; }) == ref.data + ref.size;
+					}
+					if(!fresh->idx.build(0, count, 256, [hk](DWORD p, char* buff, DWORD* len) { return enum_value(hk, p, buff, len); }) || fresh->idx.size() != count)
+						return nullptr;
+					fresh->built = true;
+					ix = std::move(fresh);
+					return ix.get();
+				}
+				static const BYTE* _find_vk(handle hk, const char* name, DWORD* pos) {
+					const BYTE* nk = _nk(hk);
+					if(nk == nullptr)
+						return nullptr;
+					DWORD count = _value_count(hk.owner, nk);
+					size_t len = strlen(name);
+					bool ascii = _ascii(name);
+					const file::_value_index* ix = count >= __regedit_details::index_min_size ? _values_index(hk, count) : nullptr;
+					if(ix != nullptr) {
+						DWORD found = ix->idx.find(name);
+						if(found < count) {
+							if(pos != nullptr)
+								*pos = found;
+							return _vk_at(hk, found);
+						}
+						if(ascii && ix->ascii) // anything else goes through the upcase table below
+							return nullptr;
+					}
+					for(DWORD i = 0; i < count; ++i) {
+						const BYTE* vk = _vk_at(hk, i);
+						if(vk == nullptr)
+							continue;
+						name_ref ref = _value_name(vk);
+						if(ref.data == nullptr || (ascii && !ref.wide && ref.size != len))
+							continue;
+						if(_equal(ref, name)) {
+							if(pos != nullptr)
+								*pos = i;
+							return vk;
+						}
+					}
+					return nullptr;
+				}
+
+				// calls fn(data, bytes) for every data chunk of a vk, returns false if the cells are corrupted
+				template<class Fn>
+				static bool _chunks(const file* f, const BYTE* vk, Fn fn) {
+					using namespace __regedit_details::regf;
+					uint32_t size = _le32(vk + vk_data_size);
+					if(size & vk_data_inline) {
+						fn(vk + vk_data, (std::min)(size & ~vk_data_inline, 4u));
+						return true;
+					}
+					if(size == 0)
+						return true;
+					uint32_t off = _le32(vk + vk_data);
+					const BYTE* db = f->cell(off, 8);
+					if(size > big_data_size && db != nullptr && _sig(db, "db")) {
+						uint16_t segments = _le16(db + 2);
+						const BYTE* lst = f->cell(_le32(db + 4), segments * 4);
+						if(lst == nullptr)
+							return false;
+						for(uint16_t i = 0; i < segments && size > 0; ++i) {
+							uint32_t bytes = (std::min)(size, big_data_size);
+							const BYTE* seg = f->cell(_le32(lst + i * 4), bytes);
+							if(seg == nullptr)
+								return false;
+							fn(seg, bytes);
+							size -= bytes;
+						}
+						return size == 0;
+					}
+					const BYTE* data = f->cell(off, size);
+					if(data == nullptr)
+						return false;
+					fn(data, size);
+					return true;
+				}
+				// size returned by query_value(), strings are converted to UTF-8
+				static bool _data_size(const file* f, const BYTE* vk, DWORD* size) {
+					size_t len = 0;
+					bool valid;
+					if(_is_string(__regedit_details::regf::_le32(vk + __regedit_details::regf::vk_type))) {
+						__regedit_details::_utf16_to_utf8 conv;
+						valid = _chunks(f, vk, [&](const BYTE* src, size_t bytes) { len += conv.feed(src, bytes, nullptr); });
+					}
+					else
+						valid = _chunks(f, vk, [&](const BYTE*, size_t bytes) { len += bytes; });
+					*size = static_cast<DWORD>(len);
+					return valid;
+				}
+				static bool _is_string(DWORD ty) {
+					using __regedit_details::type;
+					return ty == static_cast<DWORD>(type::sz) || ty == static_cast<DWORD>(type::expand_sz) || ty == static_cast<DWORD>(type::multi_sz);
+				}
+				// RegQueryValueExA rules for data / len, strings converted to UTF-8
+				static long _read_data(const file* f, const BYTE* vk, BYTE* data, DWORD* len) {
+					DWORD size = 0;
+					if(!_data_size(f, vk, &size))
+						return __regedit_details::status::file_not_found;
+					if(data != nullptr) {
+						if(len == nullptr)
+							return __regedit_details::status::invalid_parameter;
+						if(*len < size) {
+							*len = size;
+							return __regedit_details::status::more_data;
+						}
+						size_t off = 0;
+						if(_is_string(__regedit_details::regf::_le32(vk + __regedit_details::regf::vk_type))) {
+							__regedit_details::_utf16_to_utf8 conv;
+							_chunks(f, vk, [&](const BYTE* src, size_t bytes) { off += conv.feed(src, bytes, reinterpret_cast<char*>(data) + off); });
+						}
+						else
+							_chunks(f, vk, [&](const BYTE* src, size_t bytes) { memcpy(data + off, src, bytes); off += bytes; });
+					}
+					if(len != nullptr)
+						*len = size;
+					return __regedit_details::status::success;
+				}
+
+			public:
+
+				static long open(handle parent, const char* key, bool /*write*/, handle* out) {
+					if(_nk(parent) == nullptr)
+						return __regedit_details::status::invalid_handle;
+					char seg[__regedit_details::key_name_size];
+					size_t len = 0;
+					handle hk = parent;
+					for(const char* p = key != nullptr ? key : ""; ; ++p) {
+						if(*p != '\\' && *p != '\0') {
+							if(len == __regedit_details::key_name_size - 1)
+								return __regedit_details::status::invalid_parameter;
+							seg[len++] = *p;
+							continue;
+						}
+						if(len != 0) {
+							seg[len] = '\0';
+							DWORD pos = 0;
+							long ret = _find_key(hk, seg, &hk.cell, &pos);
+							if(ret != __regedit_details::status::success)
+								return ret;
+							len = 0;
+						}
+						if(*p == '\0')
+							break;
+					}
+					*out = hk;
+					return __regedit_details::status::success;
+				}
+				static long create(handle parent, const char* key, bool write, handle* out, bool* created) { // only opens existing keys
+					long ret = open(parent, key, write, out);
+					if(created != nullptr)
+						*created = false;
+					return ret == __regedit_details::status::file_not_found ? __regedit_details::status::access_denied : ret;
+				}
+				static void close(handle /*hk*/) {}
+
+				static long query_info(handle hk, DWORD* subkeys, DWORD* values) {
+					const BYTE* nk = _nk(hk);
+					if(nk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					if(subkeys != nullptr)
+						*subkeys = __regedit_details::regf::_le32(nk + __regedit_details::regf::nk_subkeys);
+					if(values != nullptr)
+						*values = _value_count(hk.owner, nk);
+					return __regedit_details::status::success;
+				}
+				// the nk maxima are UTF-16 bytes (the high bits of the subkey one hold flags on recent hives)
+				static long query_key_info(handle hk, __regedit_details::key_info* info) {
+					using namespace __regedit_details::regf;
+					const BYTE* nk = _nk(hk);
+					if(nk == nullptr)
+						return __regedit_details::status::invalid_handle;
+					info->subkeys = _le32(nk + nk_subkeys);
+					info->values = _value_count(hk.owner, nk);
+					info->max_key_name = (_le32(nk + nk_max_subkey) & 0xFFFF) / 2 * 3;
+					info->max_value_name = _le32(nk + nk_max_value) / 2 * 3;
+					info->max_value_data = _le32(nk + nk_max_data) / 2 * 3 + 1;
+					info->stamp = _le32(nk + nk_last_write) | (static_cast<uint64_t>(_le32(nk + nk_last_write + 4)) << 32);
+					return __regedit_details::status::success;
+				}
+				static long enum_key(handle hk, DWORD pos, char* name, DWORD* len) {
+					DWORD count = 0;
+					long ret = query_info(hk, &count, nullptr);
+					if(ret != __regedit_details::status::success)
+						return ret;
+					if(pos >= count)
+						return __regedit_details::status::no_more_items;
+					name_ref ref = _key_name(hk.owner, _subkey_at(hk, pos));
+					return ref.data != nullptr ? _copy_name(ref, name, len) : __regedit_details::status::file_not_found;
+				}
+				static long enum_value(handle hk, DWORD pos, char* name, DWORD* len, DWORD* ty = nullptr, DWORD* size = nullptr) {
+					DWORD count = 0;
+					long ret = query_info(hk, nullptr, &count);
+					if(ret != __regedit_details::status::success)
+						return ret;
+					if(pos >= count)
+						return __regedit_details::status::no_more_items;
+					const BYTE* vk = _vk_at(hk, pos);
+					name_ref ref = vk != nullptr ? _value_name(vk) : name_ref();
+					if(ref.data == nullptr)
+						return __regedit_details::status::file_not_found;
+					if(ty != nullptr)
+						*ty = __regedit_details::regf::_le32(vk + __regedit_details::regf::vk_type);
+					if(size != nullptr && !_data_size(hk.owner, vk, size))
+						return __regedit_details::status::file_not_found;
+					return _copy_name(ref, name, len);
+				}
+				static long enum_data(handle hk, DWORD pos, char* name, DWORD* len, DWORD* ty, BYTE* data, DWORD* size) {
+					DWORD count = 0;
+					long ret = query_info(hk, nullptr, &count);
+					if(ret != __regedit_details::status::success)
+						return ret;
+					if(pos >= count)
+						return __regedit_details::status::no_more_items;
+					const BYTE* vk = _vk_at(hk, pos);
+					name_ref ref = vk != nullptr ? _value_name(vk) : name_ref();
+					if(ref.data == nullptr)
+						return __regedit_details::status::file_not_found;
+					if((ret = _copy_name(ref, name, len)) != __regedit_details::status::success)
+						return ret;
+					if(ty != nullptr)
+						*ty = __regedit_details::regf::_le32(vk + __regedit_details::regf::vk_type);
+					return _read_data(hk.owner, vk, data, size);
+				}
+				static long find_key(handle hk, const char* name, DWORD* pos) {
+					uint32_t cell = 0;
+					return _find_key(hk, name, &cell, pos);
+				}
+				static long find_value(handle hk, const char* name, DWORD* pos) {
+					if(_nk(hk) == nullptr)
+						return __regedit_details::status::invalid_handle;
+					return _find_vk(hk, name != nullptr ? name : "", pos) != nullptr ? __regedit_details::status::success : __regedit_details::status::file_not_found;
+				}
+
+				static long query_value(handle hk, const char* name, DWORD* ty, BYTE* data, DWORD* len) {
+					using namespace __regedit_details::regf;
+					if(_nk(hk) == nullptr)
+						return __regedit_details::status::invalid_handle;
+					const BYTE* vk = _find_vk(hk, name != nullptr ? name : "", nullptr);
+					if(vk == nullptr)
+						return __regedit_details::status::file_not_found;
+					DWORD vty = _le32(vk + vk_type);
+					if(ty != nullptr)
+						*ty = vty;
+					if(data == nullptr && len == nullptr)
+						return __regedit_details::status::success;
+					return _read_data(hk.owner, vk, data, len);
+				}
+				static long set_value(handle, const char*, DWORD, const BYTE*, DWORD) {
+					return __regedit_details::status::access_denied;
+				}
+				static long set_value_unicode(handle, const char*, DWORD, const BYTE*, DWORD) {
+					return __regedit_details::status::access_denied;
+				}
+				static long delete_value(handle, const char*) {
+					return __regedit_details::status::access_denied;
+				}
+				static long delete_tree(handle, const char*) {
+					return __regedit_details::status::access_denied;
+				}
+
+				// Zero-copy access:
+
+				static name_ref key_name(handle hk, DWORD pos) {
+					return hk.owner != nullptr ? _key_name(hk.owner, _subkey_at(hk, pos)) : name_ref();
+				}
+				static name_ref value_name(handle hk, DWORD pos) {
+					const BYTE* vk = _vk_at(hk, pos);
+					return vk != nullptr ? _value_name(vk) : name_ref();
+				}
+				// raw data as stored on the hive (strings are UTF-16LE), false if missing or split on big data segments
+				static bool value_view(handle hk, const char* name, DWORD* ty, const BYTE** data, DWORD* len) {
+					using namespace __regedit_details::regf;
+					const BYTE* vk = _nk(hk) != nullptr ? _find_vk(hk, name != nullptr ? name : "", nullptr) : nullptr;
+					if(vk == nullptr)
+						return false;
+					size_t chunks = 0;
+					if(!_chunks(hk.owner, vk, [&](const BYTE* src, size_t bytes) { *data = src; *len = static_cast<DWORD>(bytes); ++chunks; }) || chunks > 1)
+						return false;
+					if(chunks == 0) {
+						*data = nullptr;
+						*len = 0;
+					}
+					if(ty != nullptr)
+						*ty = _le32(vk + vk_type);
+					return true;
+				}
+
+		};
+
+	}
+
+	/*
+		Streaming regf writer, the tree is written on DFS order through a fixed size window, only the names of the current path siblings
+		are kept in memory (memory bound by the tree depth, not by the hive size), the nk cells are patched once their subtree is written.
+		Notes:
+			- sz / expand_sz / multi_sz data and names are taken as UTF-8 and stored as UTF-16LE (names with only Latin-1 chars are stored compressed),
+				link data is taken as a wchar_t string (same than value::write<type::link>)
+			- Values bigger than 16344 bytes are split through db cells, subkey lists are sorted lh lists (ri indexed when needed)
+			- Every key gets the same default security descriptor (SYSTEM and Administrators full access, Everyone read)
+			- Writing a hive_regedit keeps the cells as they are (raw names and data, timestamps, class names and security descriptors), see compact_hive()
+	*/
+	class hive_writer {
+
+		private:
+
+			using DWORD = __regedit_details::DWORD;
+			using BYTE  = __regedit_details::BYTE;
+			using _name = __regedit_details::regf::_name;
+
+			static constexpr size_t _window   = 1 << 20;
+			static constexpr uint32_t _hbin   = 0x1000;
+			static constexpr uint32_t _lh_max = 512; // entries per lh list before splitting on a ri list
+
+			template<class Backend>
+			class _backend_source {
+
+				private:
+
+					using handle = typename Backend::handle;
+
+					std::vector<char> _vname = std::vector<char>(16384 * 3 + 1);
+					std::vector<BYTE> _raw;
+					std::vector<BYTE> _wide;
+					_name _name_tmp;
+					std::vector<BYTE> _sd;
+
+				public:
+
+					struct child {
+						std::string name;
+						_name enc;
+					};
+
+					_backend_source() {
+						// self-relative security descriptor, owner Administrators, group SYSTEM, inherited DACL
+						const BYTE admins[]   = { 1, 2, 0, 0, 0, 0, 0, 5, 32, 0, 0, 0, 0x20, 0x02, 0, 0 };
+						const BYTE system[]   = { 1, 1, 0, 0, 0, 0, 0, 5, 18, 0, 0, 0 };
+						const BYTE everyone[] = { 1, 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0 };
+						struct { const BYTE* sid; size_t len; uint32_t mask; } aces[] = { { system, sizeof(system), 0xF003F }, { admins, sizeof(admins), 0xF003F }, { everyone, sizeof(everyone), 0x20019 } };
+						std::vector<BYTE> acl(8);
+						for(auto& ace : aces) {
+							size_t pos = acl.size();
+							acl.resize(pos + 8 + ace.len);
+							acl[pos] = 0;    // ACCESS_ALLOWED_ACE_TYPE
+							acl[pos + 1] = 2; // CONTAINER_INHERIT_ACE
+							__regedit_details::regf::_put16(&acl[pos + 2], static_cast<uint16_t>(8 + ace.len));
+							__regedit_details::regf::_put32(&acl[pos + 4], ace.mask);
+							memcpy(&acl[pos + 8], ace.sid, ace.len);
+						}
+						acl[0] = 2;
+						__regedit_details::regf::_put16(&acl[2], static_cast<uint16_t>(acl.size()));
+						__regedit_details::regf::_put16(&acl[4], 3);
+						_sd.assign(20, 0);
+						_sd[0] = 1;
+						__regedit_details::regf::_put16(&_sd[2], 0x8004); // SE_SELF_RELATIVE | SE_DACL_PRESENT
+						__regedit_details::regf::_put32(&_sd[4], 20);
+						__regedit_details::regf::_put32(&_sd[8], static_cast<uint32_t>(20 + sizeof(admins)));
+						__regedit_details::regf::_put32(&_sd[16], static_cast<uint32_t>(20 + sizeof(admins) + sizeof(system)));
+						_sd.insert(_sd.end(), admins, admins + sizeof(admins));
+						_sd.insert(_sd.end(), system, system + sizeof(system));
+						_sd.insert(_sd.end(), acl.begin(), acl.end());
+					}
+
+					bool self_name(handle, _name&) {
+						return false;
+					}
+					uint64_t timestamp(handle, uint64_t now) {
+						return now;
+					}
+					uint32_t security(handle, const BYTE** sd, size_t* len) {
+						*sd = _sd.data();
+						*len = _sd.size();
+						return 0;
+					}
+					bool class_name(handle, const BYTE**, size_t*) {
+						return false;
+					}
+
+					void children(handle hk, std::vector<child>& out) {
+						DWORD count = 0;
+						Backend::query_info(hk, &count, nullptr);
+						out.reserve(count);
+						for(DWORD pos = 0; ; ++pos) {
+							DWORD len = static_cast<DWORD>(_vname.size());
+							long ret = Backend::enum_key(hk, pos, _vname.data(), &len);
+							if(ret == __regedit_details::status::no_more_items)
+								break;
+							if(ret != __regedit_details::status::success)
+								continue;
+							out.push_back(child());
+							out.back().name.assign(_vname.data(), len);
+							out.back().enc.assign_utf8(_vname.data(), len);
+						}
+						std::sort(out.begin(), out.end(), [](const child& c1, const child& c2) {
+							return __regedit_details::regf::_lh_less(c1.enc, c2.enc);
+						});
+					}
+					bool open(handle hk, const child& ch, handle* out) {
+						return Backend::open(hk, ch.name.c_str(), false, out) == __regedit_details::status::success;
+					}
+					void close(handle hk) {
+						Backend::close(hk);
+					}
+					const _name& name(handle, const child& ch) {
+						return ch.enc;
+					}
+
+					// fn(const _name& name, DWORD type, const BYTE* data, size_t len) for every value
+					template<class Fn>
+					void values(handle hk, Fn fn) {
+						using __regedit_details::type;
+						for(DWORD pos = 0; ; ++pos) {
+							DWORD len = static_cast<DWORD>(_vname.size());
+							long ret = Backend::enum_value(hk, pos, _vname.data(), &len);
+							if(ret == __regedit_details::status::no_more_items)
+								break;
+							if(ret != __regedit_details::status::success)
+								continue;
+							DWORD ty = 0, size = static_cast<DWORD>(_raw.size());
+							while((ret = Backend::query_value(hk, _vname.data(), &ty, _raw.data(), &size)) == __regedit_details::status::more_data || (ret == __regedit_details::status::success && _raw.empty() && size != 0))
+								_raw.resize(size);
+							if(ret != __regedit_details::status::success)
+								continue;
+							_name_tmp.assign_utf8(_vname.data(), len);
+							const BYTE* data = _raw.data();
+							if(ty == static_cast<DWORD>(type::sz) || ty == static_cast<DWORD>(type::expand_sz) || ty == static_cast<DWORD>(type::multi_sz)) {
+								_wide.clear();
+								__regedit_details::_utf8_to_utf16(_raw.data(), size, _wide);
+								data = _wide.data();
+								size = static_cast<DWORD>(_wide.size());
+							}
+							else if(ty == static_cast<DWORD>(type::link) && sizeof(wchar_t) != 2) {
+								_wide.clear();
+								for(DWORD i = 0; i + sizeof(wchar_t) <= size; i += sizeof(wchar_t)) {
+									wchar_t wc;
+									memcpy(&wc, _raw.data() + i, sizeof(wchar_t));
+									uint32_t cp = static_cast<uint32_t>(wc);
+									if(cp >= 0x10000) {
+										cp -= 0x10000;
+										uint32_t high = 0xD800 + (cp >> 10), low = 0xDC00 + (cp & 0x3FF);
+										_wide.insert(_wide.end(), { static_cast<BYTE>(high), static_cast<BYTE>(high >> 8), static_cast<BYTE>(low), static_cast<BYTE>(low >> 8) });
+									}
+									else
+										_wide.insert(_wide.end(), { static_cast<BYTE>(cp), static_cast<BYTE>(cp >> 8) });
+								}
+								data = _wide.data();
+								size = static_cast<DWORD>(_wide.size());
+							}
+							fn(_name_tmp, ty, data, static_cast<size_t>(size));
+						}
+					}
+
+			};
+
+			// raw cell copy from another hive
+			class _hive_source {
+
+				private:
+
+					using handle = regedit_backend::hive::handle;
+					using hive   = regedit_backend::hive;
+
+					std::vector<BYTE> _raw;
+					_name _name_tmp;
+					_name _child_tmp;
+
+					static void _raw_name(hive::name_ref ref, _name& out) {
+						out.assign_raw(ref.data, ref.size, !ref.wide);
+					}
+
+				public:
+
+					struct child {
+						uint32_t cell;
+					};
+
+					bool self_name(handle hk, _name& out) {
+						hive::name_ref ref = hive::_key_name(hk.owner, hk.cell);
+						if(ref.data == nullptr)
+							return false;
+						_raw_name(ref, out);
+						return true;
+					}
+					uint64_t timestamp(handle hk, uint64_t now) {
+						const BYTE* nk = hive::_nk(hk);
+						if(nk == nullptr)
+							return now;
+						return __regedit_details::regf::_le32(nk + __regedit_details::regf::nk_last_write) | (static_cast<uint64_t>(__regedit_details::regf::_le32(nk + __regedit_details::regf::nk_last_write + 4)) << 32);
+					}
+					uint32_t security(handle hk, const BYTE** sd, size_t* len) {
+						using namespace __regedit_details::regf;
+						const BYTE* nk = hive::_nk(hk);
+						uint32_t off = nk != nullptr ? _le32(nk + nk_security) : no_cell;
+						const BYTE* sk = hk.owner->cell(off, 20);
+						if(sk == nullptr || !_sig(sk, "sk") || hk.owner->cell(off, 20 + _le32(sk + 16)) == nullptr)
+							return no_cell;
+						*sd = sk + 20;
+						*len = _le32(sk + 16);
+						return off;
+					}
+					bool class_name(handle hk, const BYTE** data, size_t* len) {
+						using namespace __regedit_details::regf;
+						const BYTE* nk = hive::_nk(hk);
+						if(nk == nullptr || _le16(nk + nk_class_len) == 0)
+							return false;
+						*len = _le16(nk + nk_class_len);
+						*data = hk.owner->cell(_le32(nk + nk_class), *len);
+						return *data != nullptr;
+					}
+
+					void children(handle hk, std::vector<child>& out) { // already sorted
+						DWORD count = 0;
+						hive::query_info(hk, &count, nullptr);
+						out.reserve(count);
+						for(DWORD pos = 0; pos < count; ++pos) {
+							uint32_t cell = hive::_subkey_at(hk, pos);
+							if(hive::_key_name(hk.owner, cell).data != nullptr)
+								out.push_back(child{ cell });
+						}
+					}
+					bool open(handle hk, const child& ch, handle* out) {
+						out->owner = hk.owner;
+						out->cell = ch.cell;
+						return true;
+					}
+					void close(handle) {}
+					const _name& name(handle hk, const child& ch) {
+						_raw_name(hive::_key_name(hk.owner, ch.cell), _child_tmp);
+						return _child_tmp;
+					}
+
+					template<class Fn>
+					void values(handle hk, Fn fn) {
+						DWORD count = 0;
+						hive::query_info(hk, nullptr, &count);
+						for(DWORD pos = 0; pos < count; ++pos) {
+							const BYTE* vk = hive::_vk_at(hk, pos);
+							hive::name_ref ref = vk != nullptr ? hive::_value_name(vk) : hive::name_ref();
+							if(ref.data == nullptr)
+								continue;
+							_raw.clear();
+							if(!hive::_chunks(hk.owner, vk, [&](const BYTE* src, size_t bytes) { _raw.insert(_raw.end(), src, src + bytes); }))
+								continue;
+							_raw_name(ref, _name_tmp);
+							fn(_name_tmp, __regedit_details::regf::_le32(vk + __regedit_details::regf::vk_type), _raw.data(), _raw.size());
+						}
+					}
+
+			};
+
+			struct _sk {
+				uint32_t cell;
+				uint32_t refs;
+			};
+
+			std::FILE* _file = nullptr;
+			std::vector<BYTE>* _out = nullptr; // whole image or pending window of the file
+			std::vector<BYTE> _local;
+			uint64_t _flushed = 0;             // bytes of the output already on the file
+			uint32_t _pos = 0;                 // hive bins bytes, cell offsets are relative to the first hbin
+			uint32_t _hbin_end = 0;
+			uint32_t _root = __regedit_details::regf::no_cell;
+			uint64_t _now = 0;
+			bool _failed = false;
+			std::map<uint32_t, size_t> _sk_ids;
+			std::vector<_sk> _sks;
+			std::vector<BYTE> _scratch;
+
+			static uint32_t _align(size_t len, size_t align) {
+				return static_cast<uint32_t>((len + align - 1) & ~(align - 1));
+			}
+
+			void _append(const BYTE* data, size_t len) {
+				_out->insert(_out->end(), data, data + len);
+				if(_file != nullptr && _out->size() >= _window) {
+					if(std::fwrite(_out->data(), 1, _out->size(), _file) != _out->size())
+						_failed = true;
+					_flushed += _out->size();
+					_out->clear();
+				}
+			}
+			void _fill(size_t len) {
+				_out->insert(_out->end(), len, 0);
+			}
+			// cells are 32 bits offsets past the base block, the files can go over what a 32 bits long (std::fseek) holds
+			static bool _seek(std::FILE* f, uint64_t off) {
+				#ifdef _WIN32
+				return _fseeki64(f, static_cast<__int64>(off), SEEK_SET) == 0;
+				#else
+				if(off > static_cast<uint64_t>(std::numeric_limits<off_t>::max())) // 32 bits off_t, built without _FILE_OFFSET_BITS=64
+					return false;
+				return fseeko(f, static_cast<off_t>(off), SEEK_SET) == 0;
+				#endif
+			}
+			void _patch(uint64_t off, const BYTE* data, size_t len) {
+				if(off >= _flushed) {
+					memcpy(_out->data() + (off - _flushed), data, len);
+					return;
+				}
+				if(!_seek(_file, off) || std::fwrite(data, 1, len, _file) != len || std::fseek(_file, 0, SEEK_END) != 0)
+					_failed = true;
+			}
+			void _patch32(uint32_t cell, size_t field, uint32_t val) {
+				BYTE buff[4];
+				__regedit_details::regf::_put32(buff, val);
+				_patch(_hbin + static_cast<uint64_t>(cell) + 4 + field, buff, 4);
+			}
+
+			// closes the current hbin with a free cell
+			void _close_hbin() {
+				if(_pos == _hbin_end)
+					return;
+				BYTE size[4];
+				__regedit_details::regf::_put32(size, _hbin_end - _pos);
+				_append(size, 4);
+				_fill(_hbin_end - _pos - 4);
+				_pos = _hbin_end;
+			}
+			uint32_t _cell(const BYTE* data, size_t len) {
+				uint32_t size = _align(len + 4, 8);
+				if(static_cast<uint64_t>(_pos) + size + 32 + _hbin > 0xFFFFFFFFull) {
+					_failed = true;
+					return __regedit_details::regf::no_cell;
+				}
+				if(_pos + size > _hbin_end) {
+					_close_hbin();
+					uint32_t hbin_size = (std::max)(static_cast<uint32_t>(_hbin), _align(size + 32, _hbin));
+					BYTE hdr[32] = { 'h', 'b', 'i', 'n' };
+					__regedit_details::regf::_put32(hdr + 4, _pos);
+					__regedit_details::regf::_put32(hdr + 8, hbin_size);
+					__regedit_details::regf::_put64(hdr + 20, _now);
+					_append(hdr, 32);
+					_hbin_end = _pos + hbin_size;
+					_pos += 32;
+				}
+				uint32_t off = _pos;
+				BYTE hdr[4];
+				__regedit_details::regf::_put32(hdr, static_cast<uint32_t>(-static_cast<int32_t>(size)));
+				_append(hdr, 4);
+				_append(data, len);
+				_fill(size - 4 - len);
+				_pos += size;
+				return off;
+			}
+
+			uint32_t _security(uint32_t id, const BYTE* sd, size_t len) {
+				std::map<uint32_t, size_t>::iterator it = _sk_ids.find(id);
+				if(it == _sk_ids.end()) { // links and reference counts are patched at close()
+					_scratch.assign(20, 0);
+					_scratch[0] = 's';
+					_scratch[1] = 'k';
+					__regedit_details::regf::_put32(&_scratch[16], static_cast<uint32_t>(len));
+					_scratch.insert(_scratch.end(), sd, sd + len);
+					it = _sk_ids.insert({ id, _sks.size() }).first;
+					_sks.push_back(_sk{ _cell(_scratch.data(), _scratch.size()), 0 });
+				}
+				++_sks[it->second].refs;
+				return _sks[it->second].cell;
+			}
+
+			uint32_t _value(const _name& name, DWORD ty, const BYTE* data, size_t len) {
+				using namespace __regedit_details::regf;
+				BYTE vk[vk_name] = { 'v', 'k' };
+				_put16(vk + vk_name_len, static_cast<uint16_t>(name.bytes.size()));
+				_put32(vk + vk_type, ty);
+				_put16(vk + vk_flags, name.comp ? vk_comp_name : 0);
+				if(len <= 4) {
+					_put32(vk + vk_data_size, static_cast<uint32_t>(len) | vk_data_inline);
+					if(len != 0)
+						memcpy(vk + vk_data, data, len);
+				}
+				else if(len <= big_data_size) {
+					_put32(vk + vk_data_size, static_cast<uint32_t>(len));
+					_put32(vk + vk_data, _cell(data, len));
+				}
+				else {
+					std::vector<BYTE> segments;
+					for(size_t off = 0; off < len; off += big_data_size) {
+						segments.resize(segments.size() + 4);
+						_put32(&segments[segments.size() - 4], _cell(data + off, (std::min)(len - off, static_cast<size_t>(big_data_size))));
+					}
+					BYTE db[8] = { 'd', 'b' };
+					_put16(db + 2, static_cast<uint16_t>(segments.size() / 4));
+					_put32(db + 4, _cell(segments.data(), segments.size()));
+					_put32(vk + vk_data_size, static_cast<uint32_t>(len));
+					_put32(vk + vk_data, _cell(db, sizeof(db)));
+				}
+				_scratch.assign(vk, vk + vk_name);
+				_scratch.insert(_scratch.end(), name.bytes.begin(), name.bytes.end());
+				return _cell(_scratch.data(), _scratch.size());
+			}
+
+			// lh list, or ri of lh lists if there're too many subkeys
+			uint32_t _subkeys_list(const std::vector<std::pair<uint32_t, uint32_t>>& subkeys) {
+				using namespace __regedit_details::regf;
+				std::vector<uint32_t> leaves;
+				for(size_t first = 0; first < subkeys.size(); first += _lh_max) {
+					size_t count = (std::min)(subkeys.size() - first, static_cast<size_t>(_lh_max));
+					_scratch.assign(4 + count * 8, 0);
+					_scratch[0] = 'l';
+					_scratch[1] = 'h';
+					_put16(&_scratch[2], static_cast<uint16_t>(count));
+					for(size_t i = 0; i < count; ++i) {
+						_put32(&_scratch[4 + i * 8], subkeys[first + i].first);
+						_put32(&_scratch[8 + i * 8], subkeys[first + i].second);
+					}
+					leaves.push_back(_cell(_scratch.data(), _scratch.size()));
+				}
+				if(leaves.size() == 1)
+					return leaves[0];
+				_scratch.assign(4 + leaves.size() * 4, 0);
+				_scratch[0] = 'r';
+				_scratch[1] = 'i';
+				_put16(&_scratch[2], static_cast<uint16_t>(leaves.size()));
+				for(size_t i = 0; i < leaves.size(); ++i)
+					_put32(&_scratch[4 + i * 4], leaves[i]);
+				return _cell(_scratch.data(), _scratch.size());
+			}
+
+			template<class Source, class Handle>
+			uint32_t _key(Source& src, Handle hk, const _name& name, uint32_t parent, bool root) {
+				using namespace __regedit_details::regf;
+
+				// nk, counts and lists are patched once the subtree is written
+				std::vector<BYTE> nk(nk_name + name.bytes.size(), 0);
+				nk[0] = 'n';
+				nk[1] = 'k';
+				_put16(&nk[nk_flags], static_cast<uint16_t>((name.comp ? nk_comp_name : 0) | (root ? nk_root_flag | 0x0008 : 0)));
+				_put64(&nk[nk_last_write], src.timestamp(hk, _now));
+				_put32(&nk[nk_parent], parent);
+				_put32(&nk[nk_subkeys_list], no_cell);
+				_put32(&nk[nk_subkeys_list + 4], no_cell);
+				_put32(&nk[nk_values_list], no_cell);
+				_put32(&nk[nk_class], no_cell);
+				_put16(&nk[nk_name_len], static_cast<uint16_t>(name.bytes.size()));
+				std::copy(name.bytes.begin(), name.bytes.end(), nk.begin() + nk_name);
+				const BYTE* sd = nullptr;
+				size_t sd_len = 0;
+				uint32_t sd_id = src.security(hk, &sd, &sd_len);
+				if(sd != nullptr)
+					_put32(&nk[nk_security], _security(sd_id, sd, sd_len));
+				else
+					_put32(&nk[nk_security], no_cell);
+				const BYTE* cls = nullptr;
+				size_t cls_len = 0;
+				if(src.class_name(hk, &cls, &cls_len)) {
+					_put32(&nk[nk_class], _cell(cls, cls_len));
+					_put16(&nk[nk_class_len], static_cast<uint16_t>(cls_len));
+				}
+				uint32_t cell = _cell(nk.data(), nk.size());
+
+				std::vector<BYTE> vlist;
+				uint32_t max_vname = 0, max_data = 0;
+				src.values(hk, [&](const _name& vname, DWORD ty, const BYTE* data, size_t len) {
+					uint32_t vk = _value(vname, ty, data, len);
+					vlist.resize(vlist.size() + 4);
+					_put32(&vlist[vlist.size() - 4], vk);
+					max_vname = (std::max)(max_vname, static_cast<uint32_t>(vname.utf16_bytes()));
+					max_data = (std::max)(max_data, static_cast<uint32_t>(len));
+				});
+				if(!vlist.empty()) {
+					_patch32(cell, nk_values, static_cast<uint32_t>(vlist.size() / 4));
+					_patch32(cell, nk_values_list, _cell(vlist.data(), vlist.size()));
+					_patch32(cell, nk_max_value, max_vname);
+					_patch32(cell, nk_max_data, max_data);
+				}
+
+				std::vector<typename Source::child> children;
+				src.children(hk, children);
+				std::vector<std::pair<uint32_t, uint32_t>> subkeys;
+				subkeys.reserve(children.size());
+				uint32_t max_subkey = 0;
+				for(const typename Source::child& ch : children) {
+					Handle sub;
+					if(!src.open(hk, ch, &sub))
+						continue;
+					_name sub_name = src.name(hk, ch);
+					subkeys.push_back({ _key(src, sub, sub_name, cell, false), _lh_hash(sub_name) });
+					max_subkey = (std::max)(max_subkey, static_cast<uint32_t>(sub_name.utf16_bytes()));
+					src.close(sub);
+				}
+				if(!subkeys.empty()) {
+					_patch32(cell, nk_subkeys, static_cast<uint32_t>(subkeys.size()));
+					_patch32(cell, nk_subkeys_list, _subkeys_list(subkeys));
+					_patch32(cell, nk_max_subkey, max_subkey);
+				}
+				return cell;
+			}
+
+			template<class Source, class Handle>
+			bool _write(Source& src, Handle hk, const std::string& root_name) {
+				if(!is_open() || _root != __regedit_details::regf::no_cell)
+					return false;
+				_name name;
+				if(!root_name.empty() || !src.self_name(hk, name))
+					name.assign_utf8(root_name.empty() ? "ROOT" : root_name.c_str(), root_name.empty() ? 4 : root_name.size());
+				_root = _key(src, hk, name, __regedit_details::regf::no_cell, true);
+				return !_failed;
+			}
+
+		public:
+
+			hive_writer() {}
+			hive_writer(const std::string& path) {
+				open(path);
+			}
+			hive_writer(std::vector<BYTE>& image) {
+				open(image);
+			}
+			hive_writer(const hive_writer&) = delete;
+			hive_writer& operator=(const hive_writer&) = delete;
+
+			~hive_writer() {
+				close();
+			}
+
+			bool open(const std::string& path) {
+				close();
+				if((_file = std::fopen(path.c_str(), "wb")) == nullptr)
+					return false;
+				_local.clear();
+				_out = &_local;
+				_start();
+				return true;
+			}
+			// writes the hive on memory
+			bool open(std::vector<BYTE>& image) {
+				close();
+				image.clear();
+				_out = &image;
+				_start();
+				return true;
+			}
+
+			bool is_open() const {
+				return _out != nullptr;
+			}
+
+			// writes the whole tree as the hive contents, only one tree per hive, an empty root name keeps the original one on hives ("ROOT" otherwise)
+			template<class Backend>
+			bool write(const basic_regedit<Backend>& tree, const std::string& root_name = "") {
+				_backend_source<Backend> src;
+				return tree.is_open() && _write(src, tree.native_handle(), root_name);
+			}
+			bool write(const basic_regedit<regedit_backend::hive>& tree, const std::string& root_name = "") {
+				_hive_source src;
+				return tree.is_open() && _write(src, tree.native_handle(), root_name);
+			}
+
+			// finishes the hive (base block, hbins padding, security descriptors list), returns false if something failed
+			bool close() {
+				using namespace __regedit_details::regf;
+				if(!is_open())
+					return false;
+				if(_root == no_cell) {
+					_backend_source<regedit_backend::memory> src;
+					regedit_backend::memory::store empty;
+					_write(src, empty.root(), "ROOT");
+				}
+				_close_hbin();
+				for(size_t i = 0; i < _sks.size(); ++i) {
+					_patch32(_sks[i].cell, 4, _sks[(i + 1) % _sks.size()].cell);
+					_patch32(_sks[i].cell, 8, _sks[(i + _sks.size() - 1) % _sks.size()].cell);
+					_patch32(_sks[i].cell, 12, _sks[i].refs);
+				}
+
+				BYTE base[512] = { 'r', 'e', 'g', 'f' };
+				_put32(base + 0x04, 1);
+				_put32(base + 0x08, 1);
+				_put64(base + 0x0C, _now);
+				_put32(base + 0x14, 1);   // version 1.5
+				_put32(base + 0x18, 5);
+				_put32(base + 0x20, 1);   // direct memory load
+				_put32(base + 0x24, _root);
+				_put32(base + 0x28, _pos);
+				_put32(base + 0x2C, 1);
+				uint32_t checksum = 0;
+				for(size_t i = 0; i < 0x1FC; i += 4)
+					checksum ^= _le32(base + i);
+				_put32(base + 0x1FC, checksum == 0 ? 1 : checksum == 0xFFFFFFFF ? 0xFFFFFFFE : checksum);
+				_patch(0, base, sizeof(base));
+
+				bool ok = !_failed;
+				if(_file != nullptr) {
+					ok = ok && std::fwrite(_out->data(), 1, _out->size(), _file) == _out->size();
+					ok = std::fclose(_file) == 0 && ok;
+				}
+				_file = nullptr;
+				_out = nullptr;
+				_local.clear();
+				_local.shrink_to_fit();
+				_sk_ids.clear();
+				_sks.clear();
+				return ok;
+			}
+
+		private:
+
+			void _start() {
+				_flushed = 0;
+				_pos = 0;
+				_hbin_end = 0;
+				_root = __regedit_details::regf::no_cell;
+				_failed = false;
+				_sk_ids.clear();
+				_sks.clear();
+				_now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count() + 11644473600ll) * 10000000ull;
+				_fill(_hbin); // base block, written at close()
+			}
+
+	};
+
+	// writes a whole tree as a hive file
+	template<class Backend>
+	bool write_hive(const basic_regedit<Backend>& tree, const std::string& path, const std::string& root_name = "") {
+		hive_writer writer(path);
+		bool ok = writer.write(tree, root_name);
+		return writer.close() && ok;
+	}
+
+	// rewrites a hive with its cells packed in DFS order, dropping the free and unreferenced cells
+	inline bool compact_hive(const std::string& src, const std::string& dst) {
+		regedit_backend::hive::file file(src);
+		if(!file.is_open())
+			return false;
+		return write_hive(basic_regedit<regedit_backend::hive>(file.root()), dst);
+	}
+
+	using hive_regedit = basic_regedit<regedit_backend::_default<regedit_backend::hive>>;
+
+
+}
+
+
+
+#endif
+
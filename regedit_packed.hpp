@@ -0,0 +1,767 @@
+#pragma once
+
+#ifndef __NEO_REGEDIT_PACKED_HPP__
+#define __NEO_REGEDIT_PACKED_HPP__
+
+
+/*
+	Header name: regedit_packed.hpp
+	Author: neo3587
+
+	Notes:
+		- Packed snapshots : a whole tree dumped by write_packed() / pack() into one flat file, then memory mapped as a read only
+			neo::packed_regedit, meant for the configuration loaded at startup
+		- Layout (version 1, little endian) : header, key table, value table, names, value data, lookup table. The subkeys and the values
+			of a key are contiguous records sorted by name (same case insensitive order than neo::names), enumerating is indexing them and
+			every lookup goes through one hash table of (parent, name), nothing is parsed nor allocated after open()
+		- open() checks every record once (bounds, names, parents before children), the lookups only check the table entry they hit
+		- Read only, every write operation returns status::access_denied. The data is stored as the source backend returned it
+			(narrow strings), value_view() / key_name() / value_name() give views into the mapping
+*/
+
+
+
+#include "regedit.hpp"
+#include <algorithm>
+#include <cstdio>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+
+namespace neo {
+
+	namespace __regedit_details {
+
+		namespace packfmt {
+
+			constexpr uint16_t version     = 1;
+			constexpr size_t   header_size = 64;
+			constexpr size_t   record_size = 24; // keys and values
+			constexpr size_t   slot_size   = 8;
+			constexpr uint32_t no_ref      = 0xFFFFFFFF;
+			constexpr uint32_t value_ref   = 0x80000000; // slot ref bit, value record instead of key record
+
+			// header
+			constexpr size_t h_magic       = 0x00; // "RGPK"
+			constexpr size_t h_version     = 0x04;
+			constexpr size_t h_size        = 0x08; // whole file
+			constexpr size_t h_keys        = 0x0C;
+			constexpr size_t h_values      = 0x10;
+			constexpr size_t h_key_table   = 0x14;
+			constexpr size_t h_value_table = 0x18;
+			constexpr size_t h_names       = 0x1C;
+			constexpr size_t h_names_size  = 0x20;
+			constexpr size_t h_data        = 0x24;
+			constexpr size_t h_data_size   = 0x28;
+			constexpr size_t h_table       = 0x2C; // hashed lookup of every key and value by parent and name
+			constexpr size_t h_table_slots = 0x30; // power of 2
+
+			// table slot : 32 bits of the hash, then the record (no_ref when empty), linear probing
+
+			// key record, the root is the first one
+			constexpr size_t k_name        = 0x00; // offset on the names, null terminated
+			constexpr size_t k_name_len    = 0x04;
+			constexpr size_t k_first_key   = 0x08;
+			constexpr size_t k_keys        = 0x0C;
+			constexpr size_t k_first_value = 0x10;
+			constexpr size_t k_values      = 0x14;
+
+			// value record
+			constexpr size_t v_name        = 0x00;
+			constexpr size_t v_name_len    = 0x04;
+			constexpr size_t v_type        = 0x08;
+			constexpr size_t v_data        = 0x0C; // offset on the data, 8 bytes aligned
+			constexpr size_t v_data_len    = 0x10;
+
+			inline uint32_t _le32(const BYTE* p) {
+				return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+			}
+			inline void _put32(BYTE* p, uint32_t v) {
+				p[0] = static_cast<BYTE>(v);
+				p[1] = static_cast<BYTE>(v >> 8);
+				p[2] = static_cast<BYTE>(v >> 16);
+				p[3] = static_cast<BYTE>(v >> 24);
+			}
+			inline void _align8(std::vector<BYTE>& buff) {
+				buff.resize((buff.size() + 7) & ~static_cast<size_t>(7));
+			}
+
+			// case insensitive name hash of a child of the key 'parent'
+			inline uint64_t _hash(uint32_t parent, const char* name, size_t len) {
+				return names::_mix(names::hash(name, len), static_cast<uint64_t>(parent) + 1);
+			}
+
+		}
+
+	}
+
+	namespace regedit_backend {
+
+		class packed {
+
+			private:
+
+				using DWORD = __regedit_details::DWORD;
+				using BYTE  = __regedit_details::BYTE;
+
+			public:
+
+				class file;
+
+				struct handle {
+					const file* owner = nullptr;
+					uint32_t key = static_cast<uint32_t>(-1);
+					bool operator==(const handle& other) const {
+						return owner == other.owner && key == other.key;
+					}
+					bool operator!=(const handle& other) const {
+						return !(*this == other);
+					}
+				};
+				struct hkey {}; // no predefined roots, use file::root()
+
+				class file {
+
+					private:
+
+						const BYTE* _base = nullptr;
+						size_t _size = 0;
+						bool _mapped = false;
+						#ifdef _WIN32
+						HANDLE _file = INVALID_HANDLE_VALUE;
+						HANDLE _map = NULL;
+						#endif
+
+						uint32_t _key_count = 0, _value_count = 0;
+						const BYTE* _keys = nullptr;
+						const BYTE* _values = nullptr;
+						const char* _names = nullptr;
+						const BYTE* _data = nullptr;
+						const BYTE* _table = nullptr;
+						uint32_t _slots = 0;
+
+						bool _section(size_t off, size_t bytes) const {
+							return off <= _size && bytes <= _size - off;
+						}
+						bool _name(uint32_t off, uint32_t len, size_t names_size) const {
+							return static_cast<size_t>(off) + len < names_size && _names[off + len] == '\0';
+						}
+
+						bool _load() {
+							using namespace __regedit_details::packfmt;
+							if(_size < header_size || memcmp(_base + h_magic, "RGPK", 4) != 0 || (_base[h_version] | (_base[h_version + 1] << 8)) != version
+							|| _le32(_base + h_size) != _size) {
+								close();
+								return false;
+							}
+							_key_count = _le32(_base + h_keys);
+							_value_count = _le32(_base + h_values);
+							size_t names_size = _le32(_base + h_names_size), data_size = _le32(_base + h_data_size);
+							if(_key_count == 0 || !_section(_le32(_base + h_key_table), static_cast<size_t>(_key_count) * record_size)
+							|| !_section(_le32(_base + h_value_table), static_cast<size_t>(_value_count) * record_size)
+							|| !_section(_le32(_base + h_names), names_size) || !_section(_le32(_base + h_data), data_size)
+							|| (_slots = _le32(_base + h_table_slots)) == 0 || (_slots & (_slots - 1)) != 0 || !_section(_le32(_base + h_table), static_cast<size_t>(_slots) * slot_size)) {
+								close();
+								return false;
+							}
+							_keys = _base + _le32(_base + h_key_table);
+							_values = _base + _le32(_base + h_value_table);
+							_names = reinterpret_cast<const char*>(_base + _le32(_base + h_names));
+							_data = _base + _le32(_base + h_data);
+							_table = _base + _le32(_base + h_table);
+							bool ok = true;
+							for(uint32_t i = 0; i < _key_count && ok; ++i) {
+								const BYTE* k = _keys + static_cast<size_t>(i) * record_size;
+								uint32_t first = _le32(k + k_first_key), count = _le32(k + k_keys);
+								uint32_t vfirst = _le32(k + k_first_value), vcount = _le32(k + k_values);
+								ok = _name(_le32(k + k_name), _le32(k + k_name_len), names_size)
+									&& (count == 0 || (first > i && first <= _key_count && count <= _key_count - first)) // children after their parent, no cycles
+									&& vfirst <= _value_count && vcount <= _value_count - vfirst;
+							}
+							for(uint32_t i = 0; i < _value_count && ok; ++i) {
+								const BYTE* v = _values + static_cast<size_t>(i) * record_size;
+								uint32_t off = _le32(v + v_data), len = _le32(v + v_data_len);
+								ok = _name(_le32(v + v_name), _le32(v + v_name_len), names_size) && off <= data_size && len <= data_size - off;
+							}
+							if(!ok)
+								close();
+							return ok;
+						}
+
+						friend packed;
+
+					public:
+
+						file() {}
+						file(const std::string& path) {
+							open(path);
+						}
+						file(const void* data, size_t size) {
+							open(data, size);
+						}
+						file(const file&) = delete;
+						file& operator=(const file&) = delete;
+
+						~file() {
+							close();
+						}
+
+						// maps a packed snapshot
+						bool open(const std::string& path) {
+							close();
+							#ifdef _WIN32
+							_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+							if(_file == INVALID_HANDLE_VALUE)
+								return false;
+							LARGE_INTEGER size;
+							if(!GetFileSizeEx(_file, &size) || size.QuadPart == 0 || (_map = CreateFileMappingA(_file, NULL, PAGE_READONLY, 0, 0, NULL)) == NULL) {
+								close();
+								return false;
+							}
+							_base = static_cast<const BYTE*>(MapViewOfFile(_map, FILE_MAP_READ, 0, 0, 0));
+							_size = static_cast<size_t>(size.QuadPart);
+							#else
+							int fd = ::open(path.c_str(), O_RDONLY);
+							if(fd < 0)
+								return false;
+							struct stat st;
+							void* ptr = MAP_FAILED;
+							if(fstat(fd, &st) == 0 && st.st_size > 0)
+								ptr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+							::close(fd);
+							_base = ptr != MAP_FAILED ? static_cast<const BYTE*>(ptr) : nullptr;
+							_size = ptr != MAP_FAILED ? static_cast<size_t>(st.st_size) : 0;
+							#endif
+							_mapped = true;
+							if(_base == nullptr) {
+								close();
+								return false;
+							}
+							return _load();
+						}
+						// uses an already loaded snapshot, it must outlive the file
+						bool open(const void* data, size_t size) {
+							close();
+							_base = static_cast<const BYTE*>(data);
+							_size = size;
+							return _base != nullptr && _load();
+						}
+
+						void close() {
+							if(_mapped && _base != nullptr) {
+								#ifdef _WIN32
+								UnmapViewOfFile(_base);
+								#else
+								munmap(const_cast<BYTE*>(_base), _size);
+								#endif
+							}
+							#ifdef _WIN32
+							if(_map != NULL)
+								CloseHandle(_map);
+							if(_file != INVALID_HANDLE_VALUE)
+								CloseHandle(_file);
+							_map = NULL;
+							_file = INVALID_HANDLE_VALUE;
+							#endif
+							_base = nullptr;
+							_size = 0;
+							_mapped = false;
+							_key_count = _value_count = 0;
+							_keys = _values = _data = _table = nullptr;
+							_names = nullptr;
+							_slots = 0;
+						}
+
+						bool is_open() const {
+							return _base != nullptr;
+						}
+
+						handle root() const {
+							handle hk;
+							if(is_open()) {
+								hk.owner = this;
+								hk.key = 0;
+							}
+							return hk;
+						}
+
+						const BYTE* data() const {
+							return _base;
+						}
+						size_t size() const {
+							return _size;
+						}
+
+				};
+
+			private:
+
+				static const BYTE* _key(handle hk) {
+					return hk.owner != nullptr && hk.key < hk.owner->_key_count ? hk.owner->_keys + static_cast<size_t>(hk.key) * __regedit_details::packfmt::record_size : nullptr;
+				}
+				static const BYTE* _value_at(handle hk, const BYTE* k, DWORD pos) {
+					using namespace __regedit_details::packfmt;
+					return pos < _le32(k + k_values) ? hk.owner->_values + (static_cast<size_t>(_le32(k + k_first_value)) + pos) * record_size : nullptr;
+				}
+				// position of the subkey (or value) 'name' among the ones of the key record 'k', -1 if none
+				static uint32_t _lookup(handle hk, const BYTE* k, const char* name, size_t len, bool value) {
+					using namespace __regedit_details::packfmt;
+					const file* f = hk.owner;
+					uint32_t first = _le32(k + (value ? k_first_value : k_first_key)), count = _le32(k + (value ? k_values : k_keys));
+					if(count == 0)
+						return no_ref;
+					uint64_t h = _hash(hk.key, name, len);
+					uint32_t tag = static_cast<uint32_t>(h >> 32), mask = f->_slots - 1;
+					for(uint32_t i = static_cast<uint32_t>(h) & mask, probes = 0; probes < f->_slots; i = (i + 1) & mask, ++probes) {
+						const BYTE* slot = f->_table + static_cast<size_t>(i) * slot_size;
+						uint32_t ref = _le32(slot + 4);
+						if(ref == no_ref)
+							break;
+						if(_le32(slot) != tag || ((ref & value_ref) != 0) != value)
+							continue;
+						uint32_t pos = (ref & ~value_ref) - first;
+						if(pos >= count) // another key, or a broken reference (the table isn't checked by open())
+							continue;
+						const BYTE* rec = (value ? f->_values : f->_keys) + static_cast<size_t>(ref & ~value_ref) * record_size;
+						if(__regedit_details::names::eq(f->_names + _le32(rec), _le32(rec + 4), name, len))
+							return pos;
+					}
+					return no_ref;
+				}
+				static const BYTE* _find_value(handle hk, const BYTE* k, const char* name, DWORD* pos) {
+					using namespace __regedit_details::packfmt;
+					uint32_t i = _lookup(hk, k, name, strlen(name), true);
+					if(i == no_ref)
+						return nullptr;
+					if(pos != nullptr)
+						*pos = i;
+					return hk.owner->_values + (static_cast<size_t>(_le32(k + k_first_value)) + i) * record_size;
+				}
+
+				// record name into a caller buffer, RegEnumKeyExA rules
+				static long _copy_name(const file* f, const BYTE* rec, char* name, DWORD* len) {
+					using namespace __regedit_details::packfmt;
+					uint32_t size = _le32(rec + 4);
+					if(*len <= size)
+						return __regedit_details::status::more_data;
+					memcpy(name, f->_names + _le32(rec), size + 1);
+					*len = size;
+					return __regedit_details::status::success;
+				}
+				// RegQueryValueExA rules for data / len
+				static long _read_data(const file* f, const BYTE* v, BYTE* data, DWORD* len) {
+					using namespace __regedit_details::packfmt;
+					DWORD size = _le32(v + v_data_len);
+					if(data != nullptr) {
+						if(len == nullptr)
+							return __regedit_details::status::invalid_parameter;
+						if(*len < size) {
+							*len = size;
+							return __regedit_details::status::more_data;
+						}
+						memcpy(data, f->_data + _le32(v + v_data), size);
+					}
+					if(len != nullptr)
+						*len = size;
+					return __regedit_details::status::success;
+				}
+
+			public:
+
+				static long open(handle parent, const char* key, bool /*write*/, handle* out) {
+					using namespace __regedit_details::packfmt;
+					if(_key(parent) == nullptr)
+						return __regedit_details::status::invalid_handle;
+					handle hk = parent;
+					for(const char* p = key != nullptr ? key : ""; ; ) {
+						const char* end = p;
+						while(*end != '\\' && *end != '\0')
+							++end;
+						if(end != p) {
+							const BYTE* k = _key(hk);
+							uint32_t i = _lookup(hk, k, p, end - p, false);
+							if(i == no_ref)
+								return __regedit_details::status::file_not_found;
+							hk.key = _le32(k + k_first_key) + i;
+						}
+						if(*end == '\0')
+							break;
+						p = end + 1;
+					}
+					*out = hk;
+					return __regedit_details::status::success;
+				}
+				static long create(handle parent, const char* key, bool write, handle* out, bool* created) { // only opens existing keys
+					long ret = open(parent, key, write, out);
+					if(created != nullptr)
+						*created = false;
+					return ret == __regedit_details::status::file_not_found ? __regedit_details::status::access_denied : ret;
+				}
+				static void close(handle /*hk*/) {}
+
+				static long query_info(handle hk, DWORD* subkeys, DWORD* values) {
+					const BYTE* k = _key(hk);
+					if(k == nullptr)
+						return __regedit_details::status::invalid_handle;
+					if(subkeys != nullptr)
+						*subkeys = __regedit_details::packfmt::_le32(k + __regedit_details::packfmt::k_keys);
+					if(values != nullptr)
+						*values = __regedit_details::packfmt::_le32(k + __regedit_details::packfmt::k_values);
+					return __regedit_details::status::success;
+				}
+				// the lengths come from a pass over the child records, the file never changes (stamp 0)
+				static long query_key_info(handle hk, __regedit_details::key_info* info) {
+					using namespace __regedit_details::packfmt;
+					const BYTE* k = _key(hk);
+					if(k == nullptr)
+						return __regedit_details::status::invalid_handle;
+					*info = __regedit_details::key_info();
+					info->subkeys = _le32(k + k_keys);
+					info->values = _le32(k + k_values);
+					const BYTE* rec = hk.owner->_keys + static_cast<size_t>(_le32(k + k_first_key)) * record_size;
+					for(DWORD i = 0; i < info->subkeys; ++i, rec += record_size)
+						info->max_key_name = (std::max<DWORD>)(info->max_key_name, _le32(rec + k_name_len));
+					for(DWORD i = 0; i < info->values; ++i) {
+						const BYTE* v = _value_at(hk, k, i);
+						info->max_value_name = (std::max<DWORD>)(info->max_value_name, _le32(v + v_name_len));
+						info->max_value_data = (std::max<DWORD>)(info->max_value_data, _le32(v + v_data_len));
+					}
+					return __regedit_details::status::success;
+				}
+				static long enum_key(handle hk, DWORD pos, char* name, DWORD* len) {
+					using namespace __regedit_details::packfmt;
+					const BYTE* k = _key(hk);
+					if(k == nullptr)
+						return __regedit_details::status::invalid_handle;
+					if(pos >= _le32(k + k_keys))
+						return __regedit_details::status::no_more_items;
+					return _copy_name(hk.owner, hk.owner->_keys + (static_cast<size_t>(_le32(k + k_first_key)) + pos) * record_size, name, len);
+				}
+				static long enum_value(handle hk, DWORD pos, char* name, DWORD* len, DWORD* ty = nullptr, DWORD* size = nullptr) {
+					using namespace __regedit_details::packfmt;
+					const BYTE* k = _key(hk);
+					if(k == nullptr)
+						return __regedit_details::status::invalid_handle;
+					const BYTE* v = _value_at(hk, k, pos);
+					if(v == nullptr)
+						return __regedit_details::status::no_more_items;
+					if(ty != nullptr)
+						*ty = _le32(v + v_type);
+					if(size != nullptr)
+						*size = _le32(v + v_data_len);
+					return _copy_name(hk.owner, v, name, len);
+				}
+				static long enum_data(handle hk, DWORD pos, char* name, DWORD* len, DWORD* ty, BYTE* data, DWORD* size) {
+					using namespace __regedit_details::packfmt;
+					const BYTE* k = _key(hk);
+					if(k == nullptr)
+						return __regedit_details::status::invalid_handle;
+					const BYTE* v = _value_at(hk, k, pos);
+					if(v == nullptr)
+						return __regedit_details::status::no_more_items;
+					long ret = _copy_name(hk.owner, v, name, len);
+					if(ret != __regedit_details::status::success)
+						return ret;
+					if(ty != nullptr)
+						*ty = _le32(v + v_type);
+					return _read_data(hk.owner, v, data, size);
+				}
+				static long find_key(handle hk, const char* name, DWORD* pos) {
+					using namespace __regedit_details::packfmt;
+					const BYTE* k = _key(hk);
+					if(k == nullptr)
+						return __regedit_details::status::invalid_handle;
+					uint32_t i = _lookup(hk, k, name, strlen(name), false);
+					if(i == no_ref)
+						return __regedit_details::status::file_not_found;
+					*pos = i;
+					return __regedit_details::status::success;
+				}
+				static long find_value(handle hk, const char* name, DWORD* pos) {
+					const BYTE* k = _key(hk);
+					if(k == nullptr)
+						return __regedit_details::status::invalid_handle;
+					return _find_value(hk, k, name != nullptr ? name : "", pos) != nullptr ? __regedit_details::status::success : __regedit_details::status::file_not_found;
+				}
+
+				static long query_value(handle hk, const char* name, DWORD* ty, BYTE* data, DWORD* len) {
+					const BYTE* k = _key(hk);
+					if(k == nullptr)
+						return __regedit_details::status::invalid_handle;
+					const BYTE* v = _find_value(hk, k, name != nullptr ? name : "", nullptr);
+					if(v == nullptr)
+						return __regedit_details::status::file_not_found;
+					if(ty != nullptr)
+						*ty = __regedit_details::packfmt::_le32(v + __regedit_details::packfmt::v_type);
+					return _read_data(hk.owner, v, data, len);
+				}
+				static long set_value(handle, const char*, DWORD, const BYTE*, DWORD) {
+					return __regedit_details::status::access_denied;
+				}
+				static long set_value_unicode(handle, const char*, DWORD, const BYTE*, DWORD) {
+					return __regedit_details::status::access_denied;
+				}
+				static long delete_value(handle, const char*) {
+					return __regedit_details::status::access_denied;
+				}
+				static long delete_tree(handle, const char*) {
+					return __regedit_details::status::access_denied;
+				}
+
+				// Zero-copy access:
+
+				static __regedit_details::str_view key_name(handle hk, DWORD pos) {
+					using namespace __regedit_details::packfmt;
+					const BYTE* k = _key(hk);
+					if(k == nullptr || pos >= _le32(k + k_keys))
+						return __regedit_details::str_view();
+					const BYTE* sub = hk.owner->_keys + (static_cast<size_t>(_le32(k + k_first_key)) + pos) * record_size;
+					return __regedit_details::str_view(hk.owner->_names + _le32(sub), _le32(sub + 4));
+				}
+				static __regedit_details::str_view value_name(handle hk, DWORD pos) {
+					using namespace __regedit_details::packfmt;
+					const BYTE* k = _key(hk);
+					const BYTE* v = k != nullptr ? _value_at(hk, k, pos) : nullptr;
+					return v != nullptr ? __regedit_details::str_view(hk.owner->_names + _le32(v), _le32(v + 4)) : __regedit_details::str_view();
+				}
+				// the data on the mapping, false if the value doesn't exists
+				static bool value_view(handle hk, const char* name, DWORD* ty, const BYTE** data, DWORD* len) {
+					using namespace __regedit_details::packfmt;
+					const BYTE* k = _key(hk);
+					const BYTE* v = k != nullptr ? _find_value(hk, k, name != nullptr ? name : "", nullptr) : nullptr;
+					if(v == nullptr)
+						return false;
+					if(ty != nullptr)
+						*ty = _le32(v + v_type);
+					*data = hk.owner->_data + _le32(v + v_data);
+					*len = _le32(v + v_data_len);
+					return true;
+				}
+
+		};
+
+	}
+
+	namespace __regedit_details {
+
+		template<class Backend>
+		class packer {
+
+			private:
+
+				std::vector<BYTE> _keys, _values, _names, _data;
+				std::vector<char> _name = std::vector<char>(16384 * 3 + 1);
+				read_overload::_buffer _buff;
+				uint32_t _key_count = 0, _value_count = 0;
+
+				struct _entry {
+					uint32_t name, len;
+				};
+
+				uint32_t _add_name(const char* name, size_t len) {
+					uint32_t off = static_cast<uint32_t>(_names.size());
+					_names.insert(_names.end(), name, name + len);
+					_names.push_back('\0');
+					return off;
+				}
+				template<class Entry>
+				void _sort(std::vector<Entry>& entries) const {
+					const char* names = reinterpret_cast<const char*>(_names.data());
+					std::sort(entries.begin(), entries.end(), [names](const Entry& x, const Entry& y) {
+						return names::cmp(names + x.name, x.len, names + y.name, y.len) < 0;
+					});
+				}
+				BYTE* _record(std::vector<BYTE>& table, uint32_t pos) {
+					return table.data() + static_cast<size_t>(pos) * packfmt::record_size;
+				}
+
+				// every subkey and value hashed by parent and name, at most 2/3 full
+				std::vector<BYTE> _hash_table() {
+					using namespace packfmt;
+					uint32_t slots = 8;
+					while(slots < (static_cast<uint64_t>(_key_count) + _value_count) * 3 / 2)
+						slots <<= 1;
+					std::vector<BYTE> table(static_cast<size_t>(slots) * slot_size, 0xFF);
+					const char* names = reinterpret_cast<const char*>(_names.data());
+					auto insert = [&](uint32_t parent, const BYTE* rec, uint32_t ref) {
+						uint64_t h = _hash(parent, names + _le32(rec), _le32(rec + 4));
+						uint32_t i = static_cast<uint32_t>(h) & (slots - 1);
+						while(_le32(table.data() + static_cast<size_t>(i) * slot_size + 4) != no_ref)
+							i = (i + 1) & (slots - 1);
+						_put32(table.data() + static_cast<size_t>(i) * slot_size, static_cast<uint32_t>(h >> 32));
+						_put32(table.data() + static_cast<size_t>(i) * slot_size + 4, ref);
+					};
+					for(uint32_t k = 0; k < _key_count; ++k) {
+						const BYTE* rec = _record(_keys, k);
+						for(uint32_t i = _le32(rec + k_first_key), e = i + _le32(rec + k_keys); i < e; ++i)
+							insert(k, _record(_keys, i), i);
+						for(uint32_t i = _le32(rec + k_first_value), e = i + _le32(rec + k_values); i < e; ++i)
+							insert(k, _record(_values, i), i | value_ref);
+					}
+					return table;
+				}
+
+				// the record 'self' is already there, its subkeys get contiguous records before going down
+				bool _key(typename Backend::handle hk, uint32_t self) {
+					using namespace packfmt;
+					bool ok = true;
+					DWORD keys = 0, vals = 0;
+					if(Backend::query_info(hk, &keys, &vals) != status::success)
+						return false;
+
+					struct _value : _entry {
+						DWORD ty;
+						uint32_t data, size;
+					};
+					std::vector<_value> values;
+					values.reserve(vals);
+					for(DWORD pos = 0; pos < vals; ++pos) {
+						DWORD ty = 0, len = 0;
+						if(_enum_data<Backend>(hk, pos, _name.data(), static_cast<DWORD>(_name.size()), &ty, _buff, &len, _has_enum_data<Backend>()) != status::success) {
+							ok = false;
+							continue;
+						}
+						_value v;
+						v.len = static_cast<uint32_t>(strlen(_name.data()));
+						v.name = _add_name(_name.data(), v.len);
+						v.ty = ty;
+						_align8(_data);
+						v.data = static_cast<uint32_t>(_data.size());
+						v.size = len;
+						_data.insert(_data.end(), _buff.data(), _buff.data() + len);
+						values.push_back(v);
+					}
+					_sort(values);
+					_put32(_record(_keys, self) + k_first_value, _value_count);
+					_put32(_record(_keys, self) + k_values, static_cast<uint32_t>(values.size()));
+					_values.resize(_values.size() + values.size() * record_size);
+					for(const _value& v : values) {
+						BYTE* rec = _record(_values, _value_count++);
+						_put32(rec + v_name, v.name);
+						_put32(rec + v_name_len, v.len);
+						_put32(rec + v_type, v.ty);
+						_put32(rec + v_data, v.data);
+						_put32(rec + v_data_len, v.size);
+					}
+
+					std::vector<_entry> subkeys;
+					subkeys.reserve(keys);
+					for(DWORD pos = 0; pos < keys; ++pos) {
+						DWORD nlen = static_cast<DWORD>(_name.size());
+						if(Backend::enum_key(hk, pos, _name.data(), &nlen) != status::success) {
+							ok = false;
+							continue;
+						}
+						_entry e;
+						e.len = nlen;
+						e.name = _add_name(_name.data(), nlen);
+						subkeys.push_back(e);
+					}
+					_sort(subkeys);
+					uint32_t first = _key_count;
+					_put32(_record(_keys, self) + k_first_key, first);
+					_put32(_record(_keys, self) + k_keys, static_cast<uint32_t>(subkeys.size()));
+					_key_count += static_cast<uint32_t>(subkeys.size());
+					_keys.resize(static_cast<size_t>(_key_count) * record_size);
+					for(size_t i = 0; i < subkeys.size(); ++i) {
+						BYTE* rec = _record(_keys, first + static_cast<uint32_t>(i));
+						_put32(rec + k_name, subkeys[i].name);
+						_put32(rec + k_name_len, subkeys[i].len);
+					}
+					for(size_t i = 0; i < subkeys.size(); ++i) {
+						typename Backend::handle sub;
+						const char* name = reinterpret_cast<const char*>(_names.data()) + subkeys[i].name;
+						if(Backend::open(hk, name, false, &sub) != status::success) {
+							ok = false;
+							continue;
+						}
+						ok = _key(sub, first + static_cast<uint32_t>(i)) && ok;
+						Backend::close(sub);
+					}
+					return ok;
+				}
+
+			public:
+
+				bool run(typename Backend::handle root, std::vector<BYTE>& out) {
+					using namespace packfmt;
+					_key_count = 1;
+					_keys.assign(record_size, 0);
+					_put32(_keys.data() + k_name, _add_name("", 0));
+					bool ok = _key(root, 0);
+
+					out.assign(header_size, 0);
+					size_t key_table = out.size();
+					out.insert(out.end(), _keys.begin(), _keys.end());
+					_align8(out);
+					size_t value_table = out.size();
+					out.insert(out.end(), _values.begin(), _values.end());
+					size_t names = out.size();
+					out.insert(out.end(), _names.begin(), _names.end());
+					_align8(out);
+					size_t data = out.size();
+					out.insert(out.end(), _data.begin(), _data.end());
+					_align8(out);
+					size_t table = out.size();
+					std::vector<BYTE> slots = _hash_table();
+					out.insert(out.end(), slots.begin(), slots.end());
+					if(out.size() > 0xFFFFFFFFull)
+						return false;
+
+					memcpy(out.data() + h_magic, "RGPK", 4);
+					out[h_version] = static_cast<BYTE>(version);
+					out[h_version + 1] = static_cast<BYTE>(version >> 8);
+					_put32(out.data() + h_size, static_cast<uint32_t>(out.size()));
+					_put32(out.data() + h_keys, _key_count);
+					_put32(out.data() + h_values, _value_count);
+					_put32(out.data() + h_key_table, static_cast<uint32_t>(key_table));
+					_put32(out.data() + h_value_table, static_cast<uint32_t>(value_table));
+					_put32(out.data() + h_names, static_cast<uint32_t>(names));
+					_put32(out.data() + h_names_size, static_cast<uint32_t>(_names.size()));
+					_put32(out.data() + h_data, static_cast<uint32_t>(data));
+					_put32(out.data() + h_data_size, static_cast<uint32_t>(_data.size()));
+					_put32(out.data() + h_table, static_cast<uint32_t>(table));
+					_put32(out.data() + h_table_slots, static_cast<uint32_t>(slots.size() / slot_size));
+					return ok;
+				}
+
+		};
+
+	}
+
+	// the whole tree as a packed snapshot on 'out', false if some key or value couldn't be read (the rest is still packed)
+	template<class Backend>
+	bool pack(const basic_regedit<Backend>& tree, std::vector<__regedit_details::BYTE>& out) {
+		out.clear();
+		if(!tree.is_open())
+			return false;
+		__regedit_details::packer<Backend> p;
+		return p.run(tree.native_handle(), out);
+	}
+
+	// writes a whole tree as a packed snapshot file
+	template<class Backend>
+	bool write_packed(const basic_regedit<Backend>& tree, const std::string& path) {
+		std::vector<__regedit_details::BYTE> buff;
+		bool ok = pack(tree, buff);
+		if(buff.empty())
+			return false;
+		std::FILE* f = std::fopen(path.c_str(), "wb");
+		if(f == nullptr)
+			return false;
+		ok = std::fwrite(buff.data(), 1, buff.size(), f) == buff.size() && ok;
+		return std::fclose(f) == 0 && ok;
+	}
+
+	using packed_regedit = basic_regedit<regedit_backend::_default<regedit_backend::packed>>;
+
+}
+
+
+
+#endif
@@ -0,0 +1,849 @@
+#pragma once
+
+#ifndef __NEO_REGEDIT_REG_HPP__
+#define __NEO_REGEDIT_REG_HPP__
+
+
+/*
+	Header name: regedit_reg.hpp
+	Author: neo3587
+
+	Notes:
+		- .reg files for neo::basic_regedit : "REGEDIT4" (ANSI) and "Windows Registry Editor Version 5.00" (UTF-16LE as regedit.exe writes them, or UTF-8)
+		- neo::reg_reader streams the file through a fixed size window, only the current line (or the data of the current wrapped hex value) is kept besides it
+		- read() with threads > 1 splits the file at the key sections ("[...]" lines) and parses them in parallel,
+			the entries are still given in file order and from the calling thread
+		- The entries carry the data as the backends store it : narrow strings (UTF-8 from v5 files, ANSI from REGEDIT4), hex(1) / hex(2) / hex(7) data
+			of v5 files is converted from UTF-16LE likewise, any other type is kept raw
+		- neo::reg_writer / export_reg() write the same layout than regedit.exe : CRLF, hex data wrapped at 80 columns, strings for sz and dword:xxxxxxxx
+		- import_reg() applies a file over any tree, "[-key]" deletes the subtree and "name"=- deletes the value
+*/
+
+
+
+#include "regedit.hpp"
+#include <cstdio>
+#include <thread>
+
+
+
+namespace neo {
+
+	enum class reg_format {
+		regedit4, // REGEDIT4, ANSI text
+		unicode,  // Windows Registry Editor Version 5.00, UTF-16LE text
+		utf8      // Windows Registry Editor Version 5.00, UTF-8 text (hex(2) / hex(7) data is still UTF-16LE)
+	};
+
+	struct reg_entry {
+		enum class kind { key, delete_key, value, delete_value };
+		kind what = kind::key;
+		std::string path; // full path of the current key, as written on the file
+		std::string name; // value name, "" for the default value (@)
+		__regedit_details::type ty = __regedit_details::type::none;
+		std::vector<__regedit_details::BYTE> data;
+	};
+
+	namespace __regedit_details {
+
+		namespace regtext {
+
+			constexpr const char* header_v4 = "REGEDIT4";
+			constexpr const char* header_v5 = "Windows Registry Editor Version 5.00";
+
+			struct _hex_table {
+				int8_t val[256];
+				char pair[256][2];
+				_hex_table() {
+					memset(val, -1, sizeof(val));
+					for(int i = 0; i < 10; ++i)
+						val['0' + i] = static_cast<int8_t>(i);
+					for(int i = 0; i < 6; ++i)
+						val['a' + i] = val['A' + i] = static_cast<int8_t>(10 + i);
+					for(int i = 0; i < 256; ++i) {
+						pair[i][0] = "0123456789abcdef"[i >> 4];
+						pair[i][1] = "0123456789abcdef"[i & 15];
+					}
+				}
+				static const _hex_table& get() {
+					static const _hex_table table;
+					return table;
+				}
+			};
+
+			#ifdef REGEDIT_SSE2
+			// 16 "xx," triplets at once, false if the 48 chars don't follow that layout exactly
+			inline bool _hex48(const char* p, BYTE* out) {
+				static const int commas[3] = { 0x4924, 0x2492, 0x9249 };
+				alignas(16) uint8_t nib[48];
+				for(int k = 0; k < 3; ++k) {
+					__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + k * 16));
+					__m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+					__m128i l = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+					__m128i is_d = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+					__m128i is_l = _mm_cmpeq_epi8(_mm_min_epu8(l, _mm_set1_epi8(5)), l);
+					int sep = _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8(',')));
+					if(sep != commas[k] || (_mm_movemask_epi8(_mm_or_si128(is_d, is_l)) | sep) != 0xFFFF)
+						return false;
+					__m128i n = _mm_or_si128(_mm_and_si128(is_d, d), _mm_and_si128(is_l, _mm_add_epi8(l, _mm_set1_epi8(10))));
+					_mm_store_si128(reinterpret_cast<__m128i*>(nib + k * 16), n);
+				}
+				for(int i = 0; i < 16; ++i)
+					out[i] = static_cast<BYTE>((nib[i * 3] << 4) | nib[i * 3 + 1]);
+				return true;
+			}
+			#endif
+
+			// appends the bytes of a "xx,xx,..." line, 'more' tells if it continues on the next line (ends with '\')
+			inline bool _hex_decode(const char* p, const char* e, std::vector<BYTE>& out, bool& more) {
+				while(e > p && (e[-1] == ' ' || e[-1] == '\t'))
+					--e;
+				more = e > p && e[-1] == '\\';
+				if(more)
+					--e;
+				const int8_t* val = _hex_table::get().val;
+				size_t base = out.size();
+				out.resize(base + static_cast<size_t>(e - p) / 2 + 1);
+				BYTE* o = out.data() + base;
+				while(p < e) {
+					#ifdef REGEDIT_SSE2
+					if(e - p >= 48 && _hex48(p, o)) {
+						p += 48;
+						o += 16;
+						continue;
+					}
+					#endif
+					int hi = val[static_cast<unsigned char>(*p)];
+					if(hi < 0) {
+						if(*p != ',' && *p != ' ' && *p != '\t')
+							return false;
+						++p;
+						continue;
+					}
+					int lo = p + 1 < e ? val[static_cast<unsigned char>(p[1])] : -1;
+					if(lo < 0)
+						return false;
+					*o++ = static_cast<BYTE>((hi << 4) | lo);
+					p += 2;
+				}
+				out.resize(static_cast<size_t>(o - out.data()));
+				return true;
+			}
+
+			// a quoted string from the char after the opening quote, "\\" and "\"" escaped, returns the char after the closing quote
+			inline const char* _unquote(const char* p, const char* e, std::string& out) {
+				out.clear();
+				for(;;) {
+					const char* q = p;
+					while(q < e && *q != '"' && *q != '\\')
+						++q;
+					out.append(p, q);
+					if(q >= e)
+						return nullptr;
+					if(*q == '"')
+						return q + 1;
+					if(q + 1 >= e)
+						return nullptr;
+					out.push_back(q[1]);
+					p = q + 2;
+				}
+			}
+
+			// line by line state machine over the (UTF-8 or ANSI) text
+			class parser {
+
+				private:
+
+					reg_entry _e;
+					std::vector<BYTE> _tmp;
+					bool _header = false;
+					bool _wrapped = false; // inside wrapped hex data
+					bool _unicode = true;  // hex(1) / hex(2) / hex(7) data as UTF-16LE
+
+					static const char* _skip(const char* p, const char* e) {
+						while(p < e && (*p == ' ' || *p == '\t'))
+							++p;
+						return p;
+					}
+					static bool _starts(const char* p, const char* e, const char* str) {
+						size_t len = strlen(str);
+						return static_cast<size_t>(e - p) >= len && memcmp(p, str, len) == 0;
+					}
+
+					template<class Fn>
+					void _value_done(Fn& fn) {
+						if(_unicode && (_e.ty == type::sz || _e.ty == type::expand_sz || _e.ty == type::multi_sz)) {
+							_tmp.resize(_e.data.size() * 3 / 2 + 1);
+							size_t len = _utf16_to_utf8().feed(_e.data.data(), _e.data.size(), reinterpret_cast<char*>(_tmp.data()));
+							_tmp.resize(len);
+							_e.data.swap(_tmp);
+						}
+						fn(static_cast<const reg_entry&>(_e));
+					}
+
+					template<class Fn>
+					bool _value(const char* p, const char* e, Fn& fn) {
+						if(*p == '@')
+							_e.name.clear(), ++p;
+						else if((p = _unquote(p + 1, e, _e.name)) == nullptr)
+							return false;
+						p = _skip(p, e);
+						if(p == e || *p != '=')
+							return false;
+						p = _skip(p + 1, e);
+						_e.what = reg_entry::kind::value;
+						_e.data.clear();
+						if(p < e && *p == '"') {
+							const char* q = p + 1;
+							_e.ty = type::sz;
+							// unescaped straight into the data
+							for(;;) {
+								const char* r = q;
+								while(r < e && *r != '"' && *r != '\\')
+									++r;
+								_e.data.insert(_e.data.end(), q, r);
+								if(r >= e)
+									return false;
+								if(*r == '"')
+									break;
+								if(r + 1 >= e)
+									return false;
+								_e.data.push_back(static_cast<BYTE>(r[1]));
+								q = r + 2;
+							}
+							_e.data.push_back(0);
+							fn(static_cast<const reg_entry&>(_e));
+							return true;
+						}
+						if(p < e && *p == '-') {
+							_e.what = reg_entry::kind::delete_value;
+							fn(static_cast<const reg_entry&>(_e));
+							return true;
+						}
+						const int8_t* val = _hex_table::get().val;
+						if(_starts(p, e, "dword:")) {
+							uint32_t dw = 0;
+							int digits = 0;
+							for(p += 6; p < e && val[static_cast<unsigned char>(*p)] >= 0 && digits < 8; ++p, ++digits)
+								dw = (dw << 4) | static_cast<uint32_t>(val[static_cast<unsigned char>(*p)]);
+							if(digits == 0 || _skip(p, e) != e)
+								return false;
+							_e.ty = type::dword;
+							_e.data.assign(reinterpret_cast<const BYTE*>(&dw), reinterpret_cast<const BYTE*>(&dw) + 4); // registry data is little endian
+							fn(static_cast<const reg_entry&>(_e));
+							return true;
+						}
+						if(!_starts(p, e, "hex"))
+							return false;
+						p += 3;
+						DWORD ty = static_cast<DWORD>(type::binary);
+						if(p < e && *p == '(') {
+							ty = 0;
+							for(++p; p < e && val[static_cast<unsigned char>(*p)] >= 0; ++p)
+								ty = (ty << 4) | static_cast<DWORD>(val[static_cast<unsigned char>(*p)]);
+							if(p >= e || *p++ != ')')
+								return false;
+						}
+						if(p >= e || *p++ != ':')
+							return false;
+						_e.ty = static_cast<type>(ty);
+						if(!_hex_decode(p, e, _e.data, _wrapped))
+							return false;
+						if(!_wrapped)
+							_value_done(fn);
+						return true;
+					}
+
+				public:
+
+					size_t line = 0;
+
+					parser() {}
+					// for the sections after the first one, when the file is parsed by pieces
+					parser(bool unicode) : _header(true), _unicode(unicode) {}
+
+					// one line without its line break, fn(const reg_entry&) for every complete entry
+					template<class Fn>
+					bool feed(const char* p, const char* e, Fn& fn) {
+						++line;
+						if(e > p && e[-1] == '\r')
+							--e;
+						if(_wrapped) {
+							if(!_hex_decode(_skip(p, e), e, _e.data, _wrapped))
+								return false;
+							if(!_wrapped)
+								_value_done(fn);
+							return true;
+						}
+						p = _skip(p, e);
+						if(p == e)
+							return true;
+						if(!_header) {
+							_header = true;
+							_unicode = !_starts(p, e, header_v4);
+							return _unicode ? _starts(p, e, header_v5) : true;
+						}
+						switch(*p) {
+							case ';':
+								return true;
+							case '[': {
+								const char* q = e;
+								while(q > p && q[-1] != ']')
+									--q;
+								if(q == p)
+									return false;
+								bool del = p[1] == '-';
+								_e.what = del ? reg_entry::kind::delete_key : reg_entry::kind::key;
+								_e.path.assign(p + (del ? 2 : 1), q - 1);
+								_e.name.clear();
+								_e.data.clear();
+								fn(static_cast<const reg_entry&>(_e));
+								return true;
+							}
+							case '"':
+							case '@':
+								return _value(p, e, fn);
+						}
+						return false;
+					}
+					// end of the text, a wrapped value missing its last line is still given
+					template<class Fn>
+					bool finish(Fn& fn) {
+						if(_wrapped) {
+							_wrapped = false;
+							_value_done(fn);
+						}
+						return true;
+					}
+
+			};
+
+			// feeds every complete line of [p, e), returns where the unfinished last line starts (e if none)
+			template<class Fn>
+			const char* _lines(parser& ps, const char* p, const char* e, bool& ok, Fn& fn) {
+				while(ok) {
+					const char* nl = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(e - p)));
+					if(nl == nullptr)
+						return p;
+					ok = ps.feed(p, nl, fn);
+					p = nl + 1;
+				}
+				return p;
+			}
+
+		}
+
+	}
+
+	class reg_reader {
+
+		private:
+
+			using BYTE = __regedit_details::BYTE;
+
+			std::FILE* _file = nullptr;
+			size_t _window;
+			long _start = 0; // after the BOM
+			reg_format _format = reg_format::utf8;
+			size_t _error = 0;
+
+			// a piece of the file starting at a key section, parsed by a worker
+			struct _job {
+				std::vector<char> raw;
+				std::vector<char> text;
+				std::vector<reg_entry> entries;
+				size_t count = 0;
+				size_t lines = 0;
+				size_t error = 0; // line inside the piece
+			};
+
+			bool _utf16() const {
+				return _format == reg_format::unicode;
+			}
+
+			// text of the whole piece, UTF-16LE converted to UTF-8
+			const char* _text(_job& job, size_t& len) const {
+				if(!_utf16()) {
+					len = job.raw.size();
+					return job.raw.data();
+				}
+				job.text.resize(job.raw.size() / 2 * 3 + 1);
+				len = __regedit_details::_utf16_to_utf8().feed(reinterpret_cast<const BYTE*>(job.raw.data()), job.raw.size() & ~size_t(1), job.text.data());
+				return job.text.data();
+			}
+
+			void _parse(_job& job, bool first) const {
+				__regedit_details::regtext::parser ps = first ? __regedit_details::regtext::parser() : __regedit_details::regtext::parser(_format != reg_format::regedit4);
+				job.count = 0;
+				job.error = 0;
+				auto keep = [&job](const reg_entry& e) {
+					if(job.count == job.entries.size())
+						job.entries.emplace_back();
+					reg_entry& dst = job.entries[job.count++];
+					dst.what = e.what;
+					dst.path = e.path;
+					dst.name = e.name;
+					dst.ty = e.ty;
+					dst.data.assign(e.data.begin(), e.data.end());
+				};
+				size_t len = 0;
+				const char* text = _text(job, len);
+				bool ok = true;
+				const char* rest = __regedit_details::regtext::_lines(ps, text, text + len, ok, keep);
+				if(ok && rest != text + len)
+					ok = ps.feed(rest, text + len, keep);
+				if(ok)
+					ps.finish(keep);
+				job.lines = ps.line;
+				if(!ok)
+					job.error = ps.line;
+			}
+
+			// index where the last key section of [0, len) starts, 0 if there's none
+			size_t _section(const std::vector<char>& raw, size_t len) const {
+				if(_utf16()) {
+					for(size_t i = len & ~size_t(1); i >= 4; i -= 2)
+						if(raw[i - 4] == '\n' && raw[i - 3] == 0 && raw[i - 2] == '[' && raw[i - 1] == 0)
+							return i - 2;
+					return 0;
+				}
+				for(size_t i = len; i >= 2; --i)
+					if(raw[i - 2] == '\n' && raw[i - 1] == '[')
+						return i - 1;
+				return 0;
+			}
+
+			// next piece ending right before a key section (or at the end of the file), 'carry' keeps what goes after it
+			bool _next_piece(std::vector<char>& carry, _job& job) {
+				job.raw.swap(carry);
+				carry.clear();
+				size_t scanned = 0; // no section starts before it
+				for(;;) {
+					size_t have = job.raw.size();
+					if(have < scanned + _window) {
+						job.raw.resize(scanned + _window);
+						size_t got = std::fread(job.raw.data() + have, 1, scanned + _window - have, _file);
+						bool eof = got < scanned + _window - have;
+						job.raw.resize(have += got);
+						if(eof)
+							return !job.raw.empty();
+					}
+					size_t cut = _section(job.raw, have);
+					if(cut > 0) {
+						carry.assign(job.raw.begin() + cut, job.raw.end());
+						job.raw.resize(cut);
+						return true;
+					}
+					scanned = have; // a section bigger than the window, keeps reading
+				}
+			}
+
+		public:
+
+			explicit reg_reader(const std::string& path, size_t window = 1 << 20) : _window((std::max)(window, size_t(4096)) & ~size_t(1)) {
+				_file = std::fopen(path.c_str(), "rb");
+				if(_file == nullptr)
+					return;
+				unsigned char head[3] = {};
+				size_t n = std::fread(head, 1, 3, _file);
+				if(n >= 2 && head[0] == 0xFF && head[1] == 0xFE)
+					_start = 2;
+				else if(n == 3 && head[0] == 0xEF && head[1] == 0xBB && head[2] == 0xBF)
+					_start = 3;
+				_format = _start == 2 ? reg_format::unicode : reg_format::utf8;
+				if(_start != 2) {
+					char line[16] = {};
+					std::fseek(_file, _start, SEEK_SET);
+					if(std::fread(line, 1, 8, _file) == 8 && memcmp(line, __regedit_details::regtext::header_v4, 8) == 0)
+						_format = reg_format::regedit4;
+				}
+				std::fseek(_file, _start, SEEK_SET);
+			}
+			reg_reader(const reg_reader&) = delete;
+			reg_reader& operator=(const reg_reader&) = delete;
+			~reg_reader() {
+				if(_file != nullptr)
+					std::fclose(_file);
+			}
+
+			bool is_open() const {
+				return _file != nullptr;
+			}
+			reg_format format() const {
+				return _format;
+			}
+			// line of the first malformed entry found by the last read(), 0 if there wasn't any
+			size_t error_line() const {
+				return _error;
+			}
+
+			// calls fn(const reg_entry&) for every entry in file order, stops at the first malformed line
+			template<class Fn>
+			bool read(Fn fn, size_t threads = 1) {
+				if(_file == nullptr)
+					return false;
+				std::fseek(_file, _start, SEEK_SET);
+				_error = 0;
+				if(threads == 0)
+					threads = (std::max)(1u, std::thread::hardware_concurrency());
+				if(threads == 1)
+					return _read(fn);
+
+				std::vector<_job> jobs(threads);
+				std::vector<char> carry;
+				size_t lines = 0;
+				bool first = true;
+				for(bool more = true; more; ) {
+					size_t n = 0;
+					while(n < threads && (more = _next_piece(carry, jobs[n])))
+						++n;
+					more = more || !carry.empty();
+					std::vector<std::thread> pool;
+					for(size_t i = 1; i < n; ++i)
+						pool.emplace_back([this, &jobs, i] { _parse(jobs[i], false); });
+					if(n > 0)
+						_parse(jobs[0], first);
+					for(std::thread& th : pool)
+						th.join();
+					for(size_t i = 0; i < n; ++i) {
+						for(size_t j = 0; j < jobs[i].count; ++j)
+							fn(static_cast<const reg_entry&>(jobs[i].entries[j]));
+						if(jobs[i].error != 0) {
+							_error = lines + jobs[i].error;
+							return false;
+						}
+						lines += jobs[i].lines;
+					}
+					first = false;
+				}
+				return true;
+			}
+
+		private:
+
+			template<class Fn>
+			bool _read(Fn& fn) {
+				__regedit_details::regtext::parser ps;
+				std::vector<char> raw(_window), text;
+				std::string tail; // unfinished line of the previous window
+				__regedit_details::_utf16_to_utf8 conv;
+				bool ok = true;
+				for(;;) {
+					size_t n = std::fread(raw.data(), 1, _window, _file);
+					const char *p = raw.data(), *e = p + n;
+					if(_utf16()) {
+						text.resize(n / 2 * 3 + 1);
+						p = text.data();
+						e = p + conv.feed(reinterpret_cast<const BYTE*>(raw.data()), n & ~size_t(1), text.data());
+					}
+					if(!tail.empty()) {
+						const char* nl = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(e - p)));
+						tail.append(p, nl != nullptr ? nl : e);
+						if(nl == nullptr && n != 0)
+							continue;
+						ok = ps.feed(tail.data(), tail.data() + tail.size(), fn);
+						tail.clear();
+						p = nl != nullptr ? nl + 1 : e;
+					}
+					const char* rest = __regedit_details::regtext::_lines(ps, p, e, ok, fn);
+					if(!ok)
+						break;
+					tail.assign(rest, e);
+					if(n < _window) {
+						if(!tail.empty())
+							ok = ps.feed(tail.data(), tail.data() + tail.size(), fn);
+						break;
+					}
+				}
+				if(ok)
+					ps.finish(fn);
+				else
+					_error = ps.line;
+				return ok;
+			}
+
+	};
+
+	class reg_writer {
+
+		private:
+
+			using DWORD = __regedit_details::DWORD;
+			using BYTE  = __regedit_details::BYTE;
+			using type  = __regedit_details::type;
+
+			std::FILE* _file = nullptr;
+			reg_format _format;
+			std::string _out;       // pending text, UTF-8 / ANSI
+			std::vector<BYTE> _wide;
+			std::vector<char> _name = std::vector<char>(16384 * 3 + 1);
+			__regedit_details::read_overload::_buffer _data;
+			bool _failed = false;
+			std::string _section;   // key section open by write(reg_entry)
+			bool _in_section = false, _deleted = false;
+
+			static constexpr size_t _flush_size = 1 << 20;
+			static constexpr size_t _columns = 80;
+
+			void _flush() {
+				if(_out.empty() || _file == nullptr)
+					return;
+				if(_format == reg_format::unicode) {
+					_wide.clear();
+					__regedit_details::_utf8_to_utf16(reinterpret_cast<const BYTE*>(_out.data()), _out.size(), _wide);
+					_failed = std::fwrite(_wide.data(), 1, _wide.size(), _file) != _wide.size() || _failed;
+				}
+				else
+					_failed = std::fwrite(_out.data(), 1, _out.size(), _file) != _out.size() || _failed;
+				_out.clear();
+			}
+
+			void _quoted(const char* str, size_t len) {
+				_out.push_back('"');
+				for(const char* e = str + len; str < e; ++str) {
+					if(*str == '\\' || *str == '"')
+						_out.push_back('\\');
+					_out.push_back(*str);
+				}
+				_out.push_back('"');
+			}
+
+			// "xx,xx,..." wrapped as regedit.exe does, 'col' is the column where the data starts
+			void _hex(const BYTE* data, size_t len, size_t col) {
+				const __regedit_details::regtext::_hex_table& table = __regedit_details::regtext::_hex_table::get();
+				_out.reserve(_out.size() + len * 3 + len / 20 * 5 + 2);
+				for(size_t i = 0; i < len; ++i) {
+					_out.append(table.pair[data[i]], 2);
+					if(i + 1 == len)
+						break;
+					_out.push_back(',');
+					col += 3;
+					if(col > _columns - 4) {
+						_out.append("\\\r\n  ");
+						col = 2;
+					}
+				}
+			}
+
+			void _value(const char* name, DWORD ty, const BYTE* data, DWORD len) {
+				size_t line = _out.size();
+				if(*name == '\0')
+					_out.push_back('@');
+				else
+					_quoted(name, strlen(name));
+				_out.push_back('=');
+				if(ty == static_cast<DWORD>(type::sz)) {
+					const BYTE* end = static_cast<const BYTE*>(memchr(data, 0, len));
+					_quoted(reinterpret_cast<const char*>(data), end != nullptr ? static_cast<size_t>(end - data) : len);
+				}
+				else if(ty == static_cast<DWORD>(type::dword) && len == 4) {
+					char buff[16];
+					uint32_t dw = static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) | (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+					snprintf(buff, sizeof(buff), "dword:%08x", dw);
+					_out.append(buff);
+				}
+				else {
+					char buff[24];
+					if(ty == static_cast<DWORD>(type::binary))
+						_out.append("hex:");
+					else {
+						snprintf(buff, sizeof(buff), "hex(%x):", static_cast<unsigned>(ty));
+						_out.append(buff);
+					}
+					if(_format != reg_format::regedit4 && (ty == static_cast<DWORD>(type::expand_sz) || ty == static_cast<DWORD>(type::multi_sz))) {
+						_wide.clear();
+						__regedit_details::_utf8_to_utf16(data, len, _wide);
+						_hex(_wide.data(), _wide.size(), _out.size() - line);
+					}
+					else
+						_hex(data, len, _out.size() - line);
+				}
+				_out.append("\r\n");
+			}
+
+			template<class Backend>
+			bool _key(typename Backend::handle hk, std::string& path) {
+				bool ok = true;
+				_out.push_back('[');
+				_out.append(path);
+				_out.append("]\r\n");
+				DWORD keys = 0, vals = 0;
+				if(Backend::query_info(hk, &keys, &vals) != __regedit_details::status::success)
+					return false;
+				for(DWORD pos = 0; pos < vals; ++pos) {
+					DWORD ty = 0, len = 0;
+					if(__regedit_details::_enum_data<Backend>(hk, pos, _name.data(), static_cast<DWORD>(_name.size()), &ty, _data, &len, __regedit_details::_has_enum_data<Backend>()) != __regedit_details::status::success) {
+						ok = false;
+						continue;
+					}
+					_value(_name.data(), ty, _data.data(), len);
+				}
+				_out.append("\r\n");
+				if(_out.size() >= _flush_size)
+					_flush();
+				size_t base = path.size();
+				for(DWORD pos = 0; pos < keys; ++pos) {
+					char name[__regedit_details::key_name_size];
+					DWORD nlen = __regedit_details::key_name_size;
+					typename Backend::handle sub;
+					if(Backend::enum_key(hk, pos, name, &nlen) != __regedit_details::status::success || Backend::open(hk, name, false, &sub) != __regedit_details::status::success) {
+						ok = false;
+						continue;
+					}
+					path.push_back('\\');
+					path.append(name, nlen);
+					ok = _key<Backend>(sub, path) && ok;
+					path.resize(base);
+					Backend::close(sub);
+				}
+				return ok;
+			}
+
+		public:
+
+			explicit reg_writer(const std::string& path, reg_format format = reg_format::unicode) : _format(format) {
+				_file = std::fopen(path.c_str(), "wb");
+				if(_file == nullptr)
+					return;
+				if(_format == reg_format::unicode)
+					_failed = std::fwrite("\xFF\xFE", 1, 2, _file) != 2;
+				_out.append(_format == reg_format::regedit4 ? __regedit_details::regtext::header_v4 : __regedit_details::regtext::header_v5);
+				_out.append("\r\n\r\n");
+			}
+			reg_writer(const reg_writer&) = delete;
+			reg_writer& operator=(const reg_writer&) = delete;
+			~reg_writer() {
+				close();
+			}
+
+			bool is_open() const {
+				return _file != nullptr;
+			}
+
+			// writes the whole tree, 'root_path' is the path written for it (HKEY_CURRENT_USER\Software\..., as the file should be imported)
+			template<class Backend>
+			bool write(const basic_regedit<Backend>& tree, const std::string& root_path) {
+				if(_file == nullptr || !tree.is_open())
+					return false;
+				if(_in_section)
+					_out.append("\r\n");
+				_in_section = false;
+				std::string path = root_path;
+				bool ok = _key<Backend>(tree.native_handle(), path);
+				_flush();
+				return ok && !_failed;
+			}
+
+			// one entry at a time (patches, filtered copies, ...), values are written under a "[path]" section opened when the path changes
+			bool write(const reg_entry& e) {
+				if(_file == nullptr)
+					return false;
+				if(e.what == reg_entry::kind::delete_key || !_in_section || _deleted || _section != e.path) {
+					if(_in_section)
+						_out.append("\r\n");
+					_out.append(e.what == reg_entry::kind::delete_key ? "[-" : "[");
+					_out.append(e.path);
+					_out.append("]\r\n");
+					_section = e.path;
+					_in_section = true;
+					_deleted = e.what == reg_entry::kind::delete_key;
+				}
+				if(e.what == reg_entry::kind::value)
+					_value(e.name.c_str(), static_cast<DWORD>(e.ty), e.data.data(), static_cast<DWORD>(e.data.size()));
+				else if(e.what == reg_entry::kind::delete_value) {
+					if(e.name.empty())
+						_out.push_back('@');
+					else
+						_quoted(e.name.data(), e.name.size());
+					_out.append("=-\r\n");
+				}
+				if(_out.size() >= _flush_size)
+					_flush();
+				return !_failed;
+			}
+
+			bool close() {
+				if(_file == nullptr)
+					return false;
+				if(_in_section)
+					_out.append("\r\n");
+				_in_section = false;
+				_flush();
+				bool ok = std::fclose(_file) == 0 && !_failed;
+				_file = nullptr;
+				return ok;
+			}
+
+	};
+
+	// writes a whole tree as a .reg file, 'root_path' is the path given to the root key on the file
+	template<class Backend>
+	bool export_reg(const basic_regedit<Backend>& tree, const std::string& path, const std::string& root_path, reg_format format = reg_format::unicode) {
+		reg_writer writer(path, format);
+		bool ok = writer.write(tree, root_path);
+		return writer.close() && ok;
+	}
+
+	// applies a .reg file over 'dst', the file path 'root' is mapped to 'dst' and the keys outside it are skipped (an empty 'root' takes the whole paths)
+	template<class Backend>
+	bool import_reg(const std::string& path, const basic_regedit<Backend>& dst, const std::string& root = "", size_t threads = 1) {
+		namespace status = __regedit_details::status;
+		reg_reader reader(path);
+		if(!reader.is_open() || !dst.is_open())
+			return false;
+		typename Backend::handle cur = typename Backend::handle();
+		bool ok = true;
+		auto relative = [&root](const std::string& full, const char** rel) {
+			if(root.empty()) {
+				*rel = full.c_str();
+				return true;
+			}
+			if(full.size() < root.size() || !__regedit_details::names::eq(full.data(), root.size(), root.data(), root.size())
+			|| (full.size() > root.size() && full[root.size()] != '\\'))
+				return false;
+			*rel = full.c_str() + root.size() + (full.size() > root.size() ? 1 : 0);
+			return true;
+		};
+		bool read = reader.read([&](const reg_entry& e) {
+			const char* rel = nullptr;
+			switch(e.what) {
+				case reg_entry::kind::key:
+				case reg_entry::kind::delete_key:
+					if(cur != typename Backend::handle())
+						Backend::close(cur);
+					cur = typename Backend::handle();
+					if(!relative(e.path, &rel))
+						break;
+					if(e.what == reg_entry::kind::delete_key) {
+						long ret = Backend::delete_tree(dst.native_handle(), rel);
+						ok = ok && (ret == status::success || ret == status::file_not_found);
+					}
+					else if(Backend::create(dst.native_handle(), rel, true, &cur, nullptr) != status::success) {
+						cur = typename Backend::handle();
+						ok = false;
+					}
+					break;
+				case reg_entry::kind::value:
+					if(cur != typename Backend::handle())
+						ok = Backend::set_value(cur, e.name.c_str(), static_cast<__regedit_details::DWORD>(e.ty), e.data.data(), static_cast<__regedit_details::DWORD>(e.data.size())) == status::success && ok;
+					break;
+				case reg_entry::kind::delete_value:
+					if(cur != typename Backend::handle()) {
+						long ret = Backend::delete_value(cur, e.name.c_str());
+						ok = ok && (ret == status::success || ret == status::file_not_found);
+					}
+					break;
+			}
+		}, threads);
+		if(cur != typename Backend::handle())
+			Backend::close(cur);
+		dst.refresh();
+		return read && ok;
+	}
+
+
+}
+
+
+
+#endif
@@ -0,0 +1,277 @@
+#pragma once
+
+#ifndef __NEO_REGEDIT_SCHEMA_HPP__
+#define __NEO_REGEDIT_SCHEMA_HPP__
+
+
+/*
+	Header name: regedit_schema.hpp
+	Author: neo3587
+
+	Notes:
+		- neo::make_schema() binds the fields of a struct to value names and types at compile time, then load() / save() read or write
+			the whole struct over one key, works with any backend
+		- The field types are checked at compile time against the value type : DWORD for dword / dword_big_endian, DWORD64 for qword,
+			std::string for sz / expand_sz, std::vector<std::string> for multi_sz and std::vector<BYTE> for binary
+		- load() uses the handle of the key for every field (no neo::regedit::value per field), when the backend can give the data while
+			enumerating and the key doesn't have many more values than fields it's a single enumeration pass, otherwise one query per field.
+			The stored type has to match the declared one, the fields missing or with another type keep their current content
+		- expand_sz fields are loaded with the %variables% expanded, as read<type::expand_sz>() does, and saved as they are
+*/
+
+
+
+#include "regedit.hpp"
+
+
+
+namespace neo {
+
+	namespace __regedit_details {
+
+		constexpr size_t _cstrlen(const char* str) {
+			return *str != '\0' ? 1 + _cstrlen(str + 1) : 0;
+		}
+
+		template<type Ty>
+		struct _schema_type {
+			static constexpr bool supported = Ty == type::sz || Ty == type::expand_sz || Ty == type::multi_sz || Ty == type::binary ||
+				Ty == type::dword || Ty == type::dword_big_endian || Ty == type::qword;
+		};
+
+		// raw value data -> field, false if the data doesn't fit the type
+		inline bool _schema_decode(type, const BYTE* data, DWORD len, DWORD& out) {
+			if(len < sizeof(DWORD))
+				return false;
+			memcpy(&out, data, sizeof(DWORD));
+			return true;
+		}
+		inline bool _schema_decode(type, const BYTE* data, DWORD len, DWORD64& out) {
+			if(len < sizeof(DWORD64))
+				return false;
+			memcpy(&out, data, sizeof(DWORD64));
+			return true;
+		}
+		inline bool _schema_decode(type ty, const BYTE* data, DWORD len, std::string& out) {
+			const char* str = reinterpret_cast<const char*>(data);
+			out.assign(str, std::find(str, str + len, '\0'));
+			if(ty == type::expand_sz)
+				_expand_env(out);
+			return true;
+		}
+		inline bool _schema_decode(type, const BYTE* data, DWORD len, std::vector<std::string>& out) {
+			const char* str = reinterpret_cast<const char*>(data);
+			size_t count = 0;
+			for(size_t off = 0; off < len && str[off] != '\0'; ++count) {
+				size_t size = std::find(str + off, str + len, '\0') - (str + off);
+				if(count < out.size())
+					out[count].assign(str + off, size);
+				else
+					out.emplace_back(str + off, size);
+				off += size + 1;
+			}
+			out.resize(count);
+			return true;
+		}
+		inline bool _schema_decode(type, const BYTE* data, DWORD len, std::vector<BYTE>& out) {
+			out.assign(data, data + len);
+			return true;
+		}
+
+		// field -> raw value data, 'scratch' keeps the bytes when the field isn't stored as they go
+		inline const BYTE* _schema_encode(const DWORD& in, DWORD& len, std::vector<char>&) {
+			len = sizeof(DWORD);
+			return reinterpret_cast<const BYTE*>(&in);
+		}
+		inline const BYTE* _schema_encode(const DWORD64& in, DWORD& len, std::vector<char>&) {
+			len = sizeof(DWORD64);
+			return reinterpret_cast<const BYTE*>(&in);
+		}
+		inline const BYTE* _schema_encode(const std::string& in, DWORD& len, std::vector<char>&) {
+			len = static_cast<DWORD>(in.size() + 1);
+			return reinterpret_cast<const BYTE*>(in.c_str());
+		}
+		inline const BYTE* _schema_encode(const std::vector<std::string>& in, DWORD& len, std::vector<char>& scratch) {
+			scratch.clear();
+			for(const std::string& s : in) {
+				scratch.insert(scratch.end(), s.begin(), s.end());
+				scratch.push_back('\0');
+			}
+			scratch.push_back('\0');
+			len = static_cast<DWORD>(scratch.size());
+			return reinterpret_cast<const BYTE*>(scratch.data());
+		}
+		inline const BYTE* _schema_encode(const std::vector<BYTE>& in, DWORD& len, std::vector<char>&) {
+			len = static_cast<DWORD>(in.size());
+			return in.data();
+		}
+
+		// the fields of a schema, recursive storage usable in constant expressions
+		template<class... Fields>
+		struct _field_list {
+			constexpr _field_list() {}
+			size_t find(const char*, size_t, size_t) const {
+				return static_cast<size_t>(-1);
+			}
+			template<class S>
+			bool decode(size_t, S&, type, const BYTE*, DWORD) const {
+				return false;
+			}
+			template<class Backend, class S>
+			size_t query(typename Backend::handle, S&, read_overload::_buffer&, bool*) const {
+				return 0;
+			}
+			template<class Backend, class S>
+			size_t store(typename Backend::handle, const S&, std::vector<char>&) const {
+				return 0;
+			}
+		};
+		template<class Field, class... Rest>
+		struct _field_list<Field, Rest...> {
+
+			Field head;
+			_field_list<Rest...> tail;
+
+			constexpr _field_list(Field f, Rest... r) : head(f), tail(r...) {}
+
+			// position of the field named 'name' (case insensitive), -1 if none
+			size_t find(const char* name, size_t len, size_t pos = 0) const {
+				return len == head.length && names::eq(name, len, head.name, len) ? pos : tail.find(name, len, pos + 1);
+			}
+
+			template<class S>
+			bool decode(size_t pos, S& obj, type ty, const BYTE* data, DWORD len) const {
+				if(pos != 0)
+					return tail.decode(pos - 1, obj, ty, data, len);
+				return ty == Field::value_type && _schema_decode(ty, data, len, obj.*head.member);
+			}
+
+			// one query per field, 'done' marks the ones already read
+			template<class Backend, class S>
+			size_t query(typename Backend::handle hk, S& obj, read_overload::_buffer& buff, bool* done) const {
+				size_t n = 0;
+				if(!*done) {
+					DWORD ty = 0, len = 0;
+					if(read_overload::_query<Backend>(hk, head.name, &ty, buff, &len) == status::success)
+						n = ty == static_cast<DWORD>(Field::value_type) && _schema_decode(Field::value_type, buff.data(), len, obj.*head.member);
+				}
+				return n + tail.template query<Backend>(hk, obj, buff, done + 1);
+			}
+
+			template<class Backend, class S>
+			size_t store(typename Backend::handle hk, const S& obj, std::vector<char>& scratch) const {
+				DWORD len = 0;
+				const BYTE* data = _schema_encode(obj.*head.member, len, scratch);
+				size_t n = Backend::set_value(hk, head.name, static_cast<DWORD>(Field::value_type), data, len) == status::success;
+				return n + tail.template store<Backend>(hk, obj, scratch);
+			}
+
+		};
+
+		// one enumeration pass over the values of the key, the names are matched against the fields
+		template<class Backend, class S, class List>
+		size_t _schema_enum(typename Backend::handle hk, S& obj, const List& fields, bool* done, const key_info& info) {
+			std::vector<char> name(info.max_value_name != 0 ? info.max_value_name + 1 : 16384 * 3 + 1); // UTF-8 names from hives can take more than 16383 bytes
+			DWORD count = info.values;
+			read_overload::_buffer buff;
+			size_t n = 0;
+			for(DWORD pos = 0; pos < count; ++pos) {
+				DWORD ty = 0, len = 0;
+				long ret = _enum_data<Backend>(hk, pos, name.data(), static_cast<DWORD>(name.size()), &ty, buff, &len, _has_enum_data<Backend>());
+				if(ret == status::no_more_items)
+					break;
+				if(ret != status::success)
+					continue;
+				size_t i = fields.find(name.data(), strlen(name.data()));
+				if(i != static_cast<size_t>(-1) && !done[i] && fields.decode(i, obj, static_cast<type>(ty), buff.data(), len)) {
+					done[i] = true;
+					++n;
+				}
+			}
+			return n;
+		}
+
+	}
+
+	template<__regedit_details::type Ty, class S, class M>
+	struct schema_field {
+		using struct_type = S;
+		using member_type = M;
+		static constexpr __regedit_details::type value_type = Ty;
+
+		const char* name;
+		size_t length;
+		M S::* member;
+	};
+
+	// binds 'member' to the value 'name' of type 'Ty'
+	template<__regedit_details::type Ty, class S, class M>
+	constexpr schema_field<Ty, S, M> field(const char* name, M S::* member) {
+		static_assert(__regedit_details::_schema_type<Ty>::supported, "neo::field(): only sz, expand_sz, multi_sz, binary, dword, dword_big_endian and qword values can be bound");
+		static_assert(std::is_same<M, __regedit_details::read_overload::_into_t<Ty>>::value, "neo::field(): the member type doesn't match the value type");
+		return schema_field<Ty, S, M>{ name, __regedit_details::_cstrlen(name), member };
+	}
+
+	template<class S, class... Fields>
+	class schema {
+
+		private:
+
+			__regedit_details::_field_list<Fields...> _fields;
+
+		public:
+
+			static_assert(sizeof...(Fields) > 0, "neo::schema: no fields");
+
+			using struct_type = S;
+
+			constexpr schema(Fields... fields) : _fields(fields...) {}
+
+			static constexpr size_t size() {
+				return sizeof...(Fields);
+			}
+
+			// reads the fields from 'key', returns how many of them were found with the declared type
+			template<class Backend>
+			size_t load(const basic_regedit<Backend>& key, S& obj) const {
+				typename Backend::handle hk = key.native_handle();
+				bool done[sizeof...(Fields)] = {};
+				size_t n = 0;
+				__regedit_details::key_info info = key.info();
+				// enumerating is one call per value of the key against one per field, worth it while most of the values are fields
+				if(__regedit_details::_has_enum_data<Backend>::value && info.values != 0 && info.values <= 2 * size() + 8)
+					n = __regedit_details::_schema_enum<Backend>(hk, obj, _fields, done, info);
+				if(n < size()) {
+					__regedit_details::read_overload::_buffer buff;
+					n += _fields.template query<Backend>(hk, obj, buff, done);
+				}
+				return n;
+			}
+			template<class Backend>
+			S load(const basic_regedit<Backend>& key) const {
+				S obj{};
+				load(key, obj);
+				return obj;
+			}
+
+			// writes every field into 'key' (opened with write permission), returns how many were written
+			template<class Backend>
+			size_t save(const basic_regedit<Backend>& key, const S& obj) const {
+				std::vector<char> scratch;
+				size_t n = _fields.template store<Backend>(key.native_handle(), obj, scratch);
+				key.refresh();
+				return n;
+			}
+
+	};
+
+	template<class Field, class... Rest>
+	constexpr schema<typename Field::struct_type, Field, Rest...> make_schema(Field f, Rest... r) {
+		return schema<typename Field::struct_type, Field, Rest...>(f, r...);
+	}
+
+}
+
+
+
+#endif
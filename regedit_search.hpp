@@ -0,0 +1,415 @@
+#pragma once
+
+#ifndef __NEO_REGEDIT_SEARCH_HPP__
+#define __NEO_REGEDIT_SEARCH_HPP__
+
+
+/*
+	Header name: regedit_search.hpp
+	Author: neo3587
+
+	Notes:
+		- neo::search() finds the keys and values of a subtree matching a neo::search_query, works with any backend (live registry, memory, offline hives)
+		- The query matches the key path (relative to the root), the value name, the value type and the value data, every pattern can be
+			an exact string, a substring, a glob or a regex (std::regex, ECMAScript), case insensitive by default as the registry names are
+		- Path globs are matched by key name: '*' and '?' don't cross a '\', a "**" part matches any number of keys. Exact and glob path patterns
+			skip the subtrees that can't match anymore, substrings and regexes need the whole walk
+		- String data (sz, expand_sz, link) is matched whole, multi_sz string by string. dword, dword_big_endian and qword can be matched
+			against a numeric range
+		- The walk is a neo::parallel_walk(), the names, types and data are checked by the workers. The hits are given as they are found,
+			one at a time (the callback doesn't have to be thread safe), returning false from it ends the search
+*/
+
+
+
+#include "regedit_walk.hpp"
+#include <regex>
+
+
+
+namespace neo {
+
+	namespace __regedit_details {
+		class _search_path;
+	}
+
+	class search_pattern {
+
+		public:
+
+			enum class kind { any, exact, substring, glob, regex };
+
+		private:
+
+			kind _kind = kind::any;
+			std::string _text; // upper case if case insensitive
+			bool _icase = true;
+			std::shared_ptr<const std::regex> _re;
+
+			search_pattern(kind k, const std::string& text, bool icase) : _kind(k), _text(text), _icase(icase) {
+				if(_icase)
+					for(char& c : _text)
+						c = static_cast<char>(__regedit_details::names::_fold(static_cast<unsigned char>(c)));
+			}
+
+			char _fold(char c) const {
+				return _icase ? static_cast<char>(__regedit_details::names::_fold(static_cast<unsigned char>(c))) : c;
+			}
+
+			// '*' matches any run of characters, '?' any single one
+			static bool _glob(const search_pattern& self, const char* p, size_t pn, const char* s, size_t sn) {
+				size_t pi = 0, si = 0, star = static_cast<size_t>(-1), mark = 0;
+				while(si < sn) {
+					if(pi < pn && p[pi] == '*') {
+						star = ++pi;
+						mark = si;
+					}
+					else if(pi < pn && (p[pi] == '?' || p[pi] == self._fold(s[si]))) {
+						++pi;
+						++si;
+					}
+					else if(star != static_cast<size_t>(-1)) {
+						pi = star;
+						si = ++mark;
+					}
+					else
+						return false;
+				}
+				while(pi < pn && p[pi] == '*')
+					++pi;
+				return pi == pn;
+			}
+
+			bool _find(const char* s, size_t n) const {
+				size_t m = _text.size();
+				if(m == 0)
+					return true;
+				if(m > n)
+					return false;
+				const char* last = s + n - m;
+				if(!_icase) {
+					for(const char* p = s; (p = static_cast<const char*>(memchr(p, _text[0], static_cast<size_t>(last - p) + 1))) != nullptr; ++p)
+						if(memcmp(p, _text.data(), m) == 0)
+							return true;
+					return false;
+				}
+				for(const char* p = s; p <= last; ++p)
+					if(_fold(*p) == _text[0] && __regedit_details::names::eq(p, m, _text.data(), m))
+						return true;
+				return false;
+			}
+
+			friend class __regedit_details::_search_path;
+
+		public:
+
+			search_pattern() {}
+
+			static search_pattern exact(const std::string& text, bool icase = true) {
+				return search_pattern(kind::exact, text, icase);
+			}
+			static search_pattern substring(const std::string& text, bool icase = true) {
+				return search_pattern(kind::substring, text, icase);
+			}
+			static search_pattern glob(const std::string& text, bool icase = true) {
+				return search_pattern(kind::glob, text, icase);
+			}
+			// throws std::regex_error if 'text' isn't a valid expression
+			static search_pattern regex(const std::string& text, bool icase = true) {
+				search_pattern ret(kind::regex, text, false);
+				ret._icase = icase;
+				ret._re = std::make_shared<const std::regex>(text, icase ? std::regex::ECMAScript | std::regex::icase : std::regex::ECMAScript);
+				return ret;
+			}
+
+			kind type() const {
+				return _kind;
+			}
+			bool any() const {
+				return _kind == kind::any;
+			}
+			const std::string& text() const {
+				return _text;
+			}
+
+			// regexes search for a match anywhere on the string (std::regex_search), anchor them with ^ and $ to match it whole
+			bool match(const char* s, size_t n) const {
+				switch(_kind) {
+					case kind::any:
+						return true;
+					case kind::exact:
+						return n == _text.size() && (_icase ? __regedit_details::names::eq(s, n, _text.data(), n) : memcmp(s, _text.data(), n) == 0);
+					case kind::substring:
+						return _find(s, n);
+					case kind::glob:
+						return _glob(*this, _text.data(), _text.size(), s, n);
+					case kind::regex:
+						return std::regex_search(s, s + n, *_re);
+				}
+				return false;
+			}
+			bool match(const std::string& s) const {
+				return match(s.data(), s.size());
+			}
+
+	};
+
+	struct search_query {
+		search_pattern path;                        // key path relative to the root, '\' separated, "" for the root
+		search_pattern name;                        // value name, "" for the default value
+		std::vector<__regedit_details::type> types; // value types, empty for any
+		search_pattern data;                        // string data : sz, expand_sz, link and each string of a multi_sz
+		bool numeric = false;                       // dword, dword_big_endian and qword data in [min, max]
+		__regedit_details::DWORD64 min = 0;
+		__regedit_details::DWORD64 max = ~__regedit_details::DWORD64(0);
+		size_t max_depth = static_cast<size_t>(-1); // 0 : the root only
+		bool keys = false;                          // also report the keys matching 'path' (name, types and data don't apply to them)
+		bool values = true;                         // report the values matching every field
+	};
+
+	template<class Backend>
+	struct search_hit {
+		const std::string& path;              // of the key, relative to the search root
+		const basic_regedit<Backend>& key;
+		const char* name;                     // value name, nullptr on key hits
+		__regedit_details::type ty;
+		const __regedit_details::BYTE* data;  // raw value data when the query had a data predicate, nullptr otherwise
+		__regedit_details::DWORD size;        // data size, even when not read
+	};
+
+	namespace __regedit_details {
+
+		// key path pattern, globs are kept split by key so the subtrees can be pruned
+		class _search_path {
+
+			private:
+
+				const search_pattern& _pat;
+				std::vector<std::string> _parts;
+
+				static void _split(const char* s, size_t n, std::vector<std::pair<const char*, size_t>>& out) {
+					out.clear();
+					if(n == 0)
+						return;
+					for(const char* end = s + n;;) {
+						const char* sep = static_cast<const char*>(memchr(s, '\\', static_cast<size_t>(end - s)));
+						if(sep == nullptr) {
+							out.emplace_back(s, static_cast<size_t>(end - s));
+							return;
+						}
+						out.emplace_back(s, static_cast<size_t>(sep - s));
+						s = sep + 1;
+					}
+				}
+
+				bool _glob_from(size_t pi, const std::vector<std::pair<const char*, size_t>>& keys, size_t ki) const {
+					for(; pi < _parts.size(); ++pi, ++ki) {
+						if(_parts[pi] == "**") {
+							for(size_t k = ki; k <= keys.size(); ++k)
+								if(_glob_from(pi + 1, keys, k))
+									return true;
+							return false;
+						}
+						if(ki >= keys.size() || !search_pattern::_glob(_pat, _parts[pi].data(), _parts[pi].size(), keys[ki].first, keys[ki].second))
+							return false;
+					}
+					return ki == keys.size();
+				}
+
+			public:
+
+				_search_path(const search_pattern& pat) : _pat(pat) {
+					if(pat.type() == search_pattern::kind::glob) {
+						std::vector<std::pair<const char*, size_t>> parts;
+						_split(pat.text().data(), pat.text().size(), parts);
+						for(const std::pair<const char*, size_t>& p : parts)
+							_parts.emplace_back(p.first, p.second);
+					}
+				}
+
+				bool match(const std::string& path) const {
+					if(_pat.type() != search_pattern::kind::glob)
+						return _pat.match(path);
+					std::vector<std::pair<const char*, size_t>> keys;
+					_split(path.data(), path.size(), keys);
+					return _glob_from(0, keys, 0);
+				}
+
+				// false when no key below 'path' (or itself) can match
+				bool reachable(const std::string& path) const {
+					if(_pat.type() == search_pattern::kind::exact) {
+						const std::string& t = _pat.text();
+						size_t n = path.size();
+						if(n > t.size() || (n < t.size() && n != 0 && t[n] != '\\'))
+							return false;
+						return _pat._icase ? names::eq(path.data(), n, t.data(), n) : memcmp(path.data(), t.data(), n) == 0;
+					}
+					if(_pat.type() != search_pattern::kind::glob)
+						return true;
+					std::vector<std::pair<const char*, size_t>> keys;
+					_split(path.data(), path.size(), keys);
+					for(size_t i = 0; i < keys.size(); ++i) {
+						if(i >= _parts.size())
+							return false;
+						if(_parts[i] == "**")
+							return true;
+						if(!search_pattern::_glob(_pat, _parts[i].data(), _parts[i].size(), keys[i].first, keys[i].second))
+							return false;
+					}
+					return true;
+				}
+
+		};
+
+		template<class Backend, class Callback>
+		class searcher {
+
+			private:
+
+				const search_query& _q;
+				_search_path _path;
+				Callback& _fn;
+				uint32_t _types = 0; // bit per type, all set for any
+				std::mutex _mtx;
+				std::atomic<bool> _stop{ false };
+
+				bool _call(const search_hit<Backend>& h, std::true_type) {
+					_fn(h);
+					return true;
+				}
+				bool _call(const search_hit<Backend>& h, std::false_type) {
+					return static_cast<bool>(_fn(h));
+				}
+				// one hit at a time, from whichever worker found it
+				bool _emit(const search_hit<Backend>& h) {
+					std::lock_guard<std::mutex> lock(_mtx);
+					if(_stop.load(std::memory_order_relaxed))
+						return false;
+					if(!_call(h, std::is_void<decltype(_fn(h))>())) {
+						_stop = true;
+						return false;
+					}
+					return true;
+				}
+
+				static bool _is_text(type ty) {
+					return ty == type::sz || ty == type::expand_sz || ty == type::link || ty == type::multi_sz;
+				}
+				static bool _is_number(type ty) {
+					return ty == type::dword || ty == type::dword_big_endian || ty == type::qword;
+				}
+				bool _wants_data(type ty) const {
+					return (!_q.data.any() && _is_text(ty)) || (_q.numeric && _is_number(ty));
+				}
+
+				bool _match_data(type ty, const BYTE* data, DWORD len) const {
+					const char* s = reinterpret_cast<const char*>(data);
+					switch(ty) {
+						case type::sz:
+						case type::expand_sz:
+						case type::link:
+							return _q.data.match(s, strnlen(s, len));
+						case type::multi_sz:
+							for(const char* end = s + len; s < end && *s != '\0'; ) {
+								size_t n = strnlen(s, static_cast<size_t>(end - s));
+								if(_q.data.match(s, n))
+									return true;
+								s += n + 1;
+							}
+							return false;
+						case type::dword:
+						case type::dword_big_endian: {
+							if(len < sizeof(DWORD))
+								return false;
+							DWORD v;
+							memcpy(&v, data, sizeof(v));
+							if(ty == type::dword_big_endian)
+								v = (v >> 24) | ((v >> 8) & 0xFF00) | ((v << 8) & 0xFF0000) | (v << 24);
+							return v >= _q.min && v <= _q.max;
+						}
+						case type::qword: {
+							if(len < sizeof(DWORD64))
+								return false;
+							DWORD64 v;
+							memcpy(&v, data, sizeof(v));
+							return v >= _q.min && v <= _q.max;
+						}
+						default:
+							return false;
+					}
+				}
+
+				void _values(const walk_entry<Backend>& e) {
+					bool by_data = !_q.data.any() || _q.numeric;
+					read_overload::_buffer buff;
+					for(const snapshot_entry& v : e.values) {
+						if(_stop.load(std::memory_order_relaxed))
+							return;
+						DWORD t = static_cast<DWORD>(v.ty);
+						if(t >= 32 ? _types != ~uint32_t(0) : (_types & (uint32_t(1) << t)) == 0)
+							continue;
+						if(!_q.name.match(v.name, v.length))
+							continue;
+						const BYTE* data = nullptr;
+						DWORD len = v.size;
+						if(by_data) {
+							if(!_wants_data(v.ty))
+								continue;
+							if(read_overload::_query<Backend>(e.key.native_handle(), v.name, nullptr, buff, &len) != status::success)
+								continue;
+							data = buff.data();
+							if(!_match_data(v.ty, data, len))
+								continue;
+						}
+						if(!_emit(search_hit<Backend>{ e.path, e.key, v.name, v.ty, data, len }))
+							return;
+					}
+				}
+
+			public:
+
+				searcher(const search_query& q, Callback& fn) : _q(q), _path(q.path), _fn(fn) {
+					if(q.types.empty())
+						_types = ~uint32_t(0);
+					for(type ty : q.types)
+						if(static_cast<DWORD>(ty) < 32)
+							_types |= uint32_t(1) << static_cast<DWORD>(ty);
+				}
+
+				// asked by the walk before opening a subkey
+				bool enter(const std::string& path) {
+					return !_stop.load(std::memory_order_relaxed) && _path.reachable(path);
+				}
+				// walk visitor, false skips the subkeys
+				bool operator()(const walk_entry<Backend>& e) {
+					if(_stop.load(std::memory_order_relaxed) || !_path.reachable(e.path))
+						return false;
+					if(_path.match(e.path)) {
+						if(_q.keys && !_emit(search_hit<Backend>{ e.path, e.key, nullptr, type::none, nullptr, 0 }))
+							return false;
+						if(_q.values)
+							_values(e);
+					}
+					return e.depth < _q.max_depth && !_stop.load(std::memory_order_relaxed);
+				}
+
+		};
+
+	}
+
+	/*
+		finds the keys and values below 'root' (itself included) matching 'query' with 'threads' workers (0 : one per hardware thread),
+		'on_hit' gets a const neo::search_hit<Backend>& per match as soon as it's found, valid during the call only, returning false ends the search
+	*/
+	template<class Backend, class Callback>
+	walk_stats search(const basic_regedit<Backend>& root, const search_query& query, Callback on_hit, size_t threads = 0) {
+		__regedit_details::searcher<Backend, Callback> s(query, on_hit);
+		__regedit_details::walker<Backend, __regedit_details::searcher<Backend, Callback>> w(root, s, threads, false);
+		return w.run();
+	}
+
+}
+
+
+
+#endif
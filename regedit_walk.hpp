@@ -0,0 +1,357 @@
+#pragma once
+
+#ifndef __NEO_REGEDIT_WALK_HPP__
+#define __NEO_REGEDIT_WALK_HPP__
+
+
+/*
+	Header name: regedit_walk.hpp
+	Author: neo3587
+
+	Notes:
+		- neo::parallel_walk() visits a whole subtree with a pool of workers, works with any backend (live registry, memory, offline hives)
+		- Every worker opens its own (read only) handles, the pending subkeys are kept in one deque per worker:
+			the owner takes the newest ones (depth first), idle workers steal the oldest ones (the biggest subtrees)
+		- The visitor gets a neo::walk_entry : the key path relative to the root, the opened key, its subkey names and its value names,
+			types and sizes taken in one pass. Returning false from the visitor skips the subkeys of that key
+		- Unordered walks call the visitor from every worker at once, it has to be thread safe
+		- Ordered walks call it from the calling thread only, in the same order than a recursive begin() / end() loop (parent first,
+			subkeys in enumeration order), the workers keep walking ahead and the keys not yet visited stay buffered : there's no cap,
+			a slow visitor can end up with most of the subtree in memory (the opened key, its subkey names and its value snapshot per key,
+			and the handle stays open until the key is visited). Use an unordered walk, or a plain recursive loop, over big subtrees
+		- The memory backend serializes every call on its store, walks over it don't scale with the threads
+		- A visitor object with a 'bool enter(const std::string& path)' member is asked before every subkey is visited, false skips it whole.
+			Unordered walks ask it from the workers, before opening the subkey. Ordered walks ask it from the calling thread, in visit order,
+			the workers may have opened the subkey ahead already
+*/
+
+
+
+#include "regedit.hpp"
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <thread>
+
+
+
+namespace neo {
+
+	struct walk_stats {
+		size_t keys = 0;   // visited keys
+		size_t values = 0; // values of the visited keys
+		size_t failed = 0; // keys that couldn't be opened (access denied, deleted meanwhile, ...)
+	};
+
+	template<class Backend>
+	struct walk_entry {
+		const std::string& path; // relative to the walk root, '\' separated, empty for the root itself
+		size_t depth;
+		const basic_regedit<Backend>& key;
+		const typename basic_regedit<Backend>::key_snapshot& subkeys;
+		const typename basic_regedit<Backend>::values::value_snapshot& values; // with types and sizes
+	};
+
+	namespace __regedit_details {
+
+		template<class T>
+		class steal_deque {
+
+			private:
+
+				std::mutex _mtx;
+				std::deque<T> _items;
+
+			public:
+
+				void push(T&& item) {
+					std::lock_guard<std::mutex> lock(_mtx);
+					_items.push_back(std::move(item));
+				}
+				// owner side, newest first
+				bool pop(T& out) {
+					std::lock_guard<std::mutex> lock(_mtx);
+					if(_items.empty())
+						return false;
+					out = std::move(_items.back());
+					_items.pop_back();
+					return true;
+				}
+				// thief side, oldest first
+				bool steal(T& out) {
+					std::lock_guard<std::mutex> lock(_mtx);
+					if(_items.empty())
+						return false;
+					out = std::move(_items.front());
+					_items.pop_front();
+					return true;
+				}
+
+		};
+
+		template<class Backend, class Visitor>
+		class walker {
+
+			private:
+
+				using DWORD        = __regedit_details::DWORD;
+				using regedit      = basic_regedit<Backend>;
+				using key_snapshot = typename regedit::key_snapshot;
+				using val_snapshot = typename regedit::values::value_snapshot;
+
+				// a visited key, ordered walks keep it until the output reaches it
+				struct _node {
+					std::string path; // ordered walks : set by the worker of the parent, before it's ready
+					size_t depth = 0;
+					regedit key;
+					std::shared_ptr<key_snapshot> keys;
+					val_snapshot vals;
+					std::vector<std::unique_ptr<_node>> children;
+					std::atomic<bool> ready{ false };
+					std::atomic<bool> skip{ false };
+					bool failed = false;
+					bool entered = false; // ordered walks : enter() asked, calling thread only
+				};
+				struct _task {
+					std::shared_ptr<key_snapshot> parent; // the root task has none
+					DWORD pos = 0;
+					std::string path;
+					size_t depth = 0;
+					_node* node = nullptr; // ordered walks only
+				};
+
+				regedit _root;
+				Visitor& _fn;
+				size_t _threads;
+				bool _ordered;
+
+				std::unique_ptr<steal_deque<_task>[]> _queues;
+				std::atomic<size_t> _pending{ 0 };
+				std::atomic<bool> _stop{ false };
+				std::atomic<size_t> _keys{ 0 }, _values{ 0 }, _failed{ 0 };
+				std::mutex _err_mtx;
+				std::exception_ptr _error;
+				std::vector<std::unique_ptr<_node>> _stack; // ordered output, outlives the workers
+
+				bool _visit(const _node& n, std::true_type) {
+					_fn(walk_entry<Backend>{ n.path, n.depth, n.key, *n.keys, n.vals });
+					return true;
+				}
+				bool _visit(const _node& n, std::false_type) {
+					return static_cast<bool>(_fn(walk_entry<Backend>{ n.path, n.depth, n.key, *n.keys, n.vals }));
+				}
+				bool _visit(const _node& n) {
+					return _visit(n, std::is_void<decltype(_fn(std::declval<const walk_entry<Backend>&>()))>());
+				}
+
+				template<class V>
+				static auto _enter(V& fn, const std::string& path, int) -> decltype(static_cast<bool>(fn.enter(path))) {
+					return static_cast<bool>(fn.enter(path));
+				}
+				template<class V>
+				static bool _enter(V&, const std::string&, long) {
+					return true;
+				}
+
+				void _fail(std::exception_ptr err) {
+					std::lock_guard<std::mutex> lock(_err_mtx);
+					if(!_error)
+						_error = err;
+					_stop = true;
+				}
+
+				void _push(size_t self, _task&& t) {
+					_pending.fetch_add(1, std::memory_order_relaxed);
+					_queues[self].push(std::move(t));
+				}
+
+				void _process(size_t self, _task& t) {
+					_node local;
+					_node& n = t.node != nullptr ? *t.node : local;
+					try {
+						if(!n.skip.load(std::memory_order_acquire)) {
+							n.key = t.parent ? t.parent->open(t.pos) : _root;
+							if(!n.key.is_open()) {
+								n.failed = true;
+								if(!_ordered) // counted by _emit(), unless it skips it
+									_failed.fetch_add(1, std::memory_order_relaxed);
+							}
+							else {
+								if(t.node == nullptr) {
+									n.path = std::move(t.path);
+									n.depth = t.depth;
+								}
+								n.keys = std::make_shared<key_snapshot>(n.key.snapshot());
+								n.vals = n.key.values.snapshot(true);
+								if(!_ordered) {
+									_keys.fetch_add(1, std::memory_order_relaxed);
+									_values.fetch_add(n.vals.size(), std::memory_order_relaxed);
+								}
+								if(_ordered || _visit(n)) {
+									if(_ordered) {
+										n.children.resize(n.keys->size());
+										for(std::unique_ptr<_node>& c : n.children)
+											c.reset(new _node());
+									}
+									for(DWORD i = static_cast<DWORD>(n.keys->size()); i-- > 0; ) { // reversed, the owner pops the first subkey first
+										_task child;
+										child.parent = n.keys;
+										child.pos = i;
+										std::string path = n.path.empty() ? std::string((*n.keys)[i].name) : n.path + '\\' + (*n.keys)[i].name;
+										if(_ordered) { // enter() is left to _emit()
+											child.node = n.children[i].get();
+											child.node->path = std::move(path);
+											child.node->depth = n.depth + 1;
+										}
+										else {
+											if(!_enter(_fn, path, 0))
+												continue;
+											child.path = std::move(path);
+											child.depth = n.depth + 1;
+										}
+										_push(self, std::move(child));
+									}
+								}
+							}
+						}
+					}
+					catch(...) {
+						n.failed = true;
+						_fail(std::current_exception());
+					}
+					if(t.node != nullptr)
+						t.node->ready.store(true, std::memory_order_release);
+				}
+
+				bool _run_one(size_t self) {
+					_task t;
+					if(!_queues[self].pop(t) && !_steal(self, t))
+						return false;
+					_process(self, t);
+					_pending.fetch_sub(1, std::memory_order_acq_rel);
+					return true;
+				}
+				bool _steal(size_t self, _task& t) {
+					for(size_t i = 1; i < _threads; ++i)
+						if(_queues[(self + i) % _threads].steal(t))
+							return true;
+					return false;
+				}
+				static void _backoff(size_t& idle) {
+					if(++idle < 64)
+						std::this_thread::yield();
+					else
+						std::this_thread::sleep_for(std::chrono::microseconds(50));
+				}
+
+				void _work(size_t self) {
+					size_t idle = 0;
+					while(!_stop.load(std::memory_order_relaxed)) {
+						if(_run_one(self))
+							idle = 0;
+						else if(_pending.load(std::memory_order_acquire) == 0)
+							break;
+						else
+							_backoff(idle);
+					}
+				}
+
+				// depth first over the nodes as they get ready, the calling thread runs tasks too while it waits
+				void _emit(std::unique_ptr<_node> top) {
+					_stack.push_back(std::move(top));
+					size_t idle = 0;
+					while(!_stack.empty() && !_stop.load(std::memory_order_relaxed)) {
+						_node& n = *_stack.back();
+						if(!n.entered) { // path and depth were set before the parent got ready
+							n.entered = true;
+							if(n.depth != 0 && !n.skip.load(std::memory_order_relaxed) && !_enter(_fn, n.path, 0))
+								n.skip.store(true, std::memory_order_release);
+						}
+						if(!n.ready.load(std::memory_order_acquire)) {
+							if(_run_one(0))
+								idle = 0;
+							else
+								_backoff(idle);
+							continue;
+						}
+						std::unique_ptr<_node> cur = std::move(_stack.back());
+						_stack.pop_back();
+						bool skip = cur->skip.load(std::memory_order_relaxed);
+						if(!skip && cur->failed) {
+							_failed.fetch_add(1, std::memory_order_relaxed);
+							skip = true;
+						}
+						else if(!skip) {
+							_keys.fetch_add(1, std::memory_order_relaxed);
+							_values.fetch_add(cur->vals.size(), std::memory_order_relaxed);
+							skip = !_visit(*cur);
+						}
+						for(size_t i = cur->children.size(); i-- > 0; ) {
+							if(skip)
+								cur->children[i]->skip.store(true, std::memory_order_release);
+							_stack.push_back(std::move(cur->children[i]));
+						}
+					}
+				}
+
+			public:
+
+				walker(const regedit& root, Visitor& fn, size_t threads, bool ordered) : _root(root.native_handle(), "", false), _fn(fn), _ordered(ordered) {
+					_threads = threads != 0 ? threads : (std::max)(1u, std::thread::hardware_concurrency());
+					_queues.reset(new steal_deque<_task>[_threads]);
+				}
+
+				walk_stats run() {
+					walk_stats stats;
+					if(!_root.is_open()) {
+						stats.failed = 1;
+						return stats;
+					}
+					std::unique_ptr<_node> top;
+					_task t;
+					if(_ordered) {
+						top.reset(new _node());
+						t.node = top.get();
+					}
+					_push(0, std::move(t));
+
+					std::vector<std::thread> pool;
+					try {
+						for(size_t i = 1; i < _threads; ++i)
+							pool.emplace_back(&walker::_work, this, i);
+						if(_ordered)
+							_emit(std::move(top));
+						else
+							_work(0);
+					}
+					catch(...) {
+						_fail(std::current_exception());
+					}
+					for(std::thread& th : pool)
+						th.join();
+					if(_error)
+						std::rethrow_exception(_error);
+
+					stats.keys = _keys;
+					stats.values = _values;
+					stats.failed = _failed;
+					return stats;
+				}
+
+		};
+
+	}
+
+	// visits 'root' and every key below it with 'threads' workers (0 : one per hardware thread, the calling thread is one of them)
+	template<class Backend, class Visitor>
+	walk_stats parallel_walk(const basic_regedit<Backend>& root, Visitor visitor, size_t threads = 0, bool ordered = false) {
+		__regedit_details::walker<Backend, Visitor> w(root, visitor, threads, ordered);
+		return w.run();
+	}
+
+
+}
+
+
+
+#endif
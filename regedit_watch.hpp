@@ -0,0 +1,416 @@
+#pragma once
+
+#ifndef __NEO_REGEDIT_WATCH_HPP__
+#define __NEO_REGEDIT_WATCH_HPP__
+
+
+/*
+	Header name: regedit_watch.hpp
+	Author: neo3587
+
+	Notes:
+		- neo::change_feed keeps a baseline of a subtree (per key: its change stamps, its subkeys, the type and a content hash of each value)
+			and poll() brings it up to date, logging what was added, removed and changed since the previous poll as neo::diff() entries
+			(a removed key is one entry for its whole subtree, an added key is followed by its values and its subkeys)
+		- The log is read through cursors : cursor() is the position after the last entry, since(cursor) gives the entries after 'cursor'
+			and moves it past them, changes(cursor) polls first. trim(cursor) drops the entries before 'cursor' (once every reader is past it)
+		- Only the hashes of the values are kept : a changed_value entry has the new type and data and the old type, its old_data is empty
+		- An unchanged subtree is skipped without opening it : the memory backend stamps every change on the key and on all its ancestors
+			(query_change_stamp()), polling an unchanged tree is a single backend call whatever its size. On the other backends the last write
+			time of each key (query_key_info()) saves reading the unchanged keys again but every key is visited, a backend without it (packed
+			files) is read again entirely
+		- On Windows, a live registry subtree is watched through RegNotifyChangeKeyValue : no notification since the previous poll means no
+			walk at all. The last write times have the resolution of the system timer, the keys written within the last second are read
+			again on the next walk
+		- change_feed is thread safe, polls are serialized
+*/
+
+
+
+#include "regedit_diff.hpp"
+#include <deque>
+#include <memory>
+
+
+
+namespace neo {
+
+	struct feed_stats {
+		size_t keys = 0;    // keys whose stamps were checked
+		size_t read = 0;    // keys read again (values and subkeys)
+		size_t skipped = 0; // subtrees skipped by their stamp, or whole polls by a missing notification
+		size_t entries = 0;
+	};
+
+	template<class Backend>
+	class change_feed {
+
+		private:
+
+			using DWORD   = __regedit_details::DWORD;
+			using DWORD64 = __regedit_details::DWORD64;
+			using handle  = typename Backend::handle;
+			using regedit = basic_regedit<Backend>;
+			using kind    = diff_entry::kind;
+
+			using _keep = __regedit_details::_has_query_change_stamp<Backend>; // cheap handles, kept open
+			#ifdef _WIN32
+			using _is_live = std::is_same<handle, HKEY>; // RegNotifyChangeKeyValue
+			#else
+			using _is_live = std::false_type;
+			#endif
+
+			struct _value_state {
+				std::string name;
+				__regedit_details::type ty;
+				uint64_t hash;
+			};
+			struct _key_state {
+				std::string name;
+				regedit key; // kept open on the backends with query_change_stamp(), the others are opened again on each walk
+				DWORD64 stamp = 0, tree = 0; // 0 : unknown, read again
+				std::vector<_value_state> vals; // both sorted by name (case insensitive)
+				std::vector<std::unique_ptr<_key_state>> keys;
+			};
+
+			#ifdef _WIN32
+			// RegNotifyChangeKeyValue over the subtree, signaled on the first change after arm()
+			class _notify {
+
+				private:
+
+					HANDLE _ev = NULL;
+					bool _armed = false;
+
+				public:
+
+					_notify() {}
+					_notify(const _notify&) = delete;
+					_notify& operator=(const _notify&) = delete;
+					~_notify() {
+						if(_ev != NULL)
+							CloseHandle(_ev);
+					}
+
+					bool arm(HKEY hk) {
+						if(_ev == NULL && (_ev = CreateEventW(NULL, FALSE, FALSE, NULL)) == NULL)
+							return _armed = false;
+						const DWORD filter = REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET;
+						const DWORD thread_agnostic = 0x10000000L; // REG_NOTIFY_THREAD_AGNOSTIC, missing on older SDKs
+						LONG ret = RegNotifyChangeKeyValue(hk, TRUE, filter | thread_agnostic, _ev, TRUE);
+						if(ret == ERROR_INVALID_PARAMETER) // before Windows 8, the notification ends with the thread
+							ret = RegNotifyChangeKeyValue(hk, TRUE, filter, _ev, TRUE);
+						return _armed = ret == ERROR_SUCCESS;
+					}
+					// nothing changed since arm()
+					bool quiet() const {
+						return _armed && WaitForSingleObject(_ev, 0) == WAIT_TIMEOUT;
+					}
+
+			};
+			#endif
+
+			regedit _root;
+			_key_state _base;
+			std::deque<diff_entry> _log;
+			uint64_t _first = 0; // sequence of _log.front()
+			std::string _path;
+			DWORD64 _recent = ~DWORD64(0); // last write times from it on aren't kept (same timer tick than a later write)
+			bool _watch, _gone = false;
+			feed_stats _stats;
+			mutable std::mutex _mtx;
+			#ifdef _WIN32
+			_notify _ntf;
+			#endif
+
+			static bool _name_less(const std::string& l, const char* r, size_t rlen) {
+				return __regedit_details::names::cmp(l.data(), l.size(), r, rlen) < 0;
+			}
+
+			void _emit(kind what, const std::string* name = nullptr) {
+				diff_entry e;
+				e.what = what;
+				e.path = _path;
+				if(name != nullptr)
+					e.name = *name;
+				_log.push_back(std::move(e));
+				++_stats.entries;
+			}
+			void _removed(const _value_state& v) {
+				_emit(kind::removed_value, &v.name);
+				_log.back().old_ty = v.ty;
+			}
+			void _emit_value(kind what, const __regedit_details::value_info& v) {
+				diff_entry e;
+				e.what = what;
+				e.path = _path;
+				e.name.assign(v.name, v.length);
+				e.ty = v.ty;
+				e.data.assign(v.data, v.data + v.size);
+				_log.push_back(std::move(e));
+				++_stats.entries;
+			}
+
+			void _enter(const std::string& name, size_t& base) {
+				base = _path.size();
+				if(!_path.empty())
+					_path.push_back('\\');
+				_path.append(name);
+			}
+
+			// stamps taken before reading, a change while reading gives a newer stamp and a new read on the next poll
+			bool _stamps(const regedit& key, DWORD64& stamp, DWORD64& tree) {
+				++_stats.keys;
+				if(__regedit_details::_query_change_stamp<Backend>(key.native_handle(), &stamp, &tree, __regedit_details::_has_query_change_stamp<Backend>()) != __regedit_details::status::success)
+					return false;
+				if(tree == 0 && stamp >= _recent)
+					stamp = 0;
+				return true;
+			}
+
+			// the values of 'key' against the baseline, 'emit' false while building it
+			void _values(const regedit& key, _key_state& st, bool emit) {
+				auto table = key.values.query_all();
+				std::vector<const __regedit_details::value_info*> cur;
+				cur.reserve(table.size());
+				for(const __regedit_details::value_info& v : table)
+					cur.push_back(&v);
+				std::sort(cur.begin(), cur.end(), [](const __regedit_details::value_info* x, const __regedit_details::value_info* y) {
+					return __regedit_details::names::cmp(x->name, x->length, y->name, y->length) < 0;
+				});
+				std::vector<_value_state> vals;
+				vals.reserve(cur.size());
+				size_t i = 0;
+				for(const __regedit_details::value_info* v : cur) {
+					uint64_t h = __regedit_details::_data_hash(static_cast<DWORD>(v->ty), v->data, v->size);
+					for(; i < st.vals.size() && _name_less(st.vals[i].name, v->name, v->length); ++i)
+						if(emit)
+							_removed(st.vals[i]);
+					if(i < st.vals.size() && __regedit_details::names::cmp(st.vals[i].name.data(), st.vals[i].name.size(), v->name, v->length) == 0) {
+						if(emit && (st.vals[i].ty != v->ty || st.vals[i].hash != h)) {
+							_emit_value(kind::changed_value, *v);
+							_log.back().old_ty = st.vals[i].ty;
+						}
+						++i;
+					}
+					else if(emit)
+						_emit_value(kind::added_value, *v);
+					vals.push_back(_value_state{ std::string(v->name, v->length), v->ty, h });
+				}
+				for(; emit && i < st.vals.size(); ++i)
+					_removed(st.vals[i]);
+				st.vals.swap(vals);
+			}
+
+			// reads the whole subtree of 'key' into 'st', logged as added if 'emit', false if the key is gone
+			bool _build(const regedit& key, _key_state& st, bool emit) {
+				if(!_stamps(key, st.stamp, st.tree))
+					return false;
+				if(_keep::value)
+					st.key = key;
+				++_stats.read;
+				if(emit)
+					_emit(kind::added_key);
+				_values(key, st, emit);
+				typename regedit::key_snapshot keys = key.snapshot();
+				std::vector<const __regedit_details::snapshot_entry*> sorted = __regedit_details::_diff_sorted(keys);
+				st.keys.reserve(sorted.size());
+				for(const __regedit_details::snapshot_entry* e : sorted) {
+					regedit sub = keys.open(*e);
+					if(!sub.is_open())
+						continue;
+					std::unique_ptr<_key_state> child(new _key_state);
+					child->name.assign(e->name, e->length);
+					size_t base;
+					_enter(child->name, base);
+					if(_build(sub, *child, emit))
+						st.keys.push_back(std::move(child));
+					_path.resize(base);
+				}
+				return true;
+			}
+
+			// 'key' against its baseline 'st', false if the key is gone
+			bool _sync(const regedit& key, _key_state& st) {
+				DWORD64 stamp = 0, tree = 0;
+				if(!_stamps(key, stamp, tree))
+					return false;
+				if(tree != 0 && tree == st.tree) {
+					++_stats.skipped;
+					return true;
+				}
+				bool changed = stamp == 0 || stamp != st.stamp;
+				st.stamp = stamp;
+				st.tree = tree;
+				if(!changed) { // same subkeys, only the ones below can differ
+					for(std::unique_ptr<_key_state>& child : st.keys) {
+						size_t base;
+						_enter(child->name, base);
+						regedit sub = _keep::value ? child->key : regedit(key.native_handle(), child->name, false);
+						if(sub.is_open())
+							_sync(sub, *child);
+						_path.resize(base);
+					}
+					return true;
+				}
+				++_stats.read;
+				_values(key, st, true);
+				typename regedit::key_snapshot keys = key.snapshot();
+				std::vector<const __regedit_details::snapshot_entry*> sorted = __regedit_details::_diff_sorted(keys);
+				std::vector<std::unique_ptr<_key_state>> children;
+				children.reserve(sorted.size());
+				size_t i = 0;
+				for(const __regedit_details::snapshot_entry* e : sorted) {
+					for(; i < st.keys.size() && _name_less(st.keys[i]->name, e->name, e->length); ++i) {
+						size_t base;
+						_enter(st.keys[i]->name, base);
+						_emit(kind::removed_key);
+						_path.resize(base);
+					}
+					size_t base;
+					if(i < st.keys.size() && __regedit_details::names::cmp(st.keys[i]->name.data(), st.keys[i]->name.size(), e->name, e->length) == 0) {
+						std::unique_ptr<_key_state> child = std::move(st.keys[i++]);
+						_enter(child->name, base);
+						// the kept handle first, a key deleted and created again needs a new one
+						if(!_keep::value || !child->key.is_open() || !_sync(child->key, *child)) {
+							regedit sub = keys.open(*e);
+							if(_keep::value)
+								child->key = sub;
+							if(sub.is_open() && !_sync(sub, *child)) {
+								_emit(kind::removed_key);
+								child.reset();
+							}
+						}
+						if(child != nullptr) // not opened : deleted since the snapshot, seen on the next poll
+							children.push_back(std::move(child));
+					}
+					else {
+						regedit sub = keys.open(*e);
+						std::unique_ptr<_key_state> child(new _key_state);
+						child->name.assign(e->name, e->length);
+						_enter(child->name, base);
+						if(sub.is_open() && _build(sub, *child, true))
+							children.push_back(std::move(child));
+					}
+					_path.resize(base);
+				}
+				for(; i < st.keys.size(); ++i) {
+					size_t base;
+					_enter(st.keys[i]->name, base);
+					_emit(kind::removed_key);
+					_path.resize(base);
+				}
+				st.keys.swap(children);
+				return true;
+			}
+
+			#ifdef _WIN32
+			void _arm(std::true_type) {
+				FILETIME ft;
+				GetSystemTimeAsFileTime(&ft);
+				DWORD64 now = (static_cast<DWORD64>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+				_recent = now - 10000000; // 1 second, in 100 ns units
+				if(_watch && !_ntf.arm(_root.native_handle()))
+					_watch = false;
+			}
+			bool _quiet(std::true_type) const {
+				return _watch && _ntf.quiet();
+			}
+			#endif
+			template<class T> void _arm(T) {}
+			template<class T> bool _quiet(T) const {
+				return false;
+			}
+
+		public:
+
+			// Constructors:
+
+			// reads the baseline of 'root', 'notify' : watch it with RegNotifyChangeKeyValue (live registry only)
+			explicit change_feed(const regedit& root, bool notify = true) : _root(root), _watch(notify && _is_live::value) {
+				if(!_root.is_open())
+					throw std::logic_error("neo::change_feed(): trying to watch an unvalid key");
+				_arm(_is_live());
+				_build(_root, _base, false);
+				_stats = feed_stats();
+			}
+			change_feed(const change_feed&) = delete;
+			change_feed& operator=(const change_feed&) = delete;
+
+			// Polling:
+
+			// logs the changes since the previous poll, returns how many entries were added (a deleted root gives a single removed_key "")
+			size_t poll() {
+				std::lock_guard<std::mutex> lock(_mtx);
+				_stats = feed_stats();
+				if(_gone)
+					return 0;
+				if(_quiet(_is_live())) {
+					++_stats.skipped;
+					return 0;
+				}
+				_arm(_is_live());
+				_path.clear();
+				if(!_sync(_root, _base)) {
+					_emit(kind::removed_key);
+					_base = _key_state();
+					_gone = true;
+				}
+				return _stats.entries;
+			}
+
+			// Log:
+
+			// position after the last entry
+			uint64_t cursor() const {
+				std::lock_guard<std::mutex> lock(_mtx);
+				return _first + _log.size();
+			}
+			// the entries after 'cursor', moved past them
+			std::vector<diff_entry> since(uint64_t& cursor) const {
+				std::lock_guard<std::mutex> lock(_mtx);
+				if(cursor < _first || cursor > _first + _log.size())
+					throw std::out_of_range("neo::change_feed::since(): cursor out of range (trimmed or not given by this feed)");
+				std::vector<diff_entry> out(_log.begin() + static_cast<ptrdiff_t>(cursor - _first), _log.end());
+				cursor = _first + _log.size();
+				return out;
+			}
+			// poll() and since()
+			std::vector<diff_entry> changes(uint64_t& cursor) {
+				poll();
+				return since(cursor);
+			}
+			// drops the entries before 'cursor'
+			void trim(uint64_t cursor) {
+				std::lock_guard<std::mutex> lock(_mtx);
+				while(_first < cursor && !_log.empty()) {
+					_log.pop_front();
+					++_first;
+				}
+			}
+
+			// Observers:
+
+			// entries kept on the log
+			size_t size() const {
+				std::lock_guard<std::mutex> lock(_mtx);
+				return _log.size();
+			}
+			// of the last poll
+			feed_stats stats() const {
+				std::lock_guard<std::mutex> lock(_mtx);
+				return _stats;
+			}
+			// RegNotifyChangeKeyValue is armed on the root
+			bool watching() const {
+				std::lock_guard<std::mutex> lock(_mtx);
+				return _watch;
+			}
+
+	};
+
+}
+
+
+
+#endif
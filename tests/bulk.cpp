@@ -0,0 +1,87 @@
+/*
+	Batched changes : insert_bulk(), erase_bulk() and clear() on the memory backend take a single backend call (counting<memory>),
+	delete exactly what they enumerated, and the read only backends (hive, packed) throw and keep everything
+
+	g++ -std=c++11 -O2 -I.. bulk.cpp -o bulk -lpthread
+	cl /std:c++14 /O2 /EHsc /I.. bulk.cpp
+*/
+
+#include "check.hpp"
+#include "../regedit_hive.hpp"
+#include "../regedit_packed.hpp"
+
+using namespace neo;
+using type = regedit::type;
+using counted = basic_regedit<regedit_backend::counting<regedit_backend::memory>>;
+using Counted = counted::backend_type;
+
+static void single_calls() {
+	regedit_backend::memory::store store;
+	counted key = counted(store.root())["app"];
+	std::vector<std::string> names;
+	for(int i = 0; i < 100; ++i)
+		names.push_back(numbered("n", i));
+
+	Counted::stats().reset();
+	CHECK(key.insert_bulk(names.begin(), names.end()) == 100);
+	CHECK(key.values.insert_bulk(names.begin(), names.end()) == 100);
+	CHECK(Counted::stats().create == 1 && Counted::stats().set_value == 1);
+	CHECK(key.size() == 100 && key.values.size() == 100 && key.values.at("N0042").type() == type::none);
+	CHECK(key.insert_bulk({ "n0000", "extra" }) == 1 && key.size() == 101); // the existing ones are skipped
+
+	Counted::stats().reset();
+	CHECK(key.erase_bulk({ "n0001", "n0002", "missing" }) == 2);
+	CHECK(key.values.erase_bulk({ "n0001", "missing" }) == 1);
+	CHECK(Counted::stats().delete_tree == 1 && Counted::stats().delete_value == 1);
+	CHECK(key.size() == 99 && key.values.size() == 99 && key.find("n0001") == key.end());
+
+	Counted::stats().reset();
+	key.clear();
+	key.values.clear();
+	CHECK(Counted::stats().delete_tree == 1 && Counted::stats().delete_value == 1);
+	CHECK(key.size() == 0 && key.values.size() == 0);
+}
+
+// read-only backends throw and keep everything, the memory backend deletes the subkeys or the values only
+static void clear() {
+	regedit_backend::memory::store store;
+	memory_regedit root(store.root());
+	memory_regedit key = root["app"];
+	key["a"]["deep"];
+	key["b"];
+	key.values["x"].write<type::dword>(1);
+	key.values["y"].write<type::sz>("y");
+
+	const std::string path = checks_dir + "clear.hiv";
+	CHECK(write_hive(root, path));
+	{
+		regedit_backend::hive::file hive(path);
+		CHECK(hive.is_open());
+		hive_regedit h(hive.root(), "app");
+		CHECK(throws([&] { h.clear(); }) && h.size() == 2);
+		CHECK(throws([&] { h.values.clear(); }) && h.values.size() == 2);
+	}
+	std::remove(path.c_str());
+
+	std::vector<__regedit_details::BYTE> packed;
+	CHECK(pack(root, packed));
+	regedit_backend::packed::file pf;
+	CHECK(pf.open(packed.data(), packed.size()));
+	packed_regedit p(pf.root(), "app");
+	CHECK(throws([&] { p.clear(); }) && p.size() == 2);
+	CHECK(throws([&] { p.values.clear(); }) && p.values.size() == 2);
+
+	key.clear();
+	CHECK(key.size() == 0 && key.values.size() == 2);
+	CHECK(!memory_regedit(store.root(), "app\\a\\deep").is_open());
+	key["c"];
+	key.values.clear();
+	CHECK(key.size() == 1 && key.values.size() == 0);
+}
+
+int main(int argc, char* argv[]) {
+	checks_init(argc, argv);
+	single_calls();
+	clear();
+	return checks_done();
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+/*
+	Shared by the checks in tests/ : every program prints its failed checks and exits with 1 if any (return checks_done()),
+	the files it writes go to the directory given as its first argument (the current one by default)
+*/
+
+#include "../regedit.hpp"
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static int checks_failed = 0;
+static std::string checks_dir;
+
+#define CHECK(cond) do { if(!(cond)) { std::printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #cond); ++checks_failed; } } while(false)
+
+inline void checks_init(int argc, char* argv[]) {
+	checks_dir = argc > 1 ? std::string(argv[1]) + "/" : std::string();
+}
+inline int checks_done() {
+	if(checks_failed != 0) {
+		std::printf("%d checks failed\n", checks_failed);
+		return 1;
+	}
+	std::printf("all checks passed\n");
+	return 0;
+}
+
+template<class Fn>
+inline bool throws(Fn fn) {
+	try {
+		fn();
+	}
+	catch(const std::exception&) {
+		return true;
+	}
+	return false;
+}
+
+inline std::string numbered(const char* prefix, int i) {
+	char buff[32];
+	std::snprintf(buff, sizeof(buff), "%s%04d", prefix, i);
+	return buff;
+}
+
+// every value type, UTF-8 names, a default value, and a key with 'wide' subkeys (the name index starts at 64)
+inline void sample_tree(neo::memory_regedit key, int wide = 100) {
+	using type = neo::regedit::type;
+	key.values[""].write<type::sz>("default");
+	key.values["sz"].write<type::sz>("Donn\xC3\xA9" "es");
+	key.values["expand"].write<type::expand_sz>("%SystemRoot%\\x");
+	std::vector<std::string> multi{ "a", "", "ccc" };
+	key.values["multi"].write<type::multi_sz>(multi.begin(), multi.end());
+	key.values["dword"].write<type::dword>(0xdeadbeef);
+	key.values["big endian"].write<type::dword_big_endian>(0x01020304);
+	key.values["qword"].write<type::qword>(0x123456789abcull);
+	const neo::__regedit_details::BYTE bin[] = { 0, 1, 2, 0xff };
+	key.values["binary"].write<type::binary>(bin, sizeof(bin));
+	key.values["empty binary"].write<type::binary>(bin, 0);
+	key.values["none"];
+	key["Param\xC3\xA8tres"].values["\xE2\x82\xAC"].write<type::dword>(1);
+	key["empty"];
+	for(int i = 0; i < wide; ++i)
+		key["wide"][numbered("k", i)].values[numbered("v", i)].write<type::dword>(static_cast<neo::__regedit_details::DWORD>(i));
+}
+
+// same subkeys and values (names, types and data) in the same order, over any two backends
+template<class A, class B>
+inline bool same_tree(const neo::basic_regedit<A>& a, const neo::basic_regedit<B>& b) {
+	typename neo::basic_regedit<A>::values::value_table va = a.values.query_all();
+	typename neo::basic_regedit<B>::values::value_table vb = b.values.query_all();
+	if(va.size() != vb.size())
+		return false;
+	for(size_t i = 0; i < va.size(); ++i)
+		if(std::strcmp(va[i].name, vb[i].name) != 0 || va[i].ty != vb[i].ty || va[i].size != vb[i].size || std::memcmp(va[i].data, vb[i].data, va[i].size) != 0)
+			return false;
+	typename neo::basic_regedit<A>::key_snapshot ka = a.snapshot();
+	typename neo::basic_regedit<B>::key_snapshot kb = b.snapshot();
+	if(ka.size() != kb.size())
+		return false;
+	for(size_t i = 0; i < ka.size(); ++i)
+		if(std::strcmp(ka[i].name, kb[i].name) != 0 || !same_tree(ka.open(i), kb.open(i)))
+			return false;
+	return true;
+}
@@ -0,0 +1,89 @@
+/*
+	Diffs : the patch between two trees turns the first one into the second one through apply_diff() and through its .reg file, with
+	and without the subtree hashes (saved and loaded back), over memory trees and offline hives
+
+	g++ -std=c++11 -O2 -I.. diff.cpp -o diff -lpthread
+	cl /std:c++14 /O2 /EHsc /I.. diff.cpp
+*/
+
+#include "check.hpp"
+#include "../regedit_diff.hpp"
+#include "../regedit_hive.hpp"
+
+using namespace neo;
+using type = regedit::type;
+
+// 'b' is 'a' with a value changed, a value and a subtree removed, a value and a subtree added, deep in the wide key
+static void make_trees(memory_regedit a, memory_regedit b) {
+	sample_tree(a);
+	sample_tree(b);
+	b.values["dword"].write<type::dword>(1);
+	b.values.erase("qword");
+	b.erase("Param\xC3\xA8tres");
+	b["wide"]["k0042"].values["added"].write<type::sz>("new");
+	b["wide"]["k0042"]["added"]["deep"].values["x"].write<type::dword>(2);
+}
+
+static void apply() {
+	regedit_backend::memory::store store;
+	memory_regedit root(store.root());
+	make_trees(root["a"], root["b"]);
+	memory_regedit a(store.root(), "a"), b(store.root(), "b");
+
+	CHECK(diff(a, a).empty());
+	std::vector<diff_entry> patch = diff(a, b);
+	CHECK(patch.size() == 7); // the added subtree is its two keys and its value
+	CHECK(apply_diff(patch, a));
+	CHECK(diff(a, b).empty() && same_tree(a, b));
+
+	// through a .reg file
+	memory_regedit c = root["c"];
+	sample_tree(c);
+	const std::string path = checks_dir + "patch.reg";
+	{
+		reg_writer writer(path);
+		CHECK(write_patch(writer, diff(c, b), "HKEY_CURRENT_USER\\Checks"));
+		CHECK(writer.close());
+	}
+	CHECK(import_reg(path, c, "HKEY_CURRENT_USER\\Checks"));
+	CHECK(same_tree(c, b));
+	std::remove(path.c_str());
+}
+
+// the unchanged subtrees are skipped, the saved hashes give the same diff
+static void hashes() {
+	regedit_backend::memory::store store;
+	memory_regedit root(store.root());
+	make_trees(root["a"], root["b"]);
+	memory_regedit a(store.root(), "a"), b(store.root(), "b");
+
+	const std::string hive_path = checks_dir + "diff.hiv", hash_path = checks_dir + "diff.hash";
+	CHECK(write_hive(a, hive_path));
+	regedit_backend::hive::file hive(hive_path);
+	CHECK(hive.is_open());
+	hive_regedit h(hive.root());
+
+	tree_hashes ha, hb, loaded;
+	CHECK(ha.build(h) != hb.build(b));
+	CHECK(ha.size() == 1 + a.size() + 100 && ha.save(hash_path)); // the root, its subkeys and the subkeys of "wide"
+	CHECK(loaded.load(hash_path) && loaded.size() == ha.size());
+	uint64_t x = 0, y = 0;
+	CHECK(loaded.find("wide\\K0010", x) && ha.find("wide\\k0010", y) && x == y);
+
+	std::vector<diff_entry> full = diff(h, b), skipped;
+	diff_stats stats = diff(h, b, [&skipped](const diff_entry& e) { skipped.push_back(e); }, &loaded, &hb);
+	CHECK(stats.skipped >= 99 && stats.keys < 10); // every subkey of "wide" but k0042
+	CHECK(skipped.size() == full.size() && stats.entries == full.size());
+	for(size_t i = 0; i < full.size() && i < skipped.size(); ++i)
+		CHECK(full[i].what == skipped[i].what && full[i].path == skipped[i].path && full[i].name == skipped[i].name && full[i].data == skipped[i].data);
+	CHECK(!loaded.load(checks_dir + "missing.hash"));
+	std::remove(hive_path.c_str());
+	std::remove(hash_path.c_str());
+}
+
+int main(int argc, char* argv[]) {
+	checks_init(argc, argv);
+	apply();
+	hashes();
+	return checks_done();
+}
@@ -0,0 +1,65 @@
+/*
+	Shared key handles (counting<memory>) : copies of a key and the values taken from it open no handle of their own, every
+	handle opened is closed, and the values taken from a read only key don't reopen it for writing
+
+	g++ -std=c++11 -O2 -I.. handles.cpp -o handles -lpthread
+	cl /std:c++14 /O2 /EHsc /I.. handles.cpp
+*/
+
+#include "check.hpp"
+
+using namespace neo;
+using type = regedit::type;
+using counted = basic_regedit<regedit_backend::counting<regedit_backend::memory>>;
+using Counted = counted::backend_type;
+
+static void shared_handles() {
+	regedit_backend::memory::store store;
+	counted key = counted(store.root())["app"];
+	for(int i = 0; i < 100; ++i)
+		key.values[numbered("v", i)].write<type::dword>(static_cast<__regedit_details::DWORD>(i));
+
+	Counted::stats().reset();
+	std::vector<counted> copies(50, key);
+	unsigned long long sum = 0;
+	for(counted::values::iterator it = key.values.begin(); it != key.values.end(); ++it)
+		sum += it->second.read<type::dword>();
+	for(int i = 0; i < 100; ++i)
+		sum += key.values.ref(numbered("v", i).c_str()).read<type::dword>();
+	CHECK(sum == 2 * 4950);
+	CHECK(Counted::stats().open == 0 && Counted::stats().create == 0);
+
+	copies.clear();
+	Counted::stats().reset();
+	{
+		counted sub = key["sub"];
+		counted copy = sub;
+		copy.values["x"].write<type::dword>(1);
+	}
+	CHECK(Counted::stats().open_handles() == 0);
+}
+
+// the memory backend doesn't enforce the permissions of its handles, a write on a read only key is seen as the writable handle it doesn't open
+static void read_only_values() {
+	regedit_backend::memory::store store;
+	counted(store.root())["app"].values["v"].write<type::dword>(1);
+	counted key(store.root(), "app", false);
+	counted::values::value_snapshot snap = key.values.snapshot();
+
+	Counted::stats().reset();
+	key.values.at("v").write<type::dword>(2);
+	key.values["v"].write<type::dword>(2);
+	key.values.at(0).second.write<type::dword>(2);
+	key.values.begin()->second.write<type::dword>(2);
+	counted::value(key.values.ref("v")).write<type::dword>(2);
+	snap.open(0).write<type::dword>(2);
+	counted::value(snap.ref(snap[0])).write<type::dword>(2);
+	CHECK(Counted::stats().open == 0);
+}
+
+int main(int argc, char* argv[]) {
+	checks_init(argc, argv);
+	shared_handles();
+	read_only_values();
+	return checks_done();
+}
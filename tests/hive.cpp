@@ -0,0 +1,94 @@
+/*
+	Offline hive reader : lookups on keys with many values (the hashed index) and few, case insensitive and non ASCII names, and a file
+	with a corrupted value count that has to stay fast and bounded
+
+	g++ -std=c++11 -O2 -I.. hive.cpp -o hive -lpthread
+	cl /std:c++14 /O2 /EHsc /I.. hive.cpp
+*/
+
+#include "check.hpp"
+#include "../regedit_hive.hpp"
+#include <chrono>
+#include <fstream>
+#include <iterator>
+
+using namespace neo;
+using type = regedit::type;
+
+static bool write_file(const std::string& path, const std::vector<char>& data) {
+	std::ofstream out(path, std::ios::binary);
+	return out.write(data.data(), static_cast<std::streamsize>(data.size())).good();
+}
+static std::vector<char> read_file(const std::string& path) {
+	std::ifstream in(path, std::ios::binary);
+	return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static void lookups(const std::string& path) {
+	regedit_backend::memory::store store;
+	memory_regedit root(store.root());
+	memory_regedit big = root["big"];
+	for(int i = 0; i < 1000; ++i)
+		big.values[numbered("Value_", i)].write<type::dword>(static_cast<__regedit_details::DWORD>(i));
+	big.values["\xC3\xA9t\xC3\xA9"].write<type::dword>(7); // été
+	root["small"].values["a"].write<type::dword>(1);
+	CHECK(write_hive(root, path));
+
+	regedit_backend::hive::file f(path);
+	CHECK(f.is_open());
+	hive_regedit h(f.root(), "big");
+	CHECK(h.values.size() == 1001);
+	for(int i = 0; i < 1000; i += 7) {
+		CHECK(h.values.at(numbered("value_", i)).read<type::dword>() == static_cast<__regedit_details::DWORD>(i));
+		hive_regedit::values::iterator it = h.values.find(numbered("VALUE_", i));
+		CHECK(it != h.values.end() && it->first == numbered("Value_", i));
+	}
+	CHECK(h.values.find("missing") == h.values.end());
+	CHECK(h.values.at("\xC3\x89T\xC3\x89").read<type::dword>() == 7); // ÉTÉ, through the upcase table
+	CHECK(hive_regedit(f.root(), "small").values.at("A").read<type::dword>() == 1);
+}
+
+// the value count of one nk raised far past its value list : lookups neither scan nor reserve by it
+static void corrupted_count(const std::string& path) {
+	regedit_backend::memory::store store;
+	memory_regedit root(store.root());
+	memory_regedit key = root["CorruptKey"];
+	for(int i = 0; i < 100; ++i)
+		key.values[numbered("v", i)].write<type::dword>(static_cast<__regedit_details::DWORD>(i));
+	CHECK(write_hive(root, path));
+
+	std::vector<char> data = read_file(path);
+	const std::string name = "CorruptKey";
+	size_t at = std::search(data.begin(), data.end(), name.begin(), name.end()) - data.begin();
+	CHECK(at != data.size() && at > __regedit_details::regf::nk_name);
+	if(at == data.size())
+		return;
+	char* nk = &data[at - __regedit_details::regf::nk_name];
+	CHECK(nk[0] == 'n' && nk[1] == 'k');
+	const uint32_t counts[] = { 0x10000000, 0xFFFFFFFF };
+	for(uint32_t count : counts) {
+		for(int b = 0; b < 4; ++b)
+			nk[__regedit_details::regf::nk_values + b] = static_cast<char>((count >> (b * 8)) & 0xFF);
+		CHECK(write_file(path, data));
+		regedit_backend::hive::file f(path);
+		CHECK(f.is_open());
+		hive_regedit h(f.root(), "CorruptKey");
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		CHECK(h.values.size() < 1024);
+		for(int i = 0; i < 100; ++i) {
+			CHECK(h.values.find("missing") == h.values.end());
+			CHECK(h.values.at(numbered("v", i)).read<type::dword>() == static_cast<__regedit_details::DWORD>(i));
+		}
+		CHECK(h.values.snapshot().size() >= 100);
+		CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+	}
+}
+
+int main(int argc, char* argv[]) {
+	checks_init(argc, argv);
+	const std::string path = checks_dir + "checks_hive.hiv";
+	lookups(path);
+	corrupted_count(path);
+	std::remove(path.c_str());
+	return checks_done();
+}
@@ -0,0 +1,66 @@
+/*
+	Hive writer : memory trees written as hive files and read back the same (every value type, UTF-8 names, db split data, ri split
+	subkey lists), past the 1 MB write window so the nk cells get patched on the file, and compact_hive() / hive to hive rewrites
+
+	g++ -std=c++11 -O2 -I.. hive_writer.cpp -o hive_writer -lpthread
+	cl /std:c++14 /O2 /EHsc /I.. hive_writer.cpp
+*/
+
+#include "check.hpp"
+#include "../regedit_hive.hpp"
+
+using namespace neo;
+using type = regedit::type;
+
+static void round_trip() {
+	regedit_backend::memory::store store;
+	memory_regedit src = memory_regedit(store.root())["src"];
+	sample_tree(src, 1200); // two lh lists on a ri list
+	std::vector<__regedit_details::BYTE> big(3 << 20);
+	for(size_t i = 0; i < big.size(); ++i)
+		big[i] = static_cast<__regedit_details::BYTE>(i * 7);
+	src["data"].values["big"].write<type::binary>(big.data(), big.size()); // db cells, and the window flushed before "data" is patched
+	src["data"].values["after"].write<type::sz>("after");
+
+	const std::string path = checks_dir + "writer.hiv";
+	CHECK(write_hive(src, path));
+	{
+		regedit_backend::hive::file hive(path);
+		CHECK(hive.is_open());
+		hive_regedit h(hive.root());
+		CHECK(same_tree(src, h));
+		CHECK(h["wide"].size() == 1200 && h["wide"]["K1100"].values.at("V1100").read<type::dword>() == 1100);
+		CHECK(h["data"].values.at("big").size() == big.size());
+		src["wide"]["k0500"].values["v0500"].write<type::dword>(1);
+		CHECK(!same_tree(src, h));
+		src["wide"]["k0500"].values["v0500"].write<type::dword>(500);
+	}
+
+	const std::string compacted = checks_dir + "writer_compact.hiv", copied = checks_dir + "writer_copy.hiv";
+	CHECK(compact_hive(path, compacted));
+	{
+		regedit_backend::hive::file hive(path), compact(compacted);
+		CHECK(compact.is_open());
+		CHECK(same_tree(src, hive_regedit(compact.root())));
+		CHECK(write_hive(hive_regedit(hive.root()), copied));
+		regedit_backend::hive::file copy(copied);
+		CHECK(copy.is_open() && same_tree(src, hive_regedit(copy.root())));
+	}
+	std::remove(path.c_str());
+	std::remove(compacted.c_str());
+	std::remove(copied.c_str());
+}
+
+static void failures() {
+	regedit_backend::memory::store store;
+	memory_regedit src(store.root());
+	CHECK(!write_hive(src, checks_dir + "missing_dir/writer.hiv"));
+	CHECK(!compact_hive(checks_dir + "missing.hiv", checks_dir + "writer_compact.hiv"));
+}
+
+int main(int argc, char* argv[]) {
+	checks_init(argc, argv);
+	round_trip();
+	failures();
+	return checks_done();
+}
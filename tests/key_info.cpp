@@ -0,0 +1,74 @@
+/*
+	Key info kept on the shared handle (counting<memory>) : loops over the subkeys and the values, end() and find() don't query the
+	backend on every step, changes through another handle show up after refresh() or on a lookup of an indexed key
+
+	g++ -std=c++11 -O2 -I.. key_info.cpp -o key_info -lpthread
+	cl /std:c++14 /O2 /EHsc /I.. key_info.cpp
+*/
+
+#include "check.hpp"
+
+using namespace neo;
+using type = regedit::type;
+using counted = basic_regedit<regedit_backend::counting<regedit_backend::memory>>;
+using Counted = counted::backend_type;
+
+static void bounded_queries() {
+	regedit_backend::memory::store store;
+	counted key = counted(store.root())["app"];
+	for(int i = 0; i < 100; ++i) {
+		key.insert(numbered("k", i));
+		key.values[numbered("v", i)].write<type::dword>(static_cast<__regedit_details::DWORD>(i));
+	}
+	counted small = key["small"];
+	for(int i = 0; i < 10; ++i)
+		small.insert(numbered("k", i));
+
+	Counted::stats().reset();
+	size_t n = 0;
+	for(counted::iterator it = key.begin(); it != key.end(); ++it)
+		n += it->first.size();
+	CHECK(n == 101 * 5);
+	CHECK(Counted::stats().query_info <= 1);
+
+	Counted::stats().reset();
+	for(counted::values::iterator it = key.values.begin(); it != key.values.end(); ++it) // the README loop
+		n += it->first.size() + static_cast<size_t>(it->second.type());
+	CHECK(Counted::stats().query_info <= 1);
+
+	Counted::stats().reset();
+	for(int i = 0; i < 100; ++i)
+		CHECK(small.find(numbered("k", i % 10)) != small.end());
+	CHECK(Counted::stats().query_info <= 1);
+
+	Counted::stats().reset();
+	for(int i = 0; i < 100; ++i) // indexed : one stamp check per lookup, none for end()
+		CHECK(key.find(numbered("k", i)) != key.end());
+	CHECK(Counted::stats().query_info <= 100 + 1);
+}
+
+static void other_handles() {
+	regedit_backend::memory::store store;
+	memory_regedit a = memory_regedit(store.root())["app"];
+	for(int i = 0; i < 100; ++i)
+		a.insert(numbered("k", i));
+	memory_regedit small = a["k0000"];
+	CHECK(a.size() == 100 && small.size() == 0);
+
+	memory_regedit b(store.root(), "app");
+	b.insert("new");
+	b["k0000"]["sub"];
+	memory_regedit::iterator it = a.find("new"); // indexed : the lookup sees the change and refreshes the key info
+	CHECK(it != a.end() && it->first == "new");
+	CHECK(a.size() == 101);
+	CHECK(small.size() == 0);
+	small.refresh();
+	CHECK(small.size() == 1);
+}
+
+int main(int argc, char* argv[]) {
+	checks_init(argc, argv);
+	bounded_queries();
+	other_handles();
+	return checks_done();
+}
@@ -0,0 +1,71 @@
+/*
+	Name index : the hashed indexes of large keys (subkeys and values) give the same results than the lookups without them, and the
+	changes made through another handle of the same key show up on the next find()
+
+	g++ -std=c++11 -O2 -I.. name_index.cpp -o name_index -lpthread
+	cl /std:c++14 /O2 /EHsc /I.. name_index.cpp
+*/
+
+#include "check.hpp"
+
+using namespace neo;
+using type = regedit::type;
+
+static void lookups() {
+	regedit_backend::memory::store store;
+	memory_regedit key = memory_regedit(store.root())["big"];
+	for(int i = 0; i < 200; ++i) {
+		key.insert(numbered("k", i));
+		key.values[numbered("v", i)].write<type::dword>(static_cast<__regedit_details::DWORD>(i));
+	}
+	for(int r = 0; r < 2; ++r) // builds the indexes, then uses them
+		for(int i = 0; i < 200; ++i) {
+			memory_regedit::iterator k = key.find(numbered("K", i));
+			memory_regedit::values::iterator v = key.values.find(numbered("V", i));
+			CHECK(k != key.end() && k->first == numbered("k", i));
+			CHECK(v != key.values.end() && v->first == numbered("v", i));
+		}
+	memory_regedit::iterator k = key.find("k0200");
+	memory_regedit::values::iterator v = key.values.find("");
+	CHECK(k == key.end() && v == key.values.end());
+}
+
+// the indexes are built through one handle, the changes made through another one have to show up
+static void staleness() {
+	regedit_backend::memory::store store;
+	memory_regedit a = memory_regedit(store.root())["big"];
+	for(int i = 0; i < 200; ++i) {
+		a.insert(numbered("k", i));
+		a.values[numbered("v", i)].write<type::dword>(static_cast<__regedit_details::DWORD>(i));
+	}
+	for(int i = 0; i < 3; ++i) {
+		memory_regedit::iterator k = a.find("K0100");
+		memory_regedit::values::iterator v = a.values.find("V0100");
+		CHECK(k != a.end() && v != a.values.end());
+	}
+
+	memory_regedit b(store.root(), "big");
+	b.erase("k0050");
+	b.values.erase("v0050");
+	b.insert("k0050a");
+	b.values["v0050a"].write<type::dword>(7);
+
+	memory_regedit::iterator gone = a.find("k0050"), added = a.find("k0050a");
+	memory_regedit::values::iterator vgone = a.values.find("v0050");
+	CHECK(gone == a.end() && vgone == a.values.end()); // the find() saw the change, the size of 'a' is refreshed with it
+	CHECK(added != a.end() && added->first == "k0050a");
+	CHECK(a.values.at("V0050A").read<type::dword>() == 7);
+	CHECK(a.size() == 200 && a.values.size() == 200);
+	for(int i = 51; i < 200; i += 37) { // every position after the changed ones moved
+		CHECK(a.find(numbered("k", i))->first == numbered("k", i));
+		CHECK(a.values.find(numbered("v", i))->first == numbered("v", i));
+		CHECK(a.values.at(numbered("v", i)).read<type::dword>() == static_cast<__regedit_details::DWORD>(i));
+	}
+}
+
+int main(int argc, char* argv[]) {
+	checks_init(argc, argv);
+	lookups();
+	staleness();
+	return checks_done();
+}
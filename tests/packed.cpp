@@ -0,0 +1,71 @@
+/*
+	Packed snapshots : memory trees packed in memory and on a file and read back the same, lookups on large keys through the lookup
+	table, corrupted buffers refused by open(), and the write operations refused
+
+	g++ -std=c++11 -O2 -I.. packed.cpp -o packed -lpthread
+	cl /std:c++14 /O2 /EHsc /I.. packed.cpp
+*/
+
+#include "check.hpp"
+#include "../regedit_packed.hpp"
+
+using namespace neo;
+using type = regedit::type;
+
+static void round_trip() {
+	regedit_backend::memory::store store;
+	memory_regedit src = memory_regedit(store.root())["src"];
+	sample_tree(src, 1000);
+
+	std::vector<__regedit_details::BYTE> packed;
+	CHECK(pack(src, packed));
+	regedit_backend::packed::file pf;
+	CHECK(pf.open(packed.data(), packed.size()));
+	packed_regedit p(pf.root());
+	CHECK(same_tree(src, p));
+	packed_regedit wide = p["wide"];
+	for(int i = 0; i < 1000; i += 7) {
+		packed_regedit::iterator it = wide.find(numbered("K", i));
+		CHECK(it != wide.end() && it->first == numbered("k", i) && it->second.values.at(numbered("V", i)).read<type::dword>() == static_cast<__regedit_details::DWORD>(i));
+	}
+	packed_regedit::iterator missing = wide.find("k1000");
+	CHECK(missing == wide.end() && wide.values.find("none") == wide.values.end());
+	CHECK(p["PARAM\xC3\xA8TRES"].values.at("\xE2\x82\xAC").read<type::dword>() == 1);
+
+	const std::string path = checks_dir + "round_trip.pack";
+	CHECK(write_packed(src, path));
+	{
+		regedit_backend::packed::file mapped(path);
+		CHECK(mapped.is_open() && same_tree(src, packed_regedit(mapped.root())));
+	}
+	std::remove(path.c_str());
+}
+
+static void refused() {
+	regedit_backend::memory::store store;
+	memory_regedit src = memory_regedit(store.root())["src"];
+	sample_tree(src, 10);
+	std::vector<__regedit_details::BYTE> packed;
+	CHECK(pack(src, packed));
+
+	regedit_backend::packed::file pf;
+	CHECK(!pf.open(packed.data(), packed.size() / 2));
+	CHECK(!pf.open(packed.data(), 0));
+	std::vector<__regedit_details::BYTE> bad(packed);
+	bad[0] ^= 0xff;
+	CHECK(!pf.open(bad.data(), bad.size()));
+	CHECK(!regedit_backend::packed::file(checks_dir + "missing.pack").is_open());
+
+	CHECK(pf.open(packed.data(), packed.size()));
+	packed_regedit p(pf.root());
+	CHECK(throws([&] { p.clear(); }) && throws([&] { p.values.clear(); }));
+	CHECK(throws([&] { p.insert_bulk({ "x" }); }) && throws([&] { p["x"]; }));
+	CHECK(same_tree(src, p));
+}
+
+int main(int argc, char* argv[]) {
+	checks_init(argc, argv);
+	round_trip();
+	refused();
+	return checks_done();
+}
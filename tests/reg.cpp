@@ -0,0 +1,85 @@
+/*
+	.reg files : trees exported and imported back the same on the three formats, with the parallel reader too, and the "[-key]" /
+	"name"=- deletions of a hand written file
+
+	g++ -std=c++11 -O2 -I.. reg.cpp -o reg -lpthread
+	cl /std:c++14 /O2 /EHsc /I.. reg.cpp
+*/
+
+#include "check.hpp"
+#include "../regedit_reg.hpp"
+#include <fstream>
+
+using namespace neo;
+using type = regedit::type;
+
+static const char* const root_path = "HKEY_CURRENT_USER\\Software\\Checks";
+
+static void round_trips() {
+	regedit_backend::memory::store store;
+	memory_regedit root(store.root());
+	memory_regedit src = root["src"];
+	sample_tree(src);
+	std::vector<__regedit_details::BYTE> big(5000); // hex lines wrapped many times
+	for(size_t i = 0; i < big.size(); ++i)
+		big[i] = static_cast<__regedit_details::BYTE>(i);
+	src["data"].values["big"].write<type::binary>(big.data(), big.size());
+	src["data"].values["quotes \"and\" \\"].write<type::sz>("a \"b\" \\ c");
+
+	const reg_format formats[] = { reg_format::unicode, reg_format::utf8 };
+	const std::string path = checks_dir + "round_trip.reg";
+	for(reg_format f : formats) {
+		CHECK(export_reg(src, path, root_path, f));
+		for(size_t threads : { 1, 4 }) {
+			memory_regedit dst = root["dst"];
+			CHECK(import_reg(path, dst, root_path, threads));
+			CHECK(same_tree(src, dst));
+			root.erase("dst");
+		}
+	}
+
+	// ANSI text, the names and strings are kept ASCII
+	memory_regedit ascii = root["ascii"];
+	ascii.values["sz"].write<type::sz>("text");
+	ascii.values["dword"].write<type::dword>(42);
+	ascii["sub"].values["bin"].write<type::binary>(big.data(), 100);
+	CHECK(export_reg(ascii, path, root_path, reg_format::regedit4));
+	memory_regedit dst = root["dst"];
+	CHECK(import_reg(path, dst, root_path));
+	CHECK(same_tree(ascii, dst));
+	std::remove(path.c_str());
+}
+
+// the keys outside the mapped root are skipped
+static void deletions() {
+	regedit_backend::memory::store store;
+	memory_regedit dst(store.root());
+	dst["gone"]["deep"];
+	dst["kept"].values["x"].write<type::dword>(1);
+	dst["kept"].values["y"].write<type::dword>(2);
+
+	const std::string path = checks_dir + "deletions.reg";
+	{
+		std::ofstream out(path, std::ios::binary);
+		out << "Windows Registry Editor Version 5.00\r\n\r\n"
+			"[-HKEY_CURRENT_USER\\Software\\Checks\\gone]\r\n\r\n"
+			"[HKEY_CURRENT_USER\\Software\\Checks\\kept]\r\n"
+			"\"x\"=-\r\n"
+			"\"z\"=dword:00000003\r\n\r\n"
+			"[HKEY_CURRENT_USER\\Software\\Other]\r\n"
+			"\"outside\"=\"1\"\r\n";
+	}
+	CHECK(import_reg(path, dst, root_path));
+	CHECK(dst.size() == 1 && dst.find("gone") == dst.end());
+	CHECK(dst["kept"].values.size() == 2 && dst["kept"].values.find("x") == dst["kept"].values.end());
+	CHECK(dst["kept"].values.at("z").read<type::dword>() == 3);
+	CHECK(!import_reg(checks_dir + "missing.reg", dst, root_path));
+	std::remove(path.c_str());
+}
+
+int main(int argc, char* argv[]) {
+	checks_init(argc, argv);
+	round_trips();
+	deletions();
+	return checks_done();
+}